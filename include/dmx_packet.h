@@ -0,0 +1,54 @@
+/**
+ * Vaxthus_Master_V3 - Art-Net / sACN (E1.31) packet parsing
+ *
+ * Works on the receive buffer as it came off the socket: the parsed packet
+ * points into it, nothing is copied or allocated. Only DMX data packets
+ * are accepted:
+ *
+ *   Art-Net   ArtDmx (OpCode 0x5000), protocol 14+, UDP 6454
+ *   sACN      E1.31 data packet, start code 0, UDP 5568, multicast
+ *             239.255.<universe hi>.<universe lo> or unicast
+ *
+ * Everything else (ArtPoll, ArtSync, E1.31 sync/discovery, preview data,
+ * alternate start codes, truncated or malformed packets) is rejected.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARTNET_PORT     6454
+#define SACN_PORT       5568
+#define DMX_SLOTS       512
+#define DMX_PACKET_MAX  638  // E1.31 with 512 slots; ArtDmx is 530
+
+enum DmxProtocol : uint8_t {
+    DMX_OFF,
+    DMX_ARTNET,
+    DMX_SACN
+};
+
+struct DmxPacket {
+    const uint8_t* data;  // slot 1 is data[0], inside the packet buffer
+    uint16_t slots;       // slots present, 1-512
+    uint16_t universe;    // Art-Net 15-bit port address, sACN 1-63999
+    uint8_t sequence;     // Art-Net 0 = sequencing off
+    uint8_t priority;     // sACN 0-200; Art-Net has none, reported as 100
+    bool terminated;      // sACN Stream_Terminated: the source is gone
+};
+
+// False for anything but a DMX data packet of the given protocol
+bool dmx_parse(DmxProtocol protocol, const uint8_t* packet, size_t length, DmxPacket* out);
+
+// E1.31 6.7.2: a packet whose sequence is at most 20 behind the last one
+// arrived out of order and is dropped. Art-Net sequence 0 always passes.
+bool dmx_sequence_ok(DmxProtocol protocol, uint8_t last, uint8_t sequence);
+
+// Copies `count` consecutive slots from DMX address `address` (1-512) into
+// values. Returns the mask of values present (bit n = values[n]); slots
+// past the end of a short packet are left out.
+uint32_t dmx_map(const DmxPacket& packet, uint16_t address, uint8_t count, uint8_t* values);
+
+// sACN multicast group for a universe, host byte order (239.255.hi.lo)
+uint32_t sacn_multicast_group(uint16_t universe);
@@ -0,0 +1,227 @@
+/**
+ * Vaxthus_Master_V3 - Hardware Abstraction Layer
+ *
+ * Thin wrapper around the peripherals main.cpp touches directly:
+ * PWM (LEDC), clock (millis/NTP), NVS (Preferences), network (WiFi),
+ * FreeRTOS tasks and power management.
+ *
+ *   - hal_esp32.cpp  → real ESP32 implementation (built when ARDUINO is set)
+ *   - hal_native.cpp → in-memory fakes for [env:native] host builds
+ *
+ * Keep this layer thin: one call per peripheral operation, no policy.
+ * Library classes (WebServer, PubSubClient, ArduinoOTA) are not wrapped
+ * here; on the host they are replaced by the fakes in test/fakes/.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <time.h>
+
+// ============================================================================
+// PWM
+// ============================================================================
+void hal_pwm_setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution);
+void hal_pwm_write(uint8_t channel, uint32_t duty);
+
+// Hardware fade from the current duty to `duty` over fade_ms, returns at once.
+// It never runs longer than fade_ms; the LEDC fade unit steps at most once
+// per 1023 PWM periods, so very slow fades finish early. On the ESP32 a
+// fade cannot be stopped: a write or fade on a channel mid-fade blocks
+// until that fade ends, so callers keep track and wait it out themselves.
+void hal_pwm_fade(uint8_t channel, uint32_t duty, uint32_t fade_ms);
+
+// ============================================================================
+// CLOCK
+// ============================================================================
+uint32_t hal_millis();
+uint32_t hal_micros();
+void hal_delay(uint32_t ms);
+void hal_time_begin(long gmt_offset_sec, int dst_offset_sec, const char* server1, const char* server2);
+bool hal_local_time(struct tm* info);
+bool hal_utc_time(struct tm* info);   // false until NTP has synced
+uint32_t hal_unix_time();             // UTC seconds, 0 until NTP has synced
+
+// CPU cycle counter for cheap interval timing (per core, wraps every
+// ~18 s at 240 MHz). Divide a difference by hal_cycles_per_us().
+uint32_t hal_cycle_count();
+uint32_t hal_cycles_per_us();
+
+uint32_t hal_random();  // hardware RNG; a fixed sequence on the host
+
+// ============================================================================
+// NVS
+// ============================================================================
+void hal_nvs_begin(const char* name);
+String hal_nvs_get_string(const char* key, const char* default_value);
+void hal_nvs_put_string(const char* key, const String& value);
+uint32_t hal_nvs_get_u32(const char* key, uint32_t default_value);
+void hal_nvs_put_u32(const char* key, uint32_t value);
+uint8_t hal_nvs_get_u8(const char* key, uint8_t default_value);
+void hal_nvs_put_u8(const char* key, uint8_t value);
+bool hal_nvs_get_bool(const char* key, bool default_value);
+void hal_nvs_put_bool(const char* key, bool value);
+// One lookup: returns the blob's length, 0 if it is missing or longer than size
+size_t hal_nvs_get_blob(const char* key, void* data, size_t size);
+bool hal_nvs_put_blob(const char* key, const void* data, size_t length);  // replaced as a whole
+
+// ============================================================================
+// LOG PARTITION
+// ============================================================================
+// Raw "telemetry" data partition with NOR flash rules: erase works on whole
+// 4 KB sectors and sets every bit, a write can only clear bits. Offsets are
+// relative to the partition. hal_log_size() is 0 when the partition table
+// has no such partition.
+uint32_t hal_log_size();
+bool hal_log_erase(uint32_t offset, uint32_t length);
+bool hal_log_write(uint32_t offset, const void* data, uint32_t length);
+bool hal_log_read(uint32_t offset, void* data, uint32_t length);
+
+// ============================================================================
+// NETWORK
+// ============================================================================
+enum HalWifiEvent {
+    HAL_WIFI_STA_START,
+    HAL_WIFI_STA_CONNECTED,
+    HAL_WIFI_STA_GOT_IP,
+    HAL_WIFI_STA_DISCONNECTED
+};
+
+// reason is only meaningful for HAL_WIFI_STA_DISCONNECTED
+typedef void (*hal_wifi_event_cb)(HalWifiEvent event, int reason);
+
+void hal_wifi_init(hal_wifi_event_cb callback);   // AP+STA mode, event hook
+bool hal_wifi_start_ap(const char* ssid, const char* password);
+void hal_wifi_stop_ap();
+String hal_wifi_ap_ip();
+// The link as it was when the station got its IP. Addresses are IPv4 in
+// IPAddress order (first octet in the low byte).
+struct HalWifiLink {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+// With `fast`, joins that access point on that channel without scanning and
+// takes the stored addresses instead of asking DHCP. Without, scans and uses DHCP.
+void hal_wifi_begin(const char* ssid, const char* password, const HalWifiLink* fast = nullptr);
+bool hal_wifi_link(HalWifiLink* link);  // false while the station is not connected
+// Modem sleep: the station radio dozes between DTIM beacons. Off by default,
+// and without effect while the AP is up.
+void hal_wifi_set_sleep(bool sleep);
+void hal_wifi_reconnect();
+int hal_wifi_status();
+bool hal_wifi_connected();
+int hal_wifi_rssi();
+String hal_wifi_local_ip();
+
+// UDP receive socket on any interface (the DMX receiver). Plain BSD sockets
+// on both builds, so the host build receives real datagrams on loopback.
+// hal_udp_open() returns -1 on failure. Multicast groups are IPv4 in host
+// byte order; join again after a reconnect.
+int hal_udp_open(uint16_t port);
+bool hal_udp_join(int sock, uint32_t group);
+// Waits up to timeout_ms (0 = poll, UINT32_MAX = forever) for a datagram.
+// Bytes received (a longer datagram is cut to size), 0 on timeout, -1 on error.
+int hal_udp_receive(int sock, uint8_t* buffer, size_t size, uint32_t timeout_ms);
+
+// ============================================================================
+// TASKS
+// ============================================================================
+typedef void (*hal_task_fn)(void* arg);
+typedef void* hal_task_t;
+
+// Returns false when tasks are unavailable (native build); callers then run
+// the work inline from loop(). task, if given, receives the handle.
+bool hal_task_start(hal_task_fn fn, const char* name, uint32_t stack_size, uint8_t priority, int core,
+                    hal_task_t* task = nullptr);
+
+// Fixed-rate sleep that hal_task_notify() ends early. True when the period
+// came up (last_wake moves on), false on a notify; the next call then
+// waits for the rest of the same period. last_wake is an opaque tick
+// cookie, initialise it to 0.
+bool hal_task_wait_until(uint32_t* last_wake, uint32_t period_ms);
+
+// Event-driven sleep: the calling task blocks until max_ms have passed or
+// another task calls hal_task_notify() on it. Like hal_loop_wait(), wakes
+// are not counted and the native build only advances the fake clock.
+void hal_task_wait(uint32_t max_ms);
+void hal_task_notify(hal_task_t task);  // null is ignored
+
+// Recursive mutex for the network side: loop() holds it around its
+// shared-state work (not its slow network I/O) and the async web server
+// takes it around each route handler, so the two never touch settings, MQTT
+// or the light command queue at the same time. hal_net_try_lock() gives up
+// after timeout_ms. A no-op on the native build, where handlers are called
+// from the test thread (hal_fake_net_busy() makes try_lock fail).
+void hal_net_lock();
+bool hal_net_try_lock(uint32_t timeout_ms);
+void hal_net_unlock();
+
+// loop() sleeps in hal_loop_wait() until max_ms have passed (UINT32_MAX =
+// no limit) or another task calls hal_loop_wake(). Wakes are not counted:
+// any number of them before the wait ends it once. On the native build the
+// wait advances the fake clock by max_ms.
+void hal_loop_wait(uint32_t max_ms);
+void hal_loop_wake();
+
+// ============================================================================
+// POWER
+// ============================================================================
+enum HalPowerMode {
+    HAL_POWER_OFF,          // fixed 240 MHz
+    HAL_POWER_DFS,          // 80 MHz while idle
+    HAL_POWER_LIGHT_SLEEP   // and light sleep in tickless idle
+};
+
+// Automatic power management (esp_pm). The CPU clocks down to 80 MHz - not
+// lower, the APB clock and with it the LEDC frequency would follow - and,
+// with light_sleep, the idle task light-sleeps the chip until the next task
+// timeout or interrupt. Returns what the build supports: light sleep needs
+// CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE (BUILD.md).
+HalPowerMode hal_power_begin(bool light_sleep);
+
+// Counted holds, released with false. busy: full CPU clock, so cycle counts
+// stay at hal_cycles_per_us() - wrap each burst of work in it. awake: no
+// light sleep. No-ops when hal_power_begin() returned HAL_POWER_OFF.
+void hal_power_busy(bool busy);
+void hal_power_stay_awake(bool awake);
+
+// ============================================================================
+// SYSTEM
+// ============================================================================
+uint32_t hal_chip_id();
+void hal_restart();
+uint32_t hal_free_heap();
+uint32_t hal_min_free_heap();        // low-water mark since boot
+uint32_t hal_largest_free_block();   // biggest single allocation possible now
+
+#ifndef ARDUINO
+// ============================================================================
+// NATIVE FAKE CONTROLS (host builds only)
+// ============================================================================
+void hal_fake_reset();
+void hal_fake_advance_millis(uint32_t ms);
+void hal_fake_set_local_time(int hour, int minute);
+void hal_fake_clear_local_time();
+void hal_fake_set_utc_offset(int minutes);  // local - UTC, default 120 (CEST)
+void hal_fake_set_wifi(bool connected, int rssi);
+uint32_t hal_fake_pwm_duty(uint8_t channel);      // target duty (fades complete instantly)
+uint32_t hal_fake_pwm_fade_ms(uint8_t channel);   // duration of the last write/fade
+uint32_t hal_fake_pwm_stalls();                   // writes/fades that hit a running fade (the clock skips it)
+uint32_t hal_fake_nvs_writes();
+uint32_t hal_fake_nvs_reads();
+void hal_fake_set_heap(uint32_t free_bytes, uint32_t largest_block);
+void hal_fake_log_resize(uint32_t bytes);         // erased; default 64 KB, 0 = no partition
+uint32_t hal_fake_log_erases(uint32_t sector);    // erase count per 4 KB sector
+bool hal_fake_ap_running();
+bool hal_fake_wifi_sleep();
+uint32_t hal_fake_wifi_begins(bool fast);         // hal_wifi_begin() calls with / without a link
+uint32_t hal_fake_wifi_reconnects();
+int hal_fake_power_holds(bool awake);             // busy (false) or stay-awake (true) holds taken
+void hal_fake_net_busy(bool busy);                // hal_net_try_lock() times out while set
+#endif
@@ -0,0 +1,92 @@
+/**
+ * Vaxthus_Master_V3 - Lock-free primitives shared between tasks
+ *
+ *   SpscQueue<T, N> - bounded single-producer/single-consumer ring buffer.
+ *                     push() and pop() never block; push() fails when full.
+ *   Seqlock<T>      - single-writer snapshot. The writer never waits, readers
+ *                     retry if they raced a write.
+ *
+ * Both are header-only and free of FreeRTOS calls so they also build in
+ * [env:native]. T must be trivially copyable.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "SpscQueue element must be trivially copyable");
+
+public:
+    // Producer side only
+    bool push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only
+    bool pop(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        item = items_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    T items_[N];
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock value must be trivially copyable");
+
+public:
+    // Writer side only
+    void store(const T& value) {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&value_, &value, sizeof(T));
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Returns the version (number of stores) the copy belongs to
+    uint32_t load(T& out) const {
+        uint32_t before, after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            memcpy(&out, &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return before / 2;
+    }
+
+    uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    T value_{};
+    std::atomic<uint32_t> seq_{0};
+};
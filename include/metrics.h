@@ -0,0 +1,50 @@
+/**
+ * Vaxthus_Master_V3 - Runtime metrics
+ *
+ * Fixed-bucket latency histograms timed with the CPU cycle counter, and
+ * the Prometheus text format for /metrics. Recording costs two cycle
+ * counter reads and a count-leading-zeros to pick the bucket; nothing
+ * allocates and there is no floating point.
+ *
+ * Buckets are powers of two: <= 1 µs, <= 2 µs, <= 4 µs ... <= 524 ms, +Inf.
+ * Each histogram has one writer (loop() or the light task). A scrape that
+ * races a write may see that one observation half counted.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define METRICS_BUCKETS 20  // finite buckets, le = 2^i µs
+
+struct Histogram {
+    const char* label;                      // label value, e.g. "mqtt"
+    uint32_t buckets[METRICS_BUCKETS + 1];  // per bucket (not cumulative), last = +Inf
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+};
+
+void histogram_observe(Histogram& h, uint32_t us);
+
+// Observes the time from `since` (a hal_cycle_count() value) to now and
+// returns now, so consecutive sections can be timed with one read each
+uint32_t metrics_lap(Histogram& h, uint32_t since);
+
+// Prometheus text exposition. Output goes through write() in small pieces.
+struct MetricsOutput {
+    void (*write)(const char* data, size_t len, void* ctx);
+    void* ctx;
+};
+
+void metrics_header(const MetricsOutput& out, const char* name, const char* type, const char* help);
+// label may be null (no labels); the value of a labelled metric is label_value
+void metrics_value(const MetricsOutput& out, const char* name, const char* label, const char* label_value,
+                   int64_t value);
+void metrics_seconds(const MetricsOutput& out, const char* name, const char* label, const char* label_value,
+                     uint64_t us);
+void metrics_float(const MetricsOutput& out, const char* name, const char* label, const char* label_value,
+                   double value);
+// name without the _bucket/_sum/_count suffix; labelled with label="h.label"
+void metrics_histogram(const MetricsOutput& out, const char* name, const char* label, const Histogram& h);
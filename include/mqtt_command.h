@@ -0,0 +1,69 @@
+/**
+ * Vaxthus_Master_V3 - MQTT command parsing
+ *
+ * Works directly on the topic/payload buffers PubSubClient hands to the
+ * callback: no String, no JsonDocument, no heap. Topics are matched through
+ * a route table keyed by a precomputed FNV-1a hash.
+ *
+ * Accepted levels (channel topics and batch values):
+ *   128                               raw level, clamped to 0-255
+ *   50%  / 12.5%                      percent of full scale
+ *   ON / OFF (also true / false)      full / off, case-insensitive
+ *   {"state":"ON","brightness":128}   Home Assistant JSON light payload
+ *
+ * Batch topic: flat JSON object with one member per channel, e.g.
+ *   {"white":200,"red":"50%","uv":"OFF"}
+ *
+ * Combined light topic: Home Assistant's JSON-schema light command, e.g.
+ *   {"state":"ON","brightness":200,"color":{"r":255,"g":0,"b":64,"w":255},"effect":"Manual"}
+ * Only this command accepts a nested object (one level, for "color").
+ *
+ * Anything malformed is rejected as a whole rather than guessed at.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MQTT_ROUTE_BATCH     -1
+#define MQTT_ROUTE_SCHEDULE  -2
+#define MQTT_ROUTE_HA_LIGHT  -3
+#define MQTT_ROUTE_HA_STATUS -4  // Home Assistant's birth/last-will topic
+
+struct MqttRoute {
+    uint32_t hash;
+    const char* topic;  // full topic, confirms the hash match
+    int8_t channel;     // channel index, or one of MQTT_ROUTE_*
+};
+
+uint32_t mqtt_topic_hash(const char* topic, size_t length);
+
+// nullptr when the topic is not in the table
+const MqttRoute* mqtt_route_find(const MqttRoute* routes, size_t count, const char* topic);
+
+// Single level (raw, percent, ON/OFF or HA JSON). False = ignore the command.
+bool mqtt_parse_level(const uint8_t* payload, size_t length, uint8_t* level);
+
+// Batch object. Returns the mask of channels found (bit n = names[n]),
+// 0 when the payload is malformed or names no known channel.
+uint32_t mqtt_parse_batch(const uint8_t* payload, size_t length,
+                          const char* const* names, uint8_t count, uint8_t* values);
+
+// Members present in a HaLightCommand
+#define HA_LIGHT_STATE       0x01
+#define HA_LIGHT_BRIGHTNESS  0x02
+#define HA_LIGHT_COLOR       0x04
+#define HA_LIGHT_EFFECT      0x08
+
+struct HaLightCommand {
+    uint8_t fields;        // HA_LIGHT_*
+    bool on;
+    uint8_t brightness;
+    uint8_t rgbw[4];       // colour at full scale; members it lacks are 0
+    const char* effect;    // points into the payload, not NUL-terminated
+    size_t effect_length;
+};
+
+// False = malformed or no known member. Unknown members (transition...) are skipped.
+bool mqtt_parse_ha_light(const uint8_t* payload, size_t length, HaLightCommand* out);
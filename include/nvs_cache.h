@@ -0,0 +1,66 @@
+/**
+ * Vaxthus_Master_V3 - Write-behind NVS cache
+ *
+ * Sits on top of the hal_nvs_* calls for values that change often (light
+ * levels). Writes only update RAM and mark the key dirty; dirty keys are
+ * committed to flash together once nothing has changed for
+ * NVS_CACHE_IDLE_MS, or at the latest NVS_CACHE_MAX_DELAY_MS after the
+ * first unsaved change. A key is only written if its value differs from
+ * what is already in flash.
+ *
+ * nvs_cache_commit_due() tells when the next commit is due; call
+ * nvs_cache_loop() then (main.cpp arms a timer for it) and
+ * nvs_cache_flush() before anything that can end in a reboot (OTA start,
+ * settings save). Single-task use only, or under the caller's lock; a caller
+ * that must not hold its lock across the flash writes uses the split commit
+ * (nvs_cache_take(), nvs_cache_write(), nvs_cache_done()) instead.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef NVS_CACHE_IDLE_MS
+#define NVS_CACHE_IDLE_MS        5000   // commit after 5 s without changes
+#endif
+#ifndef NVS_CACHE_MAX_DELAY_MS
+#define NVS_CACHE_MAX_DELAY_MS   30000  // never hold a change longer than 30 s
+#endif
+#ifndef NVS_CACHE_MAX_ENTRIES
+#define NVS_CACHE_MAX_ENTRIES    40
+#endif
+
+// Values copied out of the cache for a split commit
+struct NvsCacheBatch {
+    uint8_t count;
+    struct {
+        const char* key;
+        uint32_t value;
+        uint8_t type;
+    } writes[NVS_CACHE_MAX_ENTRIES];
+};
+
+struct NvsCacheStats {
+    uint32_t writes_requested;  // nvs_cache_put_*() calls
+    uint32_t writes_committed;  // keys actually written to flash
+    uint32_t commits;           // flush batches that wrote at least one key
+};
+
+// key must be a string literal (or otherwise outlive the cache), max 15 chars
+uint8_t nvs_cache_get_u8(const char* key, uint8_t default_value);
+void nvs_cache_put_u8(const char* key, uint8_t value);
+uint32_t nvs_cache_get_u32(const char* key, uint32_t default_value);
+void nvs_cache_put_u32(const char* key, uint32_t value);
+
+void nvs_cache_loop();
+bool nvs_cache_commit_due(uint32_t* due_ms);  // false when nothing is dirty
+void nvs_cache_flush();
+
+// Split commit: take (locked) copies the dirty values out once a commit is
+// due, write (unlocked) puts them in flash, done (locked) marks them
+// committed. A key changed in between stays dirty for the next commit.
+bool nvs_cache_take(NvsCacheBatch* batch);  // false when nothing is due
+void nvs_cache_write(const NvsCacheBatch& batch);
+void nvs_cache_done(const NvsCacheBatch& batch);
+bool nvs_cache_dirty();
+NvsCacheStats nvs_cache_stats();
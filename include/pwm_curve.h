@@ -0,0 +1,59 @@
+/**
+ * Vaxthus_Master_V3 - Perceptual PWM curve
+ *
+ * Maps a 16-bit light level (0-65535, the 0-255 levels from MQTT/UI are
+ * scaled by 257) onto LEDC duty at BITS resolution. The 257-point table is
+ * built at compile time from the CIE 1931 lightness formula, so equal level
+ * steps look like equal brightness steps and the dark end of a sunrise gets
+ * most of the duty resolution. Between table points the duty is
+ * interpolated linearly.
+ *
+ * PERCEPTUAL = false gives a plain linear table (duty proportional to level).
+ * level_for() goes the other way.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+template <uint8_t BITS, bool PERCEPTUAL>
+struct PwmCurve {
+    static constexpr uint32_t MAX_DUTY = (1u << BITS) - 1;
+
+    uint32_t duty[257];  // duty at level i * 256, last entry = full scale
+
+    constexpr PwmCurve() : duty() {
+        for (int i = 0; i <= 256; i++) {
+            double y = i / 256.0;
+            if (PERCEPTUAL) {
+                double l = y * 100.0;  // CIE L*, 0-100
+                y = l > 8.0 ? ((l + 16.0) / 116.0) * ((l + 16.0) / 116.0) * ((l + 16.0) / 116.0)
+                            : l / 903.3;
+            }
+            uint32_t d = (uint32_t)(y * MAX_DUTY + 0.5);
+            duty[i] = (i > 0 && d == 0) ? 1 : d;  // any level above 0 must light up
+        }
+    }
+
+    constexpr uint32_t at(uint16_t level) const {
+        if (level == 0xFFFF) return duty[256];
+        uint32_t i = level >> 8;
+        uint32_t frac = level & 0xFF;
+        return duty[i] + (((duty[i + 1] - duty[i]) * frac + 128) >> 8);
+    }
+
+    // Inverse of at(): the lowest level whose duty reaches d (DLI target
+    // mode scales photon output, i.e. duty, and maps back to a level)
+    constexpr uint16_t level_for(uint32_t d) const {
+        if (d == 0) return 0;
+        if (d > duty[256]) return 0xFFFF;
+        uint32_t lo = 0, hi = 256;  // duty[lo] < d <= duty[hi]
+        while (hi - lo > 1) {
+            uint32_t mid = (lo + hi) / 2;
+            if (duty[mid] < d) lo = mid; else hi = mid;
+        }
+        uint32_t span = duty[hi] - duty[lo];
+        uint32_t level = lo * 256 + ((d - duty[lo]) * 256 - 128 + span - 1) / span;  // at() rounds
+        return level > 0xFFFF ? 0xFFFF : level;
+    }
+};
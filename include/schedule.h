@@ -0,0 +1,84 @@
+/**
+ * Vaxthus_Master_V3 - Light schedule engine
+ *
+ * A schedule is plain text, one channel per line, with breakpoints that are
+ * interpolated linearly (and across midnight):
+ *
+ *   # comment
+ *   profile mon-fri 4-9          weekdays April-September
+ *   red   05:30=0 07:00=80% 20:00=80% 21:30=0
+ *   white 06:00=0 09:00=255 18:00=255 21:00=0
+ *   uv    11:00=0 12:00=180 14:00=180 15:00=0
+ *   profile *                    every other day
+ *   all   06:00=0 10:00=255 18:00=255 22:00=0
+ *
+ * `profile <days> [<months>]` starts a profile; days are mon..sun ("*",
+ * ranges "mon-fri", lists "sat,sun"), months 1-12 (ranges may wrap:
+ * "11-2"). Lines before the first profile line belong to "profile * *".
+ * The first profile matching the date is used; no match = all channels off.
+ * `all` sets every channel; channels a profile leaves out are off.
+ * Levels use the MQTT level syntax (128, 50%, ON/OFF).
+ *
+ * Times can also be solar: `sunrise`, `sunset` or `noon`, with an offset in
+ * minutes (`sunrise-30=0 sunrise+60=255`), and `sun=<level>` makes the
+ * channel follow the sun's elevation with <level> at solar noon. These are
+ * resolved against the SolarDay passed in, so the schedule is recompiled
+ * once a day. Points on a day without sunrise/sunset (or without a SolarDay)
+ * are skipped, and a solar point that lands on a time already used is
+ * dropped rather than failing the schedule.
+ *
+ * schedule_compile() turns the text into a sorted breakpoint table, so
+ * evaluating a channel is a binary search no matter how large the schedule.
+ * Compile on the network side only (it uses static scratch space).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "solar.h"
+
+#ifndef SCHEDULE_MAX_PROFILES
+#define SCHEDULE_MAX_PROFILES  8
+#endif
+#ifndef SCHEDULE_MAX_POINTS
+#define SCHEDULE_MAX_POINTS    384   // all profiles and channels together
+#endif
+#define SCHEDULE_MAX_CHANNELS  16
+
+struct SchedulePoint {
+    uint16_t minute;  // 0-1439
+    uint16_t level;   // 0-65535
+};
+
+struct ScheduleProfile {
+    uint8_t days;     // bit n = tm_wday n (0 = Sunday)
+    uint16_t months;  // bit n = tm_mon n (0 = January)
+    uint16_t first[SCHEDULE_MAX_CHANNELS];  // index into Schedule::points
+    uint16_t count[SCHEDULE_MAX_CHANNELS];
+};
+
+struct Schedule {
+    bool solar;       // uses sunrise/sunset/noon/sun=, so it changes from day to day
+    uint8_t profile_count;
+    uint16_t point_count;
+    ScheduleProfile profiles[SCHEDULE_MAX_PROFILES];
+    SchedulePoint points[SCHEDULE_MAX_POINTS];
+};
+
+struct ScheduleError {
+    uint16_t line;      // 1-based, 0 = whole schedule
+    char message[48];
+};
+
+// False on any error (out is then undefined and err says why). sun may be
+// null when the date is unknown.
+bool schedule_compile(const char* text, size_t length, const char* const* names, uint8_t count,
+                      const SolarDay* sun, Schedule* out, ScheduleError* err);
+
+// Index of the first profile matching the date, -1 if none
+int schedule_find_profile(const Schedule& schedule, int wday, int month);
+
+// Channel level at a second of the day (0-86399)
+uint16_t schedule_level(const Schedule& schedule, int profile, uint8_t channel, uint32_t second);
@@ -0,0 +1,67 @@
+/**
+ * Vaxthus_Master_V3 - Packed settings blob
+ *
+ * All configuration lives in one NVS blob instead of a key per setting:
+ * loading is a single read, and a save replaces the blob with one NVS
+ * write. NVS writes the new entry before it erases the old one, so a power
+ * cut during a save leaves either the old settings or the new ones, never a
+ * mix.
+ *
+ * Layout: SettingsHeader, then Settings as it is in RAM (packed, little
+ * endian). The CRC-32 covers everything after the header. New versions
+ * only append fields:
+ *   - a blob from an older version is shorter, and the fields it lacks keep
+ *     the defaults the caller filled in
+ *   - a blob from a newer firmware (after a downgrade) is read as far as
+ *     this version knows it
+ * A blob with a bad CRC or length is rejected as a whole. Version 0 is the
+ * old key-per-setting layout, migrated in main.cpp.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SETTINGS_VERSION    1
+#define SETTINGS_CHANNELS   6    // PPFD slots: room for every channel in the table
+#define SETTINGS_BLOB_MAX   512  // read buffer, leaves room for fields a newer firmware adds
+
+#define SETTINGS_MQTT_ENABLED         0x01
+#define SETTINGS_MQTT_CHANNEL_TOPICS  0x02
+#define SETTINGS_POWER_SAVE           0x04
+
+struct __attribute__((packed)) SettingsHeader {
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t length;  // bytes after the header
+    uint32_t crc;
+};
+
+// Version 1. Append new fields at the end and bump SETTINGS_VERSION.
+struct __attribute__((packed)) Settings {
+    char wifi_ssid[33];
+    char wifi_password[65];
+    char mqtt_server[65];
+    char mqtt_user[33];
+    char mqtt_password[65];
+    uint16_t mqtt_port;
+    uint8_t flags;  // SETTINGS_*
+    uint8_t dmx_protocol;
+    uint16_t dmx_universe;
+    uint16_t dmx_address;
+    float latitude;
+    float longitude;
+    float dli_target;  // mol/m²/day, 0 = off
+    uint16_t ppfd[SETTINGS_CHANNELS];  // µmol/m²/s at full output
+};
+
+// Header + settings into blob (at least settings_blob_size() bytes); returns the length
+size_t settings_encode(const Settings& settings, uint8_t* blob, size_t size);
+size_t settings_blob_size();
+
+// Overwrites the fields the blob has; false (settings untouched) if the blob
+// is truncated, fails its CRC or has no known version. *version gets the blob's.
+bool settings_decode(const uint8_t* blob, size_t length, Settings* settings, uint8_t* version);
+
+uint32_t settings_crc(const uint8_t* data, size_t length);  // CRC-32 (IEEE)
@@ -0,0 +1,63 @@
+/**
+ * Vaxthus_Master_V3 - Accelerated-time simulation
+ *
+ * light_simulate() drives the same light engine as the light task
+ * (schedule lookup, max levels, interlocks such as the UV limiter, manual
+ * override expiry, DLI integration and target mode) from a virtual clock instead of hal_millis() and
+ * hal_local_time(), and never touches the outputs. Solar schedules are
+ * recompiled for every simulated day, like solar_loop() does live.
+ *
+ * A day at the live 10 s update interval is 8640 engine steps, about a
+ * millisecond on a PC, so thousands of schedule variants can be swept.
+ *
+ * Implemented in main.cpp next to the engine. Network side only: it
+ * shares the compiler's static scratch space. Used by GET/POST /simulate
+ * and the host suite test_simulation.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "schedule.h"
+
+#define SIM_MAX_DAYS 400  // keeps seconds-from-start in 32 bits
+
+// A manual change at a point in the run, as if from a slider or MQTT
+struct SimEvent {
+    uint32_t at;      // seconds from the start
+    int8_t channel;   // index into LIGHT_CHANNELS, -1 = back to auto mode
+    uint8_t level;    // 0-255
+};
+
+struct SimOptions {
+    int year, month, day;      // first simulated local date (month 1-12)
+    uint16_t days;
+    uint32_t step;             // seconds between engine steps
+    float latitude, longitude;
+    int utc_offset_minutes;    // local - UTC, for sunrise/sunset
+    const SimEvent* events;    // sorted by at, may be null
+    size_t event_count;
+    float dli_target;          // mol/m²/day, 0 = run the schedule as is
+};
+
+struct SimSample {
+    uint32_t t;                // seconds from the start
+    const struct tm* local;    // simulated wall clock
+    const uint8_t* levels;     // per channel, what the outputs would show (0-255)
+    bool auto_mode;
+    uint32_t dli;              // PAR dose since simulated midnight, µmol/m²
+};
+
+// Called after every step; return false to stop the run early
+typedef bool (*SimSink)(const SimSample& sample, void* ctx);
+
+// False (with err set) if the schedule text does not compile for one of
+// the simulated days, or the options are out of range
+bool light_simulate(const char* text, size_t length, const SimOptions& opt, SimSink sink, void* ctx,
+                    ScheduleError* err);
+
+// One trace row: CSV "2026-06-21 06:05:00,12,12,9,1\n" or JSON "[300,12,12,9,1]"
+int format_sim_row(char* buf, size_t size, const SimSample& sample, bool json);
@@ -0,0 +1,32 @@
+/**
+ * Vaxthus_Master_V3 - Sun position
+ *
+ * NOAA low-precision solar equations (about a minute of error for sunrise
+ * and sunset at Swedish latitudes). All the trigonometry happens in
+ * solar_compute_day(), once per day on the network side. Everything after
+ * that is a lookup in the resulting SolarDay.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define SOLAR_STEP_MINUTES 15
+#define SOLAR_TABLE_SIZE   (1440 / SOLAR_STEP_MINUTES + 1)  // 00:00 .. 24:00
+#define SOLAR_NONE         -1  // no sunrise/sunset today (polar night or midnight sun)
+
+struct SolarDay {
+    int16_t sunrise;   // local minute of day, or SOLAR_NONE
+    int16_t sunset;    // local minute of day, or SOLAR_NONE
+    int16_t noon;      // local minute of day
+    int16_t max_elevation;                 // centidegrees, at solar noon
+    int16_t elevation[SOLAR_TABLE_SIZE];   // centidegrees at minute i * SOLAR_STEP_MINUTES
+    uint16_t intensity[SOLAR_TABLE_SIZE];  // sin(elevation) relative to noon, 0-65535
+};
+
+// yday 0-365 as in struct tm; utc_offset_minutes = local time - UTC (DST included)
+void solar_compute_day(int year, int yday, float latitude, float longitude, int utc_offset_minutes,
+                       SolarDay* out);
+
+// Elevation in centidegrees at a local second of the day (interpolated)
+int16_t solar_elevation(const SolarDay& day, uint32_t second);
@@ -0,0 +1,99 @@
+/**
+ * Vaxthus_Master_V3 - Flash ring-buffer telemetry log
+ *
+ * Append-only log of fixed-width 32-byte records in the raw "telemetry"
+ * data partition (see partitions.csv), for auditing months of lighting.
+ * Every record is a full snapshot - channel levels, mode, link flags and
+ * RSSI - tagged with the event that caused it, so any row stands alone.
+ *
+ * Flash handling:
+ *   - Records collect in a one-page RAM buffer (TELEMETRY_PAGE_SIZE) and
+ *     are programmed in page-aligned runs: when the page fills, after
+ *     TELEMETRY_FLUSH_MS, or on telemetry_flush().
+ *   - The partition is a ring of 4 KB sectors. A sector is erased just
+ *     before the head enters it, dropping the oldest 128 records, so every
+ *     sector is erased exactly once per lap - wear is even by construction.
+ *   - Each record carries a sequence number and a CRC. telemetry_begin()
+ *     finds the head from the first record of each sector (newest sequence
+ *     wins); a record torn by a power cut fails its CRC and is skipped.
+ *
+ * Readers walk the ring oldest to newest a page at a time, then the
+ * unflushed RAM records, so the whole log can be streamed without
+ * holding it in memory. Network side (loop()) only.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_RECORD_SIZE   32
+#define TELEMETRY_PAGE_SIZE     256    // flash program page
+#define TELEMETRY_SECTOR_SIZE   4096   // flash erase unit
+#define TELEMETRY_MAX_CHANNELS  16
+
+#ifndef TELEMETRY_FLUSH_MS
+#define TELEMETRY_FLUSH_MS      600000  // a part-filled page waits at most 10 min
+#endif
+
+enum TelemetryEvent : uint8_t {
+    TELEMETRY_BOOT = 1,
+    TELEMETRY_LEVELS,       // levels changed (rate limited by the caller)
+    TELEMETRY_MODE,         // auto <-> manual
+    TELEMETRY_HEARTBEAT,    // nothing else logged for a while
+    TELEMETRY_WIFI_UP,
+    TELEMETRY_WIFI_DOWN,
+    TELEMETRY_MQTT_UP,
+    TELEMETRY_MQTT_DOWN,
+    TELEMETRY_TIME_SYNC,
+    TELEMETRY_EVENT_COUNT
+};
+
+#define TELEMETRY_FLAG_AUTO    0x01
+#define TELEMETRY_FLAG_WIFI    0x02
+#define TELEMETRY_FLAG_MQTT    0x04
+#define TELEMETRY_FLAG_UPTIME  0x80  // time is seconds since boot (no NTP yet)
+
+struct TelemetryRecord {
+    uint32_t seq;           // filled in by telemetry_append(), 0xFFFFFFFF = erased
+    uint32_t time;          // UTC unix seconds, or uptime with TELEMETRY_FLAG_UPTIME
+    uint8_t event;          // TelemetryEvent
+    uint8_t flags;
+    int8_t rssi;            // dBm, 0 when WiFi is down
+    uint8_t channel_count;
+    uint8_t levels[TELEMETRY_MAX_CHANNELS];
+    uint16_t reserved;      // 0xFFFF, left erased
+    uint16_t crc;           // CRC-16/CCITT over the bytes before it
+};
+static_assert(sizeof(TelemetryRecord) == TELEMETRY_RECORD_SIZE, "TelemetryRecord must be 32 bytes");
+static_assert(TELEMETRY_SECTOR_SIZE % TELEMETRY_PAGE_SIZE == 0 && TELEMETRY_PAGE_SIZE % TELEMETRY_RECORD_SIZE == 0,
+              "records must tile pages and sectors");
+
+struct TelemetryStats {
+    uint32_t capacity;      // records the partition holds, 0 = no partition (log off)
+    uint32_t records;       // appended since boot
+    uint32_t page_writes;   // flash program operations
+    uint32_t sector_erases;
+    uint32_t next_seq;
+};
+
+// Return false to stop the walk
+typedef bool (*TelemetryVisitor)(const TelemetryRecord& record, void* ctx);
+
+// Scans the partition for the head. False when there is no partition;
+// appends are then counted and dropped.
+bool telemetry_begin();
+
+// Stamps seq and crc, buffers the record; a full page goes to flash
+void telemetry_append(TelemetryRecord& record);
+void telemetry_loop(uint32_t now_ms);
+bool telemetry_flush_due(uint32_t* due_ms);  // false when nothing waits in RAM
+void telemetry_flush();
+
+// Oldest to newest, including records not flushed yet. Records with
+// seq < from_seq are skipped cheaply.
+void telemetry_read(uint32_t from_seq, TelemetryVisitor visit, void* ctx);
+TelemetryStats telemetry_stats();
+
+const char* telemetry_event_name(uint8_t event);
+uint16_t telemetry_crc(const TelemetryRecord& record);
@@ -0,0 +1,71 @@
+/**
+ * Vaxthus_Master_V3 - Timer queue
+ *
+ * One-shot and periodic deadlines for the network side, kept in a binary
+ * min-heap ordered by due time. loop() calls timers_run() once per pass
+ * to fire whatever is due, then sleeps for timers_next(). New timed
+ * behaviour is a Timer, not another millis() comparison in loop().
+ *
+ * Timers are intrusive - the caller owns the Timer (usually a global) and
+ * the heap only holds pointers, so nothing allocates. Due times are
+ * hal_millis() values compared wrap-safe; pending deadlines must lie
+ * within 24 days of each other. A callback may start or stop any timer,
+ * its own included. Network side only (loop() or under hal_net_lock()).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef TIMERS_MAX
+#define TIMERS_MAX 16  // pending at the same time
+#endif
+
+#define TIMER_NONE UINT32_MAX  // timers_next(): nothing pending
+
+typedef void (*TimerCallback)();
+
+struct Timer {
+    const char* name;        // for the log
+    TimerCallback callback;  // may be null: the timer only wakes loop()
+    uint32_t period_ms;      // 0 = one-shot
+    uint32_t due;            // hal_millis() deadline while pending
+    int8_t slot;             // index in the heap, -1 = not pending
+};
+
+#define TIMER_INIT(name, callback, period_ms) {name, callback, period_ms, 0, -1}
+
+struct TimerStats {
+    uint32_t fired;        // callbacks run since boot
+    uint32_t late_max_ms;  // worst delay between due time and firing
+};
+
+// (Re)arms the timer to fire delay_ms from now, or at an absolute due time.
+// Re-arming a pending timer moves it. False if the queue is full.
+bool timer_start(Timer& timer, uint32_t delay_ms);
+bool timer_start_at(Timer& timer, uint32_t due);
+void timer_stop(Timer& timer);
+bool timer_pending(const Timer& timer);
+
+// Fires every timer that is due. A periodic timer is re-armed before its
+// callback runs, on its own grid; one that fell a whole period behind
+// skips the missed firings.
+void timers_run();
+uint32_t timers_next();  // ms until the first deadline, 0 if overdue, TIMER_NONE if none
+uint8_t timers_pending();
+TimerStats timers_stats();
+
+// Retry delays that double per failed attempt up to max_ms, each drawn at
+// random from the upper half of its step ("equal jitter"): devices that lost
+// the same access point or broker spread their retries out instead of
+// hammering it in lockstep.
+struct Backoff {
+    uint32_t min_ms;    // first step
+    uint32_t max_ms;    // cap
+    uint8_t attempts;   // since the last reset
+};
+
+#define BACKOFF_INIT(min_ms, max_ms) {min_ms, max_ms, 0}
+
+uint32_t backoff_next(Backoff& backoff);  // delay before the next attempt, counts it
+void backoff_reset(Backoff& backoff);     // after a success
@@ -0,0 +1,31 @@
+/**
+ * Vaxthus_Master_V3 - Embedded web UI
+ *
+ * The pages in web/ are gzipped at build time by scripts/embed_web.py into
+ * src/web_assets.cpp. They are static: live values come from /status and
+ * /config, so the same bytes (and ETag) are served on every request.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct WebAsset {
+    const char* path;          // URL, "/" for index.html
+    const char* content_type;
+    const uint8_t* data;       // gzip, in flash
+    size_t length;
+    const char* etag;          // quoted, derived from the uncompressed file
+};
+
+extern const WebAsset WEB_ASSETS[];
+extern const size_t WEB_ASSET_COUNT;
+
+inline const WebAsset* web_asset_find(const char* path) {
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        if (strcmp(WEB_ASSETS[i].path, path) == 0) return &WEB_ASSETS[i];
+    }
+    return nullptr;
+}
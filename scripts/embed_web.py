@@ -0,0 +1,90 @@
+"""
+Vaxthus_Master_V3 - Embed the web UI in the firmware image
+
+Gzips every file in web/ and writes them as const byte arrays to
+src/web_assets.cpp, together with a strong ETag per file. The arrays live
+in flash and are streamed straight to the socket by the web server, so a
+page load costs no heap.
+
+Runs automatically before each build (extra_scripts = pre:scripts/embed_web.py)
+and can also be run by hand:  python scripts/embed_web.py
+
+The output is deterministic (gzip mtime = 0) and only rewritten when it
+changes, so it does not trigger rebuilds on its own.
+"""
+
+import gzip
+import hashlib
+import os
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - provided by PlatformIO
+        return env["PROJECT_DIR"]  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def url_for(name):
+    return "/" if name == "index.html" else "/" + os.path.splitext(name)[0]
+
+
+def symbol_for(name):
+    return "web_" + "".join(c if c.isalnum() else "_" for c in name)
+
+
+def render(web_dir):
+    names = sorted(n for n in os.listdir(web_dir) if os.path.splitext(n)[1] in MIME_TYPES)
+    out = [
+        "// Generated by scripts/embed_web.py from web/ - do not edit by hand.",
+        "",
+        '#include "web_assets.h"',
+        "",
+    ]
+    table = []
+    for name in names:
+        with open(os.path.join(web_dir, name), "rb") as f:
+            raw = f.read()
+        data = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha1(raw).hexdigest()[:16]
+        symbol = symbol_for(name)
+        out.append("// %s: %d bytes, %d gzipped" % (name, len(raw), len(data)))
+        out.append("static const uint8_t %s[] = {" % symbol)
+        for i in range(0, len(data), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+        out.append("};")
+        out.append("")
+        table.append('    {"%s", "%s", %s, sizeof(%s), "\\"%s\\""},'
+                     % (url_for(name), MIME_TYPES[os.path.splitext(name)[1]], symbol, symbol, etag))
+    out.append("const WebAsset WEB_ASSETS[] = {")
+    out.extend(table)
+    out.append("};")
+    out.append("const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    root = project_dir()
+    target = os.path.join(root, "src", "web_assets.cpp")
+    content = render(os.path.join(root, "web"))
+    if os.path.exists(target):
+        with open(target) as f:
+            if f.read() == content:
+                return
+    with open(target, "w", newline="\n") as f:
+        f.write(content)
+    print("embed_web: wrote %s" % os.path.relpath(target, root))
+
+
+main()
@@ -0,0 +1,136 @@
+"""
+Vaxthus_Master_V3 - HTTP load generator
+
+Runs concurrent clients against a controller on the local network and
+reports request latency plus what the controller itself measured:
+
+  - fast clients loop over GET /status, GET / and GET /channels
+  - slow clients download /telemetry.csv at a trickle (bad WiFi stand-in)
+  - /metrics is scraped before and after for loop() and handler timings
+
+    python scripts/http_load.py 192.168.1.100
+    python scripts/http_load.py vaxthus.local --clients 8 --slow 3 --seconds 60
+
+Standard library only. Every request is a fresh connection, like a browser
+that does not keep sockets alive across page loads.
+"""
+
+import argparse
+import asyncio
+import re
+import time
+
+FAST_PATHS = ["/status", "/", "/channels"]
+
+
+async def request(host, path, read_delay=0.0, chunk=512):
+    """GET path, returns (status, body bytes). read_delay throttles reading."""
+    reader, writer = await asyncio.open_connection(host, 80)
+    writer.write(f"GET {path} HTTP/1.1\r\nHost: {host}\r\nConnection: close\r\n\r\n".encode())
+    await writer.drain()
+    status_line = await reader.readline()
+    size = 0
+    while True:
+        data = await reader.read(chunk)
+        if not data:
+            break
+        size += len(data)
+        if read_delay:
+            await asyncio.sleep(read_delay)
+    writer.close()
+    status = int(status_line.split()[1]) if status_line else 0
+    return status, size
+
+
+async def fast_client(host, deadline, latencies, errors):
+    i = 0
+    while time.monotonic() < deadline:
+        path = FAST_PATHS[i % len(FAST_PATHS)]
+        i += 1
+        start = time.monotonic()
+        try:
+            status, _ = await asyncio.wait_for(request(host, path), 10)
+            if status not in (200, 304):
+                errors[path] = errors.get(path, 0) + 1
+                continue
+            latencies.setdefault(path, []).append(time.monotonic() - start)
+        except (OSError, asyncio.TimeoutError):
+            errors[path] = errors.get(path, 0) + 1
+
+
+async def slow_client(host, deadline, totals):
+    while time.monotonic() < deadline:
+        try:
+            # ~5 KB/s: 512 bytes every 100 ms
+            _, size = await asyncio.wait_for(request(host, "/telemetry.csv", read_delay=0.1),
+                                             deadline - time.monotonic())
+            totals.append(size)
+        except (OSError, asyncio.TimeoutError):
+            pass
+
+
+async def scrape(host):
+    reader, writer = await asyncio.open_connection(host, 80)
+    writer.write(f"GET /metrics HTTP/1.1\r\nHost: {host}\r\nConnection: close\r\n\r\n".encode())
+    await writer.drain()
+    text = (await reader.read()).decode(errors="replace")
+    writer.close()
+    values = {}
+    for line in text.splitlines():
+        m = re.match(r"^(vaxthus_[a-z_]+(?:\{[^}]*\})?) (\S+)$", line)
+        if m:
+            values[m.group(1)] = float(m.group(2))
+    return values
+
+
+def percentile(samples, p):
+    samples = sorted(samples)
+    return samples[min(len(samples) - 1, int(len(samples) * p))]
+
+
+def delta_mean_ms(before, after, name):
+    count = after.get(name + "_count", 0) - before.get(name + "_count", 0)
+    total = after.get(name + "_sum", 0) - before.get(name + "_sum", 0)
+    return total / count * 1000 if count else 0.0
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--clients", type=int, default=8, help="concurrent fast clients")
+    parser.add_argument("--slow", type=int, default=2, help="concurrent slow /telemetry.csv readers")
+    parser.add_argument("--seconds", type=float, default=30)
+    args = parser.parse_args()
+
+    before = await scrape(args.host)
+    deadline = time.monotonic() + args.seconds
+    latencies, errors, slow_bytes = {}, {}, []
+    await asyncio.gather(*[fast_client(args.host, deadline, latencies, errors) for _ in range(args.clients)],
+                         *[slow_client(args.host, deadline, slow_bytes) for _ in range(args.slow)])
+    after = await scrape(args.host)
+
+    print(f"{args.clients} fast + {args.slow} slow clients for {args.seconds:.0f} s")
+    print(f"{'path':<12} {'requests':>9} {'req/s':>7} {'p50 ms':>8} {'p95 ms':>8} {'p99 ms':>8} {'max ms':>8} {'errors':>7}")
+    for path in FAST_PATHS:
+        samples = latencies.get(path, [])
+        if not samples:
+            print(f"{path:<12} {0:>9} {'-':>7} {'-':>8} {'-':>8} {'-':>8} {'-':>8} {errors.get(path, 0):>7}")
+            continue
+        print(f"{path:<12} {len(samples):>9} {len(samples) / args.seconds:>7.1f} "
+              f"{percentile(samples, 0.50) * 1000:>8.1f} {percentile(samples, 0.95) * 1000:>8.1f} "
+              f"{percentile(samples, 0.99) * 1000:>8.1f} {max(samples) * 1000:>8.1f} {errors.get(path, 0):>7}")
+    print(f"slow downloads finished: {len(slow_bytes)}, {sum(slow_bytes) // 1024} KB")
+
+    loop_max = after.get('vaxthus_section_duration_max_seconds{section="loop"}', 0) * 1000
+    print(f"device loop():   mean {delta_mean_ms(before, after, 'vaxthus_loop_duration_seconds'):.2f} ms, "
+          f"max since boot {loop_max:.2f} ms")
+    count_key = 'vaxthus_section_duration_seconds_count{section="http"}'
+    sum_key = 'vaxthus_section_duration_seconds_sum{section="http"}'
+    count = after.get(count_key, 0) - before.get(count_key, 0)
+    if count:
+        mean = (after[sum_key] - before.get(sum_key, 0)) / count * 1000
+        print(f"device handlers: {count:.0f} calls, mean {mean:.2f} ms")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,115 @@
+/**
+ * Vaxthus_Master_V3 - Art-Net / sACN (E1.31) packet parsing
+ *
+ * See include/dmx_packet.h. Field offsets are fixed in both protocols, so
+ * parsing is a length check and a handful of compares; every read is
+ * inside `length`.
+ */
+
+#include "dmx_packet.h"
+
+#include <string.h>
+
+static uint16_t be16(const uint8_t* p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint32_t be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// ============================================================================
+// ART-NET
+// ============================================================================
+// ArtDmx: ID[8] OpCode(LE)[2] ProtVer(BE)[2] Sequence Physical SubUni Net Length(BE)[2] Data
+#define ARTDMX_HEADER   18
+#define ARTDMX_OPCODE   0x5000
+#define ARTNET_PROTOCOL 14
+
+static bool artnet_parse(const uint8_t* p, size_t length, DmxPacket* out) {
+    if (length < ARTDMX_HEADER + 2) return false;
+    if (memcmp(p, "Art-Net", 8) != 0) return false;  // includes the NUL
+    if ((p[8] | p[9] << 8) != ARTDMX_OPCODE) return false;
+    if (be16(p + 10) < ARTNET_PROTOCOL) return false;
+    uint16_t slots = be16(p + 16);
+    if (slots < 2 || slots > DMX_SLOTS || ARTDMX_HEADER + (size_t)slots > length) return false;
+
+    out->data = p + ARTDMX_HEADER;
+    out->slots = slots;
+    out->universe = (uint16_t)((p[15] & 0x7F) << 8 | p[14]);
+    out->sequence = p[12];
+    out->priority = 100;
+    out->terminated = false;
+    return true;
+}
+
+// ============================================================================
+// sACN (E1.31)
+// ============================================================================
+// Root layer 0-37, framing layer 38-114, DMP layer 115-125, slots from 126
+#define E131_ROOT_VECTOR     0x00000004  // VECTOR_ROOT_E131_DATA
+#define E131_FRAMING_VECTOR  0x00000002  // VECTOR_E131_DATA_PACKET
+#define E131_DMP_VECTOR      0x02        // VECTOR_DMP_SET_PROPERTY
+#define E131_SLOTS_OFFSET    126
+#define E131_OPTION_PREVIEW    0x80
+#define E131_OPTION_TERMINATED 0x40
+
+static const uint8_t E131_PREAMBLE[16] = {0x00, 0x10, 0x00, 0x00, 'A', 'S', 'C', '-',
+                                          'E',  '1',  '.',  '1',  '7', 0,   0,   0};
+
+static bool sacn_parse(const uint8_t* p, size_t length, DmxPacket* out) {
+    if (length < E131_SLOTS_OFFSET) return false;
+    if (memcmp(p, E131_PREAMBLE, sizeof(E131_PREAMBLE)) != 0) return false;
+    if (be32(p + 18) != E131_ROOT_VECTOR || be32(p + 40) != E131_FRAMING_VECTOR) return false;
+    if (p[117] != E131_DMP_VECTOR || p[118] != 0xA1) return false;  // 1-byte data, absolute addresses
+    if (be16(p + 119) != 0 || be16(p + 121) != 1) return false;    // first address 0, increment 1
+
+    uint8_t options = p[112];
+    if (options & E131_OPTION_PREVIEW) return false;  // for visualisers, not fixtures
+    uint16_t universe = be16(p + 113);
+    if (universe == 0 || universe > 63999) return false;
+    uint16_t count = be16(p + 123);  // start code + slots
+    if (count < 1 || count > DMX_SLOTS + 1 || E131_SLOTS_OFFSET - 1u + count > length) return false;
+    if (p[125] != 0) return false;  // alternate start code (RDM, text...)
+
+    out->data = p + E131_SLOTS_OFFSET;
+    out->slots = count - 1;
+    out->universe = universe;
+    out->sequence = p[111];
+    out->priority = p[108];
+    out->terminated = (options & E131_OPTION_TERMINATED) != 0;
+    return true;
+}
+
+// ============================================================================
+// PACKETS
+// ============================================================================
+bool dmx_parse(DmxProtocol protocol, const uint8_t* packet, size_t length, DmxPacket* out) {
+    switch (protocol) {
+        case DMX_ARTNET: return artnet_parse(packet, length, out);
+        case DMX_SACN: return sacn_parse(packet, length, out);
+        default: return false;
+    }
+}
+
+bool dmx_sequence_ok(DmxProtocol protocol, uint8_t last, uint8_t sequence) {
+    if (protocol == DMX_ARTNET && (sequence == 0 || last == 0)) return true;
+    int8_t diff = (int8_t)(sequence - last);
+    return diff > 0 || diff <= -20;
+}
+
+uint32_t dmx_map(const DmxPacket& packet, uint16_t address, uint8_t count, uint8_t* values) {
+    uint32_t mask = 0;
+    if (address < 1) return 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t slot = address - 1u + i;
+        if (slot >= packet.slots) break;
+        values[i] = packet.data[slot];
+        mask |= 1u << i;
+    }
+    return mask;
+}
+
+uint32_t sacn_multicast_group(uint16_t universe) {
+    return 0xEFFF0000u | universe;
+}
@@ -0,0 +1,453 @@
+/**
+ * Vaxthus_Master_V3 - ESP32 HAL implementation
+ *
+ * See include/hal.h. Only built for the ESP32 (Arduino) target.
+ */
+
+#ifdef ARDUINO
+
+#include "hal.h"
+
+#include <WiFi.h>
+#include <Preferences.h>
+#include <driver/ledc.h>
+#include <esp_partition.h>
+#include <esp_pm.h>
+#include <esp_system.h>
+#include <nvs.h>
+#include <lwip/sockets.h>
+
+static Preferences nvs;
+static nvs_handle_t nvs_blobs = 0;  // same namespace; Preferences::getBytes() looks a key up twice
+static uint32_t pwm_freq[16] = {};
+static uint8_t pwm_bits[16] = {};
+static hal_wifi_event_cb wifi_event_callback = nullptr;
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t pm_busy_lock = nullptr;
+static esp_pm_lock_handle_t pm_awake_lock = nullptr;
+#endif
+
+// ============================================================================
+// PWM
+// ============================================================================
+void hal_pwm_setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) {
+    static bool fade_installed = false;
+    ledcSetup(channel, freq, resolution);
+    ledcAttachPin(pin, channel);
+    pwm_freq[channel & 15] = freq;
+    pwm_bits[channel & 15] = resolution;
+    if (!fade_installed) fade_installed = ledc_fade_func_install(0) == ESP_OK;
+}
+
+void hal_pwm_write(uint8_t channel, uint32_t duty) {
+    ledcWrite(channel, duty);
+}
+
+void hal_pwm_fade(uint8_t channel, uint32_t duty, uint32_t fade_ms) {
+    // Arduino LEDC channel n = speed mode n / 8, hardware channel n % 8
+    ledc_mode_t mode = (ledc_mode_t)(channel / 8);
+    ledc_channel_t hw = (ledc_channel_t)(channel % 8);
+    uint32_t max_duty = (1u << pwm_bits[channel & 15]) - 1;
+    if (duty >= max_duty) duty = max_duty + 1;  // same "fully on" rule as ledcWrite()
+
+    uint32_t current = ledc_get_duty(mode, hw);
+    uint32_t delta = duty > current ? duty - current : current - duty;
+    uint32_t cycles = (uint64_t)fade_ms * pwm_freq[channel & 15] / 1000;
+    if (fade_ms == 0 || delta == 0 || cycles == 0) {
+        ledc_set_duty(mode, hw, duty);
+        ledc_update_duty(mode, hw);
+        return;
+    }
+
+    // Step size and period chosen here rather than by ledc_set_fade_with_time(),
+    // which warns on every call once a fade is longer than the hardware can stretch
+    // (the last step may be partial, so it counts: the fade never overruns fade_ms)
+    uint32_t scale = (delta + cycles - 1) / cycles;
+    if (scale > 1023) scale = 1023;
+    uint32_t cycle_num = cycles / ((delta + scale - 1) / scale);
+    if (cycle_num > 1023) cycle_num = 1023;
+    if (cycle_num == 0) cycle_num = 1;
+    ledc_set_fade_with_step(mode, hw, duty, scale, cycle_num);
+    ledc_fade_start(mode, hw, LEDC_FADE_NO_WAIT);
+}
+
+// ============================================================================
+// CLOCK
+// ============================================================================
+uint32_t hal_millis() {
+    return millis();
+}
+
+uint32_t hal_micros() {
+    return micros();
+}
+
+uint32_t hal_cycle_count() {
+    return ESP.getCycleCount();
+}
+
+uint32_t hal_cycles_per_us() {
+    return ESP.getCpuFreqMHz();
+}
+
+uint32_t hal_random() {
+    return esp_random();
+}
+
+void hal_delay(uint32_t ms) {
+    delay(ms);
+}
+
+void hal_time_begin(long gmt_offset_sec, int dst_offset_sec, const char* server1, const char* server2) {
+    configTime(gmt_offset_sec, dst_offset_sec, server1, server2);
+}
+
+bool hal_local_time(struct tm* info) {
+    // Timeout 0: never block waiting for NTP, callers retry on their own
+    return getLocalTime(info, 0);
+}
+
+bool hal_utc_time(struct tm* info) {
+    time_t now = time(nullptr);
+    if (now < 1600000000) return false;  // same "not synced" test as getLocalTime()
+    gmtime_r(&now, info);
+    return true;
+}
+
+uint32_t hal_unix_time() {
+    time_t now = time(nullptr);
+    return now < 1600000000 ? 0 : (uint32_t)now;
+}
+
+// ============================================================================
+// LOG PARTITION
+// ============================================================================
+static const esp_partition_t* log_partition() {
+    static const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "telemetry");
+    return partition;
+}
+
+uint32_t hal_log_size() {
+    return log_partition() ? log_partition()->size : 0;
+}
+
+bool hal_log_erase(uint32_t offset, uint32_t length) {
+    return log_partition() && esp_partition_erase_range(log_partition(), offset, length) == ESP_OK;
+}
+
+bool hal_log_write(uint32_t offset, const void* data, uint32_t length) {
+    return log_partition() && esp_partition_write(log_partition(), offset, data, length) == ESP_OK;
+}
+
+bool hal_log_read(uint32_t offset, void* data, uint32_t length) {
+    return log_partition() && esp_partition_read(log_partition(), offset, data, length) == ESP_OK;
+}
+
+// ============================================================================
+// NVS
+// ============================================================================
+void hal_nvs_begin(const char* name) {
+    nvs.begin(name, false);
+    if (nvs_open(name, NVS_READWRITE, &nvs_blobs) != ESP_OK) nvs_blobs = 0;
+}
+
+String hal_nvs_get_string(const char* key, const char* default_value) {
+    return nvs.getString(key, default_value);
+}
+
+void hal_nvs_put_string(const char* key, const String& value) {
+    nvs.putString(key, value);
+}
+
+uint32_t hal_nvs_get_u32(const char* key, uint32_t default_value) {
+    return nvs.getUInt(key, default_value);
+}
+
+void hal_nvs_put_u32(const char* key, uint32_t value) {
+    nvs.putUInt(key, value);
+}
+
+uint8_t hal_nvs_get_u8(const char* key, uint8_t default_value) {
+    return nvs.getUChar(key, default_value);
+}
+
+void hal_nvs_put_u8(const char* key, uint8_t value) {
+    nvs.putUChar(key, value);
+}
+
+bool hal_nvs_get_bool(const char* key, bool default_value) {
+    return nvs.getBool(key, default_value);
+}
+
+void hal_nvs_put_bool(const char* key, bool value) {
+    nvs.putBool(key, value);
+}
+
+size_t hal_nvs_get_blob(const char* key, void* data, size_t size) {
+    size_t length = size;
+    if (!nvs_blobs || nvs_get_blob(nvs_blobs, key, data, &length) != ESP_OK) return 0;
+    return length;
+}
+
+bool hal_nvs_put_blob(const char* key, const void* data, size_t length) {
+    return nvs_blobs && nvs_set_blob(nvs_blobs, key, data, length) == ESP_OK && nvs_commit(nvs_blobs) == ESP_OK;
+}
+
+// ============================================================================
+// NETWORK
+// ============================================================================
+void hal_wifi_init(hal_wifi_event_cb callback) {
+    wifi_event_callback = callback;
+    WiFi.mode(WIFI_AP_STA);
+    WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info) {
+        if (!wifi_event_callback) return;
+        switch (event) {
+            case ARDUINO_EVENT_WIFI_STA_START:
+                wifi_event_callback(HAL_WIFI_STA_START, 0);
+                break;
+            case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+                wifi_event_callback(HAL_WIFI_STA_CONNECTED, 0);
+                break;
+            case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+                wifi_event_callback(HAL_WIFI_STA_GOT_IP, 0);
+                break;
+            case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+                wifi_event_callback(HAL_WIFI_STA_DISCONNECTED, info.wifi_sta_disconnected.reason);
+                break;
+            default:
+                break;
+        }
+    });
+}
+
+bool hal_wifi_start_ap(const char* ssid, const char* password) {
+    return WiFi.softAP(ssid, password);
+}
+
+void hal_wifi_stop_ap() {
+    WiFi.softAPdisconnect(true);  // back to STA only
+}
+
+String hal_wifi_ap_ip() {
+    return WiFi.softAPIP().toString();
+}
+
+void hal_wifi_begin(const char* ssid, const char* password, const HalWifiLink* fast) {
+    if (fast) {
+        WiFi.config(IPAddress(fast->ip), IPAddress(fast->gateway), IPAddress(fast->subnet), IPAddress(fast->dns));
+        WiFi.begin(ssid, password, fast->channel, fast->bssid);
+    } else {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);  // back to DHCP
+        WiFi.begin(ssid, password);
+    }
+    WiFi.setAutoReconnect(true);
+    WiFi.setSleep(false);
+}
+
+void hal_wifi_set_sleep(bool sleep) {
+    WiFi.setSleep(sleep);  // WIFI_PS_MIN_MODEM: wake for every DTIM beacon
+}
+
+void hal_wifi_reconnect() {
+    WiFi.reconnect();
+}
+
+int hal_wifi_status() {
+    return WiFi.status();
+}
+
+bool hal_wifi_connected() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+int hal_wifi_rssi() {
+    return WiFi.RSSI();
+}
+
+String hal_wifi_local_ip() {
+    return WiFi.localIP().toString();
+}
+
+bool hal_wifi_link(HalWifiLink* link) {
+    const uint8_t* bssid = WiFi.BSSID();
+    if (WiFi.status() != WL_CONNECTED || !bssid) return false;
+    memcpy(link->bssid, bssid, sizeof(link->bssid));
+    link->channel = (uint8_t)WiFi.channel();
+    link->ip = (uint32_t)WiFi.localIP();
+    link->gateway = (uint32_t)WiFi.gatewayIP();
+    link->subnet = (uint32_t)WiFi.subnetMask();
+    link->dns = (uint32_t)WiFi.dnsIP(0);
+    return true;
+}
+
+int hal_udp_open(uint16_t port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) return -1;
+    int yes = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool hal_udp_join(int sock, uint32_t group) {
+    struct ip_mreq mreq = {};
+    mreq.imr_multiaddr.s_addr = htonl(group);
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    return setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+}
+
+int hal_udp_receive(int sock, uint8_t* buffer, size_t size, uint32_t timeout_ms) {
+    if (timeout_ms != UINT32_MAX) {
+        fd_set ready;
+        FD_ZERO(&ready);
+        FD_SET(sock, &ready);
+        struct timeval tv;
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        int n = select(sock + 1, &ready, nullptr, nullptr, &tv);
+        if (n <= 0) return n;
+    }
+    int n = recv(sock, buffer, size, 0);
+    return n < 0 ? -1 : n;
+}
+
+// ============================================================================
+// TASKS
+// ============================================================================
+bool hal_task_start(hal_task_fn fn, const char* name, uint32_t stack_size, uint8_t priority, int core,
+                    hal_task_t* task) {
+    return xTaskCreatePinnedToCore(fn, name, stack_size, nullptr, priority, (TaskHandle_t*)task, core) == pdPASS;
+}
+
+bool hal_task_wait_until(uint32_t* last_wake, uint32_t period_ms) {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t due = (*last_wake ? (TickType_t)*last_wake : now) + pdMS_TO_TICKS(period_ms);
+    TickType_t left = due - now;
+    if ((int32_t)left > 0 && ulTaskNotifyTake(pdTRUE, left) > 0) {
+        if (!*last_wake) *last_wake = (uint32_t)now;
+        return false;
+    }
+    *last_wake = (uint32_t)due;
+    return true;
+}
+
+void hal_task_wait(uint32_t max_ms) {
+    ulTaskNotifyTake(pdTRUE, max_ms == UINT32_MAX ? portMAX_DELAY : max_ms / portTICK_PERIOD_MS);
+}
+
+void hal_task_notify(hal_task_t task) {
+    if (task) xTaskNotifyGive((TaskHandle_t)task);
+}
+
+// Created on first use (function-local static, initialisation is thread-safe)
+static SemaphoreHandle_t net_mutex() {
+    static SemaphoreHandle_t mutex = xSemaphoreCreateRecursiveMutex();
+    return mutex;
+}
+
+void hal_net_lock() {
+    xSemaphoreTakeRecursive(net_mutex(), portMAX_DELAY);
+}
+
+bool hal_net_try_lock(uint32_t timeout_ms) {
+    return xSemaphoreTakeRecursive(net_mutex(), pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void hal_net_unlock() {
+    xSemaphoreGiveRecursive(net_mutex());
+}
+
+static SemaphoreHandle_t loop_wake_semaphore() {
+    static SemaphoreHandle_t semaphore = xSemaphoreCreateBinary();
+    return semaphore;
+}
+
+void hal_loop_wait(uint32_t max_ms) {
+    // max_ms / portTICK_PERIOD_MS: pdMS_TO_TICKS() overflows above ~71 minutes
+    xSemaphoreTake(loop_wake_semaphore(), max_ms == UINT32_MAX ? portMAX_DELAY : max_ms / portTICK_PERIOD_MS);
+}
+
+void hal_loop_wake() {
+    xSemaphoreGive(loop_wake_semaphore());
+}
+
+// ============================================================================
+// POWER
+// ============================================================================
+HalPowerMode hal_power_begin(bool light_sleep) {
+#if CONFIG_PM_ENABLE
+#if !CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    light_sleep = false;  // esp_pm_configure() would refuse it
+#endif
+    esp_pm_config_esp32_t config = {};
+    config.max_freq_mhz = ESP.getCpuFreqMHz();
+    config.min_freq_mhz = 80;
+    config.light_sleep_enable = light_sleep;
+    if (esp_pm_configure(&config) != ESP_OK) return HAL_POWER_OFF;
+    esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "busy", &pm_busy_lock);
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "awake", &pm_awake_lock);
+    return light_sleep ? HAL_POWER_LIGHT_SLEEP : HAL_POWER_DFS;
+#else
+    (void)light_sleep;
+    return HAL_POWER_OFF;
+#endif
+}
+
+void hal_power_busy(bool busy) {
+#if CONFIG_PM_ENABLE
+    if (!pm_busy_lock) return;
+    if (busy) {
+        esp_pm_lock_acquire(pm_busy_lock);
+    } else {
+        esp_pm_lock_release(pm_busy_lock);
+    }
+#else
+    (void)busy;
+#endif
+}
+
+void hal_power_stay_awake(bool awake) {
+#if CONFIG_PM_ENABLE
+    if (!pm_awake_lock) return;
+    if (awake) {
+        esp_pm_lock_acquire(pm_awake_lock);
+    } else {
+        esp_pm_lock_release(pm_awake_lock);
+    }
+#else
+    (void)awake;
+#endif
+}
+
+// ============================================================================
+// SYSTEM
+// ============================================================================
+uint32_t hal_chip_id() {
+    return (uint32_t)ESP.getEfuseMac();
+}
+
+void hal_restart() {
+    ESP.restart();
+}
+
+uint32_t hal_free_heap() {
+    return ESP.getFreeHeap();
+}
+
+uint32_t hal_min_free_heap() {
+    return ESP.getMinFreeHeap();
+}
+
+uint32_t hal_largest_free_block() {
+    return ESP.getMaxAllocHeap();
+}
+
+#endif  // ARDUINO
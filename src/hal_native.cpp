@@ -0,0 +1,572 @@
+/**
+ * Vaxthus_Master_V3 - Native (host) HAL fakes
+ *
+ * In-memory stand-ins for the ESP32 peripherals so main.cpp can be built
+ * and benchmarked with [env:native]. Time only moves when the code calls
+ * hal_delay() or a test calls hal_fake_advance_millis().
+ */
+
+#ifndef ARDUINO
+
+#include "hal.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <string.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define HAL_FAKE_PWM_CHANNELS 16
+
+static uint32_t fake_millis = 0;
+static bool fake_time_valid = false;
+static struct tm fake_time = {};
+static int fake_utc_offset = 120;
+static uint32_t fake_pwm[HAL_FAKE_PWM_CHANNELS] = {};
+static uint32_t fake_pwm_fade[HAL_FAKE_PWM_CHANNELS] = {};
+static uint32_t fake_pwm_fade_end[HAL_FAKE_PWM_CHANNELS] = {};
+static uint32_t fake_pwm_stalls = 0;
+static std::map<std::string, std::string> fake_nvs;
+static uint32_t fake_nvs_write_count = 0;
+static uint32_t fake_nvs_read_count = 0;
+static bool fake_wifi_connected = false;
+static int fake_wifi_rssi = -60;
+static hal_wifi_event_cb fake_wifi_callback = nullptr;
+static uint32_t fake_wifi_begins[2] = {};  // [fast]
+static uint32_t fake_wifi_reconnects = 0;
+static uint32_t fake_random = 0x9E3779B9;
+static bool fake_ap_running = false;
+static bool fake_wifi_sleep = false;
+static bool fake_power_on = false;
+static int fake_power_busy = 0;
+static int fake_power_awake = 0;
+static bool fake_net_busy = false;
+static uint32_t fake_free_heap = 180000;
+static uint32_t fake_min_free_heap = 180000;
+static uint32_t fake_largest_block = 110000;
+
+#define HAL_FAKE_LOG_SECTOR 4096
+#define HAL_FAKE_LOG_DEFAULT_SIZE (64 * 1024)
+static std::vector<uint8_t> fake_log(HAL_FAKE_LOG_DEFAULT_SIZE, 0xFF);
+static std::vector<uint32_t> fake_log_erases(HAL_FAKE_LOG_DEFAULT_SIZE / HAL_FAKE_LOG_SECTOR, 0);
+
+// ============================================================================
+// PWM
+// ============================================================================
+void hal_pwm_setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) {
+    (void)pin;
+    (void)freq;
+    (void)resolution;
+    if (channel < HAL_FAKE_PWM_CHANNELS) fake_pwm[channel] = 0;
+}
+
+void hal_pwm_write(uint8_t channel, uint32_t duty) {
+    hal_pwm_fade(channel, duty, 0);
+}
+
+void hal_pwm_fade(uint8_t channel, uint32_t duty, uint32_t fade_ms) {
+    if (channel >= HAL_FAKE_PWM_CHANNELS) return;
+    // Like the LEDC driver: wait for a running fade on the channel to end
+    int32_t left = (int32_t)(fake_pwm_fade_end[channel] - fake_millis);
+    if (left > 0) {
+        fake_pwm_stalls++;
+        fake_millis += left;
+    }
+    fake_pwm[channel] = duty;
+    fake_pwm_fade[channel] = fade_ms;
+    fake_pwm_fade_end[channel] = fake_millis + fade_ms;
+}
+
+// ============================================================================
+// CLOCK
+// ============================================================================
+uint32_t hal_millis() {
+    return fake_millis;
+}
+
+uint32_t hal_micros() {
+    return fake_millis * 1000;
+}
+
+// Real time, unlike the clock above: benchmarks measure with it. 1 "cycle" = 1 ns.
+uint32_t hal_cycle_count() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+uint32_t hal_cycles_per_us() {
+    return 1000;
+}
+
+uint32_t hal_random() {  // xorshift32: repeatable runs
+    fake_random ^= fake_random << 13;
+    fake_random ^= fake_random >> 17;
+    fake_random ^= fake_random << 5;
+    return fake_random;
+}
+
+void hal_delay(uint32_t ms) {
+    fake_millis += ms;
+}
+
+void hal_time_begin(long gmt_offset_sec, int dst_offset_sec, const char* server1, const char* server2) {
+    (void)gmt_offset_sec;
+    (void)dst_offset_sec;
+    (void)server1;
+    (void)server2;
+}
+
+bool hal_local_time(struct tm* info) {
+    if (!fake_time_valid) return false;
+    *info = fake_time;
+    return true;
+}
+
+bool hal_utc_time(struct tm* info) {
+    if (!fake_time_valid) return false;
+    struct tm local = fake_time;
+    time_t t = timegm(&local) - fake_utc_offset * 60;
+    gmtime_r(&t, info);
+    return true;
+}
+
+uint32_t hal_unix_time() {
+    if (!fake_time_valid) return 0;
+    struct tm local = fake_time;
+    return (uint32_t)(timegm(&local) - fake_utc_offset * 60);
+}
+
+// ============================================================================
+// LOG PARTITION
+// ============================================================================
+uint32_t hal_log_size() {
+    return (uint32_t)fake_log.size();
+}
+
+bool hal_log_erase(uint32_t offset, uint32_t length) {
+    if (offset % HAL_FAKE_LOG_SECTOR || length % HAL_FAKE_LOG_SECTOR || offset + length > fake_log.size()) return false;
+    memset(fake_log.data() + offset, 0xFF, length);
+    for (uint32_t s = offset / HAL_FAKE_LOG_SECTOR; s < (offset + length) / HAL_FAKE_LOG_SECTOR; s++) fake_log_erases[s]++;
+    return true;
+}
+
+// Like NOR flash: programming can only clear bits
+bool hal_log_write(uint32_t offset, const void* data, uint32_t length) {
+    if (offset + length > fake_log.size()) return false;
+    for (uint32_t i = 0; i < length; i++) fake_log[offset + i] &= ((const uint8_t*)data)[i];
+    return true;
+}
+
+bool hal_log_read(uint32_t offset, void* data, uint32_t length) {
+    if (offset + length > fake_log.size()) return false;
+    memcpy(data, fake_log.data() + offset, length);
+    return true;
+}
+
+// ============================================================================
+// NVS
+// ============================================================================
+void hal_nvs_begin(const char* name) {
+    (void)name;
+}
+
+String hal_nvs_get_string(const char* key, const char* default_value) {
+    fake_nvs_read_count++;
+    auto it = fake_nvs.find(key);
+    return it == fake_nvs.end() ? String(default_value) : String(it->second.c_str());
+}
+
+void hal_nvs_put_string(const char* key, const String& value) {
+    fake_nvs[key] = value.c_str();
+    fake_nvs_write_count++;
+}
+
+uint32_t hal_nvs_get_u32(const char* key, uint32_t default_value) {
+    fake_nvs_read_count++;
+    auto it = fake_nvs.find(key);
+    return it == fake_nvs.end() ? default_value : (uint32_t)std::stoul(it->second);
+}
+
+void hal_nvs_put_u32(const char* key, uint32_t value) {
+    fake_nvs[key] = std::to_string(value);
+    fake_nvs_write_count++;
+}
+
+uint8_t hal_nvs_get_u8(const char* key, uint8_t default_value) {
+    return (uint8_t)hal_nvs_get_u32(key, default_value);
+}
+
+void hal_nvs_put_u8(const char* key, uint8_t value) {
+    hal_nvs_put_u32(key, value);
+}
+
+bool hal_nvs_get_bool(const char* key, bool default_value) {
+    return hal_nvs_get_u32(key, default_value ? 1 : 0) != 0;
+}
+
+void hal_nvs_put_bool(const char* key, bool value) {
+    hal_nvs_put_u32(key, value ? 1 : 0);
+}
+
+// Blobs are kept as binary std::string values
+size_t hal_nvs_get_blob(const char* key, void* data, size_t size) {
+    fake_nvs_read_count++;
+    auto it = fake_nvs.find(key);
+    if (it == fake_nvs.end() || it->second.size() > size) return 0;
+    memcpy(data, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+bool hal_nvs_put_blob(const char* key, const void* data, size_t length) {
+    fake_nvs[key] = std::string((const char*)data, length);
+    fake_nvs_write_count++;
+    return true;
+}
+
+// ============================================================================
+// NETWORK
+// ============================================================================
+void hal_wifi_init(hal_wifi_event_cb callback) {
+    fake_wifi_callback = callback;
+}
+
+bool hal_wifi_start_ap(const char* ssid, const char* password) {
+    (void)ssid;
+    (void)password;
+    fake_ap_running = true;
+    return true;
+}
+
+void hal_wifi_stop_ap() {
+    fake_ap_running = false;
+}
+
+String hal_wifi_ap_ip() {
+    return String("192.168.4.1");
+}
+
+void hal_wifi_begin(const char* ssid, const char* password, const HalWifiLink* fast) {
+    (void)ssid;
+    (void)password;
+    fake_wifi_begins[fast ? 1 : 0]++;
+    if (fake_wifi_callback) fake_wifi_callback(HAL_WIFI_STA_START, 0);
+}
+
+void hal_wifi_set_sleep(bool sleep) {
+    fake_wifi_sleep = sleep;
+}
+
+void hal_wifi_reconnect() {
+    fake_wifi_reconnects++;
+}
+
+int hal_wifi_status() {
+    return fake_wifi_connected ? 3 : 6;  // WL_CONNECTED / WL_DISCONNECTED
+}
+
+bool hal_wifi_connected() {
+    return fake_wifi_connected;
+}
+
+int hal_wifi_rssi() {
+    return fake_wifi_connected ? fake_wifi_rssi : 0;
+}
+
+String hal_wifi_local_ip() {
+    return String(fake_wifi_connected ? "192.168.1.100" : "0.0.0.0");
+}
+
+bool hal_wifi_link(HalWifiLink* link) {
+    if (!fake_wifi_connected) return false;
+    static const uint8_t bssid[6] = {0x02, 0x00, 0x5E, 0x10, 0x00, 0x01};
+    memcpy(link->bssid, bssid, sizeof(bssid));
+    link->channel = 6;
+    link->ip = 0x6401A8C0;       // 192.168.1.100
+    link->gateway = 0x0101A8C0;  // 192.168.1.1
+    link->subnet = 0x00FFFFFF;   // 255.255.255.0
+    link->dns = 0x0101A8C0;
+    return true;
+}
+
+// Real sockets, so tests can send to the firmware over loopback. Not on
+// Windows hosts: no receiver there (hal_udp_open() fails).
+#ifndef _WIN32
+int hal_udp_open(uint16_t port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) return -1;
+    int yes = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool hal_udp_join(int sock, uint32_t group) {
+    struct ip_mreq mreq = {};
+    mreq.imr_multiaddr.s_addr = htonl(group);
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    return setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+}
+
+int hal_udp_receive(int sock, uint8_t* buffer, size_t size, uint32_t timeout_ms) {
+    if (timeout_ms != UINT32_MAX) {
+        fd_set ready;
+        FD_ZERO(&ready);
+        FD_SET(sock, &ready);
+        struct timeval tv;
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        int n = select(sock + 1, &ready, nullptr, nullptr, &tv);
+        if (n <= 0) return n;
+    }
+    int n = recv(sock, buffer, size, 0);
+    return n < 0 ? -1 : n;
+}
+#else
+int hal_udp_open(uint16_t port) {
+    (void)port;
+    return -1;
+}
+
+bool hal_udp_join(int sock, uint32_t group) {
+    (void)sock;
+    (void)group;
+    return false;
+}
+
+int hal_udp_receive(int sock, uint8_t* buffer, size_t size, uint32_t timeout_ms) {
+    (void)sock;
+    (void)buffer;
+    (void)size;
+    (void)timeout_ms;
+    return -1;
+}
+#endif
+
+// ============================================================================
+// TASKS
+// ============================================================================
+bool hal_task_start(hal_task_fn fn, const char* name, uint32_t stack_size, uint8_t priority, int core,
+                    hal_task_t* task) {
+    (void)fn;
+    (void)name;
+    (void)stack_size;
+    (void)priority;
+    (void)core;
+    if (task) *task = nullptr;
+    return false;
+}
+
+bool hal_task_wait_until(uint32_t* last_wake, uint32_t period_ms) {
+    *last_wake = fake_millis + period_ms;
+    fake_millis += period_ms;
+    return true;
+}
+
+void hal_task_wait(uint32_t max_ms) {
+    fake_millis += max_ms;
+}
+
+void hal_task_notify(hal_task_t task) {
+    (void)task;
+}
+
+void hal_net_lock() {
+}
+
+bool hal_net_try_lock(uint32_t timeout_ms) {
+    if (fake_net_busy) fake_millis += timeout_ms;
+    return !fake_net_busy;
+}
+
+void hal_net_unlock() {
+}
+
+void hal_loop_wait(uint32_t max_ms) {
+    fake_millis += max_ms;
+}
+
+void hal_loop_wake() {
+}
+
+// ============================================================================
+// POWER
+// ============================================================================
+// Counts the holds so tests can check they balance and what is held
+HalPowerMode hal_power_begin(bool light_sleep) {
+    fake_power_on = true;
+    return light_sleep ? HAL_POWER_LIGHT_SLEEP : HAL_POWER_DFS;
+}
+
+void hal_power_busy(bool busy) {
+    if (fake_power_on) fake_power_busy += busy ? 1 : -1;
+}
+
+void hal_power_stay_awake(bool awake) {
+    if (fake_power_on) fake_power_awake += awake ? 1 : -1;
+}
+
+// ============================================================================
+// SYSTEM
+// ============================================================================
+uint32_t hal_chip_id() {
+    return 0x00C0FFEE;
+}
+
+void hal_restart() {
+}
+
+uint32_t hal_free_heap() {
+    return fake_free_heap;
+}
+
+uint32_t hal_min_free_heap() {
+    return fake_min_free_heap;
+}
+
+uint32_t hal_largest_free_block() {
+    return fake_largest_block;
+}
+
+// ============================================================================
+// NATIVE FAKE CONTROLS
+// ============================================================================
+void hal_fake_reset() {
+    fake_millis = 0;
+    fake_time_valid = false;
+    fake_utc_offset = 120;
+    for (int i = 0; i < HAL_FAKE_PWM_CHANNELS; i++) {
+        fake_pwm[i] = 0;
+        fake_pwm_fade[i] = 0;
+        fake_pwm_fade_end[i] = 0;
+    }
+    fake_pwm_stalls = 0;
+    fake_nvs.clear();
+    fake_nvs_write_count = 0;
+    fake_nvs_read_count = 0;
+    fake_wifi_connected = false;
+    fake_wifi_rssi = -60;
+    fake_wifi_begins[0] = fake_wifi_begins[1] = 0;
+    fake_wifi_reconnects = 0;
+    fake_random = 0x9E3779B9;
+    fake_ap_running = false;
+    fake_wifi_sleep = false;
+    fake_power_on = false;
+    fake_power_busy = fake_power_awake = 0;
+    fake_net_busy = false;
+    fake_free_heap = fake_min_free_heap = 180000;
+    fake_largest_block = 110000;
+    hal_fake_log_resize(HAL_FAKE_LOG_DEFAULT_SIZE);
+}
+
+void hal_fake_advance_millis(uint32_t ms) {
+    fake_millis += ms;
+}
+
+void hal_fake_set_local_time(int hour, int minute) {
+    fake_time = {};
+    fake_time.tm_year = 126;
+    fake_time.tm_mon = 5;
+    fake_time.tm_mday = 21;
+    fake_time.tm_wday = 0;    // Sunday
+    fake_time.tm_yday = 171;
+    fake_time.tm_hour = hour;
+    fake_time.tm_min = minute;
+    fake_time_valid = true;
+}
+
+void hal_fake_clear_local_time() {
+    fake_time_valid = false;
+}
+
+void hal_fake_set_utc_offset(int minutes) {
+    fake_utc_offset = minutes;
+}
+
+void hal_fake_set_wifi(bool connected, int rssi) {
+    bool was_connected = fake_wifi_connected;
+    fake_wifi_connected = connected;
+    fake_wifi_rssi = rssi;
+    if (!fake_wifi_callback || was_connected == connected) return;
+    if (connected) {
+        fake_wifi_callback(HAL_WIFI_STA_CONNECTED, 0);
+        fake_wifi_callback(HAL_WIFI_STA_GOT_IP, 0);
+    } else {
+        fake_wifi_callback(HAL_WIFI_STA_DISCONNECTED, 8);
+    }
+}
+
+uint32_t hal_fake_pwm_duty(uint8_t channel) {
+    return channel < HAL_FAKE_PWM_CHANNELS ? fake_pwm[channel] : 0;
+}
+
+uint32_t hal_fake_pwm_fade_ms(uint8_t channel) {
+    return channel < HAL_FAKE_PWM_CHANNELS ? fake_pwm_fade[channel] : 0;
+}
+
+uint32_t hal_fake_pwm_stalls() {
+    return fake_pwm_stalls;
+}
+
+uint32_t hal_fake_nvs_writes() {
+    return fake_nvs_write_count;
+}
+
+uint32_t hal_fake_nvs_reads() {
+    return fake_nvs_read_count;
+}
+
+void hal_fake_set_heap(uint32_t free_bytes, uint32_t largest_block) {
+    fake_free_heap = free_bytes;
+    if (free_bytes < fake_min_free_heap) fake_min_free_heap = free_bytes;
+    fake_largest_block = largest_block;
+}
+
+void hal_fake_log_resize(uint32_t bytes) {
+    fake_log.assign(bytes, 0xFF);
+    fake_log_erases.assign(bytes / HAL_FAKE_LOG_SECTOR, 0);
+}
+
+uint32_t hal_fake_log_erases(uint32_t sector) {
+    return sector < fake_log_erases.size() ? fake_log_erases[sector] : 0;
+}
+
+bool hal_fake_ap_running() {
+    return fake_ap_running;
+}
+
+bool hal_fake_wifi_sleep() {
+    return fake_wifi_sleep;
+}
+
+uint32_t hal_fake_wifi_begins(bool fast) {
+    return fake_wifi_begins[fast ? 1 : 0];
+}
+
+uint32_t hal_fake_wifi_reconnects() {
+    return fake_wifi_reconnects;
+}
+
+int hal_fake_power_holds(bool awake) {
+    return awake ? fake_power_awake : fake_power_busy;
+}
+
+void hal_fake_net_busy(bool busy) {
+    fake_net_busy = busy;
+}
+
+#endif  // !ARDUINO
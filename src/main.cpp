@@ -5,7 +5,7 @@
  * Repurposed for PWM grow light control with MQTT/Home Assistant integration
  *
  * Hardware: ESP32-WROOM-32 (DevKit V1)
- * PWM Channels:
+ * PWM Channels (see LIGHT_CHANNELS, up to 16):
  *   - White: GPIO 16
  *   - Red:   GPIO 17
  *   - UV:    GPIO 18
@@ -13,41 +13,176 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
-#include <Preferences.h>
+#include <ESPAsyncWebServer.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
 #include <ArduinoOTA.h>
+#include <math.h>
 #include <time.h>
 
+#include "dmx_packet.h"
+#include "hal.h"
+#include "lockfree.h"
+#include "metrics.h"
+#include "mqtt_command.h"
+#include "nvs_cache.h"
+#include "pwm_curve.h"
+#include "schedule.h"
+#include "settings_blob.h"
+#include "simulation.h"
+#include "solar.h"
+#include "telemetry_log.h"
+#include "timer_queue.h"
+#include "web_assets.h"
+
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "3.3.0"  // boot log, /status, /metrics and the HA device
+#endif
+
 // ============================================================================
-// PIN DEFINITIONS
+// LIGHT CHANNELS
 // ============================================================================
-#define PWM_WHITE_PIN   16
-#define PWM_RED_PIN     17
-#define PWM_UV_PIN      18
-
+// Upplösning och frekvens kan sättas från build_flags (-D PWM_RESOLUTION=14).
+// LEDC-klockan är 80 MHz: frekvens × 2^bitar får inte överstiga den.
+#ifndef PWM_FREQ
 #define PWM_FREQ        5000
-#define PWM_RESOLUTION  8  // 0-255
+#endif
+#ifndef PWM_RESOLUTION
+#define PWM_RESOLUTION  12  // 0-4095
+#endif
+#ifndef PWM_PERCEPTUAL
+#define PWM_PERCEPTUAL  1   // CIE lightness curve, 0 = duty linear in level
+#endif
+
+#define PWM_MANUAL_FADE_MS  300    // manual changes glide instead of jump
+#define SUN_UPDATE_INTERVAL_MS 10000  // sun target recomputed, then faded in hardware
+#define SUN_FADE_MS         1000   // well inside the interval: a channel mid-fade holds back other writes
+
+static_assert(PWM_RESOLUTION >= 8 && PWM_RESOLUTION <= 16, "PWM_RESOLUTION must be 8-16 bits");
+static_assert((uint64_t)PWM_FREQ << PWM_RESOLUTION <= 80000000ULL, "PWM_FREQ too high for PWM_RESOLUTION");
 
-#define PWM_CHANNEL_WHITE 0
-#define PWM_CHANNEL_RED   1
-#define PWM_CHANNEL_UV    2
+// 0-65535 level → duty, built at compile time
+constexpr PwmCurve<PWM_RESOLUTION, PWM_PERCEPTUAL> PWM_CURVE;
+static_assert(PWM_CURVE.at(0) == 0 && PWM_CURVE.at(0xFFFF) == PWM_CURVE.MAX_DUTY, "PWM curve endpoints");
+
+#define UV_LIMITER_PERCENTAGE 80  // UV max 80% of white (safety feature)
+
+// En rad per kanal - PWM, NVS, MQTT-topics, HA discovery och webbgränssnittet
+// byggs från den här tabellen. Lägg till en rad för en ny kanal.
+struct LightChannel {
+    const char* name;       // MQTT topics, JSON keys, HA unique_id
+    const char* label;      // UI and HA entity name
+    const char* nvs_key;    // last manual level (max 15 chars)
+    const char* color;      // slider accent in the UI
+    uint8_t pin;
+    uint8_t ledc;           // LEDC channel 0-15
+    uint8_t max_level;      // hard ceiling, applied to every update
+    uint8_t sun_percent;    // share of the sun level in the default schedule
+    int8_t limit_to;        // interlock: never above limit_percent of this channel (-1 = none)
+    uint8_t limit_percent;
+    uint16_t ppfd;          // µmol/m²/s at the canopy at full output (default calibration, 0 = not PAR)
+    int8_t rgbw;            // component in the combined HA light: 0-3 = r/g/b/w, -1 = not in it
+};
+
+constexpr LightChannel LIGHT_CHANNELS[] = {
+    // name    label    NVS key       color      pin ledc max  sun  limit_to limit %  ppfd rgbw
+    {"white", "White", "LIGHTWHITE", "#ffffff", 16, 0, 255, 100, -1, 0, 250, 3},
+    {"red",   "Red",   "LIGHTRED",   "#ff4444", 17, 1, 255, 100, -1, 0, 150, 0},
+    {"uv",    "UV",    "LIGHTUV",    "#9944ff", 18, 2, 255, 100, 0, UV_LIMITER_PERCENTAGE, 0, -1},
+    // {"far_red", "Far Red", "LIGHTFARRED", "#aa0000", 19, 3, 255, 100, -1, 0, 0, -1},
+    // {"blue",    "Blue",    "LIGHTBLUE",   "#4466ff", 21, 4, 255, 100, -1, 0, 100, 1},
+    // {"uvb",     "UV-B",    "LIGHTUVB",    "#cc66ff", 22, 5, 128,  50,  0, 30, 0, -1},
+};
+constexpr uint8_t LIGHT_CHANNEL_COUNT = sizeof(LIGHT_CHANNELS) / sizeof(LIGHT_CHANNELS[0]);
+
+// Interlocks are applied in table order, so a channel may only be limited
+// by one listed before it. Each rgbw component drives one channel at most.
+constexpr bool light_channels_valid() {
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        if (LIGHT_CHANNELS[ch].ledc > 15) return false;
+        if (LIGHT_CHANNELS[ch].limit_to >= (int8_t)ch) return false;
+        if (LIGHT_CHANNELS[ch].rgbw > 3) return false;
+        for (uint8_t other = 0; other < ch; other++) {
+            if (LIGHT_CHANNELS[ch].rgbw >= 0 && LIGHT_CHANNELS[other].rgbw == LIGHT_CHANNELS[ch].rgbw) return false;
+        }
+    }
+    return true;
+}
+static_assert(LIGHT_CHANNEL_COUNT >= 1 && LIGHT_CHANNEL_COUNT <= 16, "ESP32 LEDC has 16 channels");
+static_assert(light_channels_valid(), "LIGHT_CHANNELS: bad LEDC channel, interlock order or rgbw component");
 
-// Sol-simulering tidsschema
+// Standardschema (när inget eget schema sparats, se /schedule)
 #define SUNRISE_START_HOUR   6   // 06:00 - Soluppgång börjar
 #define SUNRISE_END_HOUR     10  // 10:00 - Full ljusstyrka
 #define SUNSET_START_HOUR    18  // 18:00 - Skymning börjar
 #define SUNSET_END_HOUR      22  // 22:00 - Mörker
 
+#define SCHEDULE_MAX_TEXT 2048  // NVS string and MQTT payload limit
+#define SIM_HTTP_MAX_ROWS 20000  // /simulate: days * 86400 / step
+
+// Async web server: bodies are collected in RAM up to this size (413 above),
+// streamed responses are produced this many bytes at a time
+#define WEB_BODY_MAX        4096
+#define HTTP_STREAM_BUFFER  1024
+#define RESTART_DELAY_MS    1000  // /saveSettings: let the response go out first
+#define WEB_LOCK_TIMEOUT_MS 2000  // a handler waits this long for the net lock, then answers 503
+
+// Telemetry log (/telemetry.csv): a level change is logged at most this often
+#define TELEMETRY_LEVELS_AUTO_MS    300000   // sun ramps, one row per 5 min
+#define TELEMETRY_LEVELS_MANUAL_MS  10000    // slider drags
+#define TELEMETRY_HEARTBEAT_MS      3600000  // a row every hour even when idle
+
 #define MANUAL_OVERRIDE_DURATION 2400000  // 40 minuter i millisekunder
-#define UV_LIMITER_PERCENTAGE 80  // UV max 80% of white (safety feature)
+
+// Network side deadlines (timer_queue.h). loop() sleeps until the next one;
+// while something without a wake-up of its own needs polling (PubSubClient,
+// the inline light step) it still runs every LOOP_POLL_MS.
+#define LOOP_POLL_MS        10
+#define LOOP_POLL_SAVE_MS   100      // the same in power save: about one DTIM beacon
+#define OTA_POLL_MS         100      // ArduinoOTA.handle(), once WiFi is up
+#define WIFI_BACKOFF_MIN_MS 10000    // reconnect while the link stays down: 5-10 s,
+#define WIFI_BACKOFF_MAX_MS 120000   // doubling up to 1-2 min (timer_queue.h Backoff)
+#define TIME_SYNC_POLL_MS   1000     // is the clock set yet?
+#define NTP_RETRY_MS        300000   // restart SNTP if still not synced
+#define MQTT_BACKOFF_MIN_MS 5000     // broker retries after the first: 2.5-5 s,
+#define MQTT_BACKOFF_MAX_MS 300000   // doubling up to 2.5-5 min
+#define SOLAR_CHECK_MS      60000    // new date → new sunrise/sunset
+
+// Daily Light Integral (mol/m²/day of PAR), integrated from the output duty
+#define DLI_PLAN_SLOTS        96       // target mode: dose left in the schedule, per 15 min
+#define DLI_SAVE_INTERVAL_MS  900000   // today's integral to NVS every 15 min
+#define DLI_PUBLISH_MS        60000    // bastun/vaxtljus/dli at most once a minute
+
+// Ljusstyrning kör i egen task på core 0, nätverk (loop) på core 1
+#define LIGHT_TASK_CORE          0
+#define LIGHT_TASK_PRIORITY      5
+#define LIGHT_TASK_STACK         4096
+#define LIGHT_TASK_PERIOD_MS     10
+#define LIGHT_COMMAND_QUEUE_SIZE 32
+
+// DMX over UDP (Art-Net / sACN): frames go straight to the light task
+#define DMX_TASK_STACK     3072
+#define DMX_TASK_PRIORITY  (LIGHT_TASK_PRIORITY + 1)  // same core: read, then the light task runs
+#define DMX_TIMEOUT_MS     2500   // E1.31 network data loss, then the schedule takes over again
+#define DMX_PUBLISH_MS     1000   // light state to MQTT/SSE at most this often while streaming
+
+// Power save: the CPU idles at 80 MHz, the chip light-sleeps when nothing is
+// due and the light task only wakes for commands and sun steps
+#define POWER_REPORT_MS 60000  // CPU duty cycle and wakes, per window
+
+// Server-Sent Events (/events) - dashboarden får ändringar push:ade
+#define EVENTS_MAX_CLIENTS   4
+#define EVENTS_KEEPALIVE_MS  15000  // full state: repairs dropped deltas, keeps proxies from timing out
+#define EVENTS_BUFFER_SIZE   (192 + LIGHT_CHANNEL_COUNT * 24)
+
+// /status snapshot: rendered when the state moves
+#define STATUS_BUFFER_SIZE   1024
 
 // ============================================================================
 // GLOBAL VARIABLES
 // ============================================================================
-Preferences settings;
-WebServer server(80);
+AsyncWebServer server(80);
+AsyncEventSource events("/events");
 WiFiClient espClient;
 PubSubClient mqtt(espClient);
 
@@ -63,69 +198,520 @@ uint16_t mqtt_port = 1883;
 String mqtt_user = "";
 String mqtt_password = "";
 bool mqtt_enabled = false;
-
-// Light state (0-255)
-uint8_t light_white = 0;
-uint8_t light_red = 0;
-uint8_t light_uv = 0;
+bool mqtt_channel_topics = false;  // also publish legacy <channel>/state topics
+
+// Power save (settings page). Read at boot only, a change restarts.
+bool power_save = false;
+HalPowerMode power_mode = HAL_POWER_OFF;  // what hal_power_begin() could turn on
+const char* POWER_MODE_NAMES[] = {"off", "dfs", "light_sleep"};
+bool ap_running = false;  // power save stops the AP while the station is up
+
+// DMX receiver (settings page). Read at boot only, a change restarts.
+uint8_t dmx_protocol = DMX_OFF;
+uint16_t dmx_universe = 0;  // Art-Net port address 0-32767, sACN 1-63999
+uint16_t dmx_address = 1;   // slot of the first channel, the rest follow in table order
+const char* DMX_PROTOCOL_NAMES[] = {"off", "artnet", "sacn"};
+
+// Location for sunrise/sunset (default Stockholm)
+float latitude = 59.33f;
+float longitude = 18.07f;
+
+// DLI: calibration per channel (µmol/m²/s at full output) and the daily
+// target in mol/m² (0 = off). Set before the light task starts, read-only after.
+uint16_t light_ppfd[LIGHT_CHANNEL_COUNT];
+float dli_target = 0.0f;
+
+// Settings blob (settings_blob.h); how this boot got its settings, for /metrics
+#define SETTINGS_NVS_KEY "SETTINGS"
+static_assert(LIGHT_CHANNEL_COUNT <= SETTINGS_CHANNELS, "Settings blob has no PPFD slot for every channel");
+const char* settings_source = "defaults";  // "blob", "migrated" (old keys) or "rebuilt" (bad blob)
+uint32_t settings_load_us = 0;
+
+// Light state (0-255) as last reported by the light task (network side view),
+// indexed like LIGHT_CHANNELS
+uint8_t light_levels[LIGHT_CHANNEL_COUNT] = {};
+const char* light_channel_names[LIGHT_CHANNEL_COUNT];  // for mqtt_parse_batch()
+
+// Today's DLI per channel in µmol/m² (network side view) and the day it
+// belongs to (tm_year * 1000 + tm_yday, -1 = unknown)
+uint32_t light_dli[LIGHT_CHANNEL_COUNT] = {};
+int32_t light_dli_day = -1;
+uint8_t light_dli_percent = 100;
+const char* const DLI_NVS_KEYS[16] = {"DLI0", "DLI1", "DLI2", "DLI3", "DLI4", "DLI5", "DLI6", "DLI7",
+                                      "DLI8", "DLI9", "DLI10", "DLI11", "DLI12", "DLI13", "DLI14", "DLI15"};
 
 // MQTT topics
 const char* TOPIC_BASE = "bastun/vaxtljus";
 const char* HA_DISCOVERY_PREFIX = "homeassistant";
 
-// Timing
-unsigned long lastMqttReconnect = 0;
-unsigned long lastWifiCheck = 0;
-bool ha_discovery_sent = false;
-
-// Sol-simulering variabler
+// Topics are built once in init_mqtt(), publishing never allocates
+char topic_state[64];               // bastun/vaxtljus/state (JSON, retained)
+char topic_channel_state[LIGHT_CHANNEL_COUNT][64];  // bastun/vaxtljus/<channel>/state (legacy)
+char topic_channel_set[LIGHT_CHANNEL_COUNT][64];    // bastun/vaxtljus/<channel>/set
+char topic_batch_set[64];           // bastun/vaxtljus/set (JSON, all channels)
+char topic_schedule[64];            // bastun/vaxtljus/schedule (text, retained)
+char topic_schedule_set[64];        // bastun/vaxtljus/schedule/set
+char topic_schedule_error[64];      // bastun/vaxtljus/schedule/error
+char topic_dli[64];                 // bastun/vaxtljus/dli (JSON, retained)
+char topic_light_set[64];           // bastun/vaxtljus/light/set (HA JSON-schema light)
+char topic_ha_status[64];           // homeassistant/status ("online" after HA starts)
+
+// Incoming topics → channel, matched by precomputed hash
+#define MQTT_ROUTE_COUNT (LIGHT_CHANNEL_COUNT + 4)
+MqttRoute mqtt_routes[MQTT_ROUTE_COUNT];
+
+// Home Assistant discovery: serialized once in init_mqtt(), then published as
+// is on every connect and when HA comes back online. One combined JSON-schema
+// light (the rgbw channels, effects for sun simulation / manual), a template
+// light per channel, and the DLI sensor.
+#define HA_DISCOVERY_COUNT   (LIGHT_CHANNEL_COUNT + 2)
+#define HA_DISCOVERY_BUFFER  4096
+#define HA_EFFECT_SUN        "Sun simulation"
+#define HA_EFFECT_MANUAL     "Manual"
+struct HaDiscovery {
+    char topic[80];
+    const char* payload;  // into ha_discovery_json, null if it did not fit
+};
+HaDiscovery ha_discovery[HA_DISCOVERY_COUNT];
+char ha_discovery_json[HA_DISCOVERY_BUFFER];
+uint16_t ha_discovery_bytes = 0;
+
+// Combined light as HA sees it, worked out from the channel levels
+struct HaLightColor {
+    bool on;
+    uint8_t brightness;
+    uint8_t rgbw[4];
+};
+
+// What an ON without colour or brightness comes back with after OFF; only
+// ha_light_command() updates it
+HaLightColor ha_light_last = {true, 255, {0, 0, 0, 255}};
+
+// Timing (the deadlines themselves are Timers, see TIMERS below)
+unsigned long lastTimeSync = 0;       // last SNTP (re)start
+Backoff wifi_backoff = BACKOFF_INIT(WIFI_BACKOFF_MIN_MS, WIFI_BACKOFF_MAX_MS);
+Backoff mqtt_backoff = BACKOFF_INIT(MQTT_BACKOFF_MIN_MS, MQTT_BACKOFF_MAX_MS);
+
+// Uppkopplingens tillståndsmaskin - driven från loop(), blockerar aldrig
+enum ConnState : uint8_t {
+    CONN_AP_ONLY,           // Inget SSID konfigurerat, endast AP
+    CONN_WIFI_CONNECTING,   // Väntar på IP från routern
+    CONN_TIME_SYNCING,      // WiFi uppe, väntar på NTP
+    CONN_ONLINE             // WiFi + tid klar (MQTT sköts av mqtt_loop)
+};
+const char* CONN_STATE_NAMES[] = {"ap_only", "wifi_connecting", "time_syncing", "online"};
+
+ConnState conn_state = CONN_AP_ONLY;
+bool ota_started = false;
+bool ntp_started = false;
+uint32_t boot_first_light_ms = 0;
+uint32_t boot_online_ms = 0;
+
+// Set from the WiFi event task, consumed by connectivity_step()
+#define WIFI_EVENT_GOT_IP        0x01
+#define WIFI_EVENT_DISCONNECTED  0x02
+std::atomic<uint8_t> wifi_events{0};
+
+// Fast connect: the last link that got an IP, for the SSID it was learned
+// on. At boot the station joins that AP on that channel with those
+// addresses - no scan, no DHCP. A stale entry costs one retry period, then
+// the station scans and asks DHCP again. Raw struct in NVS; a blob of
+// another size (other firmware) is ignored and rewritten.
+#define WIFI_CACHE_NVS_KEY "WIFICACHE"
+struct WifiCache {
+    uint32_t ssid_crc;  // settings_crc() of the SSID
+    HalWifiLink link;
+};
+WifiCache wifi_cache;
+bool wifi_cache_valid = false;
+bool wifi_fast_connecting = false;  // begun from the cache, no IP yet
+bool wifi_fast_boot = false;        // this boot's first IP came that way
+
+// Sol-simulering variabler (network side view)
 bool autoMode = true;
-unsigned long manualOverrideStart = 0;
-unsigned long lastSunUpdate = 0;
+
+// Schedule: text kept on the network side, compiled table handed to the
+// light task through a seqlock (read once per sun update)
+String schedule_text;
+Schedule schedule_staging;
+Seqlock<Schedule> schedule_shared;
+SolarDay solar_day;
+int solar_day_key = -1;  // tm_yday solar_day was computed for, -1 = date unknown
+
+// Light task <-> network: commands go in through a lock-free queue, state
+// comes back as a seqlock snapshot. Neither side ever waits for the other.
+enum LightCommandType : uint8_t {
+    LIGHT_CMD_SET,          // one or more channels, applied together
+    LIGHT_CMD_EXIT_MANUAL,
+    LIGHT_CMD_SUN_REFRESH,
+    LIGHT_CMD_BLACKOUT
+};
+
+struct LightCommand {
+    LightCommandType type;
+    uint16_t mask;                        // LIGHT_CMD_SET: bit n = channel n present in values
+    uint8_t values[LIGHT_CHANNEL_COUNT];  // indexed like LIGHT_CHANNELS
+};
+
+struct LightState {
+    uint8_t levels[LIGHT_CHANNEL_COUNT];
+    bool auto_mode;
+    uint32_t manual_changes;  // bumps on user changes, network side persists them
+    bool dmx;                 // a DMX stream drives the outputs, the schedule waits
+};
+
+// Running DLI, on its own seqlock: it moves on every sun step, LightState
+// only when an output or the mode does. Read by the DLI timers and /status.
+struct LightDli {
+    uint32_t umol[LIGHT_CHANNEL_COUNT];  // µmol/m² today, per channel
+    int32_t day;                         // tm_year * 1000 + tm_yday, -1 = unknown
+    uint8_t percent;                     // target mode: output as % of the schedule's, 100 otherwise
+};
+
+SpscQueue<LightCommand, LIGHT_COMMAND_QUEUE_SIZE> light_commands;  // network → light
+Seqlock<LightState> light_state_shared;                           // light → network
+Seqlock<LightDli> light_dli_shared;                               // light → network
+bool light_task_inline = false;  // no task available (native build), step from loop()
+hal_task_t light_task_handle = nullptr;  // send_light_command() wakes it in power save
+uint32_t light_state_seen = 0;
+uint32_t light_manual_seen = 0;
+uint32_t light_dli_seen = 0;
+
+// DMX receiver → light task. Only the newest frame matters, so a seqlock
+// rather than a queue: the receiver never waits and nothing backs up.
+struct DmxFrame {
+    uint8_t values[LIGHT_CHANNEL_COUNT];
+    uint16_t mask;         // channels the packet reached
+    bool terminated;       // sACN source said goodbye
+    uint32_t received_us;  // hal_micros() when the datagram was read
+};
+
+Seqlock<DmxFrame> dmx_shared;
+bool dmx_inline = false;  // no task available (native build), poll from loop()
+int dmx_socket = -1;
+bool dmx_active = false;  // network side view of LightState::dmx
+std::atomic<uint32_t> dmx_frames{0};    // handed to the light task
+std::atomic<uint32_t> dmx_rejected{0};  // malformed, wrong protocol or out of order
+
+// Light task timing, readable from any task
+std::atomic<uint32_t> light_jitter_avg_us{0};
+std::atomic<uint32_t> light_jitter_max_us{0};
+std::atomic<uint32_t> light_step_max_us{0};
+
+// Light engine: everything the control logic decides from. The clock is
+// passed in, so light_simulate() can run a copy on virtual time.
+struct LightEngine {
+    LightState state;
+    LightDli dli;
+    uint16_t fine[LIGHT_CHANNEL_COUNT];  // 16-bit levels behind state.levels
+    uint32_t duty[LIGHT_CHANNEL_COUNT];  // last duty sent to each output
+    bool blackout;
+    bool simulated;             // no outputs, no logging, nothing published
+    uint32_t manual_start;      // ms, when manual override began
+    uint32_t last_sun_update;   // ms
+    const Schedule* schedule;
+    int schedule_day;           // tm_yday the profile was picked for
+    int schedule_profile;
+    uint64_t dli_acc[LIGHT_CHANNEL_COUNT];  // ppfd × duty × ms since midnight
+    uint32_t dli_last;          // ms, last light_integrate()
+    uint32_t dli_target;        // µmol/m², 0 = run the schedule as is
+    uint32_t dli_plan[DLI_PLAN_SLOTS + 1];  // schedule's PAR dose from each slot to midnight, µmol/m²
+    uint32_t fade_until[LIGHT_CHANNEL_COUNT];  // ms, when each output's hardware fade ends
+    uint32_t held_fade[LIGHT_CHANNEL_COUNT];   // ms, fade of a duty held back by a running one
+    uint8_t held;               // bit per output with e.duty waiting for its fade to end
+    uint32_t dmx_last;          // ms, last DMX frame
+    uint32_t dmx_published;     // ms, last snapshot published while streaming
+};
+
+// Light task private state - only touched from light_control_step()
+Schedule light_schedule;
+uint32_t light_schedule_seen = 0;
+uint32_t light_dmx_seen = 0;
+LightEngine light_engine = {{{}, true, 0, false}, {{}, -1, 100}, {}, {}, false, false, 0, 0, &light_schedule, -1, -1,
+                           {}, 0, 0, {}, {}, {}, 0, 0, 0};
+LightState light_engine_published = {{}, true, 0, false};
+LightDli light_dli_published = {{}, -1, 100};
+uint32_t light_last_step_us = 0;
+std::atomic<bool> light_awake_held{false};  // hal_power_stay_awake() while an output is mid duty
+
+// Live state pushed to /events subscribers; only changed fields are sent
+struct EventState {
+    uint8_t levels[LIGHT_CHANNEL_COUNT];
+    bool auto_mode;
+    ConnState conn_state;
+    bool wifi_connected;
+    bool mqtt_connected;
+};
+
+EventState event_state_sent = {};
+std::atomic<bool> events_snapshot_due{false};  // new subscriber, or the keepalive timer
+uint32_t events_sent = 0;
+
+// /status is served from a pre-rendered snapshot. status_version moves
+// with the lights, the mode and connectivity (status_step()), the day's sun
+// times and the DLI as the timers pull it (once a minute at most); the
+// snapshot is re-rendered on the next request after that and holds nothing
+// else that moves. Counters and timings live in /metrics. The ETag is a
+// hash of the body, so a poll that finds nothing new gets a bodyless 304.
+char status_json[STATUS_BUFFER_SIZE];
+size_t status_length = 0;
+char status_etag[12];
+uint32_t status_version = 1;
+uint32_t status_rendered_version = 0;
+EventState status_state_seen = {};
+uint32_t status_renders = 0;
+uint32_t status_not_modified = 0;
+
+// Runtime metrics (/metrics). One histogram per timed section of loop(),
+// plus the light task's sun update.
+enum MetricSection : uint8_t {
+    METRIC_OTA,           // ArduinoOTA.handle(), every OTA_POLL_MS
+    METRIC_HTTP,          // route handlers and stream fills, on the async_tcp task
+    METRIC_TIMERS,        // timers_run(): every callback due on this pass
+    METRIC_CONNECTIVITY,  // connectivity_step()
+    METRIC_MQTT,
+    METRIC_LIGHT_STATE,   // process_light_state() (+ inline light step)
+    METRIC_EVENTS,        // events_loop() + telemetry_step()
+    METRIC_NVS_COMMIT,    // only commits that wrote to flash (inside "timers")
+    METRIC_SUN_UPDATE,    // light task, only steps that recomputed the target
+    METRIC_LIGHT_TASK,    // light task, every step (count = wakes)
+    METRIC_SECTION_COUNT
+};
+
+Histogram metric_loop = {"loop", {}, 0, 0, 0};
+Histogram metric_sections[METRIC_SECTION_COUNT] = {
+    {"ota", {}, 0, 0, 0},
+    {"http", {}, 0, 0, 0},
+    {"timers", {}, 0, 0, 0},
+    {"connectivity", {}, 0, 0, 0},
+    {"mqtt", {}, 0, 0, 0},
+    {"light_state", {}, 0, 0, 0},
+    {"events", {}, 0, 0, 0},
+    {"nvs_commit", {}, 0, 0, 0},
+    {"sun_update", {}, 0, 0, 0},
+    {"light_task", {}, 0, 0, 0},
+};
+Histogram metric_dmx_latency = {"dmx", {}, 0, 0, 0};  // datagram read → outputs written, light task
+
+// Power report: busy time and wakes of each task over the last
+// POWER_REPORT_MS, from the histograms' sums and counts. The light task
+// and HTTP handlers run inside loop() on the native build.
+#define POWER_TASK_COUNT 3
+Histogram* const POWER_TASKS[POWER_TASK_COUNT] = {&metric_loop, &metric_sections[METRIC_LIGHT_TASK],
+                                                  &metric_sections[METRIC_HTTP]};
+struct PowerReport {
+    uint16_t duty_permille[POWER_TASK_COUNT];  // busy share of one core
+    uint32_t wakes[POWER_TASK_COUNT];
+    uint32_t window_ms;                        // 0 until the first report
+};
+PowerReport power_report = {};
+uint32_t mqtt_connects = 0;
+uint32_t mqtt_connect_failures = 0;
+bool mqtt_connecting = false;  // connect() runs without the net lock, nothing else may touch the client
+std::atomic<uint32_t> http_busy_rejects{0};  // 503s: the net lock was not free in WEB_LOCK_TIMEOUT_MS
+
+// Slow network I/O flagged by the timers, run by net_io_step() without the lock
+bool mqtt_connect_due = false;
+bool ota_due = false;
+bool nvs_commit_due = false;
+
+// Time from losing a link to having it back. The first connect after boot is
+// boot_online_ms, not a reconnect.
+struct ReconnectStats {
+    const char* link;  // metrics label
+    bool down;
+    uint32_t down_since;
+    uint32_t count;
+    uint32_t last_ms;
+    uint32_t max_ms;
+    uint64_t total_ms;
+};
+ReconnectStats wifi_reconnect = {"wifi", false, 0, 0, 0, 0, 0};
+ReconnectStats mqtt_reconnect = {"mqtt", false, 0, 0, 0, 0, 0};
+uint32_t mqtt_publishes = 0;
+uint32_t mqtt_publish_failures = 0;
+
+// Telemetry log: the last logged snapshot, for change detection
+uint8_t telemetry_levels[LIGHT_CHANNEL_COUNT] = {};
+uint8_t telemetry_flags = 0;
+uint32_t telemetry_last_ms = 0;
+bool telemetry_booted = false;
+bool telemetry_time_known = false;
+
+// Response body produced on demand, a buffer at a time, as AsyncTCP asks
+// for more (/simulate, /telemetry.csv). produce() appends whole rows and
+// returns false once the body is complete.
+struct HttpStream {
+    char buf[HTTP_STREAM_BUFFER];
+    size_t len;
+    size_t sent;
+    bool done;
+    bool (*produce)(HttpStream& out);
+};
 
 // ============================================================================
 // FORWARD DECLARATIONS
 // ============================================================================
 void init_wifi();
+void on_wifi_event(HalWifiEvent event, int reason);
 void init_ota();
 void init_mqtt();
 void init_webserver();
 void init_pwm();
 void load_settings();
 void save_settings();
-void wifi_monitor();
+void settings_defaults(Settings* s);
+void settings_from_keys(Settings* s);
+void settings_apply(const Settings& s);
+void settings_collect(Settings* s);
+void connectivity_step();
+void conn_wifi_up();
+void conn_timer_step();
+bool wifi_cache_load();
+void wifi_cache_store();
+void reconnect_lost(ReconnectStats& stats);
+void reconnect_done(ReconnectStats& stats);
+void set_conn_state(ConnState state);
+void ota_step();
 void mqtt_loop();
+void mqtt_connect();
+bool mqtt_up();
+void net_io_step();
 void mqtt_callback(char* topic, byte* payload, unsigned int length);
-void publish_state(const char* channel, uint8_t value);
+void publish_state(uint8_t channel, uint8_t value);
+void publish_mqtt_state(bool force);
+void init_ha_discovery();
 void publish_ha_discovery();
+void ha_light_command(const HaLightCommand& cmd);
+HaLightColor ha_light_color(const uint8_t* levels);
 void set_light(uint8_t channel, uint8_t value);
-void set_light_direct(uint8_t white, uint8_t red, uint8_t uv);
+void set_lights(uint16_t mask, const uint8_t* values);
+void light_apply_levels(LightEngine& e, const uint16_t* levels, uint32_t fade_ms);
+void light_output(LightEngine& e, uint8_t ch, uint32_t fade_ms, uint32_t now);
+void light_output_held(LightEngine& e, uint32_t now);
+void send_light_command(LightCommandType type);
+void send_light_command(const LightCommand& cmd);
+void process_light_state();
+void process_light_dli();
+void init_light_task();
+void light_task(void* arg);
+void light_control_step(bool periodic = true);
+bool light_outputs_steady(const LightEngine& e, uint32_t now);
+uint32_t light_idle_ms();
+void light_apply_command(LightEngine& e, const LightCommand& cmd, uint32_t now);
+void light_apply_dmx(LightEngine& e, const DmxFrame& frame, uint32_t now);
+void light_dmx_release(LightEngine& e, uint32_t now);
+void publish_light_state();
+void publish_light_dli();
 void update_sun_simulation();
-uint8_t calculate_light_level(int hour, int minute);
+void light_sun_step(LightEngine& e, uint32_t now, const struct tm* local);
+void light_integrate(LightEngine& e, uint32_t now);
+uint32_t light_dli_umol(const LightEngine& e, uint8_t channel);
+void light_plan_dose(LightEngine& e);
+uint32_t light_dose_scale(const LightEngine& e, uint32_t second);
+void save_dli_state();
+void publish_dli(bool force);
+void nvs_schedule_commit();
+void nvs_commit_step();
+void init_schedule();
+String default_schedule();
+const String active_schedule_text();
+bool compile_schedule(const String& text, ScheduleError* err);
+bool update_schedule(const char* text, size_t length, ScheduleError* err);
+void publish_schedule();
+void solar_loop();
+void format_solar_time(char* buf, int16_t minute);
+int utc_offset_minutes(const struct tm& local, const struct tm& utc);
+void handle_simulate_request(AsyncWebServerRequest* request);
+AsyncWebServerResponse* http_stream_response(AsyncWebServerRequest* request, const char* content_type,
+                                             std::shared_ptr<HttpStream> stream);
+size_t http_stream_fill(HttpStream& out, uint8_t* buffer, size_t max_len);
+bool http_stream_room(const HttpStream& out, size_t len);
+void http_stream_write(HttpStream& out, const char* data, size_t len);
+void handle_metrics_request(AsyncWebServerRequest* request);
+void init_telemetry();
+void telemetry_step();
+void telemetry_log_event(TelemetryEvent event);
+uint8_t telemetry_current_flags();
+void handle_telemetry_request(AsyncWebServerRequest* request);
+bool mqtt_publish(const char* topic, const char* payload, bool retained);
 void init_time();
 int get_wifi_signal_strength();
-String get_index_html();
-String get_settings_html();
+void web_on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction handler);
+void web_collect_body(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
+const char* web_body(AsyncWebServerRequest* request, size_t* len);
+void serve_web_asset(AsyncWebServerRequest* request, const WebAsset* asset);
+void init_events();
+void events_loop();
+void init_timers();
+uint32_t loop_wait_ms();
+void init_power();
+void power_report_step();
+void init_dmx();
+void dmx_task(void* arg);
+void dmx_receive(uint32_t timeout_ms);
+EventState current_event_state();
+bool event_state_equal(const EventState& a, const EventState& b);
+void status_step();
+void status_render();
+void handle_status_request(AsyncWebServerRequest* request);
+int format_event(char* buf, size_t size, const EventState& now, const EventState* prev);
+uint8_t events_client_count();
+
+// ============================================================================
+// TIMERS
+// ============================================================================
+// Every deadline on the network side. The periodic ones start in
+// init_timers(), the rest are armed by whatever they follow up on.
+// telemetry_timer has no callback: telemetry_step() runs on every pass,
+// the timer only makes sure a pass happens when its next deadline is due.
+Timer conn_timer = TIMER_INIT("conn", conn_timer_step, 0);  // WiFi retry or NTP poll, per state
+Timer ota_timer = TIMER_INIT("ota", [] { ota_due = true; }, OTA_POLL_MS);
+Timer mqtt_timer = TIMER_INIT("mqtt", [] { mqtt_connect_due = true; }, 0);
+Timer solar_timer = TIMER_INIT("solar", solar_loop, SOLAR_CHECK_MS);
+Timer dli_save_timer = TIMER_INIT("dli_save", save_dli_state, DLI_SAVE_INTERVAL_MS);
+Timer dli_publish_timer = TIMER_INIT("dli_publish", [] { publish_dli(false); }, DLI_PUBLISH_MS);
+Timer events_timer = TIMER_INIT("events", [] { events_snapshot_due = true; }, EVENTS_KEEPALIVE_MS);
+Timer telemetry_timer = TIMER_INIT("telemetry", nullptr, 0);
+Timer nvs_timer = TIMER_INIT("nvs", [] { nvs_commit_due = true; }, 0);
+Timer restart_timer = TIMER_INIT("restart", hal_restart, 0);  // /saveSettings, once the response is out
+Timer power_timer = TIMER_INIT("power", power_report_step, POWER_REPORT_MS);
+
+void init_timers() {
+    timer_start(solar_timer, 0);
+    timer_start(dli_save_timer, DLI_SAVE_INTERVAL_MS);
+    timer_start(dli_publish_timer, DLI_PUBLISH_MS);
+    timer_start(events_timer, EVENTS_KEEPALIVE_MS);
+    timer_start(power_timer, POWER_REPORT_MS);
+}
 
 // ============================================================================
 // SETUP
 // ============================================================================
 void setup() {
     Serial.begin(115200);
-    delay(1000);
 
     Serial.println("\n\n=================================");
     Serial.println("  Vaxthus_Master_V3");
-    Serial.println("  Grow Light Controller");
+    Serial.println("  Grow Light Controller " FIRMWARE_VERSION);
     Serial.println("=================================\n");
 
+    // Ljuset först - inget i setup() får vänta på nätverket.
+    // WiFi, OTA, NTP och MQTT kommer upp i bakgrunden via connectivity_step().
     load_settings();
+    init_power();
     init_pwm();
+    init_schedule();
+    init_light_task();
+    init_telemetry();
+    init_timers();
+    boot_first_light_ms = hal_millis();
+    Serial.printf("[Boot] Lights restored after %u ms\n", boot_first_light_ms);
+
     init_wifi();
-    init_ota();
-    init_webserver();
+    init_dmx();  // after init_wifi(): sockets need the network stack
     init_mqtt();
-    init_time();
+    init_webserver();  // last: handlers may run from here on
 
     Serial.println("Setup complete!");
 }
@@ -134,12 +720,167 @@ void setup() {
 // MAIN LOOP
 // ============================================================================
 void loop() {
-    ArduinoOTA.handle();
-    server.handleClient();
-    wifi_monitor();
+    // Each lap closes one section and starts the next (see metrics.h)
+    // HTTP is served on the async_tcp task; it waits for this lock, never
+    // the other way round, so a slow client cannot stall the loop. The lock
+    // is released for net_io_step(), where a broker timeout or an OTA
+    // upload would otherwise hold every handler up.
+    hal_net_lock();
+    hal_power_busy(true);
+    uint32_t start = hal_cycle_count();
+    if (dmx_inline) dmx_receive(0);
+    if (light_task_inline) light_control_step();
+    process_light_state();  // timers below see the current light state
+    uint32_t t = metrics_lap(metric_sections[METRIC_LIGHT_STATE], start);
+    timers_run();
+    t = metrics_lap(metric_sections[METRIC_TIMERS], t);
+    connectivity_step();
+    t = metrics_lap(metric_sections[METRIC_CONNECTIVITY], t);
     mqtt_loop();
-    update_sun_simulation();
-    delay(10);
+    t = metrics_lap(metric_sections[METRIC_MQTT], t);
+    events_loop();
+    status_step();
+    telemetry_step();
+    metrics_lap(metric_sections[METRIC_EVENTS], t);
+    hal_net_unlock();
+
+    net_io_step();
+
+    hal_net_lock();
+    metrics_lap(metric_loop, start);
+    uint32_t wait = loop_wait_ms();
+    hal_power_busy(false);
+    hal_net_unlock();
+    hal_loop_wait(wait);
+}
+
+// Called without the net lock; each step takes it around the shared state it touches
+void net_io_step() {
+    if (mqtt_connect_due) {
+        mqtt_connect_due = false;
+        mqtt_connect();
+    }
+    if (ota_due) {
+        ota_due = false;
+        ota_step();
+    }
+    if (nvs_commit_due) {
+        nvs_commit_due = false;
+        nvs_commit_step();
+    }
+}
+
+// Until the next deadline. Light state, WiFi events and HTTP requests
+// wake loop() early (hal_loop_wake()); PubSubClient and the inline light
+// step cannot, so they are polled every LOOP_POLL_MS while active
+// (LOOP_POLL_SAVE_MS for PubSubClient in power save).
+uint32_t loop_wait_ms() {
+    uint32_t wait = timers_next();
+    uint32_t poll = TIMER_NONE;
+    if (mqtt_up()) poll = power_save ? LOOP_POLL_SAVE_MS : LOOP_POLL_MS;
+    if (light_task_inline) poll = LOOP_POLL_MS;
+    return wait < poll ? wait : poll;
+}
+
+// ============================================================================
+// POWER
+// ============================================================================
+// Before the light task starts, which reads power_mode. WiFi modem sleep is
+// turned on in init_wifi(), the AP goes down once the station is up.
+void init_power() {
+    if (!power_save) return;
+    power_mode = hal_power_begin(true);
+    Serial.printf("[Power] Power save: %s\n", POWER_MODE_NAMES[power_mode]);
+}
+
+// Every POWER_REPORT_MS: how much of the window each task spent awake and
+// busy. Runs in power save or not, so the two can be compared.
+void power_report_step() {
+    static uint64_t last_sum_us[POWER_TASK_COUNT] = {};
+    static uint32_t last_count[POWER_TASK_COUNT] = {};
+    static uint32_t last_ms = 0;
+
+    uint32_t now = hal_millis();
+    uint32_t window = now - last_ms;
+    last_ms = now;
+    if (window == 0) return;
+    for (uint8_t i = 0; i < POWER_TASK_COUNT; i++) {
+        const Histogram& h = *POWER_TASKS[i];
+        uint64_t sum = h.sum_us;
+        uint32_t count = h.count;
+        uint64_t permille = (sum - last_sum_us[i]) / window;  // µs per ms
+        power_report.duty_permille[i] = permille > 1000 ? 1000 : (uint16_t)permille;
+        power_report.wakes[i] = count - last_count[i];
+        last_sum_us[i] = sum;
+        last_count[i] = count;
+    }
+    power_report.window_ms = window;
+}
+
+// ============================================================================
+// DMX RECEIVER
+// ============================================================================
+// Art-Net or sACN frames from a lighting desk or show controller. The
+// receive task sits in recv() at a priority above the light task on the
+// same core, so a frame is parsed, handed over and on the outputs within
+// one scheduler switch - not on the next 10 ms step.
+void init_dmx() {
+    if (dmx_protocol == DMX_OFF) return;
+    uint16_t port = dmx_protocol == DMX_ARTNET ? ARTNET_PORT : SACN_PORT;
+    dmx_socket = hal_udp_open(port);
+    if (dmx_socket < 0) {
+        Serial.printf("[DMX] Could not open UDP port %u\n", port);
+        return;
+    }
+    if (!hal_task_start(dmx_task, "dmx", DMX_TASK_STACK, DMX_TASK_PRIORITY, LIGHT_TASK_CORE)) {
+        dmx_inline = true;
+    }
+    Serial.printf("[DMX] %s universe %u, channels from address %u, UDP %u\n", DMX_PROTOCOL_NAMES[dmx_protocol],
+                  dmx_universe, dmx_address, port);
+}
+
+void dmx_task(void* arg) {
+    (void)arg;
+    for (;;) dmx_receive(UINT32_MAX);
+}
+
+// One datagram: parsed in place in the receive buffer, our universe mapped
+// onto the channels and the frame handed to the light task. Runs on the
+// DMX task (loop() on the native build), the only writer of dmx_shared.
+void dmx_receive(uint32_t timeout_ms) {
+    static uint8_t packet[DMX_PACKET_MAX];
+    static uint8_t last_sequence = 0;
+    static uint32_t last_ms = 0;
+
+    int length = hal_udp_receive(dmx_socket, packet, sizeof(packet), timeout_ms);
+    if (length < 0 && !dmx_inline) hal_delay(100);  // socket error, don't spin
+    if (length <= 0) return;
+    uint32_t received = hal_micros();
+
+    DmxPacket p;
+    DmxProtocol protocol = (DmxProtocol)dmx_protocol;
+    if (!dmx_parse(protocol, packet, (size_t)length, &p)) {
+        dmx_rejected.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (p.universe != dmx_universe) return;
+    // After a data loss timeout any sequence starts a new stream
+    uint32_t now = hal_millis();
+    if (now - last_ms <= DMX_TIMEOUT_MS && !dmx_sequence_ok(protocol, last_sequence, p.sequence)) {
+        dmx_rejected.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    last_sequence = p.sequence;
+    last_ms = now;
+
+    DmxFrame frame = {};
+    frame.mask = (uint16_t)dmx_map(p, dmx_address, LIGHT_CHANNEL_COUNT, frame.values);
+    frame.terminated = p.terminated;
+    frame.received_us = received;
+    if (frame.mask == 0 && !frame.terminated) return;  // address past the end of the packet
+    dmx_shared.store(frame);
+    dmx_frames.fetch_add(1, std::memory_order_relaxed);
+    hal_task_notify(light_task_handle);
 }
 
 // ============================================================================
@@ -147,172 +888,720 @@ void loop() {
 // ============================================================================
 void load_settings() {
     Serial.println("Loading settings from NVM...");
-    settings.begin("vaxthus", false);
-
-    wifi_ssid = settings.getString("SSID", "");
-    wifi_password = settings.getString("PASSWORD", "");
-    mqtt_server = settings.getString("MQTTSERVER", "mqtt.revolt-energy.org");
-    mqtt_port = settings.getUInt("MQTTPORT", 1883);
-    mqtt_user = settings.getString("MQTTUSER", "");
-    mqtt_password = settings.getString("MQTTPASS", "");
-    mqtt_enabled = settings.getBool("MQTTENABLED", false);
-
-    mqtt_server = "mqtt.revolt-energy.org";
-    if (mqtt_server != settings.getString("MQTTSERVER", "")) {
-        settings.putString("MQTTSERVER", mqtt_server);
+    hal_nvs_begin("vaxthus");
+
+    Settings settings;
+    settings_defaults(&settings);
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    uint8_t version = 0;
+    uint32_t start = hal_micros();
+    size_t length = hal_nvs_get_blob(SETTINGS_NVS_KEY, blob, sizeof(blob));
+    bool from_blob = length > 0 && settings_decode(blob, length, &settings, &version);
+    if (!from_blob) settings_from_keys(&settings);  // version 0: one key per setting
+    settings_load_us = hal_micros() - start;
+    settings_apply(settings);
+
+    if (from_blob) {
+        settings_source = "blob";
+        Serial.printf("[Settings] v%u blob, %u bytes, read in %u us\n", version, (unsigned)length,
+                      settings_load_us);
+        if (version < SETTINGS_VERSION) save_settings();  // new fields get their defaults stored
+    } else {
+        // The old keys stay, so an older firmware still finds its settings
+        settings_source = length > 0 ? "rebuilt" : "migrated";
+        Serial.printf("[Settings] %s, read from NVS keys in %u us\n",
+                      length > 0 ? "Blob failed its CRC" : "No settings blob yet", settings_load_us);
+        save_settings();
     }
 
-    // Load last light states
-    light_white = settings.getUChar("LIGHTWHITE", 0);
-    light_red = settings.getUChar("LIGHTRED", 0);
-    light_uv = settings.getUChar("LIGHTUV", 0);
+    // Load last light states, and today's DLI so far
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        light_levels[ch] = nvs_cache_get_u8(LIGHT_CHANNELS[ch].nvs_key, 0);
+        light_dli[ch] = nvs_cache_get_u32(DLI_NVS_KEYS[ch], 0);
+    }
+    light_dli_day = (int32_t)nvs_cache_get_u32("DLIDAY", (uint32_t)-1);
 
     Serial.printf("  WiFi SSID: %s\n", wifi_ssid.c_str());
     Serial.printf("  MQTT Server: %s:%d\n", mqtt_server.c_str(), mqtt_port);
     Serial.printf("  MQTT Enabled: %s\n", mqtt_enabled ? "Yes" : "No");
+    Serial.printf("  Location: %.4f, %.4f\n", latitude, longitude);
+    if (dli_target > 0) Serial.printf("  DLI target: %.1f mol/m2/day\n", dli_target);
 }
 
+// One blob, replaced as a whole: a power cut leaves the old or the new settings
 void save_settings() {
     Serial.println("Saving settings to NVM...");
-    settings.putString("SSID", wifi_ssid);
-    settings.putString("PASSWORD", wifi_password);
-    settings.putString("MQTTSERVER", mqtt_server);
-    settings.putUInt("MQTTPORT", mqtt_port);
-    settings.putString("MQTTUSER", mqtt_user);
-    settings.putString("MQTTPASS", mqtt_password);
-    settings.putBool("MQTTENABLED", mqtt_enabled);
-    Serial.println("Settings saved!");
+    Settings settings;
+    settings_collect(&settings);
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t length = settings_encode(settings, blob, sizeof(blob));
+    if (hal_nvs_put_blob(SETTINGS_NVS_KEY, blob, length)) {
+        Serial.println("Settings saved!");
+    } else {
+        Serial.println("[Settings] Could not write the settings blob");
+    }
+}
+
+void settings_defaults(Settings* s) {
+    memset(s, 0, sizeof(*s));
+    snprintf(s->mqtt_server, sizeof(s->mqtt_server), "mqtt.revolt-energy.org");
+    s->mqtt_port = 1883;
+    s->dmx_protocol = DMX_OFF;
+    s->dmx_address = 1;
+    s->latitude = 59.33f;  // Stockholm
+    s->longitude = 18.07f;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) s->ppfd[ch] = LIGHT_CHANNELS[ch].ppfd;
+}
+
+// Settings as stored before the blob, one NVS key each
+void settings_from_keys(Settings* s) {
+    snprintf(s->wifi_ssid, sizeof(s->wifi_ssid), "%s", hal_nvs_get_string("SSID", s->wifi_ssid).c_str());
+    snprintf(s->wifi_password, sizeof(s->wifi_password), "%s",
+             hal_nvs_get_string("PASSWORD", s->wifi_password).c_str());
+    snprintf(s->mqtt_server, sizeof(s->mqtt_server), "%s",
+             hal_nvs_get_string("MQTTSERVER", s->mqtt_server).c_str());
+    s->mqtt_port = hal_nvs_get_u32("MQTTPORT", s->mqtt_port);
+    snprintf(s->mqtt_user, sizeof(s->mqtt_user), "%s", hal_nvs_get_string("MQTTUSER", s->mqtt_user).c_str());
+    snprintf(s->mqtt_password, sizeof(s->mqtt_password), "%s",
+             hal_nvs_get_string("MQTTPASS", s->mqtt_password).c_str());
+    s->flags = (hal_nvs_get_bool("MQTTENABLED", false) ? SETTINGS_MQTT_ENABLED : 0) |
+               (hal_nvs_get_bool("MQTTCHTOPICS", false) ? SETTINGS_MQTT_CHANNEL_TOPICS : 0) |
+               (hal_nvs_get_bool("POWERSAVE", false) ? SETTINGS_POWER_SAVE : 0);
+    s->dmx_protocol = hal_nvs_get_u8("DMXPROTO", s->dmx_protocol);
+    s->dmx_universe = hal_nvs_get_u32("DMXUNIVERSE", s->dmx_universe);
+    s->dmx_address = hal_nvs_get_u32("DMXADDRESS", s->dmx_address);
+    s->latitude = hal_nvs_get_string("LATITUDE", "59.33").toFloat();
+    s->longitude = hal_nvs_get_string("LONGITUDE", "18.07").toFloat();
+    s->dli_target = hal_nvs_get_string("DLITARGET", "0").toFloat();
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        char key[16];
+        snprintf(key, sizeof(key), "PPFD_%s", LIGHT_CHANNELS[ch].name);
+        s->ppfd[ch] = hal_nvs_get_u32(key, s->ppfd[ch]);
+    }
+}
+
+void settings_apply(const Settings& s) {
+    wifi_ssid = s.wifi_ssid;
+    wifi_password = s.wifi_password;
+    mqtt_server = s.mqtt_server;
+    mqtt_port = s.mqtt_port;
+    mqtt_user = s.mqtt_user;
+    mqtt_password = s.mqtt_password;
+    mqtt_enabled = s.flags & SETTINGS_MQTT_ENABLED;
+    mqtt_channel_topics = s.flags & SETTINGS_MQTT_CHANNEL_TOPICS;
+    power_save = s.flags & SETTINGS_POWER_SAVE;
+    dmx_protocol = s.dmx_protocol <= DMX_SACN ? s.dmx_protocol : (uint8_t)DMX_OFF;
+    dmx_universe = s.dmx_universe;
+    dmx_address = s.dmx_address;
+    latitude = s.latitude;
+    longitude = s.longitude;
+    dli_target = s.dli_target;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) light_ppfd[ch] = s.ppfd[ch];
 }
 
+void settings_collect(Settings* s) {
+    settings_defaults(s);
+    snprintf(s->wifi_ssid, sizeof(s->wifi_ssid), "%s", wifi_ssid.c_str());
+    snprintf(s->wifi_password, sizeof(s->wifi_password), "%s", wifi_password.c_str());
+    snprintf(s->mqtt_server, sizeof(s->mqtt_server), "%s", mqtt_server.c_str());
+    s->mqtt_port = mqtt_port;
+    snprintf(s->mqtt_user, sizeof(s->mqtt_user), "%s", mqtt_user.c_str());
+    snprintf(s->mqtt_password, sizeof(s->mqtt_password), "%s", mqtt_password.c_str());
+    s->flags = (mqtt_enabled ? SETTINGS_MQTT_ENABLED : 0) | (mqtt_channel_topics ? SETTINGS_MQTT_CHANNEL_TOPICS : 0) |
+               (power_save ? SETTINGS_POWER_SAVE : 0);
+    s->dmx_protocol = dmx_protocol;
+    s->dmx_universe = dmx_universe;
+    s->dmx_address = dmx_address;
+    s->latitude = latitude;
+    s->longitude = longitude;
+    s->dli_target = dli_target;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) s->ppfd[ch] = light_ppfd[ch];
+}
+
+// Write-behind: only marks the keys dirty, nvs_timer commits them
 void save_light_state() {
-    settings.putUChar("LIGHTWHITE", light_white);
-    settings.putUChar("LIGHTRED", light_red);
-    settings.putUChar("LIGHTUV", light_uv);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        nvs_cache_put_u8(LIGHT_CHANNELS[ch].nvs_key, light_levels[ch]);
+    }
+    nvs_schedule_commit();
+}
+
+// Same path; called every DLI_SAVE_INTERVAL_MS and before a reboot
+void save_dli_state() {
+    process_light_dli();
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        nvs_cache_put_u32(DLI_NVS_KEYS[ch], light_dli[ch]);
+    }
+    nvs_cache_put_u32("DLIDAY", (uint32_t)light_dli_day);
+    nvs_schedule_commit();
+}
+
+// Every put pushes the idle deadline out (up to NVS_CACHE_MAX_DELAY_MS)
+void nvs_schedule_commit() {
+    uint32_t due;
+    if (nvs_cache_commit_due(&due)) {
+        timer_start_at(nvs_timer, due);
+    } else {
+        timer_stop(nvs_timer);
+    }
+}
+
+// From net_io_step(): the flash writes run without the net lock
+void nvs_commit_step() {
+    NvsCacheBatch batch;
+    hal_net_lock();
+    bool due = nvs_cache_take(&batch);
+    hal_net_unlock();
+
+    uint32_t start = hal_cycle_count();
+    if (due) nvs_cache_write(batch);
+
+    hal_net_lock();
+    if (due) {
+        nvs_cache_done(batch);
+        metrics_lap(metric_sections[METRIC_NVS_COMMIT], start);
+    }
+    nvs_schedule_commit();
+    hal_net_unlock();
 }
 
 // ============================================================================
 // PWM CONTROL
 // ============================================================================
 void init_pwm() {
-    Serial.println("Initializing PWM channels...");
+    Serial.printf("Initializing PWM channels (%d Hz, %d-bit, %s)...\n", PWM_FREQ, PWM_RESOLUTION,
+                  PWM_PERCEPTUAL ? "perceptual" : "linear");
+
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        const LightChannel& c = LIGHT_CHANNELS[ch];
+        light_channel_names[ch] = c.name;
+        hal_pwm_setup(c.ledc, c.pin, PWM_FREQ, PWM_RESOLUTION);
+    }
+
+    // Restore last state (limits and interlocks apply as usual)
+    uint16_t levels[LIGHT_CHANNEL_COUNT];
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) levels[ch] = light_levels[ch] * 257;
+    light_apply_levels(light_engine, levels, 0);
+    memcpy(light_levels, light_engine.state.levels, sizeof(light_levels));
+    light_engine_published = light_engine.state;
 
-    ledcSetup(PWM_CHANNEL_WHITE, PWM_FREQ, PWM_RESOLUTION);
-    ledcSetup(PWM_CHANNEL_RED, PWM_FREQ, PWM_RESOLUTION);
-    ledcSetup(PWM_CHANNEL_UV, PWM_FREQ, PWM_RESOLUTION);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        Serial.printf("  %s: %d (GPIO %d, LEDC %d)\n", LIGHT_CHANNELS[ch].label, light_levels[ch],
+                      LIGHT_CHANNELS[ch].pin, LIGHT_CHANNELS[ch].ledc);
+    }
+}
 
-    ledcAttachPin(PWM_WHITE_PIN, PWM_CHANNEL_WHITE);
-    ledcAttachPin(PWM_RED_PIN, PWM_CHANNEL_RED);
-    ledcAttachPin(PWM_UV_PIN, PWM_CHANNEL_UV);
+// Network side: queue a command for the light task, never blocks
+void send_light_command(const LightCommand& cmd) {
+    if (!light_commands.push(cmd)) {
+        Serial.printf("[Light] Command queue full, dropped command %d\n", cmd.type);
+    }
+    hal_task_notify(light_task_handle);  // applied now, not on the next 10 ms step
+}
 
-    // Restore last state
-    ledcWrite(PWM_CHANNEL_WHITE, light_white);
-    ledcWrite(PWM_CHANNEL_RED, light_red);
-    ledcWrite(PWM_CHANNEL_UV, light_uv);
+void send_light_command(LightCommandType type) {
+    LightCommand cmd = {};
+    cmd.type = type;
+    send_light_command(cmd);
+}
 
-    Serial.printf("  White: %d, Red: %d, UV: %d\n", light_white, light_red, light_uv);
+// Sätter flera kanaler i ett svep: ett kommando, en limiter-utvärdering,
+// en snapshot till nätverkssidan och en NVS-ändring
+void set_lights(uint16_t mask, const uint8_t* values) {
+    if (mask == 0) return;
+    LightCommand cmd = {};
+    cmd.type = LIGHT_CMD_SET;
+    cmd.mask = mask;
+    memcpy(cmd.values, values, sizeof(cmd.values));
+    send_light_command(cmd);
 }
 
 void set_light(uint8_t channel, uint8_t value) {
-    // Aktivera manuell override när användaren justerar ljuset
-    autoMode = false;
-    manualOverrideStart = millis();
-    Serial.println("[Manual] Override activated for 40 minutes");
-    
-    switch(channel) {
-        case PWM_CHANNEL_WHITE:
-            light_white = value;
-            ledcWrite(PWM_CHANNEL_WHITE, value);
-            publish_state("white", value);
+    if (channel >= LIGHT_CHANNEL_COUNT) return;
+    uint8_t values[LIGHT_CHANNEL_COUNT] = {};
+    values[channel] = value;
+    set_lights(1 << channel, values);
+}
+
+// Network side: pick up the latest light task snapshot, publish and persist
+void process_light_state() {
+    if (light_state_shared.version() == light_state_seen) return;
+
+    LightState state;
+    light_state_seen = light_state_shared.load(state);
+
+    memcpy(light_levels, state.levels, sizeof(light_levels));
+    autoMode = state.auto_mode;
+    dmx_active = state.dmx;
+    status_version++;
+    publish_mqtt_state(false);
+
+    if (state.manual_changes != light_manual_seen) {
+        light_manual_seen = state.manual_changes;
+        save_light_state();
+    }
+}
+
+// Network side: latest running DLI, pulled by dli_save_timer and
+// dli_publish_timer. /status shows it in 0.01 mol steps and gets a new
+// version only when one of those moves.
+void process_light_dli() {
+    if (light_dli_shared.version() == light_dli_seen) return;
+
+    LightDli dli;
+    light_dli_seen = light_dli_shared.load(dli);
+    bool shown = dli.percent != light_dli_percent;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) shown |= dli.umol[ch] / 10000 != light_dli[ch] / 10000;
+    memcpy(light_dli, dli.umol, sizeof(light_dli));
+    light_dli_day = dli.day;
+    light_dli_percent = dli.percent;
+    if (shown) status_version++;
+}
+
+// ============================================================================
+// LIGHT CONTROL TASK
+// ============================================================================
+void init_light_task() {
+    // Today's DLI from NVS; light_sun_step() clears it if the date turns out to be another day
+    light_engine.dli_target = dli_target > 0 ? (uint32_t)(dli_target * 1e6f) : 0;
+    light_engine.dli.day = light_dli_day;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        light_engine.dli.umol[ch] = light_dli[ch];
+        light_engine.dli_acc[ch] = (uint64_t)light_dli[ch] * PWM_CURVE.MAX_DUTY * 1000;
+    }
+    light_engine_published = light_engine.state;
+
+    if (hal_task_start(light_task, "light", LIGHT_TASK_STACK, LIGHT_TASK_PRIORITY, LIGHT_TASK_CORE,
+                       &light_task_handle)) {
+        if (power_save) {
+            Serial.printf("Light control task started on core %d (commands and sun steps only)\n",
+                LIGHT_TASK_CORE);
+        } else {
+            Serial.printf("Light control task started on core %d (%d ms period)\n",
+                LIGHT_TASK_CORE, LIGHT_TASK_PERIOD_MS);
+        }
+    } else {
+        light_task_inline = true;
+        Serial.println("Light control task unavailable, stepping from loop()");
+    }
+}
+
+void light_task(void* arg) {
+    (void)arg;
+    uint32_t last_wake = 0;
+    for (;;) {
+        // Commands and DMX frames (hal_task_notify()) end the wait early
+        bool periodic = false;
+        if (power_save) {
+            hal_task_wait(light_idle_ms());
+        } else {
+            periodic = hal_task_wait_until(&last_wake, LIGHT_TASK_PERIOD_MS);
+        }
+        hal_power_busy(true);
+        light_control_step(periodic);
+        hal_power_busy(false);
+    }
+}
+
+// periodic: woken by the 10 ms period rather than a notify
+void light_control_step(bool periodic) {
+    uint32_t start = hal_micros();
+    uint32_t cycles = hal_cycle_count();
+
+    // Jitter = avvikelse från nominell period (bara periodiska steg)
+    if (periodic && light_last_step_us != 0) {
+        uint32_t period = start - light_last_step_us;
+        uint32_t expected = LIGHT_TASK_PERIOD_MS * 1000;
+        uint32_t jitter = period > expected ? period - expected : expected - period;
+        if (jitter > light_jitter_max_us.load(std::memory_order_relaxed)) {
+            light_jitter_max_us.store(jitter, std::memory_order_relaxed);
+        }
+        uint32_t avg = light_jitter_avg_us.load(std::memory_order_relaxed);
+        light_jitter_avg_us.store((avg * 15 + jitter) / 16, std::memory_order_relaxed);
+    }
+    if (periodic) light_last_step_us = start;
+
+    LightCommand cmd;
+    while (light_commands.pop(cmd)) {
+        light_apply_command(light_engine, cmd, hal_millis());
+    }
+    if (dmx_shared.version() != light_dmx_seen) {
+        DmxFrame frame;
+        light_dmx_seen = dmx_shared.load(frame);
+        light_apply_dmx(light_engine, frame, hal_millis());
+        histogram_observe(metric_dmx_latency, hal_micros() - frame.received_us);
+    }
+    if (light_engine.state.dmx && hal_millis() - light_engine.dmx_last > DMX_TIMEOUT_MS) {
+        light_dmx_release(light_engine, hal_millis());
+    }
+    update_sun_simulation();
+    light_output_held(light_engine, hal_millis());
+
+    if (power_mode == HAL_POWER_LIGHT_SLEEP) {
+        bool awake = !light_outputs_steady(light_engine, hal_millis());
+        if (awake != light_awake_held.load(std::memory_order_relaxed)) {
+            light_awake_held.store(awake, std::memory_order_relaxed);
+            hal_power_stay_awake(awake);
+        }
+    }
+
+    uint32_t busy = hal_micros() - start;
+    if (busy > light_step_max_us.load(std::memory_order_relaxed)) {
+        light_step_max_us.store(busy, std::memory_order_relaxed);
+    }
+    metrics_lap(metric_sections[METRIC_LIGHT_TASK], cycles);
+}
+
+// The LEDC timers run on the APB clock, which stops in light sleep: each
+// output freezes wherever its PWM cycle was, fully on or off. Only 0 and
+// full duty survive that, and only once the fade unit is done.
+bool light_outputs_steady(const LightEngine& e, uint32_t now) {
+    if (e.held) return false;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        if ((int32_t)(now - e.fade_until[ch]) < 0) return false;
+        if (!e.blackout && e.duty[ch] != 0 && e.duty[ch] < PWM_CURVE.MAX_DUTY) return false;
+    }
+    return true;
+}
+
+// Power save: the light task sleeps until the next sun step, or until a
+// fade ends if a held duty waits for it or the chip can light-sleep sooner
+uint32_t light_idle_ms() {
+    uint32_t now = hal_millis();
+    uint32_t since = now - light_engine.last_sun_update;
+    uint32_t wait = since < SUN_UPDATE_INTERVAL_MS ? SUN_UPDATE_INTERVAL_MS - since : 0;
+    bool awake = light_awake_held.load(std::memory_order_relaxed);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        int32_t fade_left = (int32_t)(light_engine.fade_until[ch] - now);
+        if (fade_left <= 0 || !(awake || (light_engine.held & (1 << ch)))) continue;
+        if ((uint32_t)fade_left < wait) wait = fade_left;
+    }
+    if (light_engine.state.dmx) {
+        uint32_t quiet = now - light_engine.dmx_last;
+        uint32_t left = quiet < DMX_TIMEOUT_MS ? DMX_TIMEOUT_MS - quiet + 1 : 0;
+        if (left < wait) wait = left;
+    }
+    return wait;
+}
+
+void light_apply_command(LightEngine& e, const LightCommand& cmd, uint32_t now) {
+    light_integrate(e, now);  // dose at the old duty up to now
+    switch (cmd.type) {
+        case LIGHT_CMD_SET: {
+            // Aktivera manuell override när användaren justerar ljuset
+            e.state.auto_mode = false;
+            e.manual_start = now;
+            if (!e.simulated) Serial.println("[Manual] Override activated for 40 minutes");
+
+            uint16_t levels[LIGHT_CHANNEL_COUNT];
+            for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+                levels[ch] = (cmd.mask & (1 << ch)) ? cmd.values[ch] * 257 : e.fine[ch];
+            }
+            light_apply_levels(e, levels, PWM_MANUAL_FADE_MS);
+            e.state.manual_changes++;
+            break;
+        }
+        case LIGHT_CMD_SUN_REFRESH:
+            e.last_sun_update = now - SUN_UPDATE_INTERVAL_MS;
             break;
-        case PWM_CHANNEL_RED:
-            light_red = value;
-            ledcWrite(PWM_CHANNEL_RED, value);
-            publish_state("red", value);
+        case LIGHT_CMD_EXIT_MANUAL:
+            e.state.auto_mode = true;
+            e.last_sun_update = now - SUN_UPDATE_INTERVAL_MS;  // apply the sun level on this step
+            if (!e.simulated) Serial.println("[Manual] User requested return to auto mode");
             break;
-        case PWM_CHANNEL_UV:
-            // UV Safety Limiter: Max 80% of white brightness
-            uint8_t max_uv = (light_white * UV_LIMITER_PERCENTAGE) / 100;
-            if (value > max_uv) {
-                value = max_uv;
-                Serial.printf("[UV Limiter] Limited UV to %d (80%% of white %d)\n", value, light_white);
-            }
-            light_uv = value;
-            ledcWrite(PWM_CHANNEL_UV, value);
-            publish_state("uv", value);
+        case LIGHT_CMD_BLACKOUT:
+            // Outputs off until reboot (OTA); reported state is left untouched
+            e.blackout = true;
+            for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT && !e.simulated; ch++) light_output(e, ch, 0, now);
             break;
     }
-    save_light_state();
+    if (!e.simulated) publish_light_state();
+}
+
+// Light side: a DMX frame goes to the outputs as it is - no fade (the
+// console sends its own), no override timer, nothing saved. While the
+// stream runs the network side gets a snapshot every DMX_PUBLISH_MS.
+// The first frame can find a sun fade running; it cannot be stopped, so
+// that output is held for at most SUN_FADE_MS (light_output()) and the
+// paused schedule starts no new ones.
+void light_apply_dmx(LightEngine& e, const DmxFrame& frame, uint32_t now) {
+    if (frame.terminated) {
+        light_dmx_release(e, now);
+        return;
+    }
+    light_integrate(e, now);
+    bool starting = !e.state.dmx;
+    e.state.dmx = true;
+    e.dmx_last = now;
+
+    uint16_t levels[LIGHT_CHANNEL_COUNT];
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        levels[ch] = (frame.mask & (1 << ch)) ? frame.values[ch] * 257 : e.fine[ch];
+    }
+    light_apply_levels(e, levels, 0);
+
+    if (e.simulated) return;
+    if (starting || now - e.dmx_published >= DMX_PUBLISH_MS) {
+        e.dmx_published = now;
+        publish_light_state();
+    }
+    if (starting) Serial.println("[DMX] Stream started, schedule paused");
+}
+
+// Stream gone (timeout or sACN Stream_Terminated): the schedule takes over
+// on this same step
+void light_dmx_release(LightEngine& e, uint32_t now) {
+    if (!e.state.dmx) return;
+    e.state.dmx = false;
+    e.state.auto_mode = true;
+    e.last_sun_update = now - SUN_UPDATE_INTERVAL_MS;
+    if (e.simulated) return;
+    publish_light_state();
+    Serial.println("[DMX] Stream ended, back to the schedule");
+}
+
+// Light side: hand the current state to the network side if it changed
+void publish_light_state() {
+    if (memcmp(&light_engine.state, &light_engine_published, sizeof(LightState)) == 0) return;
+    light_engine_published = light_engine.state;
+    light_state_shared.store(light_engine.state);
+    hal_loop_wake();
+}
+
+// Same for the running DLI, but no wake: the network side polls it on its timers
+void publish_light_dli() {
+    if (memcmp(&light_engine.dli, &light_dli_published, sizeof(LightDli)) == 0) return;
+    light_dli_published = light_engine.dli;
+    light_dli_shared.store(light_engine.dli);
 }
 
 // ============================================================================
 // WIFI (AP + STA mode, like Battery-Emulator)
 // ============================================================================
+void on_wifi_event(HalWifiEvent event, int reason) {
+    switch (event) {
+        case HAL_WIFI_STA_START:
+            Serial.println("  [WiFi] STA started");
+            break;
+        case HAL_WIFI_STA_CONNECTED:
+            Serial.println("  [WiFi] STA connected to AP");
+            break;
+        case HAL_WIFI_STA_GOT_IP:
+            Serial.printf("  [WiFi] Got IP: %s\n", hal_wifi_local_ip().c_str());
+            wifi_events.fetch_or(WIFI_EVENT_GOT_IP);
+            hal_loop_wake();
+            break;
+        case HAL_WIFI_STA_DISCONNECTED:
+            Serial.printf("  [WiFi] Disconnected, reason: %d\n", reason);
+            wifi_events.fetch_or(WIFI_EVENT_DISCONNECTED);
+            hal_loop_wake();
+            break;
+    }
+}
+
 void init_wifi() {
     Serial.println("Initializing WiFi...");
 
-    WiFi.mode(WIFI_AP_STA);
-    WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info) {
-        switch (event) {
-            case ARDUINO_EVENT_WIFI_STA_START:
-                Serial.println("  [WiFi] STA started");
-                break;
-            case ARDUINO_EVENT_WIFI_STA_CONNECTED:
-                Serial.println("  [WiFi] STA connected to AP");
-                break;
-            case ARDUINO_EVENT_WIFI_STA_GOT_IP:
-                Serial.printf("  [WiFi] Got IP: %s\n", WiFi.localIP().toString().c_str());
-                break;
-            case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
-                Serial.printf("  [WiFi] Disconnected, reason: %d\n", info.wifi_sta_disconnected.reason);
-                break;
-            default:
-                break;
-        }
-    });
+    hal_wifi_init(on_wifi_event);
 
     // Start Access Point
-    WiFi.softAP(ap_ssid.c_str(), ap_password.c_str());
+    ap_running = hal_wifi_start_ap(ap_ssid.c_str(), ap_password.c_str());
     Serial.printf("  AP started: %s (pw: %s)\n", ap_ssid.c_str(), ap_password.c_str());
-    Serial.printf("  AP IP: %s\n", WiFi.softAPIP().toString().c_str());
+    Serial.printf("  AP IP: %s\n", hal_wifi_ap_ip().c_str());
 
-    // Connect to home WiFi if configured
+    // Connect to home WiFi if configured - connectivity_step() takes it from here
     if (wifi_ssid.length() > 0) {
-        Serial.printf("  Connecting to: %s\n", wifi_ssid.c_str());
-        WiFi.begin(wifi_ssid.c_str(), wifi_password.c_str());
-        WiFi.setAutoReconnect(true);
-        WiFi.setSleep(false);
-
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-            Serial.printf("  [WiFi] status=%d (attempt %d)\n", WiFi.status(), attempts + 1);
-            delay(500);
-            attempts++;
+        if (wifi_cache_load()) {
+            const uint8_t* bssid = wifi_cache.link.bssid;
+            Serial.printf("  Fast connect to: %s (%02x:%02x:%02x:%02x:%02x:%02x, channel %u, cached IP)\n",
+                wifi_ssid.c_str(), bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5],
+                wifi_cache.link.channel);
+            hal_wifi_begin(wifi_ssid.c_str(), wifi_password.c_str(), &wifi_cache.link);
+            wifi_fast_connecting = true;
+        } else {
+            Serial.printf("  Connecting to: %s (in background)\n", wifi_ssid.c_str());
+            hal_wifi_begin(wifi_ssid.c_str(), wifi_password.c_str());
         }
+        if (power_save) hal_wifi_set_sleep(true);
+        set_conn_state(CONN_WIFI_CONNECTING);
+    } else {
+        Serial.println("  WiFi SSID not set; skipping STA connect");
+        set_conn_state(CONN_AP_ONLY);
+    }
+}
+
+// ============================================================================
+// CONNECTIVITY STATE MACHINE
+// ============================================================================
+void set_conn_state(ConnState state) {
+    if (state == conn_state) return;
+    Serial.printf("[Conn] %s -> %s (t=%u ms)\n",
+        CONN_STATE_NAMES[conn_state], CONN_STATE_NAMES[state], hal_millis());
+    conn_state = state;
+
+    // Each waiting state has one deadline on conn_timer
+    if (state == CONN_WIFI_CONNECTING) {
+        timer_start(conn_timer, backoff_next(wifi_backoff));
+    } else if (state == CONN_TIME_SYNCING) {
+        timer_start(conn_timer, TIME_SYNC_POLL_MS);
+    } else {
+        timer_stop(conn_timer);
+    }
+}
+
+// Every pass: WiFi events from the event task. Everything that waits is on conn_timer.
+void connectivity_step() {
+    uint8_t events = wifi_events.exchange(0);
 
-        if (WiFi.status() == WL_CONNECTED) {
-            Serial.printf("  Connected! IP: %s\n", WiFi.localIP().toString().c_str());
+    if (conn_state == CONN_AP_ONLY) return;
+
+    if ((events & WIFI_EVENT_DISCONNECTED) && !hal_wifi_connected()) {
+        backoff_reset(wifi_backoff);  // a fresh drop starts over at the shortest wait
+        if (conn_state == CONN_WIFI_CONNECTING) {
+            timer_start(conn_timer, backoff_next(wifi_backoff));
         } else {
-            Serial.printf("  Failed to connect to home WiFi (status=%d)\n", WiFi.status());
+            reconnect_lost(wifi_reconnect);
+            set_conn_state(CONN_WIFI_CONNECTING);
         }
+        return;
+    }
+
+    if (conn_state == CONN_WIFI_CONNECTING && (events & WIFI_EVENT_GOT_IP)) conn_wifi_up();
+
+    if (conn_state == CONN_ONLINE && boot_online_ms == 0) {
+        boot_online_ms = hal_millis();
+        Serial.printf("[Boot] Online after %u ms\n", boot_online_ms);
+    }
+}
+
+void conn_wifi_up() {
+    Serial.printf("  Connected! IP: %s\n", hal_wifi_local_ip().c_str());
+    if (wifi_fast_connecting && boot_online_ms == 0) wifi_fast_boot = true;
+    wifi_fast_connecting = false;
+    backoff_reset(wifi_backoff);
+    backoff_reset(mqtt_backoff);  // the broker gets a first try at once
+    reconnect_done(wifi_reconnect);
+    wifi_cache_store();
+    if (dmx_socket >= 0 && dmx_protocol == DMX_SACN) {
+        hal_udp_join(dmx_socket, sacn_multicast_group(dmx_universe));  // memberships end with the link
+    }
+    // Modem sleep (and with it light sleep) only works in STA mode
+    if (power_save && ap_running) {
+        hal_wifi_stop_ap();
+        ap_running = false;
+        Serial.println("[Power] AP off while the station is up");
+    }
+    if (!ota_started) {
+        init_ota();
+        ota_started = true;
+    }
+    struct tm timeinfo;
+    if (hal_local_time(&timeinfo)) {
+        set_conn_state(CONN_ONLINE);
     } else {
-        Serial.println("  WiFi SSID not set; skipping STA connect");
+        if (!ntp_started) {
+            init_time();
+            ntp_started = true;
+            lastTimeSync = hal_millis();
+        }
+        set_conn_state(CONN_TIME_SYNCING);
     }
 }
 
-void wifi_monitor() {
-    if (millis() - lastWifiCheck < 10000) return;
-    lastWifiCheck = millis();
+void conn_timer_step() {
+    uint32_t now = hal_millis();
+    switch (conn_state) {
+        case CONN_WIFI_CONNECTING:
+            if (hal_wifi_connected()) {  // the event went missing
+                conn_wifi_up();
+                break;
+            }
+            Serial.printf("WiFi disconnected (status=%d), reconnecting...\n", hal_wifi_status());
+            if (!ap_running) {  // power save: the AP is the way back in
+                ap_running = hal_wifi_start_ap(ap_ssid.c_str(), ap_password.c_str());
+                Serial.printf("[Power] AP back on: %s\n", ap_ssid.c_str());
+            }
+            if (wifi_fast_connecting) {  // cached AP or address did not answer
+                Serial.println("[WiFi] Fast connect failed, scanning with DHCP");
+                wifi_fast_connecting = false;
+                wifi_cache_valid = false;
+                hal_wifi_begin(wifi_ssid.c_str(), wifi_password.c_str());
+            } else {
+                hal_wifi_reconnect();
+            }
+            timer_start(conn_timer, backoff_next(wifi_backoff));
+            break;
+
+        case CONN_TIME_SYNCING: {
+            struct tm timeinfo;
+            if (hal_local_time(&timeinfo)) {
+                Serial.printf("  Time synced: %04d-%02d-%02d %02d:%02d:%02d\n",
+                    timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+                // Tiden är känd - låt solsimuleringen räkna om direkt
+                send_light_command(LIGHT_CMD_SUN_REFRESH);
+                timer_start(solar_timer, 0);
+                set_conn_state(CONN_ONLINE);
+                break;
+            }
+            if (now - lastTimeSync >= NTP_RETRY_MS) {  // Var 5:e minut
+                lastTimeSync = now;
+                Serial.println("  Time still not synced, restarting NTP");
+                init_time();
+            }
+            timer_start(conn_timer, TIME_SYNC_POLL_MS);
+            break;
+        }
 
-    if (wifi_ssid.length() > 0 && WiFi.status() != WL_CONNECTED) {
-        Serial.printf("WiFi disconnected (status=%d), reconnecting...\n", WiFi.status());
-        WiFi.reconnect();
+        default:
+            break;
     }
 }
 
+bool wifi_cache_load() {
+    WifiCache stored;
+    if (hal_nvs_get_blob(WIFI_CACHE_NVS_KEY, &stored, sizeof(stored)) != sizeof(stored)) return false;
+    if (stored.ssid_crc != settings_crc((const uint8_t*)wifi_ssid.c_str(), wifi_ssid.length())) return false;
+    if (stored.link.channel == 0 || stored.link.ip == 0) return false;
+    wifi_cache = stored;
+    wifi_cache_valid = true;
+    return true;
+}
+
+// On every GOT_IP; only a changed link (new AP, channel or lease) is written
+void wifi_cache_store() {
+    WifiCache fresh;
+    memset(&fresh, 0, sizeof(fresh));  // padding too: compared and stored as bytes
+    if (!hal_wifi_link(&fresh.link)) return;
+    fresh.ssid_crc = settings_crc((const uint8_t*)wifi_ssid.c_str(), wifi_ssid.length());
+    if (wifi_cache_valid && memcmp(&fresh, &wifi_cache, sizeof(fresh)) == 0) return;
+    wifi_cache = fresh;
+    wifi_cache_valid = true;
+    hal_nvs_put_blob(WIFI_CACHE_NVS_KEY, &wifi_cache, sizeof(wifi_cache));
+    Serial.printf("[WiFi] Link cached for fast connect (channel %u)\n", fresh.link.channel);
+}
+
+void reconnect_lost(ReconnectStats& stats) {
+    if (stats.down) return;
+    stats.down = true;
+    stats.down_since = hal_millis();
+}
+
+void reconnect_done(ReconnectStats& stats) {
+    if (!stats.down) return;
+    stats.down = false;
+    uint32_t ms = hal_millis() - stats.down_since;
+    stats.count++;
+    stats.last_ms = ms;
+    if (ms > stats.max_ms) stats.max_ms = ms;
+    stats.total_ms += ms;
+    Serial.printf("[Conn] %s back after %u ms\n", stats.link, ms);
+}
+
 int get_wifi_signal_strength() {
-    if (WiFi.status() != WL_CONNECTED) return 0;
+    if (!hal_wifi_connected()) return 0;
     
-    int rssi = WiFi.RSSI();
+    int rssi = hal_wifi_rssi();
     // Konvertera till procent (approximation)
     // -30 dBm = 100%, -90 dBm = 0%
     int quality = 2 * (rssi + 100);
@@ -325,8 +1614,8 @@ int get_wifi_signal_strength() {
 // OTA (Over-The-Air Updates - like Battery-Emulator)
 // ============================================================================
 void init_ota() {
-    // Only initialize OTA if WiFi is connected
-    if (WiFi.status() != WL_CONNECTED) {
+    // Called by connectivity_step() once WiFi is up
+    if (!hal_wifi_connected()) {
         Serial.println("OTA not initialized - WiFi not connected");
         return;
     }
@@ -343,13 +1632,18 @@ void init_ota() {
     ArduinoOTA.setPort(3232);
     
     // Callbacks for OTA events
+    // handle() runs without the net lock (net_io_step()), the callbacks take it
     ArduinoOTA.onStart([]() {
         String type = (ArduinoOTA.getCommand() == U_FLASH) ? "sketch" : "filesystem";
         Serial.println("\n[OTA] Starting update: " + type);
+        hal_net_lock();
+        // Save pending light state before the flash is rewritten
+        save_dli_state();
+        nvs_cache_flush();
+        telemetry_flush();
         // Turn off lights during update (safety)
-        ledcWrite(PWM_CHANNEL_WHITE, 0);
-        ledcWrite(PWM_CHANNEL_RED, 0);
-        ledcWrite(PWM_CHANNEL_UV, 0);
+        send_light_command(LIGHT_CMD_BLACKOUT);
+        hal_net_unlock();
     });
     
     ArduinoOTA.onEnd([]() {
@@ -373,118 +1667,1028 @@ void init_ota() {
     });
     
     ArduinoOTA.begin();
+    timer_start(ota_timer, OTA_POLL_MS);
     Serial.printf("  OTA Ready! Hostname: vaxthus-master\n");
-    Serial.printf("  Upload via: %s:3232\n", WiFi.localIP().toString().c_str());
+    Serial.printf("  Upload via: %s:3232\n", hal_wifi_local_ip().c_str());
+}
+
+// The invitation waits in the UDP socket; an update runs to the end inside
+// handle(), so this runs from net_io_step() without the net lock
+void ota_step() {
+    uint32_t start = hal_cycle_count();
+    ArduinoOTA.handle();
+    hal_net_lock();
+    metrics_lap(metric_sections[METRIC_OTA], start);
+    hal_net_unlock();
 }
 
 // ============================================================================
 // NTP TIME & SUN SIMULATION
 // ============================================================================
 void init_time() {
+    // Non-blocking: SNTP syncs in the background, connectivity_step() polls
     Serial.println("Initializing NTP time sync...");
     // CET = GMT+1, CEST = GMT+2 (sommartid)
-    configTime(3600, 3600, "pool.ntp.org", "time.nist.gov");
-    
-    Serial.print("  Waiting for time sync");
-    time_t now = 0;
-    struct tm timeinfo;
-    int retry = 0;
-    while (now < 1000000000 && retry < 20) {
-        time(&now);
-        Serial.print(".");
-        delay(500);
-        retry++;
-    }
-    Serial.println();
-    
-    if (getLocalTime(&timeinfo)) {
-        Serial.printf("  Time synced: %04d-%02d-%02d %02d:%02d:%02d\n",
-            timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-            timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-    } else {
-        Serial.println("  Failed to sync time, will retry later");
+    hal_time_begin(3600, 3600, "pool.ntp.org", "time.nist.gov");
+}
+
+// Light side: the single place levels reach the outputs. Clamps to each
+// channel's max, applies the interlocks (UV limiter etc.) in table order,
+// maps through PWM_CURVE and only touches the outputs whose duty changed.
+// fade_ms > 0 hands the ramp to the LEDC fade unit.
+void light_apply_levels(LightEngine& e, const uint16_t* levels, uint32_t fade_ms) {
+    bool changed = false;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        const LightChannel& c = LIGHT_CHANNELS[ch];
+        uint16_t max = c.max_level * 257;
+        uint16_t value = levels[ch] < max ? levels[ch] : max;
+        if (c.limit_to >= 0) {
+            uint16_t ref = e.fine[c.limit_to];  // already updated (earlier in table)
+            uint16_t limit = ((uint32_t)ref * c.limit_percent) / 100;
+            if (value > limit) {
+                value = limit;
+                if (!e.simulated && levels[ch] > limit && (levels[ch] >> 8) != (e.fine[ch] >> 8)) {
+                    Serial.printf("[Limiter] %s limited to %d (%d%% of %s %d)\n", c.label, (value + 128) / 257,
+                                  c.limit_percent, LIGHT_CHANNELS[c.limit_to].label, (ref + 128) / 257);
+                }
+            }
+        }
+        e.fine[ch] = value;
+
+        uint32_t duty = PWM_CURVE.at(value);
+        if (duty != e.duty[ch]) {
+            e.duty[ch] = duty;
+            if (!e.blackout && !e.simulated) light_output(e, ch, fade_ms, hal_millis());
+        }
+
+        uint8_t level = (value + 128) / 257;
+        if (level == e.state.levels[ch]) continue;
+        e.state.levels[ch] = level;
+        changed = true;
     }
+
+    // MQTT publiceras av nätverkssidan i process_light_state(), DMX-strömmar begränsat
+    if (changed && !e.simulated && !e.state.dmx) publish_light_state();
 }
 
-uint8_t calculate_light_level(int hour, int minute) {
-    int totalMinutes = hour * 60 + minute;
-    int sunriseStart = SUNRISE_START_HOUR * 60;
-    int sunriseEnd = SUNRISE_END_HOUR * 60;
-    int sunsetStart = SUNSET_START_HOUR * 60;
-    int sunsetEnd = SUNSET_END_HOUR * 60;
-    
-    if (totalMinutes < sunriseStart || totalMinutes >= sunsetEnd) {
-        return 0;  // Mörker (00:00-06:00 och 22:00-23:59)
-    } else if (totalMinutes >= sunriseEnd && totalMinutes < sunsetStart) {
-        return 255;  // Full ljusstyrka (10:00-18:00)
-    } else if (totalMinutes >= sunriseStart && totalMinutes < sunriseEnd) {
-        // Soluppgång - rampa upp (06:00-10:00)
-        int rampMinutes = sunriseEnd - sunriseStart;  // 240 minuter
-        int elapsed = totalMinutes - sunriseStart;
-        return (uint8_t)((elapsed * 255) / rampMinutes);
+// Light side: e.duty[ch] (0 in blackout) to the LEDC. The driver makes a
+// write or fade wait for a fade running on the channel - the ESP32 cannot
+// stop one - so the duty is held and light_output_held() sends it once that
+// fade is over. The newest duty wins; the light task never waits.
+void light_output(LightEngine& e, uint8_t ch, uint32_t fade_ms, uint32_t now) {
+    if ((int32_t)(now - e.fade_until[ch]) < 0) {
+        e.held |= 1 << ch;
+        e.held_fade[ch] = fade_ms;
+        return;
+    }
+    e.held &= ~(1 << ch);
+    uint32_t duty = e.blackout ? 0 : e.duty[ch];
+    if (fade_ms > 0) {
+        hal_pwm_fade(LIGHT_CHANNELS[ch].ledc, duty, fade_ms);
+        e.fade_until[ch] = now + fade_ms + 1;  // the fade may start up to 1 ms after now
     } else {
-        // Skymning - rampa ner (18:00-22:00)
-        int rampMinutes = sunsetEnd - sunsetStart;  // 240 minuter
-        int elapsed = totalMinutes - sunsetStart;
-        return (uint8_t)(255 - ((elapsed * 255) / rampMinutes));
+        hal_pwm_write(LIGHT_CHANNELS[ch].ledc, duty);
     }
 }
 
-void set_light_direct(uint8_t white, uint8_t red, uint8_t uv) {
-    light_white = white;
-    light_red = red;
-    light_uv = uv;
-    
-    ledcWrite(PWM_CHANNEL_WHITE, white);
-    ledcWrite(PWM_CHANNEL_RED, red);
-    ledcWrite(PWM_CHANNEL_UV, uv);
-    
-    // Publicera till MQTT
-    publish_state("white", white);
-    publish_state("red", red);
-    publish_state("uv", uv);
+void light_output_held(LightEngine& e, uint32_t now) {
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT && e.held; ch++) {
+        if (e.held & (1 << ch)) light_output(e, ch, e.held_fade[ch], now);
+    }
 }
 
+// Live engine on the real clocks
 void update_sun_simulation() {
-    // Kör endast varje minut
-    if (millis() - lastSunUpdate < 60000) return;
-    lastSunUpdate = millis();
-    
-    // Kolla om manuell override har löpt ut (40 minuter)
-    if (!autoMode && (millis() - manualOverrideStart > MANUAL_OVERRIDE_DURATION)) {
-        autoMode = true;
-        Serial.println("[Sun Sim] Manual override expired, returning to auto mode");
+    // Nytt mål var 10:e sekund, LEDC-fadern glider dit under tiden
+    uint32_t now = hal_millis();
+    if (now - light_engine.last_sun_update < SUN_UPDATE_INTERVAL_MS) return;
+    light_engine.last_sun_update = now;
+    uint32_t start = hal_cycle_count();
+
+    // Nytt schema från nätverkssidan? Profilen väljs om vid nästa steg.
+    if (schedule_shared.version() != light_schedule_seen) {
+        light_schedule_seen = schedule_shared.load(light_schedule);
+        light_engine.schedule_day = -1;
     }
-    
-    // Skip om vi är i manuellt läge
-    if (!autoMode) return;
-    
-    // Hämta aktuell tid
+
+    // Hämta aktuell tid (NTP sköts av connectivity_step() på nätverkssidan)
     struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        // Om tiden inte är synkad, försök igen
-        static unsigned long lastTimeSync = 0;
-        if (millis() - lastTimeSync > 300000) {  // Var 5:e minut
-            init_time();
-            lastTimeSync = millis();
+    light_sun_step(light_engine, now, hal_local_time(&timeinfo) ? &timeinfo : nullptr);
+    publish_light_dli();
+    metrics_lap(metric_sections[METRIC_SUN_UPDATE], start);
+}
+
+// One sun update at the given time: override expiry, then the schedule.
+// local is null while the time is unknown.
+void light_sun_step(LightEngine& e, uint32_t now, const struct tm* local) {
+    light_integrate(e, now);
+    if (local) {
+        int32_t day = local->tm_year * 1000 + local->tm_yday;
+        if (e.dli.day >= 0 && day != e.dli.day) {
+            memset(e.dli_acc, 0, sizeof(e.dli_acc));  // midnight: new day, new dose
         }
-        return;
+        e.dli.day = day;
     }
-    
-    // Beräkna ljusnivå baserat på tid
-    uint8_t level = calculate_light_level(timeinfo.tm_hour, timeinfo.tm_min);
-    
-    // Sätt ljuset (samma nivå för alla kanaler)
-    set_light_direct(level, level, level);
-    
-    Serial.printf("[Sun Sim] %02d:%02d → Light: %d%% (Auto mode)\n", 
-        timeinfo.tm_hour, timeinfo.tm_min, (level * 100) / 255);
-}
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) e.dli.umol[ch] = light_dli_umol(e, ch);
 
-// ============================================================================
-// MQTT
-// ============================================================================
+    // Kolla om manuell override har löpt ut (40 minuter)
+    if (!e.state.auto_mode && (now - e.manual_start > MANUAL_OVERRIDE_DURATION)) {
+        e.state.auto_mode = true;
+        if (!e.simulated) {
+            publish_light_state();
+            Serial.println("[Sun Sim] Manual override expired, returning to auto mode");
+        }
+    }
+
+    // Skip om vi är i manuellt läge eller en DMX-ström styr
+    if (!e.state.auto_mode || e.blackout || !local || e.state.dmx) return;
+
+    // Profilen väljs om en gång per dygn
+    if (local->tm_yday != e.schedule_day) {
+        e.schedule_day = local->tm_yday;
+        e.schedule_profile = schedule_find_profile(*e.schedule, local->tm_wday, local->tm_mon);
+        if (e.dli_target) light_plan_dose(e);
+    }
+
+    // Sätt ljuset (binärsökning i kanalens brytpunkter)
+    uint32_t second = (local->tm_hour * 60 + local->tm_min) * 60 + local->tm_sec;
+    uint16_t levels[LIGHT_CHANNEL_COUNT];
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        levels[ch] = schedule_level(*e.schedule, e.schedule_profile, ch, second);
+    }
+
+    // DLI-mål: hela kurvan skalas i fotoner (duty), inte i nivå
+    if (e.dli_target) {
+        uint32_t scale = light_dose_scale(e, second);
+        e.dli.percent = (scale * 100 + 0x8000) >> 16;
+        if (scale < 0x10000) {
+            for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+                levels[ch] = PWM_CURVE.level_for(((uint64_t)PWM_CURVE.at(levels[ch]) * scale) >> 16);
+            }
+        }
+    }
+    light_apply_levels(e, levels, SUN_FADE_MS);
+    if (e.simulated) return;
+
+    static uint8_t logged_percent[LIGHT_CHANNEL_COUNT] = {};
+    static bool logged = false;
+    bool log = !logged;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        uint8_t percent = ((uint32_t)levels[ch] * 100) / 0xFFFF;
+        if (percent != logged_percent[ch]) log = true;
+        logged_percent[ch] = percent;
+    }
+    if (log) {
+        logged = true;
+        Serial.printf("[Sun Sim] %02d:%02d profile %d →", local->tm_hour, local->tm_min, e.schedule_profile);
+        for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+            Serial.printf(" %s %d%%", LIGHT_CHANNELS[ch].name, logged_percent[ch]);
+        }
+        Serial.println(" (Auto mode)");
+    }
+}
+
+// ============================================================================
+// DAILY LIGHT INTEGRAL
+// ============================================================================
+// Light side, fixed point. Photon flux is taken as proportional to duty, so
+// a channel's dose is ppfd × duty / MAX_DUTY × time. The duty last sent is
+// used for the whole interval: at most one 10 s sun fade is counted early.
+void light_integrate(LightEngine& e, uint32_t now) {
+    uint32_t elapsed = now - e.dli_last;
+    e.dli_last = now;
+    if (e.blackout) return;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        e.dli_acc[ch] += (uint64_t)light_ppfd[ch] * e.duty[ch] * elapsed;
+    }
+}
+
+uint32_t light_dli_umol(const LightEngine& e, uint8_t channel) {
+    return e.dli_acc[channel] / ((uint64_t)PWM_CURVE.MAX_DUTY * 1000);
+}
+
+// What today's profile would deliver from each 15 min slot to midnight if
+// run as is (three 5 min samples per slot). Interlocks are left out; the
+// scale is recomputed every step, so the error corrects itself.
+void light_plan_dose(LightEngine& e) {
+    uint64_t total = 0;
+    e.dli_plan[DLI_PLAN_SLOTS] = 0;
+    for (int slot = DLI_PLAN_SLOTS - 1; slot >= 0; slot--) {
+        for (uint32_t second = slot * 900 + 150; second < (uint32_t)(slot + 1) * 900; second += 300) {
+            for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+                if (light_ppfd[ch] == 0) continue;
+                uint16_t max = LIGHT_CHANNELS[ch].max_level * 257;
+                uint16_t level = schedule_level(*e.schedule, e.schedule_profile, ch, second);
+                total += (uint64_t)light_ppfd[ch] * PWM_CURVE.at(level < max ? level : max) * 300 / PWM_CURVE.MAX_DUTY;
+            }
+        }
+        e.dli_plan[slot] = (uint32_t)total;
+    }
+}
+
+// Q16 factor for the schedule's photon output so that what is left of it
+// lands on the target: 0 once the target is reached, never above 1 (the
+// schedule is the ceiling).
+uint32_t light_dose_scale(const LightEngine& e, uint32_t second) {
+    uint32_t done = 0;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) done += light_dli_umol(e, ch);
+    if (done >= e.dli_target) return 0;
+
+    uint32_t slot = second / 900;
+    uint32_t left = e.dli_plan[slot] - (uint64_t)(e.dli_plan[slot] - e.dli_plan[slot + 1]) * (second % 900) / 900;
+    if (left == 0) return 0x10000;
+    uint64_t scale = ((uint64_t)(e.dli_target - done) << 16) / left;
+    return scale < 0x10000 ? (uint32_t)scale : 0x10000;
+}
+
+// Network side: retained JSON with the total and each channel in mol/m²
+void publish_dli(bool force) {
+    static uint32_t sent_total = UINT32_MAX;
+    process_light_dli();
+    if (!mqtt_up()) return;
+    uint32_t total = 0;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) total += light_dli[ch];
+    if (!force && total == sent_total) return;
+
+    char payload[96 + LIGHT_CHANNEL_COUNT * 32];
+    int len = snprintf(payload, sizeof(payload), "{\"dli\":%.2f,\"target\":%.1f,\"percent\":%u", total / 1e6,
+                       dli_target, light_dli_percent);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        len += snprintf(payload + len, sizeof(payload) - len, ",\"%s\":%.2f", LIGHT_CHANNELS[ch].name,
+                        light_dli[ch] / 1e6);
+    }
+    snprintf(payload + len, sizeof(payload) - len, "}");
+    mqtt_publish(topic_dli, payload, true);
+    sent_total = total;
+}
+
+// ============================================================================
+// SCHEDULE
+// ============================================================================
+void init_schedule() {
+    String text = hal_nvs_get_string("SCHEDULE", "");
+    ScheduleError err;
+    if (text.length() > 0 && compile_schedule(text, &err)) {
+        schedule_text = text;
+        Serial.printf("Schedule loaded: %d profiles, %d points\n",
+                      schedule_staging.profile_count, schedule_staging.point_count);
+        return;
+    }
+    if (text.length() > 0) {
+        Serial.printf("[Schedule] Stored schedule invalid (line %d: %s), using default\n", err.line, err.message);
+    }
+    schedule_text = "";  // "no custom schedule"; GET /schedule shows the default
+    compile_schedule(default_schedule(), &err);
+}
+
+// Samma dygnskurva som före schemamotorn: SUNRISE/SUNSET-makron och
+// varje kanals sun_percent
+String default_schedule() {
+    String text = "# Default schedule\n";
+    char line[96];
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        uint8_t level = (255 * LIGHT_CHANNELS[ch].sun_percent) / 100;
+        snprintf(line, sizeof(line), "%s %02d:00=0 %02d:00=%u %02d:00=%u %02d:00=0\n", LIGHT_CHANNELS[ch].name,
+                 SUNRISE_START_HOUR, SUNRISE_END_HOUR, level, SUNSET_START_HOUR, level, SUNSET_END_HOUR);
+        text += line;
+    }
+    return text;
+}
+
+const String active_schedule_text() {
+    return schedule_text.length() > 0 ? schedule_text : default_schedule();
+}
+
+// Network side: compile against today's sun and hand the table to the light task
+bool compile_schedule(const String& text, ScheduleError* err) {
+    if (text.length() > SCHEDULE_MAX_TEXT) {
+        err->line = 0;
+        snprintf(err->message, sizeof(err->message), "longer than %d bytes", SCHEDULE_MAX_TEXT);
+        return false;
+    }
+    if (!schedule_compile(text.c_str(), text.length(), light_channel_names, LIGHT_CHANNEL_COUNT,
+                          solar_day_key >= 0 ? &solar_day : nullptr, &schedule_staging, err)) {
+        return false;
+    }
+    schedule_shared.store(schedule_staging);
+    send_light_command(LIGHT_CMD_SUN_REFRESH);
+    return true;
+}
+
+// Network side: a schedule from HTTP/MQTT. Empty text = back to the default.
+bool update_schedule(const char* text, size_t length, ScheduleError* err) {
+    String new_text(text, length);
+    if (!compile_schedule(length > 0 ? new_text : default_schedule(), err)) {
+        Serial.printf("[Schedule] Rejected, line %d: %s\n", err->line, err->message);
+        return false;
+    }
+    schedule_text = new_text;
+    hal_nvs_put_string("SCHEDULE", schedule_text);
+    Serial.printf("[Schedule] Updated: %d profiles, %d points\n",
+                  schedule_staging.profile_count, schedule_staging.point_count);
+    publish_schedule();
+    return true;
+}
+
+void publish_schedule() {
+    if (!mqtt_up()) return;
+    mqtt_publish(topic_schedule, active_schedule_text().c_str(), true);
+}
+
+// ============================================================================
+// SUN POSITION
+// ============================================================================
+// All trigonometry runs here, once per day: the result feeds the solar
+// breakpoints (sunrise+30, sun=...) and the schedule is recompiled.
+// From solar_timer, every SOLAR_CHECK_MS and right after the first time sync.
+void solar_loop() {
+    struct tm local, utc;
+    if (!hal_local_time(&local) || !hal_utc_time(&utc)) return;
+    if (local.tm_yday == solar_day_key) return;
+
+    solar_compute_day(local.tm_year + 1900, local.tm_yday, latitude, longitude, utc_offset_minutes(local, utc),
+                      &solar_day);
+    solar_day_key = local.tm_yday;
+    status_version++;  // new sunrise/sunset
+
+    char sunrise[8], sunset[8];
+    format_solar_time(sunrise, solar_day.sunrise);
+    format_solar_time(sunset, solar_day.sunset);
+    Serial.printf("[Sun] %04d-%02d-%02d at %.2f, %.2f: sunrise %s, sunset %s, noon elevation %.1f°\n",
+                  local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, latitude, longitude,
+                  sunrise, sunset, solar_day.max_elevation / 100.0);
+
+    if (!schedule_staging.solar) return;  // nothing in it depends on the date
+    ScheduleError err;
+    if (!compile_schedule(active_schedule_text(), &err)) {
+        Serial.printf("[Schedule] Recompile for today failed (line %d: %s), keeping the previous table\n",
+                      err.line, err.message);
+    }
+}
+
+// Lokal tid - UTC i minuter, inklusive sommartid
+int utc_offset_minutes(const struct tm& local, const struct tm& utc) {
+    int days = local.tm_yday - utc.tm_yday;
+    if (days > 1) days = -1;  // year boundary
+    if (days < -1) days = 1;
+    return days * 1440 + (local.tm_hour - utc.tm_hour) * 60 + (local.tm_min - utc.tm_min);
+}
+
+// "HH:MM", or "-" when the event does not happen today
+void format_solar_time(char* buf, int16_t minute) {
+    if (minute == SOLAR_NONE) {
+        strcpy(buf, "-");
+    } else {
+        snprintf(buf, 8, "%02d:%02d", (minute / 60) % 24, minute % 60);
+    }
+}
+
+// ============================================================================
+// SIMULATION
+// ============================================================================
+// The light engine on a virtual clock: no outputs, no logging, and the
+// live engine is never touched. See simulation.h.
+//
+// A run is resumable: sim_resume() steps until the sink asks for a pause,
+// so /simulate can produce rows only as fast as the client reads them.
+// One run at a time - the schedule and sun below are shared.
+static Schedule sim_schedule;  // network side only, like schedule_staging
+static SolarDay sim_sun;
+
+struct SimRun {
+    LightEngine e;
+    SimOptions opt;
+    const char* text;  // must outlive the run, recompiled per solar day
+    size_t length;
+    struct tm local;
+    int day;
+    bool compiled;
+    size_t next_event;
+    uint32_t t;        // next step, seconds from the start
+    uint32_t end;
+};
+
+bool sim_begin(SimRun& run, const char* text, size_t length, const SimOptions& opt, ScheduleError* err) {
+    if (opt.days == 0 || opt.days > SIM_MAX_DAYS || opt.step == 0) {
+        err->line = 0;
+        snprintf(err->message, sizeof(err->message), "days 1-%d, step > 0", SIM_MAX_DAYS);
+        return false;
+    }
+    run.e = {{{}, true, 0, false}, {{}, -1, 100}, {}, {}, false, true, 0, 0, &sim_schedule, -1, -1,
+             {}, 0, (uint32_t)(opt.dli_target * 1e6f), {}, {}, {}, 0, 0, 0};
+    run.opt = opt;
+    run.text = text;
+    run.length = length;
+    run.local = {};
+    run.day = -1;
+    run.compiled = false;
+    run.next_event = 0;
+    run.t = 0;
+    run.end = (uint32_t)opt.days * 86400;
+    return true;
+}
+
+// Runs until the sink returns false or run.t reaches run.end. False (with
+// err set) when the schedule does not compile for a simulated day.
+bool sim_resume(SimRun& run, SimSink sink, void* ctx, ScheduleError* err) {
+    const SimOptions& opt = run.opt;
+    while (run.t < run.end) {
+        uint32_t t = run.t;
+        if ((int)(t / 86400) != run.day) {
+            run.day = t / 86400;
+            // mktime() normalizes the date and fills in tm_wday/tm_yday;
+            // noon keeps DST changes from moving it to another day
+            run.local = {};
+            run.local.tm_year = opt.year - 1900;
+            run.local.tm_mon = opt.month - 1;
+            run.local.tm_mday = opt.day + run.day;
+            run.local.tm_hour = 12;
+            run.local.tm_isdst = -1;
+            mktime(&run.local);
+
+            if (!run.compiled || sim_schedule.solar) {
+                solar_compute_day(run.local.tm_year + 1900, run.local.tm_yday, opt.latitude, opt.longitude,
+                                  opt.utc_offset_minutes, &sim_sun);
+                if (!schedule_compile(run.text, run.length, light_channel_names, LIGHT_CHANNEL_COUNT, &sim_sun,
+                                      &sim_schedule, err)) {
+                    run.t = run.end;
+                    return false;
+                }
+                run.compiled = true;
+                run.e.schedule_day = -1;
+            }
+        }
+        uint32_t second = t % 86400;
+        run.local.tm_hour = second / 3600;
+        run.local.tm_min = second / 60 % 60;
+        run.local.tm_sec = second % 60;
+        uint32_t now = t * 1000;  // virtual millis, wraps like the real one
+
+        while (run.next_event < opt.event_count && opt.events[run.next_event].at <= t) {
+            const SimEvent& ev = opt.events[run.next_event++];
+            LightCommand cmd = {LIGHT_CMD_EXIT_MANUAL, 0, {}};
+            if (ev.channel >= 0 && ev.channel < LIGHT_CHANNEL_COUNT) {
+                cmd.type = LIGHT_CMD_SET;
+                cmd.mask = 1 << ev.channel;
+                cmd.values[ev.channel] = ev.level;
+            }
+            light_apply_command(run.e, cmd, now);
+        }
+        light_sun_step(run.e, now, &run.local);
+        run.t += opt.step;
+
+        uint32_t dli = 0;
+        for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) dli += run.e.dli.umol[ch];
+        SimSample sample = {t, &run.local, run.e.state.levels, run.e.state.auto_mode, dli};
+        if (!sink(sample, ctx)) break;
+    }
+    return true;
+}
+
+bool light_simulate(const char* text, size_t length, const SimOptions& opt, SimSink sink, void* ctx,
+                    ScheduleError* err) {
+    static SimRun run;
+    return sim_begin(run, text, length, opt, err) && sim_resume(run, sink, ctx, err);
+}
+
+int format_sim_row(char* buf, size_t size, const SimSample& sample, bool json) {
+    const struct tm& tm = *sample.local;
+    int len = json ? snprintf(buf, size, "[%u", (unsigned)sample.t)
+                   : snprintf(buf, size, "%04d-%02d-%02d %02d:%02d:%02d", tm.tm_year + 1900, tm.tm_mon + 1,
+                              tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT && len < (int)size; ch++) {
+        len += snprintf(buf + len, size - len, ",%u", sample.levels[ch]);
+    }
+    if (len < (int)size) len += snprintf(buf + len, size - len, json ? ",%d]" : ",%d\n", sample.auto_mode ? 1 : 0);
+    return len;
+}
+
+// GET /simulate previews the active schedule, POST /simulate the schedule
+// in the body. ?date=YYYY-MM-DD (default today) &days=1 &step=300 (s)
+// &format=csv|json &changes=1 (only rows where something changed)
+// &dli_target=<mol> (default: the configured target, 0 = off).
+// The run is resumed a buffer at a time as the client reads, nothing the
+// size of the trace is held in RAM. 503 while another preview streams.
+#define SIM_ROW_MAX (32 + LIGHT_CHANNEL_COUNT * 4)
+
+static SimRun sim_http_run;
+static bool sim_http_busy = false;
+
+struct SimStream : HttpStream {
+    String text;       // the run recompiles from it
+    bool json;
+    bool changes_only;
+    uint32_t rows;
+    uint8_t last[LIGHT_CHANNEL_COUNT];
+    bool last_auto;
+    ScheduleError err;
+    ~SimStream() { sim_http_busy = false; }
+};
+
+void sim_stream_begin(SimStream& sim, const struct tm& start) {
+    char head[64];
+    if (sim.json) {
+        http_stream_write(sim, head, snprintf(head, sizeof(head), "{\"start\":\"%04d-%02d-%02d\",\"step\":%u,\"columns\":[\"t\"",
+                                              start.tm_year + 1900, start.tm_mon + 1, start.tm_mday,
+                                              (unsigned)sim_http_run.opt.step));
+    } else {
+        http_stream_write(sim, "time", 4);
+    }
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        http_stream_write(sim, head, snprintf(head, sizeof(head), sim.json ? ",\"%s\"" : ",%s", LIGHT_CHANNELS[ch].name));
+    }
+    http_stream_write(sim, head, snprintf(head, sizeof(head), sim.json ? ",\"auto\"],\"rows\":[" : ",auto\n"));
+}
+
+// Pauses the run once the buffer cannot take another row
+bool sim_stream_row(const SimSample& sample, void* ctx) {
+    SimStream& sim = *(SimStream*)ctx;
+    if (sim.rows == 0) {
+        sim_stream_begin(sim, *sample.local);
+    } else if (sim.changes_only && sample.auto_mode == sim.last_auto &&
+               memcmp(sample.levels, sim.last, LIGHT_CHANNEL_COUNT) == 0) {
+        return true;
+    }
+    memcpy(sim.last, sample.levels, LIGHT_CHANNEL_COUNT);
+    sim.last_auto = sample.auto_mode;
+
+    char row[SIM_ROW_MAX];
+    int len = 0;
+    if (sim.json && sim.rows > 0) row[len++] = ',';
+    len += format_sim_row(row + len, sizeof(row) - len, sample, sim.json);
+    http_stream_write(sim, row, len);
+    sim.rows++;
+    return http_stream_room(sim, SIM_ROW_MAX);
+}
+
+bool sim_stream_produce(HttpStream& out) {
+    SimStream& sim = (SimStream&)out;
+    uint32_t rows = sim.rows;
+    if (!sim_resume(sim_http_run, sim_stream_row, &sim, &sim.err) && rows > 0) {
+        Serial.printf("[Simulate] Stopped after %u rows, line %d: %s\n", sim.rows, sim.err.line, sim.err.message);
+    }
+    if (sim_http_run.t < sim_http_run.end) return true;
+    if (sim.json && sim.rows > 0) http_stream_write(sim, "]}", 2);
+    return false;
+}
+
+void handle_simulate_request(AsyncWebServerRequest* request) {
+    SimOptions opt = {};
+    struct tm local, utc;
+    bool have_time = hal_local_time(&local) && hal_utc_time(&utc);
+    if (request->hasArg("date")) {
+        if (sscanf(request->arg("date").c_str(), "%d-%d-%d", &opt.year, &opt.month, &opt.day) != 3) {
+            request->send(400, "application/json", "{\"status\":\"error\",\"error\":\"date must be YYYY-MM-DD\"}");
+            return;
+        }
+    } else if (have_time) {
+        opt.year = local.tm_year + 1900;
+        opt.month = local.tm_mon + 1;
+        opt.day = local.tm_mday;
+    } else {
+        request->send(400, "application/json", "{\"status\":\"error\",\"error\":\"time not synced, pass date\"}");
+        return;
+    }
+    long days = request->hasArg("days") ? request->arg("days").toInt() : 1;
+    long step = request->hasArg("step") ? request->arg("step").toInt() : 300;
+    // days first: days * 86400 overflows a 32-bit long before SIM_HTTP_MAX_ROWS could catch it
+    if (days < 1 || days > SIM_MAX_DAYS || step < SUN_UPDATE_INTERVAL_MS / 1000 ||
+        days * 86400 / step > SIM_HTTP_MAX_ROWS) {
+        char response[112];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"error\",\"error\":\"days 1-%d, step >= %d s, at most %d rows\"}", SIM_MAX_DAYS,
+                 SUN_UPDATE_INTERVAL_MS / 1000, SIM_HTTP_MAX_ROWS);
+        request->send(400, "application/json", response);
+        return;
+    }
+    if (sim_http_busy) {
+        request->send(503, "application/json", "{\"status\":\"error\",\"error\":\"another simulation is running\"}");
+        return;
+    }
+    opt.days = days;
+    opt.step = step;
+    opt.latitude = latitude;
+    opt.longitude = longitude;
+    opt.utc_offset_minutes = have_time ? utc_offset_minutes(local, utc) : 60;
+    opt.dli_target = request->hasArg("dli_target") ? request->arg("dli_target").toFloat() : dli_target;
+
+    sim_http_busy = true;  // until the stream is destroyed
+    std::shared_ptr<SimStream> sim = std::make_shared<SimStream>();
+    sim->produce = sim_stream_produce;
+    size_t body_len;
+    const char* body = web_body(request, &body_len);
+    sim->text = body ? String(body, body_len) : active_schedule_text();
+    sim->json = request->arg("format") == "json";
+    sim->changes_only = request->arg("changes") == "1";
+
+    // The first buffer is produced here: until a row exists a schedule
+    // that does not compile can still get a 400
+    bool ok = sim->text.length() <= SCHEDULE_MAX_TEXT &&
+              sim_begin(sim_http_run, sim->text.c_str(), sim->text.length(), opt, &sim->err);
+    if (ok) sim->done = !sim_stream_produce(*sim);
+    if (sim->rows == 0) {
+        if (sim->text.length() > SCHEDULE_MAX_TEXT) {
+            sim->err.line = 0;
+            snprintf(sim->err.message, sizeof(sim->err.message), "longer than %d bytes", SCHEDULE_MAX_TEXT);
+        }
+        char response[128];
+        snprintf(response, sizeof(response), "{\"status\":\"error\",\"line\":%d,\"error\":\"%s\"}", sim->err.line,
+                 sim->err.message);
+        request->send(400, "application/json", response);
+        return;
+    }
+    AsyncWebServerResponse* response = http_stream_response(request, sim->json ? "application/json" : "text/csv", sim);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+// ============================================================================
+// METRICS
+// ============================================================================
+// Prometheus text format, scraped from /metrics. Histograms are fed from
+// loop() and the light task; see metrics.h. Rendered in one go into a
+// response stream (~10 KB) so a scrape is one consistent snapshot.
+void metrics_stream_write(const char* data, size_t len, void* ctx) {
+    ((AsyncResponseStream*)ctx)->write((const uint8_t*)data, len);
+}
+
+void handle_metrics_request(AsyncWebServerRequest* request) {
+    AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+    response->addHeader("Cache-Control", "no-store");
+    MetricsOutput out = {metrics_stream_write, response};
+
+    metrics_header(out, "vaxthus_loop_duration_seconds", "histogram", "Time per loop() iteration, excluding the delay");
+    metrics_histogram(out, "vaxthus_loop_duration_seconds", nullptr, metric_loop);
+    metrics_header(out, "vaxthus_section_duration_seconds", "histogram", "Time per call of each loop section");
+    for (uint8_t i = 0; i < METRIC_SECTION_COUNT; i++) {
+        metrics_histogram(out, "vaxthus_section_duration_seconds", "section", metric_sections[i]);
+    }
+    metrics_header(out, "vaxthus_section_duration_max_seconds", "gauge", "Longest single call since boot");
+    metrics_seconds(out, "vaxthus_section_duration_max_seconds", "section", "loop", metric_loop.max_us);
+    for (uint8_t i = 0; i < METRIC_SECTION_COUNT; i++) {
+        metrics_seconds(out, "vaxthus_section_duration_max_seconds", "section", metric_sections[i].label,
+                        metric_sections[i].max_us);
+    }
+
+    metrics_header(out, "vaxthus_light_jitter_seconds", "gauge", "Light task period jitter, moving average");
+    metrics_seconds(out, "vaxthus_light_jitter_seconds", nullptr, nullptr,
+                    light_jitter_avg_us.load(std::memory_order_relaxed));
+    metrics_header(out, "vaxthus_light_jitter_max_seconds", "gauge", "Light task period jitter, worst since boot");
+    metrics_seconds(out, "vaxthus_light_jitter_max_seconds", nullptr, nullptr,
+                    light_jitter_max_us.load(std::memory_order_relaxed));
+    metrics_header(out, "vaxthus_light_step_max_seconds", "gauge", "Longest light task step since boot");
+    metrics_seconds(out, "vaxthus_light_step_max_seconds", nullptr, nullptr,
+                    light_step_max_us.load(std::memory_order_relaxed));
+    metrics_header(out, "vaxthus_light_queue_dropped_total", "counter", "Light commands dropped on a full queue");
+    metrics_value(out, "vaxthus_light_queue_dropped_total", nullptr, nullptr, light_commands.dropped());
+
+    metrics_header(out, "vaxthus_power_mode", "gauge", "0 = off, 1 = 80 MHz when idle, 2 = and light sleep");
+    metrics_value(out, "vaxthus_power_mode", nullptr, nullptr, power_mode);
+    metrics_header(out, "vaxthus_cpu_duty_permille", "gauge", "Busy share of one core per task, last window");
+    for (uint8_t i = 0; i < POWER_TASK_COUNT; i++) {
+        metrics_value(out, "vaxthus_cpu_duty_permille", "task", POWER_TASKS[i]->label,
+                      power_report.duty_permille[i]);
+    }
+    metrics_header(out, "vaxthus_wakes", "gauge", "Wakes per task in the last window");
+    for (uint8_t i = 0; i < POWER_TASK_COUNT; i++) {
+        metrics_value(out, "vaxthus_wakes", "task", POWER_TASKS[i]->label, power_report.wakes[i]);
+    }
+    metrics_header(out, "vaxthus_power_window_seconds", "gauge", "Length of that window");
+    metrics_seconds(out, "vaxthus_power_window_seconds", nullptr, nullptr,
+                    (uint64_t)power_report.window_ms * 1000);
+    metrics_header(out, "vaxthus_light_sleep_blocked", "gauge", "1 while an output mid duty keeps the chip awake");
+    metrics_value(out, "vaxthus_light_sleep_blocked", nullptr, nullptr,
+                  light_awake_held.load(std::memory_order_relaxed) ? 1 : 0);
+
+    metrics_header(out, "vaxthus_settings_load_seconds", "gauge", "Settings read at boot, by where they came from");
+    metrics_seconds(out, "vaxthus_settings_load_seconds", "source", settings_source, settings_load_us);
+
+    metrics_header(out, "vaxthus_status_renders_total", "counter", "/status snapshots serialized");
+    metrics_value(out, "vaxthus_status_renders_total", nullptr, nullptr, status_renders);
+    metrics_header(out, "vaxthus_status_not_modified_total", "counter", "/status polls answered 304");
+    metrics_value(out, "vaxthus_status_not_modified_total", nullptr, nullptr, status_not_modified);
+
+    metrics_header(out, "vaxthus_dmx_active", "gauge", "1 while a DMX stream drives the outputs");
+    metrics_value(out, "vaxthus_dmx_active", nullptr, nullptr, dmx_active ? 1 : 0);
+    metrics_header(out, "vaxthus_dmx_frames_total", "counter", "DMX frames handed to the light task");
+    metrics_value(out, "vaxthus_dmx_frames_total", nullptr, nullptr, dmx_frames.load(std::memory_order_relaxed));
+    metrics_header(out, "vaxthus_dmx_rejected_total", "counter", "Malformed or out of order DMX packets");
+    metrics_value(out, "vaxthus_dmx_rejected_total", nullptr, nullptr, dmx_rejected.load(std::memory_order_relaxed));
+    metrics_header(out, "vaxthus_dmx_latency_seconds", "histogram", "DMX datagram read to outputs written");
+    metrics_histogram(out, "vaxthus_dmx_latency_seconds", nullptr, metric_dmx_latency);
+
+    metrics_header(out, "vaxthus_heap_free_bytes", "gauge", "Free heap");
+    metrics_value(out, "vaxthus_heap_free_bytes", nullptr, nullptr, hal_free_heap());
+    metrics_header(out, "vaxthus_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    metrics_value(out, "vaxthus_heap_min_free_bytes", nullptr, nullptr, hal_min_free_heap());
+    metrics_header(out, "vaxthus_heap_largest_free_block_bytes", "gauge", "Largest allocatable block");
+    metrics_value(out, "vaxthus_heap_largest_free_block_bytes", nullptr, nullptr, hal_largest_free_block());
+    metrics_header(out, "vaxthus_build_info", "gauge", "Firmware version, always 1");
+    metrics_value(out, "vaxthus_build_info", "version", FIRMWARE_VERSION, 1);
+    metrics_header(out, "vaxthus_uptime_seconds", "counter", "Seconds since boot");
+    metrics_value(out, "vaxthus_uptime_seconds", nullptr, nullptr, hal_millis() / 1000);
+
+    struct tm timeinfo;
+    if (solar_day_key >= 0 && hal_local_time(&timeinfo)) {
+        uint32_t second = (timeinfo.tm_hour * 60 + timeinfo.tm_min) * 60 + timeinfo.tm_sec;
+        metrics_header(out, "vaxthus_sun_elevation_degrees", "gauge", "Sun above the horizon, at the configured site");
+        metrics_float(out, "vaxthus_sun_elevation_degrees", nullptr, nullptr,
+                      solar_elevation(solar_day, second) / 100.0);
+    }
+
+    metrics_header(out, "vaxthus_wifi_connected", "gauge", "1 while the station link is up");
+    metrics_value(out, "vaxthus_wifi_connected", nullptr, nullptr, hal_wifi_connected() ? 1 : 0);
+    if (hal_wifi_connected()) {
+        metrics_header(out, "vaxthus_wifi_rssi_dbm", "gauge", "WiFi signal strength");
+        metrics_value(out, "vaxthus_wifi_rssi_dbm", nullptr, nullptr, hal_wifi_rssi());
+    }
+    metrics_header(out, "vaxthus_mqtt_connected", "gauge", "1 while connected to the broker");
+    metrics_value(out, "vaxthus_mqtt_connected", nullptr, nullptr, mqtt_up() ? 1 : 0);
+    metrics_header(out, "vaxthus_mqtt_connects_total", "counter", "Successful MQTT (re)connects");
+    metrics_value(out, "vaxthus_mqtt_connects_total", nullptr, nullptr, mqtt_connects);
+    metrics_header(out, "vaxthus_mqtt_connect_failures_total", "counter", "Failed MQTT connect attempts");
+    metrics_value(out, "vaxthus_mqtt_connect_failures_total", nullptr, nullptr, mqtt_connect_failures);
+    metrics_header(out, "vaxthus_http_busy_total", "counter", "Requests answered 503, the network lock stayed taken");
+    metrics_value(out, "vaxthus_http_busy_total", nullptr, nullptr, http_busy_rejects.load());
+    const ReconnectStats* reconnects[] = {&wifi_reconnect, &mqtt_reconnect};
+    metrics_header(out, "vaxthus_reconnect_seconds", "summary", "Time from losing a link to having it back");
+    for (const ReconnectStats* r : reconnects) {
+        metrics_seconds(out, "vaxthus_reconnect_seconds_sum", "link", r->link, r->total_ms * 1000);
+        metrics_value(out, "vaxthus_reconnect_seconds_count", "link", r->link, r->count);
+    }
+    metrics_header(out, "vaxthus_reconnect_last_seconds", "gauge", "The latest reconnect");
+    for (const ReconnectStats* r : reconnects) {
+        metrics_seconds(out, "vaxthus_reconnect_last_seconds", "link", r->link, (uint64_t)r->last_ms * 1000);
+    }
+    metrics_header(out, "vaxthus_reconnect_max_seconds", "gauge", "The slowest reconnect since boot");
+    for (const ReconnectStats* r : reconnects) {
+        metrics_seconds(out, "vaxthus_reconnect_max_seconds", "link", r->link, (uint64_t)r->max_ms * 1000);
+    }
+    metrics_header(out, "vaxthus_reconnect_attempts", "gauge", "Failed retries since the link was last up");
+    metrics_value(out, "vaxthus_reconnect_attempts", "link", "wifi", wifi_backoff.attempts);
+    metrics_value(out, "vaxthus_reconnect_attempts", "link", "mqtt", mqtt_backoff.attempts);
+    metrics_header(out, "vaxthus_wifi_fast_connect", "gauge", "1 if this boot joined from the cached link");
+    metrics_value(out, "vaxthus_wifi_fast_connect", nullptr, nullptr, wifi_fast_boot ? 1 : 0);
+    metrics_header(out, "vaxthus_mqtt_publishes_total", "counter", "MQTT messages published");
+    metrics_value(out, "vaxthus_mqtt_publishes_total", nullptr, nullptr, mqtt_publishes);
+    metrics_header(out, "vaxthus_mqtt_publish_failures_total", "counter", "MQTT publishes that failed");
+    metrics_value(out, "vaxthus_mqtt_publish_failures_total", nullptr, nullptr, mqtt_publish_failures);
+
+    NvsCacheStats nvs = nvs_cache_stats();
+    metrics_header(out, "vaxthus_nvs_commits_total", "counter", "NVS write-behind batches that reached flash");
+    metrics_value(out, "vaxthus_nvs_commits_total", nullptr, nullptr, nvs.commits);
+    metrics_header(out, "vaxthus_nvs_writes_total", "counter", "NVS keys written to flash");
+    metrics_value(out, "vaxthus_nvs_writes_total", nullptr, nullptr, nvs.writes_committed);
+    metrics_header(out, "vaxthus_nvs_writes_requested_total", "counter", "NVS cache puts, written or not");
+    metrics_value(out, "vaxthus_nvs_writes_requested_total", nullptr, nullptr, nvs.writes_requested);
+    metrics_header(out, "vaxthus_event_clients", "gauge", "Connected /events subscribers");
+    metrics_value(out, "vaxthus_event_clients", nullptr, nullptr, events_client_count());
+    metrics_header(out, "vaxthus_events_sent_total", "counter", "Server-Sent Events pushed");
+    metrics_value(out, "vaxthus_events_sent_total", nullptr, nullptr, events_sent);
+    TimerStats timers = timers_stats();
+    metrics_header(out, "vaxthus_timers_fired_total", "counter", "Timer callbacks run by loop()");
+    metrics_value(out, "vaxthus_timers_fired_total", nullptr, nullptr, timers.fired);
+    metrics_header(out, "vaxthus_timer_late_max_seconds", "gauge", "Longest wait from a deadline to its timer firing");
+    metrics_seconds(out, "vaxthus_timer_late_max_seconds", nullptr, nullptr, (uint64_t)timers.late_max_ms * 1000);
+
+    TelemetryStats log = telemetry_stats();
+    metrics_header(out, "vaxthus_telemetry_capacity_records", "gauge", "Records the telemetry log holds, 0 = no partition");
+    metrics_value(out, "vaxthus_telemetry_capacity_records", nullptr, nullptr, log.capacity);
+    metrics_header(out, "vaxthus_telemetry_records_total", "counter", "Telemetry records appended");
+    metrics_value(out, "vaxthus_telemetry_records_total", nullptr, nullptr, log.records);
+    metrics_header(out, "vaxthus_telemetry_sector_erases_total", "counter", "Telemetry flash sectors erased");
+    metrics_value(out, "vaxthus_telemetry_sector_erases_total", nullptr, nullptr, log.sector_erases);
+
+    request->send(response);
+}
+
+// ============================================================================
+// TELEMETRY LOG
+// ============================================================================
+// Events and level changes go to the flash ring log (telemetry_log.h).
+// Everything is read from the network side view, one record per call.
+void init_telemetry() {
+    telemetry_begin();
+}
+
+uint8_t telemetry_current_flags() {
+    uint8_t flags = 0;
+    if (autoMode) flags |= TELEMETRY_FLAG_AUTO;
+    if (hal_wifi_connected()) flags |= TELEMETRY_FLAG_WIFI;
+    if (mqtt_up()) flags |= TELEMETRY_FLAG_MQTT;
+    return flags;
+}
+
+void telemetry_log_event(TelemetryEvent event) {
+    TelemetryRecord record;
+    memset(&record, 0, sizeof(record));
+    record.time = hal_unix_time();
+    record.event = event;
+    record.flags = telemetry_current_flags();
+    if (record.time == 0) {
+        record.time = hal_millis() / 1000;
+        record.flags |= TELEMETRY_FLAG_UPTIME;
+    }
+    record.rssi = (int8_t)(hal_wifi_connected() ? hal_wifi_rssi() : 0);
+    record.channel_count = LIGHT_CHANNEL_COUNT;
+    memcpy(record.levels, light_levels, LIGHT_CHANNEL_COUNT);
+    telemetry_append(record);
+
+    memcpy(telemetry_levels, light_levels, sizeof(telemetry_levels));
+    telemetry_flags = record.flags & ~TELEMETRY_FLAG_UPTIME;
+    telemetry_last_ms = hal_millis();
+}
+
+void telemetry_step() {
+    uint32_t now = hal_millis();
+    uint8_t changed = telemetry_current_flags() ^ telemetry_flags;
+
+    if (!telemetry_booted) {
+        telemetry_booted = true;
+        telemetry_log_event(TELEMETRY_BOOT);
+    } else if (changed & TELEMETRY_FLAG_AUTO) {
+        telemetry_log_event(TELEMETRY_MODE);
+    } else if (changed & TELEMETRY_FLAG_WIFI) {
+        telemetry_log_event(hal_wifi_connected() ? TELEMETRY_WIFI_UP : TELEMETRY_WIFI_DOWN);
+    } else if (changed & TELEMETRY_FLAG_MQTT) {
+        telemetry_log_event(mqtt_up() ? TELEMETRY_MQTT_UP : TELEMETRY_MQTT_DOWN);
+    } else if (!telemetry_time_known && hal_unix_time() != 0) {
+        telemetry_time_known = true;
+        telemetry_log_event(TELEMETRY_TIME_SYNC);
+    } else if (memcmp(telemetry_levels, light_levels, sizeof(telemetry_levels)) != 0 &&
+               now - telemetry_last_ms >= (autoMode ? TELEMETRY_LEVELS_AUTO_MS : TELEMETRY_LEVELS_MANUAL_MS)) {
+        telemetry_log_event(TELEMETRY_LEVELS);
+    } else if (now - telemetry_last_ms >= TELEMETRY_HEARTBEAT_MS) {
+        telemetry_log_event(TELEMETRY_HEARTBEAT);
+    }
+    telemetry_loop(now);
+
+    // Next pass that can log anything: a held-back level change, the
+    // heartbeat, or the part-filled page going to flash
+    uint32_t due = telemetry_last_ms + TELEMETRY_HEARTBEAT_MS;
+    if (memcmp(telemetry_levels, light_levels, sizeof(telemetry_levels)) != 0) {
+        due = telemetry_last_ms + (autoMode ? TELEMETRY_LEVELS_AUTO_MS : TELEMETRY_LEVELS_MANUAL_MS);
+    }
+    uint32_t flush_due;
+    if (telemetry_flush_due(&flush_due) && (int32_t)(flush_due - due) < 0) due = flush_due;
+    timer_start_at(telemetry_timer, due);
+}
+
+#define TELEMETRY_CSV_ROW_MAX (96 + LIGHT_CHANNEL_COUNT * 4)
+
+// Resumes from next_seq on every fill, so records flushed or overwritten
+// while the download runs are neither repeated nor skipped
+struct TelemetryCsv : HttpStream {
+    uint32_t since;     // unix seconds, 0 = everything
+    uint32_t next_seq;
+    bool more;          // the walk stopped on a full buffer
+};
+
+bool telemetry_csv_row(const TelemetryRecord& record, void* ctx) {
+    TelemetryCsv& csv = *(TelemetryCsv*)ctx;
+    if (!http_stream_room(csv, TELEMETRY_CSV_ROW_MAX)) {
+        csv.more = true;
+        return false;
+    }
+    csv.next_seq = record.seq + 1;
+    bool uptime = record.flags & TELEMETRY_FLAG_UPTIME;
+    if (csv.since && (uptime || record.time < csv.since)) return true;
+
+    char row[TELEMETRY_CSV_ROW_MAX];
+    char when[24];
+    if (uptime) {
+        snprintf(when, sizeof(when), "+%u", (unsigned)record.time);
+    } else {
+        time_t t = record.time;
+        struct tm utc;
+        gmtime_r(&t, &utc);
+        strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    }
+    int len = snprintf(row, sizeof(row), "%u,%s,%s,%s,%d,%d,", (unsigned)record.seq, when,
+                       telemetry_event_name(record.event), record.flags & TELEMETRY_FLAG_AUTO ? "auto" : "manual",
+                       record.flags & TELEMETRY_FLAG_WIFI ? 1 : 0, record.flags & TELEMETRY_FLAG_MQTT ? 1 : 0);
+    if (record.flags & TELEMETRY_FLAG_WIFI) len += snprintf(row + len, sizeof(row) - len, "%d", record.rssi);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        row[len++] = ',';
+        if (ch < record.channel_count) len += snprintf(row + len, sizeof(row) - len, "%u", record.levels[ch]);
+    }
+    row[len++] = '\n';
+    http_stream_write(csv, row, len);
+    return true;
+}
+
+bool telemetry_csv_produce(HttpStream& out) {
+    TelemetryCsv& csv = (TelemetryCsv&)out;
+    csv.more = false;
+    telemetry_read(csv.next_seq, telemetry_csv_row, &csv);
+    return csv.more;
+}
+
+// GET /telemetry.csv[?since=<unix seconds>][&last=<records>]
+// Read from flash a buffer at a time as the client takes it; rows before
+// NTP sync carry "+<seconds since boot>" as time and are left out when
+// since is given.
+void handle_telemetry_request(AsyncWebServerRequest* request) {
+    std::shared_ptr<TelemetryCsv> csv = std::make_shared<TelemetryCsv>();
+    csv->produce = telemetry_csv_produce;
+    csv->since = strtoul(request->arg("since").c_str(), nullptr, 10);
+    if (request->hasArg("last")) {
+        uint32_t last = strtoul(request->arg("last").c_str(), nullptr, 10);
+        uint32_t next = telemetry_stats().next_seq;
+        csv->next_seq = next > last ? next - last : 0;
+    }
+
+    char header[64 + LIGHT_CHANNEL_COUNT * 16];
+    int len = snprintf(header, sizeof(header), "seq,time,event,mode,wifi,mqtt,rssi");
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        len += snprintf(header + len, sizeof(header) - len, ",%s", LIGHT_CHANNELS[ch].name);
+    }
+    header[len++] = '\n';
+    http_stream_write(*csv, header, len);
+
+    AsyncWebServerResponse* response = http_stream_response(request, "text/csv", csv);
+    response->addHeader("Content-Disposition", "attachment; filename=\"telemetry.csv\"");
+    request->send(response);
+}
+
+// ============================================================================
+// STREAMED HTTP RESPONSES
+// ============================================================================
+// AsyncTCP calls the filler whenever the client's TCP window has room.
+// Each call takes the network lock (or asks to be called again when it
+// stays busy for WEB_LOCK_TIMEOUT_MS) and hands out what is left of the
+// buffer, refilling it through produce() first when it is empty. A slow
+// client therefore just gets called less often; it holds no task and at
+// most one buffer of RAM.
+AsyncWebServerResponse* http_stream_response(AsyncWebServerRequest* request, const char* content_type,
+                                             std::shared_ptr<HttpStream> stream) {
+    return request->beginChunkedResponse(content_type, [stream](uint8_t* buffer, size_t max_len, size_t index) -> size_t {
+        (void)index;
+        if (!hal_net_try_lock(WEB_LOCK_TIMEOUT_MS)) return RESPONSE_TRY_AGAIN;  // headers are out, no 503
+        hal_power_busy(true);
+        uint32_t start = hal_cycle_count();
+        size_t len = http_stream_fill(*stream, buffer, max_len);
+        metrics_lap(metric_sections[METRIC_HTTP], start);
+        hal_power_busy(false);
+        hal_net_unlock();
+        return len;
+    });
+}
+
+// 0 ends the response
+size_t http_stream_fill(HttpStream& out, uint8_t* buffer, size_t max_len) {
+    while (out.sent == out.len) {
+        if (out.done) return 0;
+        out.len = 0;
+        out.sent = 0;
+        out.done = !out.produce(out);
+    }
+    size_t len = out.len - out.sent < max_len ? out.len - out.sent : max_len;
+    memcpy(buffer, out.buf + out.sent, len);
+    out.sent += len;
+    return len;
+}
+
+bool http_stream_room(const HttpStream& out, size_t len) {
+    return out.len + len <= sizeof(out.buf);
+}
+
+// Callers check http_stream_room() per row; anything beyond is cut off
+void http_stream_write(HttpStream& out, const char* data, size_t len) {
+    if (len > sizeof(out.buf) - out.len) len = sizeof(out.buf) - out.len;
+    memcpy(out.buf + out.len, data, len);
+    out.len += len;
+}
+
+// ============================================================================
+// MQTT
+// ============================================================================
 void init_mqtt() {
+    snprintf(topic_state, sizeof(topic_state), "%s/state", TOPIC_BASE);
+    snprintf(topic_batch_set, sizeof(topic_batch_set), "%s/set", TOPIC_BASE);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        snprintf(topic_channel_state[ch], sizeof(topic_channel_state[ch]), "%s/%s/state",
+                 TOPIC_BASE, LIGHT_CHANNELS[ch].name);
+        snprintf(topic_channel_set[ch], sizeof(topic_channel_set[ch]), "%s/%s/set",
+                 TOPIC_BASE, LIGHT_CHANNELS[ch].name);
+        mqtt_routes[ch] = {mqtt_topic_hash(topic_channel_set[ch], strlen(topic_channel_set[ch])),
+                           topic_channel_set[ch], (int8_t)ch};
+    }
+    mqtt_routes[LIGHT_CHANNEL_COUNT] = {mqtt_topic_hash(topic_batch_set, strlen(topic_batch_set)), topic_batch_set, MQTT_ROUTE_BATCH};
+    snprintf(topic_schedule, sizeof(topic_schedule), "%s/schedule", TOPIC_BASE);
+    snprintf(topic_schedule_set, sizeof(topic_schedule_set), "%s/schedule/set", TOPIC_BASE);
+    snprintf(topic_schedule_error, sizeof(topic_schedule_error), "%s/schedule/error", TOPIC_BASE);
+    snprintf(topic_dli, sizeof(topic_dli), "%s/dli", TOPIC_BASE);
+    mqtt_routes[LIGHT_CHANNEL_COUNT + 1] = {mqtt_topic_hash(topic_schedule_set, strlen(topic_schedule_set)),
+                                            topic_schedule_set, MQTT_ROUTE_SCHEDULE};
+    snprintf(topic_light_set, sizeof(topic_light_set), "%s/light/set", TOPIC_BASE);
+    snprintf(topic_ha_status, sizeof(topic_ha_status), "%s/status", HA_DISCOVERY_PREFIX);
+    mqtt_routes[LIGHT_CHANNEL_COUNT + 2] = {mqtt_topic_hash(topic_light_set, strlen(topic_light_set)),
+                                            topic_light_set, MQTT_ROUTE_HA_LIGHT};
+    mqtt_routes[LIGHT_CHANNEL_COUNT + 3] = {mqtt_topic_hash(topic_ha_status, strlen(topic_ha_status)),
+                                            topic_ha_status, MQTT_ROUTE_HA_STATUS};
+    init_ha_discovery();
+
     if (!mqtt_enabled || mqtt_server.length() == 0) {
         Serial.println("MQTT disabled or not configured");
         return;
@@ -493,348 +2697,771 @@ void init_mqtt() {
     Serial.printf("Initializing MQTT to %s:%d\n", mqtt_server.c_str(), mqtt_port);
     mqtt.setServer(mqtt_server.c_str(), mqtt_port);
     mqtt.setCallback(mqtt_callback);
-    mqtt.setBufferSize(1024);
+    mqtt.setBufferSize(SCHEDULE_MAX_TEXT + 256);  // room for a full schedule
 }
 
+// Every pass while connected. A lost broker gets one try at once, then the
+// failures back off on mqtt_timer (mqtt_backoff).
 void mqtt_loop() {
     if (!mqtt_enabled || mqtt_server.length() == 0) return;
-    if (WiFi.status() != WL_CONNECTED) return;
+    if (mqtt_connects > 0 && (!hal_wifi_connected() || !mqtt.connected())) reconnect_lost(mqtt_reconnect);
+    if (!hal_wifi_connected()) return;
 
     if (!mqtt.connected()) {
-        if (millis() - lastMqttReconnect > 5000) {
-            lastMqttReconnect = millis();
-            Serial.println("Connecting to MQTT...");
+        if (!timer_pending(mqtt_timer)) timer_start(mqtt_timer, 0);
+        return;
+    }
 
-            String clientId = "vaxthus_" + String((uint32_t)ESP.getEfuseMac(), HEX);
+    mqtt.loop();
+}
 
-            bool connected = false;
-            if (mqtt_user.length() > 0) {
-                connected = mqtt.connect(clientId.c_str(), mqtt_user.c_str(), mqtt_password.c_str());
-            } else {
-                connected = mqtt.connect(clientId.c_str());
-            }
+// From net_io_step(): connect() blocks up to the socket timeout when the
+// broker is away, so it runs without the net lock. mqtt_connecting keeps
+// handlers off the client (mqtt_up()) until it returns.
+void mqtt_connect() {
+    hal_net_lock();
+    if (!hal_wifi_connected() || mqtt.connected()) {
+        hal_net_unlock();
+        return;
+    }
+    Serial.println("Connecting to MQTT...");
 
-            if (connected) {
-                Serial.println("MQTT connected!");
+    String clientId = "vaxthus_" + String(hal_chip_id(), HEX);
+    String user = mqtt_user;
+    String password = mqtt_password;
+    mqtt_connecting = true;
+    hal_net_unlock();
 
-                // Subscribe to command topics
-                String topic_white = String(TOPIC_BASE) + "/white/set";
-                String topic_red = String(TOPIC_BASE) + "/red/set";
-                String topic_uv = String(TOPIC_BASE) + "/uv/set";
+    bool connected = false;
+    if (user.length() > 0) {
+        connected = mqtt.connect(clientId.c_str(), user.c_str(), password.c_str());
+    } else {
+        connected = mqtt.connect(clientId.c_str());
+    }
 
-                mqtt.subscribe(topic_white.c_str());
-                mqtt.subscribe(topic_red.c_str());
-                mqtt.subscribe(topic_uv.c_str());
+    hal_net_lock();
+    mqtt_connecting = false;
+    if (connected) {
+        mqtt_connects++;
+        backoff_reset(mqtt_backoff);
+        reconnect_done(mqtt_reconnect);
+        Serial.println("MQTT connected!");
+
+        // Subscribe to command topics
+        for (uint8_t i = 0; i < MQTT_ROUTE_COUNT; i++) {
+            mqtt.subscribe(mqtt_routes[i].topic);
+            Serial.printf("Subscribed to: %s\n", mqtt_routes[i].topic);
+        }
 
-                Serial.printf("Subscribed to: %s, %s, %s\n",
-                    topic_white.c_str(), topic_red.c_str(), topic_uv.c_str());
+        // Retained, but a broker without persistence forgets them on restart
+        publish_ha_discovery();
 
-                // Send HA Discovery
-                if (!ha_discovery_sent) {
-                    publish_ha_discovery();
-                    ha_discovery_sent = true;
-                }
+        // Publish current states
+        publish_mqtt_state(true);
+        publish_schedule();
+        publish_dli(true);
+    } else {
+        mqtt_connect_failures++;
+        uint32_t wait = backoff_next(mqtt_backoff);
+        Serial.printf("MQTT connection failed, rc=%d, retry in %u ms\n", mqtt.state(), wait);
+        timer_start(mqtt_timer, wait);
+    }
+    hal_net_unlock();
+}
 
-                // Publish current states
-                publish_state("white", light_white);
-                publish_state("red", light_red);
-                publish_state("uv", light_uv);
-            } else {
-                Serial.printf("MQTT connection failed, rc=%d\n", mqtt.state());
-            }
+// What everything but mqtt_loop() and mqtt_connect() asks before using the client
+bool mqtt_up() {
+    return !mqtt_connecting && mqtt.connected();
+}
+
+// Zero-copy: payload is parsed in place (it is not NUL-terminated)
+void mqtt_callback(char* topic, byte* payload, unsigned int length) {
+    Serial.printf("MQTT received: %s = %.*s\n", topic, (int)length, (const char*)payload);
+
+    const MqttRoute* route = mqtt_route_find(mqtt_routes, MQTT_ROUTE_COUNT, topic);
+    if (!route) return;
+
+    if (route->channel == MQTT_ROUTE_HA_STATUS) {
+        if (length == 6 && memcmp(payload, "online", 6) == 0) {  // HA restarted: it needs the configs again
+            publish_ha_discovery();
+            publish_mqtt_state(true);
         }
+        return;
     }
 
-    mqtt.loop();
+    if (route->channel == MQTT_ROUTE_HA_LIGHT) {
+        HaLightCommand cmd;
+        if (mqtt_parse_ha_light(payload, length, &cmd)) {
+            ha_light_command(cmd);
+        } else {
+            Serial.println("[MQTT] Ignoring invalid light command");
+        }
+        return;
+    }
+
+    if (route->channel == MQTT_ROUTE_SCHEDULE) {
+        ScheduleError err;
+        if (!update_schedule((const char*)payload, length, &err)) {
+            char message[80];
+            snprintf(message, sizeof(message), "line %d: %s", err.line, err.message);
+            mqtt_publish(topic_schedule_error, message, false);
+        }
+        return;
+    }
+
+    uint8_t values[LIGHT_CHANNEL_COUNT] = {};
+    if (route->channel == MQTT_ROUTE_BATCH) {
+        uint32_t mask = mqtt_parse_batch(payload, length, light_channel_names, LIGHT_CHANNEL_COUNT, values);
+        if (mask == 0) {
+            Serial.println("[MQTT] Ignoring invalid batch command");
+            return;
+        }
+        set_lights(mask, values);
+    } else if (mqtt_parse_level(payload, length, &values[route->channel])) {
+        set_lights(1 << route->channel, values);
+    } else {
+        Serial.printf("[MQTT] Ignoring invalid level on %s\n", topic);
+    }
 }
 
-void mqtt_callback(char* topic, byte* payload, unsigned int length) {
-    String topicStr = String(topic);
-    String payloadStr = "";
-    for (unsigned int i = 0; i < length; i++) {
-        payloadStr += (char)payload[i];
+// Every publish goes through here so /metrics can count them
+bool mqtt_publish(const char* topic, const char* payload, bool retained) {
+    bool ok = mqtt.publish(topic, payload, retained);
+    if (ok) {
+        mqtt_publishes++;
+    } else {
+        mqtt_publish_failures++;
+    }
+    return ok;
+}
+
+void publish_state(uint8_t channel, uint8_t value) {
+    if (!mqtt_up()) return;
+
+    char payload[4];
+    snprintf(payload, sizeof(payload), "%u", value);
+    mqtt_publish(topic_channel_state[channel], payload, true);
+}
+
+// Publicerar bara när något faktiskt ändrats: en retained JSON på
+// bastun/vaxtljus/state, plus de ändrade kanalerna om mqtt_channel_topics.
+// force = allt på nytt (efter återanslutning)
+void publish_mqtt_state(bool force) {
+    static uint8_t sent_levels[LIGHT_CHANNEL_COUNT];
+    static bool sent_auto;
+    if (!mqtt_up()) return;
+    if (!force && autoMode == sent_auto && memcmp(light_levels, sent_levels, sizeof(sent_levels)) == 0) return;
+
+    // The combined HA light reads its fields, the per-channel lights the channel keys
+    // While off, the colour it would come back on with
+    char payload[160 + LIGHT_CHANNEL_COUNT * 24];
+    HaLightColor light = ha_light_color(light_levels);
+    const HaLightColor& shown = light.on ? light : ha_light_last;
+    int len = snprintf(payload, sizeof(payload),
+        "{\"state\":\"%s\",\"brightness\":%u,\"color_mode\":\"rgbw\","
+        "\"color\":{\"r\":%u,\"g\":%u,\"b\":%u,\"w\":%u},\"effect\":\"%s\",",
+        light.on ? "ON" : "OFF", shown.brightness, shown.rgbw[0], shown.rgbw[1], shown.rgbw[2], shown.rgbw[3],
+        autoMode ? HA_EFFECT_SUN : HA_EFFECT_MANUAL);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        len += snprintf(payload + len, sizeof(payload) - len, "\"%s\":%u,", LIGHT_CHANNELS[ch].name, light_levels[ch]);
+    }
+    snprintf(payload + len, sizeof(payload) - len, "\"auto_mode\":%s}", autoMode ? "true" : "false");
+    mqtt_publish(topic_state, payload, true);
+
+    if (mqtt_channel_topics) {
+        for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+            if (force || light_levels[ch] != sent_levels[ch]) publish_state(ch, light_levels[ch]);
+        }
     }
 
-    Serial.printf("MQTT received: %s = %s\n", topic, payloadStr.c_str());
+    memcpy(sent_levels, light_levels, sizeof(sent_levels));
+    sent_auto = autoMode;
+}
 
-    int value = payloadStr.toInt();
-    if (value < 0) value = 0;
-    if (value > 255) value = 255;
+// ============================================================================
+// HOME ASSISTANT
+// ============================================================================
+// Combined light: brightness is the brightest rgbw channel, the colour each
+// channel relative to it (HA's JSON schema keeps the two apart). Off when
+// every rgbw channel is at 0; brightness and colour are 0 then.
+HaLightColor ha_light_color(const uint8_t* levels) {
+    HaLightColor light = {false, 0, {0, 0, 0, 0}};
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        if (LIGHT_CHANNELS[ch].rgbw >= 0 && levels[ch] > light.brightness) light.brightness = levels[ch];
+    }
+    if (light.brightness == 0) return light;
 
-    if (topicStr.endsWith("/white/set")) {
-        set_light(PWM_CHANNEL_WHITE, value);
-    } else if (topicStr.endsWith("/red/set")) {
-        set_light(PWM_CHANNEL_RED, value);
-    } else if (topicStr.endsWith("/uv/set")) {
-        set_light(PWM_CHANNEL_UV, value);
+    light.on = true;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        if (LIGHT_CHANNELS[ch].rgbw < 0) continue;
+        light.rgbw[LIGHT_CHANNELS[ch].rgbw] = (uint8_t)((levels[ch] * 255 + light.brightness / 2) / light.brightness);
     }
+    return light;
 }
 
-void publish_state(const char* channel, uint8_t value) {
-    if (!mqtt.connected()) return;
+bool ha_effect_is(const HaLightCommand& cmd, const char* name) {
+    return cmd.effect_length == strlen(name) && memcmp(cmd.effect, name, cmd.effect_length) == 0;
+}
+
+// One HA scene change = one command here = one set_lights(): a single
+// light task command, limiter pass and NVS change for all channels
+void ha_light_command(const HaLightCommand& cmd) {
+    // Missing fields come from the levels now, or from before the last OFF
+    HaLightColor current = ha_light_color(light_levels);
+    if (current.on) ha_light_last = current;
+    const HaLightColor& base = current.on ? current : ha_light_last;
+
+    // OFF always turns the light off, whatever effect comes with it
+    bool off = (cmd.fields & HA_LIGHT_STATE) && !cmd.on;
+    if ((cmd.fields & HA_LIGHT_EFFECT) && !off) {
+        if (ha_effect_is(cmd, HA_EFFECT_SUN)) {
+            send_light_command(LIGHT_CMD_EXIT_MANUAL);
+            return;
+        }
+        if (!ha_effect_is(cmd, HA_EFFECT_MANUAL)) {
+            Serial.printf("[HA] Unknown effect %.*s\n", (int)cmd.effect_length, cmd.effect);
+            return;
+        }
+        // Manual: the levels below (without other fields, the current ones - off too) are held
+    }
+
+    // No state: a brightness or colour turns the light on, anything else keeps it as it is
+    bool on = current.on;
+    if (cmd.fields & HA_LIGHT_STATE) {
+        on = cmd.on;
+    } else if (cmd.fields & (HA_LIGHT_BRIGHTNESS | HA_LIGHT_COLOR)) {
+        on = true;
+    }
+    uint8_t brightness = (cmd.fields & HA_LIGHT_BRIGHTNESS) ? cmd.brightness : base.brightness;
+    const uint8_t* rgbw = (cmd.fields & HA_LIGHT_COLOR) ? cmd.rgbw : base.rgbw;
+    uint8_t values[LIGHT_CHANNEL_COUNT] = {};
+    uint16_t mask = 0;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        if (LIGHT_CHANNELS[ch].rgbw < 0) continue;
+        mask |= 1 << ch;
+        values[ch] = on ? (uint8_t)((rgbw[LIGHT_CHANNELS[ch].rgbw] * brightness + 127) / 255) : 0;
+    }
+    set_lights(mask, values);
+}
 
-    String topic = String(TOPIC_BASE) + "/" + channel + "/state";
-    mqtt.publish(topic.c_str(), String(value).c_str(), true);
+void ha_device(JsonDocument& doc, bool full) {
+    JsonObject device = doc["device"].to<JsonObject>();
+    device["identifiers"][0] = "vaxthus_master_v3";
+    if (!full) return;
+    device["name"] = "Vaxthus Master V3";
+    device["model"] = "Grow Light Controller";
+    device["manufacturer"] = "DIY";
+    device["sw_version"] = FIRMWARE_VERSION;
 }
 
-void publish_ha_discovery() {
-    Serial.println("Publishing HA Discovery...");
+// Serializes doc into ha_discovery_json as entry `index`
+void ha_discovery_add(uint8_t index, const char* component, const char* object_id, JsonDocument& doc) {
+    HaDiscovery& entry = ha_discovery[index];
+    snprintf(entry.topic, sizeof(entry.topic), "%s/%s/%s/config", HA_DISCOVERY_PREFIX, component, object_id);
+    size_t room = sizeof(ha_discovery_json) - ha_discovery_bytes;
+    size_t length = measureJson(doc);
+    if (length >= room) {
+        entry.payload = nullptr;
+        Serial.printf("[HA] No room for %s (%u bytes)\n", entry.topic, (unsigned)length);
+        return;
+    }
+    entry.payload = ha_discovery_json + ha_discovery_bytes;
+    serializeJson(doc, ha_discovery_json + ha_discovery_bytes, room);
+    ha_discovery_bytes += length + 1;
+}
 
-    const char* channels[] = {"white", "red", "uv"};
-    const char* names[] = {"Grow Light White", "Grow Light Red", "Grow Light UV"};
+// Once, after the topics are built: connects then only publish
+void init_ha_discovery() {
+    ha_discovery_bytes = 0;
+    uint8_t index = 0;
+    {
+        JsonDocument doc;
+        doc["name"] = "Grow Light";
+        doc["unique_id"] = "vaxthus_light";
+        doc["schema"] = "json";
+        doc["command_topic"] = topic_light_set;
+        doc["state_topic"] = topic_state;
+        doc["supported_color_modes"][0] = "rgbw";
+        doc["effect"] = true;
+        doc["effect_list"][0] = HA_EFFECT_SUN;
+        doc["effect_list"][1] = HA_EFFECT_MANUAL;
+        ha_device(doc, true);
+        ha_discovery_add(index++, "light", "vaxthus_light", doc);
+    }
 
-    for (int i = 0; i < 3; i++) {
+    for (uint8_t i = 0; i < LIGHT_CHANNEL_COUNT; i++) {
+        const char* channel = LIGHT_CHANNELS[i].name;
+        char unique_id[40];
+        snprintf(unique_id, sizeof(unique_id), "vaxthus_%s", channel);
+        char text[96];
         JsonDocument doc;
 
-        doc["name"] = names[i];
-        doc["unique_id"] = String("vaxthus_") + channels[i];
-        doc["command_topic"] = String(TOPIC_BASE) + "/" + channels[i] + "/set";
-        doc["state_topic"] = String(TOPIC_BASE) + "/" + channels[i] + "/state";
+        snprintf(text, sizeof(text), "Grow Light %s", LIGHT_CHANNELS[i].label);
+        doc["name"] = text;
+        doc["unique_id"] = unique_id;
+        doc["command_topic"] = topic_channel_set[i];
+        doc["state_topic"] = topic_state;
         doc["brightness_scale"] = 255;
         doc["schema"] = "template";
         doc["command_on_template"] = "{{ brightness }}";
         doc["command_off_template"] = "0";
-        doc["state_template"] = "{% if value | int > 0 %}on{% else %}off{% endif %}";
-        doc["brightness_template"] = "{{ value }}";
-
-        JsonObject device = doc["device"].to<JsonObject>();
-        device["identifiers"][0] = "vaxthus_master_v3";
-        device["name"] = "Vaxthus Master V3";
-        device["model"] = "Grow Light Controller";
-        device["manufacturer"] = "DIY";
-        device["sw_version"] = "3.0.0";
+        snprintf(text, sizeof(text), "{%% if value_json.%s | int > 0 %%}on{%% else %%}off{%% endif %%}", channel);
+        doc["state_template"] = text;
+        snprintf(text, sizeof(text), "{{ value_json.%s }}", channel);
+        doc["brightness_template"] = text;
+        ha_device(doc, true);
+        ha_discovery_add(index++, "light", unique_id, doc);
+    }
 
-        String topic = String(HA_DISCOVERY_PREFIX) + "/light/vaxthus_" + channels[i] + "/config";
-        String payload;
-        serializeJson(doc, payload);
+    // Daily Light Integral sensor (resets at midnight)
+    JsonDocument doc;
+    doc["name"] = "Grow Light DLI";
+    doc["unique_id"] = "vaxthus_dli";
+    doc["state_topic"] = topic_dli;
+    doc["value_template"] = "{{ value_json.dli }}";
+    doc["unit_of_measurement"] = "mol/m²/d";
+    doc["state_class"] = "total_increasing";
+    doc["icon"] = "mdi:sprout";
+    ha_device(doc, false);
+    ha_discovery_add(index++, "sensor", "vaxthus_dli", doc);
+
+    Serial.printf("[HA] %u discovery payloads, %u of %u bytes\n", index, ha_discovery_bytes, HA_DISCOVERY_BUFFER);
+}
 
-        mqtt.publish(topic.c_str(), payload.c_str(), true);
-        Serial.printf("  Published: %s\n", topic.c_str());
+void publish_ha_discovery() {
+    for (const HaDiscovery& entry : ha_discovery) {
+        if (entry.payload) mqtt_publish(entry.topic, entry.payload, true);
     }
+    Serial.printf("[HA] Discovery published (%u entities)\n", HA_DISCOVERY_COUNT);
 }
 
 // ============================================================================
 // WEB SERVER
 // ============================================================================
+// ESPAsyncWebServer: sockets are serviced by the async_tcp task (core 1,
+// CONFIG_ASYNC_TCP_RUNNING_CORE) and any number of clients can be mid
+// request at once. Handlers run on that task, so web_on() wraps each one
+// in the network lock that loop() holds while it works.
 void init_webserver() {
     Serial.println("Initializing web server...");
 
-    // Main page
-    server.on("/", HTTP_GET, []() {
-        server.send(200, "text/html", get_index_html());
-    });
+    // Statiska sidor (gzip i flash): "/", "/settings"
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset* asset = &WEB_ASSETS[i];
+        web_on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest* request) {
+            serve_web_asset(request, asset);
+        });
+    }
 
-    // Settings page
-    server.on("/settings", HTTP_GET, []() {
-        server.send(200, "text/html", get_settings_html());
+    // Current settings for the settings page (passwords are never sent)
+    web_on("/config", HTTP_GET, [](AsyncWebServerRequest* request) {
+        JsonDocument doc;
+        doc["ssid"] = wifi_ssid;
+        doc["mqtt_enabled"] = mqtt_enabled;
+        doc["mqtt_server"] = mqtt_server;
+        doc["mqtt_port"] = mqtt_port;
+        doc["mqtt_user"] = mqtt_user;
+        doc["mqtt_channel_topics"] = mqtt_channel_topics;
+        doc["power_save"] = power_save;
+        doc["dmx_protocol"] = DMX_PROTOCOL_NAMES[dmx_protocol];
+        doc["dmx_universe"] = dmx_universe;
+        doc["dmx_address"] = dmx_address;
+        doc["latitude"] = latitude;
+        doc["longitude"] = longitude;
+        doc["dli_target"] = dli_target;
+        for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+            doc["ppfd"][LIGHT_CHANNELS[ch].name] = light_ppfd[ch];
+        }
+
+        String json;
+        serializeJson(doc, json);
+        AsyncWebServerResponse* response = request->beginResponse(200, "application/json", json);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
     });
 
-    // Save settings
-    server.on("/saveSettings", HTTP_POST, []() {
-        wifi_ssid = server.arg("ssid");
-        wifi_password = server.arg("password");
-        mqtt_server = server.arg("mqtt_server");
-        mqtt_port = server.arg("mqtt_port").toInt();
-        mqtt_user = server.arg("mqtt_user");
-        mqtt_password = server.arg("mqtt_pass");
-        mqtt_enabled = server.hasArg("mqtt_enabled");
+    // Save settings; loop() restarts once the response is out
+    web_on("/saveSettings", HTTP_POST, [](AsyncWebServerRequest* request) {
+        wifi_ssid = request->arg("ssid");
+        mqtt_server = request->arg("mqtt_server");
+        mqtt_port = request->arg("mqtt_port").toInt();
+        mqtt_user = request->arg("mqtt_user");
+        // Tomt lösenord = behåll det sparade (sidan får aldrig se det)
+        if (request->arg("password").length() > 0) wifi_password = request->arg("password");
+        if (request->arg("mqtt_pass").length() > 0) mqtt_password = request->arg("mqtt_pass");
+        mqtt_enabled = request->hasArg("mqtt_enabled");
+        mqtt_channel_topics = request->hasArg("mqtt_channel_topics");
+        power_save = request->hasArg("power_save");
+        if (request->hasArg("dmx_protocol")) {
+            String proto = request->arg("dmx_protocol");
+            dmx_protocol = proto == "artnet" ? DMX_ARTNET : (proto == "sacn" ? DMX_SACN : DMX_OFF);
+        }
+        if (request->hasArg("dmx_universe")) {
+            long universe = request->arg("dmx_universe").toInt();
+            dmx_universe = universe < 0 ? 0 : (universe > 63999 ? 63999 : universe);
+        }
+        if (request->hasArg("dmx_address")) {
+            long address = request->arg("dmx_address").toInt();
+            long last = DMX_SLOTS - LIGHT_CHANNEL_COUNT + 1;
+            dmx_address = address < 1 ? 1 : (address > last ? last : address);
+        }
+        if (request->hasArg("latitude")) latitude = fminf(fmaxf(request->arg("latitude").toFloat(), -90.0f), 90.0f);
+        if (request->hasArg("longitude")) longitude = fminf(fmaxf(request->arg("longitude").toFloat(), -180.0f), 180.0f);
+        if (request->hasArg("dli_target")) dli_target = fminf(fmaxf(request->arg("dli_target").toFloat(), 0.0f), 100.0f);
+        for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+            String arg = String("ppfd_") + LIGHT_CHANNELS[ch].name;
+            if (!request->hasArg(arg.c_str())) continue;
+            long ppfd = request->arg(arg.c_str()).toInt();
+            light_ppfd[ch] = ppfd < 0 ? 0 : (ppfd > 5000 ? 5000 : ppfd);
+        }
 
         save_settings();
+        save_dli_state();
+        nvs_cache_flush();
+        telemetry_flush();
 
-        server.send(200, "text/html", "<html><body><h1>Settings Saved!</h1><p>Rebooting...</p></body></html>");
-        delay(1000);
-        ESP.restart();
+        request->send(200, "text/html", "<html><body><h1>Settings Saved!</h1><p>Rebooting...</p></body></html>");
+        timer_start(restart_timer, RESTART_DELAY_MS);
     });
 
-    // Set light values
-    server.on("/setLight", HTTP_GET, []() {
-        if (server.hasArg("white")) {
-            set_light(PWM_CHANNEL_WHITE, server.arg("white").toInt());
+    // Set light values: /setLight?white=..&red=..&uv=.. (any subset)
+    web_on("/setLight", HTTP_GET, [](AsyncWebServerRequest* request) {
+        uint8_t values[LIGHT_CHANNEL_COUNT] = {};
+        uint16_t mask = 0;
+        for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+            if (!request->hasArg(LIGHT_CHANNELS[ch].name)) continue;
+            long value = request->arg(LIGHT_CHANNELS[ch].name).toInt();
+            values[ch] = value < 0 ? 0 : (value > 255 ? 255 : value);
+            mask |= 1 << ch;
         }
-        if (server.hasArg("red")) {
-            set_light(PWM_CHANNEL_RED, server.arg("red").toInt());
-        }
-        if (server.hasArg("uv")) {
-            set_light(PWM_CHANNEL_UV, server.arg("uv").toInt());
+        set_lights(mask, values);
+        request->send(200, "application/json", "{\"status\":\"ok\"}");
+    });
+
+    // Batch set: POST /setLight with {"white":..,"red":"50%","uv":"OFF"}
+    web_on("/setLight", HTTP_POST, [](AsyncWebServerRequest* request) {
+        // Same parser and formats as the MQTT batch topic
+        size_t len;
+        const char* body = web_body(request, &len);
+        uint8_t values[LIGHT_CHANNEL_COUNT] = {};
+        uint32_t mask = body ? mqtt_parse_batch((const uint8_t*)body, len, light_channel_names, LIGHT_CHANNEL_COUNT,
+                                                values)
+                             : 0;
+        if (mask == 0) {
+            request->send(400, "application/json", "{\"status\":\"error\",\"error\":\"invalid command\"}");
+            return;
         }
-        server.send(200, "application/json", "{\"status\":\"ok\"}");
+        set_lights(mask, values);
+        request->send(200, "application/json", "{\"status\":\"ok\"}");
     });
 
-    // Get status
-    server.on("/status", HTTP_GET, []() {
+    // Channel table for the dashboard (static, fetched once per page load)
+    web_on("/channels", HTTP_GET, [](AsyncWebServerRequest* request) {
         JsonDocument doc;
-        doc["white"] = light_white;
-        doc["red"] = light_red;
-        doc["uv"] = light_uv;
-        doc["wifi_connected"] = WiFi.status() == WL_CONNECTED;
-        doc["wifi_ip"] = WiFi.localIP().toString();
-        doc["wifi_rssi"] = WiFi.RSSI();
-        doc["wifi_signal_percent"] = get_wifi_signal_strength();
-        doc["mqtt_connected"] = mqtt.connected();
-        doc["auto_mode"] = autoMode;
-
-        String response;
-        serializeJson(doc, response);
-        server.send(200, "application/json", response);
+        for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+            JsonObject c = doc.add<JsonObject>();
+            c["name"] = LIGHT_CHANNELS[ch].name;
+            c["label"] = LIGHT_CHANNELS[ch].label;
+            c["color"] = LIGHT_CHANNELS[ch].color;
+            c["max"] = LIGHT_CHANNELS[ch].max_level;
+        }
+        String json;
+        serializeJson(doc, json);
+        request->send(200, "application/json", json);
+    });
+
+    // Schedule as text (the default one until a custom schedule is saved)
+    web_on("/schedule", HTTP_GET, [](AsyncWebServerRequest* request) {
+        AsyncWebServerResponse* response = request->beginResponse(
+            200, "text/plain", schedule_text.length() > 0 ? schedule_text : default_schedule());
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    });
+
+    // Replace the schedule (text body); an empty body restores the default
+    web_on("/schedule", HTTP_POST, [](AsyncWebServerRequest* request) {
+        size_t len;
+        const char* body = web_body(request, &len);
+        ScheduleError err;
+        char response[128];
+        if (!update_schedule(body ? body : "", body ? len : 0, &err)) {
+            snprintf(response, sizeof(response), "{\"status\":\"error\",\"line\":%d,\"error\":\"%s\"}",
+                     err.line, err.message);
+            request->send(400, "application/json", response);
+            return;
+        }
+        snprintf(response, sizeof(response), "{\"status\":\"ok\",\"profiles\":%d,\"points\":%d}",
+                 schedule_staging.profile_count, schedule_staging.point_count);
+        request->send(200, "application/json", response);
     });
 
+    // Prometheus scrape target
+    web_on("/metrics", HTTP_GET, handle_metrics_request);
+
+    web_on("/telemetry.csv", HTTP_GET, handle_telemetry_request);
+
+    // Dry run of the active (GET) or a candidate (POST body) schedule
+    web_on("/simulate", HTTP_GET | HTTP_POST, handle_simulate_request);
+
+    // Get status (cached snapshot, see status_render())
+    web_on("/status", HTTP_GET, handle_status_request);
+
+    // Live state stream for the dashboard (replaces /status polling)
+    init_events();
+
     // Exit manual mode (return to auto)
-    server.on("/exitManual", HTTP_GET, []() {
-        autoMode = true;
-        Serial.println("[Manual] User requested return to auto mode");
-        server.send(200, "application/json", "{\"status\":\"ok\",\"mode\":\"auto\"}");
+    web_on("/exitManual", HTTP_GET, [](AsyncWebServerRequest* request) {
+        send_light_command(LIGHT_CMD_EXIT_MANUAL);
+        request->send(200, "application/json", "{\"status\":\"ok\",\"mode\":\"auto\"}");
     });
 
+    server.onNotFound([](AsyncWebServerRequest* request) {
+        request->send(404, "text/plain", "Not found");
+    });
     server.begin();
     Serial.println("  Web server started on port 80");
 }
 
-String get_index_html() {
-    String html = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta name='viewport' content='width=device-width, initial-scale=1'>
-    <title>Vaxthus Master V3</title>
-    <style>
-        body { font-family: Arial; margin: 20px; background: #1a1a2e; color: #eee; }
-        h1 { color: #4ecca3; }
-        .card { background: #16213e; padding: 20px; border-radius: 10px; margin: 10px 0; }
-        .slider-container { margin: 15px 0; }
-        .slider-label { display: flex; justify-content: space-between; margin-bottom: 5px; }
-        input[type=range] { width: 100%; height: 25px; }
-        .white { accent-color: #fff; }
-        .red { accent-color: #ff4444; }
-        .uv { accent-color: #9944ff; }
-        .status { font-size: 0.9em; color: #888; }
-        a { color: #4ecca3; text-decoration: none; }
-        .btn { 
-            background: #ff6b35; color: #fff; border: none;
-            padding: 12px 24px; border-radius: 5px; cursor: pointer;
-            font-size: 14px; margin: 10px 0; display: inline-block;
-        }
-        .btn:hover { background: #ff8855; }
-        #autoBtn { display: none; }
-    </style>
-</head>
-<body>
-    <h1>Vaxthus Master V3</h1>
-    <p class='status'>WiFi: <span id='wifi'>--</span> (<span id='signal'>--</span>) | MQTT: <span id='mqtt'>--</span></p>
-
-    <div class='card'>
-        <h2>Light Control</h2>
-
-        <div class='slider-container'>
-            <div class='slider-label'><span>White</span><span id='white_val'>)rawliteral" + String(light_white) + R"rawliteral(</span></div>
-            <input type='range' min='0' max='255' value=')rawliteral" + String(light_white) + R"rawliteral(' class='white' id='white' onchange='setLight("white", this.value)'>
-        </div>
-
-        <div class='slider-container'>
-            <div class='slider-label'><span>Red</span><span id='red_val'>)rawliteral" + String(light_red) + R"rawliteral(</span></div>
-            <input type='range' min='0' max='255' value=')rawliteral" + String(light_red) + R"rawliteral(' class='red' id='red' onchange='setLight("red", this.value)'>
-        </div>
-
-        <div class='slider-container'>
-            <div class='slider-label'><span>UV</span><span id='uv_val'>)rawliteral" + String(light_uv) + R"rawliteral(</span></div>
-            <input type='range' min='0' max='255' value=')rawliteral" + String(light_uv) + R"rawliteral(' class='uv' id='uv' onchange='setLight("uv", this.value)'>
-        </div>
-        
-        <button id='autoBtn' class='btn' onclick='exitManual()'>🌅 Return to Auto Mode</button>
-    </div>
-
-    <p><a href='/settings'>Settings</a></p>
-
-    <script>
-        function setLight(channel, value) {
-            document.getElementById(channel + '_val').innerText = value;
-            fetch('/setLight?' + channel + '=' + value);
-        }
-
-        function exitManual() {
-            fetch('/exitManual')
-                .then(r => r.json())
-                .then(d => {
-                    alert('Returned to automatic sun simulation mode');
-                    updateStatus();
-                });
-        }
-
-        function updateStatus() {
-            fetch('/status')
-                .then(r => r.json())
-                .then(d => {
-                    document.getElementById('wifi').innerText = d.wifi_connected ? d.wifi_ip : 'Disconnected';
-                    document.getElementById('signal').innerText = d.wifi_connected ? d.wifi_rssi + ' dBm (' + d.wifi_signal_percent + '%)' : '--';
-                    document.getElementById('mqtt').innerText = d.mqtt_connected ? 'Connected' : 'Disconnected';
-                    
-                    // Show/hide return to auto button
-                    document.getElementById('autoBtn').style.display = d.auto_mode ? 'none' : 'inline-block';
-                });
-        }
-
-        setInterval(updateStatus, 5000);
-        updateStatus();
-    </script>
-</body>
-</html>
-)rawliteral";
-    return html;
-}
-
-String get_settings_html() {
-    String html = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta name='viewport' content='width=device-width, initial-scale=1'>
-    <title>Settings - Vaxthus Master</title>
-    <style>
-        body { font-family: Arial; margin: 20px; background: #1a1a2e; color: #eee; }
-        h1 { color: #4ecca3; }
-        .card { background: #16213e; padding: 20px; border-radius: 10px; margin: 10px 0; }
-        label { display: block; margin: 10px 0 5px; }
-        input[type=text], input[type=password], input[type=number] {
-            width: 100%; padding: 10px; border: none; border-radius: 5px;
-            background: #0f3460; color: #eee; box-sizing: border-box;
-        }
-        input[type=checkbox] { width: 20px; height: 20px; }
-        button {
-            background: #4ecca3; color: #1a1a2e; border: none;
-            padding: 15px 30px; border-radius: 5px; cursor: pointer;
-            font-size: 16px; margin-top: 20px; width: 100%;
-        }
-        a { color: #4ecca3; }
-    </style>
-</head>
-<body>
-    <h1>Settings</h1>
-    <form action='/saveSettings' method='POST'>
-        <div class='card'>
-            <h2>WiFi</h2>
-            <label>SSID:</label>
-            <input type='text' name='ssid' value=')rawliteral" + wifi_ssid + R"rawliteral('>
-            <label>Password:</label>
-            <input type='password' name='password' value=')rawliteral" + wifi_password + R"rawliteral('>
-        </div>
-
-        <div class='card'>
-            <h2>MQTT</h2>
-            <label><input type='checkbox' name='mqtt_enabled' )rawliteral" + String(mqtt_enabled ? "checked" : "") + R"rawliteral(> Enable MQTT</label>
-            <label>Server:</label>
-            <input type='text' name='mqtt_server' value=')rawliteral" + mqtt_server + R"rawliteral('>
-            <label>Port:</label>
-            <input type='number' name='mqtt_port' value=')rawliteral" + String(mqtt_port) + R"rawliteral('>
-            <label>Username:</label>
-            <input type='text' name='mqtt_user' value=')rawliteral" + mqtt_user + R"rawliteral('>
-            <label>Password:</label>
-            <input type='password' name='mqtt_pass' value=')rawliteral" + mqtt_password + R"rawliteral('>
-        </div>
-
-        <button type='submit'>Save & Reboot</button>
-    </form>
-    <p><a href='/'>Back to Dashboard</a></p>
-</body>
-</html>
-)rawliteral";
-    return html;
+// ============================================================================
+// STATUS
+// ============================================================================
+// Loop side: a new status version when anything the dashboard shows moved
+// (the light state bumps it in process_light_state())
+void status_step() {
+    EventState now = current_event_state();
+    if (event_state_equal(now, status_state_seen)) return;
+    status_state_seen = now;
+    status_version++;
+}
+
+void handle_status_request(AsyncWebServerRequest* request) {
+    if (status_rendered_version != status_version) status_render();
+    const AsyncWebHeader* etag = request->getHeader("If-None-Match");
+    AsyncWebServerResponse* response;
+    if (etag && etag->value() == status_etag) {
+        response = request->beginResponse(304);
+        status_not_modified++;
+    } else {
+        response = request->beginResponse(200, "application/json", status_json);
+    }
+    response->addHeader("ETag", status_etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+// Serializes the status into status_json: only what status_version
+// follows, plus what is fixed from boot. The ETag is the body's FNV-1a
+// hash, so a render that changed nothing keeps it (and it stays valid
+// across reboots).
+void status_render() {
+    JsonDocument doc;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        doc[LIGHT_CHANNELS[ch].name] = light_levels[ch];
+    }
+    doc["wifi_connected"] = hal_wifi_connected();
+    doc["wifi_ip"] = hal_wifi_local_ip();
+    doc["mqtt_connected"] = mqtt_up();
+    doc["auto_mode"] = autoMode;
+    doc["conn_state"] = CONN_STATE_NAMES[conn_state];
+    doc["boot_first_light_ms"] = boot_first_light_ms;
+    doc["boot_online_ms"] = boot_online_ms;
+    doc["firmware"] = FIRMWARE_VERSION;
+    doc["wifi_fast_connect"] = wifi_fast_boot;
+    doc["wifi_reconnect_ms"] = wifi_reconnect.last_ms;
+    doc["mqtt_reconnect_ms"] = mqtt_reconnect.last_ms;
+    doc["pwm_resolution_bits"] = PWM_RESOLUTION;
+    if (solar_day_key >= 0) {
+        char sunrise[8], sunset[8];
+        format_solar_time(sunrise, solar_day.sunrise);
+        format_solar_time(sunset, solar_day.sunset);
+        doc["sunrise"] = sunrise;
+        doc["sunset"] = sunset;
+    }
+    // As of the last process_light_dli(), in the same 0.01 mol steps that bump the version
+    uint32_t dli = 0;
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        doc["dli_channels"][LIGHT_CHANNELS[ch].name] = (light_dli[ch] / 10000) / 100.0;
+        dli += light_dli[ch];
+    }
+    doc["dli"] = (dli / 10000) / 100.0;
+    doc["dli_target"] = dli_target;
+    doc["dli_percent"] = light_dli_percent;
+    doc["dmx_protocol"] = DMX_PROTOCOL_NAMES[dmx_protocol];
+    doc["dmx_active"] = dmx_active;
+    doc["power_mode"] = POWER_MODE_NAMES[power_mode];
+
+    status_length = serializeJson(doc, status_json, sizeof(status_json));
+    if (status_length >= sizeof(status_json) - 1) {
+        Serial.printf("[HTTP] /status truncated at %u bytes\n", (unsigned)status_length);
+    }
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < status_length; i++) hash = (hash ^ (uint8_t)status_json[i]) * 16777619u;
+    snprintf(status_etag, sizeof(status_etag), "\"%08x\"", (unsigned)hash);
+    status_rendered_version = status_version;
+    status_renders++;
+}
+
+// Every route goes through here: request bodies are collected for
+// web_body(), and the handler runs under the network lock, timed into
+// the "http" section of /metrics. A lock that stays taken for
+// WEB_LOCK_TIMEOUT_MS gets the client a 503 rather than a stalled socket.
+void web_on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction handler) {
+    server.on(uri, method, [handler](AsyncWebServerRequest* request) {
+        if (request->contentLength() > WEB_BODY_MAX) {
+            request->send(413, "application/json", "{\"status\":\"error\",\"error\":\"body too large\"}");
+            return;
+        }
+        if (!hal_net_try_lock(WEB_LOCK_TIMEOUT_MS)) {
+            http_busy_rejects++;
+            AsyncWebServerResponse* response =
+                request->beginResponse(503, "application/json", "{\"status\":\"error\",\"error\":\"busy\"}");
+            response->addHeader("Retry-After", "1");
+            request->send(response);
+            return;
+        }
+        hal_power_busy(true);
+        uint32_t start = hal_cycle_count();
+        handler(request);
+        metrics_lap(metric_sections[METRIC_HTTP], start);
+        hal_power_busy(false);
+        hal_net_unlock();
+        hal_loop_wake();  // whatever the handler changed, loop() picks it up now
+    }, nullptr, web_collect_body);
+}
+
+// Raw bodies (JSON, schedule text) arrive in pieces before the handler
+// runs. Form posts (curl -d's default content type) are parsed into
+// arguments by the server instead, so schedule text goes as text/plain.
+void web_collect_body(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (total > WEB_BODY_MAX) return;
+    if (index == 0) {
+        free(request->_tempObject);
+        request->_tempObject = malloc(sizeof(size_t) + total + 1);
+        if (!request->_tempObject) return;
+        *(size_t*)request->_tempObject = total;
+    }
+    if (!request->_tempObject || index + len > total) return;
+    char* body = (char*)request->_tempObject + sizeof(size_t);
+    memcpy(body + index, data, len);
+    body[index + len] = '\0';
+}
+
+// nullptr when the request had no raw body
+const char* web_body(AsyncWebServerRequest* request, size_t* len) {
+    if (!request->_tempObject) return nullptr;
+    *len = *(size_t*)request->_tempObject;
+    return (const char*)request->_tempObject + sizeof(size_t);
+}
+
+// Serves a gzip asset straight from flash. "no-cache" makes the browser
+// revalidate every time, which costs a bodyless 304 when nothing changed.
+void serve_web_asset(AsyncWebServerRequest* request, const WebAsset* asset) {
+    const AsyncWebHeader* etag = request->getHeader("If-None-Match");
+    AsyncWebServerResponse* response;
+    if (etag && etag->value() == asset->etag) {
+        response = request->beginResponse(304);
+    } else {
+        response = request->beginResponse(200, asset->content_type, asset->data, asset->length);
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+// ============================================================================
+// SERVER-SENT EVENTS
+// ============================================================================
+// /events är en AsyncEventSource. Nya prenumeranter får hela tillståndet,
+// därefter skickar events_loop() bara fält som ändrats. Inga
+// JsonDocument/String - allt formateras i en stackbuffert.
+//
+// A client whose queue overflows on weak WiFi loses messages rather than
+// the connection, so every EVENTS_KEEPALIVE_MS the full state goes out
+// instead of a delta.
+void init_events() {
+    // Runs on the async_tcp task without the network lock; loop() sends
+    events.onConnect([](AsyncEventSourceClient* client) {
+        (void)client;
+        events_snapshot_due = true;
+        hal_loop_wake();
+    });
+    events.setFilter([](AsyncWebServerRequest* request) {
+        (void)request;
+        return events.count() < EVENTS_MAX_CLIENTS;
+    });
+    server.addHandler(&events);
+
+    // Reached only when the filter above turned the client away;
+    // the dashboard then falls back to polling /status
+    web_on("/events", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(503, "text/plain", "Too many event clients");
+    });
+}
+
+void events_loop() {
+    EventState now = current_event_state();
+    if (events_client_count() == 0) {
+        event_state_sent = now;
+        return;
+    }
+
+    bool full = events_snapshot_due.exchange(false);
+    char buf[EVENTS_BUFFER_SIZE];
+    int len = format_event(buf, sizeof(buf), now, full ? nullptr : &event_state_sent);
+    if (len == 0) return;
+
+    events.send(buf);
+    events_sent += events_client_count();
+    event_state_sent = now;
+}
+
+bool event_state_equal(const EventState& a, const EventState& b) {
+    return memcmp(a.levels, b.levels, sizeof(a.levels)) == 0 && a.auto_mode == b.auto_mode &&
+           a.conn_state == b.conn_state && a.wifi_connected == b.wifi_connected &&
+           a.mqtt_connected == b.mqtt_connected;
+}
+
+EventState current_event_state() {
+    EventState state;
+    memcpy(state.levels, light_levels, sizeof(state.levels));
+    state.auto_mode = autoMode;
+    state.conn_state = conn_state;
+    state.wifi_connected = hal_wifi_connected();
+    state.mqtt_connected = mqtt_up();
+    return state;
+}
+
+// Formats the JSON object "{...}" with the fields that differ from prev (all of
+// them when prev is null). Returns 0 when nothing changed.
+int format_event(char* buf, size_t size, const EventState& now, const EventState* prev) {
+    int len = snprintf(buf, size, "{");
+    size_t fields_start = len;
+
+#define EVENT_FIELD(cond, fmt, ...)                                              \
+    if ((cond) && len < (int)size) {                                             \
+        len += snprintf(buf + len, size - len, "%s" fmt,                         \
+                        (size_t)len > fields_start ? "," : "", __VA_ARGS__);     \
+    }
+    for (uint8_t ch = 0; ch < LIGHT_CHANNEL_COUNT; ch++) {
+        EVENT_FIELD(!prev || prev->levels[ch] != now.levels[ch], "\"%s\":%u", LIGHT_CHANNELS[ch].name, now.levels[ch]);
+    }
+    EVENT_FIELD(!prev || prev->auto_mode != now.auto_mode, "\"auto_mode\":%s", now.auto_mode ? "true" : "false");
+    EVENT_FIELD(!prev || prev->conn_state != now.conn_state, "\"conn_state\":\"%s\"", CONN_STATE_NAMES[now.conn_state]);
+    EVENT_FIELD(!prev || prev->mqtt_connected != now.mqtt_connected, "\"mqtt_connected\":%s", now.mqtt_connected ? "true" : "false");
+    if (!prev || prev->wifi_connected != now.wifi_connected) {
+        EVENT_FIELD(true, "\"wifi_connected\":%s", now.wifi_connected ? "true" : "false");
+        EVENT_FIELD(true, "\"wifi_ip\":\"%s\"", hal_wifi_local_ip().c_str());
+        EVENT_FIELD(true, "\"wifi_rssi\":%d", hal_wifi_rssi());
+        EVENT_FIELD(true, "\"wifi_signal_percent\":%d", get_wifi_signal_strength());
+    }
+#undef EVENT_FIELD
+
+    if ((size_t)len == fields_start) return 0;
+    if (len < (int)size) len += snprintf(buf + len, size - len, "}");
+    return len < (int)size ? len : 0;
+}
+
+uint8_t events_client_count() {
+    return events.count();
 }
@@ -0,0 +1,106 @@
+/**
+ * Vaxthus_Master_V3 - Runtime metrics
+ *
+ * See include/metrics.h.
+ */
+
+#include "metrics.h"
+
+#include <stdio.h>
+
+#include "hal.h"
+
+void histogram_observe(Histogram& h, uint32_t us) {
+    // Smallest i with us <= 2^i
+    uint32_t i = us <= 1 ? 0 : 32 - __builtin_clz(us - 1);
+    if (i > METRICS_BUCKETS) i = METRICS_BUCKETS;
+    h.buckets[i]++;
+    h.count++;
+    h.sum_us += us;
+    if (us > h.max_us) h.max_us = us;
+}
+
+uint32_t metrics_lap(Histogram& h, uint32_t since) {
+    static uint32_t cycles_per_us = 0;  // CPU clock is fixed after boot
+    if (cycles_per_us == 0) cycles_per_us = hal_cycles_per_us();
+    uint32_t now = hal_cycle_count();
+    histogram_observe(h, (now - since) / cycles_per_us);
+    return now;
+}
+
+// ============================================================================
+// PROMETHEUS TEXT FORMAT
+// ============================================================================
+static void emit(const MetricsOutput& out, const char* line, int len) {
+    if (len > 0) out.write(line, (size_t)len, out.ctx);
+}
+
+// "name" or "name{label=\"value\"}" (+ extra label, e.g. le)
+static int format_name(char* buf, size_t size, const char* name, const char* suffix, const char* label,
+                       const char* label_value, const char* le) {
+    int len = snprintf(buf, size, "%s%s", name, suffix);
+    if (!label && !le) return len;
+    len += snprintf(buf + len, size - len, "{");
+    if (label) len += snprintf(buf + len, size - len, "%s=\"%s\"%s", label, label_value, le ? "," : "");
+    if (le) len += snprintf(buf + len, size - len, "le=\"%s\"", le);
+    return len + snprintf(buf + len, size - len, "}");
+}
+
+static int format_us(char* buf, size_t size, uint64_t us) {
+    return snprintf(buf, size, "%llu.%06u", (unsigned long long)(us / 1000000), (unsigned)(us % 1000000));
+}
+
+void metrics_header(const MetricsOutput& out, const char* name, const char* type, const char* help) {
+    char line[192];
+    emit(out, line, snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type));
+}
+
+void metrics_value(const MetricsOutput& out, const char* name, const char* label, const char* label_value,
+                   int64_t value) {
+    char line[128];
+    int len = format_name(line, sizeof(line), name, "", label, label_value, nullptr);
+    len += snprintf(line + len, sizeof(line) - len, " %lld\n", (long long)value);
+    emit(out, line, len);
+}
+
+void metrics_seconds(const MetricsOutput& out, const char* name, const char* label, const char* label_value,
+                     uint64_t us) {
+    char line[128];
+    int len = format_name(line, sizeof(line), name, "", label, label_value, nullptr);
+    line[len++] = ' ';
+    len += format_us(line + len, sizeof(line) - len, us);
+    line[len++] = '\n';
+    emit(out, line, len);
+}
+
+void metrics_float(const MetricsOutput& out, const char* name, const char* label, const char* label_value,
+                   double value) {
+    char line[128];
+    int len = format_name(line, sizeof(line), name, "", label, label_value, nullptr);
+    len += snprintf(line + len, sizeof(line) - len, " %.2f\n", value);
+    emit(out, line, len);
+}
+
+void metrics_histogram(const MetricsOutput& out, const char* name, const char* label, const Histogram& h) {
+    char line[160], le[16];
+    uint32_t cumulative = 0;
+    for (uint32_t i = 0; i <= METRICS_BUCKETS; i++) {
+        cumulative += h.buckets[i];
+        if (i < METRICS_BUCKETS) {
+            format_us(le, sizeof(le), 1u << i);
+        } else {
+            snprintf(le, sizeof(le), "+Inf");
+        }
+        int len = format_name(line, sizeof(line), name, "_bucket", label, h.label, le);
+        len += snprintf(line + len, sizeof(line) - len, " %u\n", (unsigned)cumulative);
+        emit(out, line, len);
+    }
+    int len = format_name(line, sizeof(line), name, "_sum", label, h.label, nullptr);
+    line[len++] = ' ';
+    len += format_us(line + len, sizeof(line) - len, h.sum_us);
+    line[len++] = '\n';
+    emit(out, line, len);
+    len = format_name(line, sizeof(line), name, "_count", label, h.label, nullptr);
+    len += snprintf(line + len, sizeof(line) - len, " %u\n", (unsigned)h.count);
+    emit(out, line, len);
+}
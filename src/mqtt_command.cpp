@@ -0,0 +1,338 @@
+/**
+ * Vaxthus_Master_V3 - MQTT command parsing
+ *
+ * See include/mqtt_command.h. Every read is bounds-checked against the
+ * payload length; the buffer is not NUL-terminated.
+ */
+
+#include "mqtt_command.h"
+
+#include <string.h>
+
+// Larger than any sane payload, keeps the integer math from overflowing
+#define LEVEL_NUMBER_LIMIT 100000
+
+struct Cursor {
+    const uint8_t* p;
+    const uint8_t* end;
+};
+
+struct Span {
+    const uint8_t* p;
+    size_t len;
+};
+
+// ============================================================================
+// TOPICS
+// ============================================================================
+uint32_t mqtt_topic_hash(const char* topic, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)topic[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const MqttRoute* mqtt_route_find(const MqttRoute* routes, size_t count, const char* topic) {
+    uint32_t hash = mqtt_topic_hash(topic, strlen(topic));
+    for (size_t i = 0; i < count; i++) {
+        if (routes[i].hash == hash && strcmp(routes[i].topic, topic) == 0) return &routes[i];
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// SCALAR LEVELS
+// ============================================================================
+static bool is_space(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void skip_space(Cursor& c) {
+    while (c.p < c.end && is_space(*c.p)) c.p++;
+}
+
+static Span trim(Span s) {
+    while (s.len > 0 && is_space(s.p[0])) {
+        s.p++;
+        s.len--;
+    }
+    while (s.len > 0 && is_space(s.p[s.len - 1])) s.len--;
+    return s;
+}
+
+static bool equals_nocase(Span s, const char* word) {
+    size_t n = strlen(word);
+    if (s.len != n) return false;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t c = s.p[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != (uint8_t)word[i]) return false;
+    }
+    return true;
+}
+
+// "128", "-3", "50%", "12.5%". Result in tenths so percentages can carry
+// one decimal; extra decimals are accepted and ignored.
+static bool parse_number(Span s, bool* negative, uint32_t* tenths, bool* percent) {
+    size_t i = 0;
+    *negative = false;
+    *percent = false;
+    if (i < s.len && (s.p[i] == '-' || s.p[i] == '+')) {
+        *negative = s.p[i] == '-';
+        i++;
+    }
+
+    uint32_t whole = 0;
+    size_t digits = 0;
+    while (i < s.len && s.p[i] >= '0' && s.p[i] <= '9') {
+        if (whole < LEVEL_NUMBER_LIMIT) whole = whole * 10 + (s.p[i] - '0');
+        i++;
+        digits++;
+    }
+
+    uint32_t fraction = 0;
+    if (i < s.len && s.p[i] == '.') {
+        i++;
+        if (i < s.len && s.p[i] >= '0' && s.p[i] <= '9') {
+            fraction = s.p[i] - '0';
+            digits++;
+        }
+        while (i < s.len && s.p[i] >= '0' && s.p[i] <= '9') i++;
+    }
+
+    if (i < s.len && s.p[i] == '%') {
+        *percent = true;
+        i++;
+    }
+    if (digits == 0 || i != s.len) return false;
+
+    *tenths = whole * 10 + fraction;
+    return true;
+}
+
+static bool parse_scalar(Span s, uint8_t* level) {
+    s = trim(s);
+    if (s.len == 0) return false;
+
+    if (equals_nocase(s, "on") || equals_nocase(s, "true")) {
+        *level = 255;
+        return true;
+    }
+    if (equals_nocase(s, "off") || equals_nocase(s, "false")) {
+        *level = 0;
+        return true;
+    }
+
+    bool negative, percent;
+    uint32_t tenths;
+    if (!parse_number(s, &negative, &tenths, &percent)) return false;
+
+    uint32_t value;
+    if (percent) {
+        value = (tenths * 255 + 500) / 1000;  // rounded
+    } else {
+        value = (tenths + 5) / 10;
+    }
+    *level = negative ? 0 : (value > 255 ? 255 : (uint8_t)value);
+    return true;
+}
+
+// ============================================================================
+// FLAT JSON OBJECTS
+// ============================================================================
+// Only what the commands need: one level of "key": value members where the
+// value is a string, number or literal. Escapes are rejected, and so is
+// nesting unless the caller asks for it (one level, see json_object).
+static bool json_begin(Cursor& c) {
+    skip_space(c);
+    if (c.p >= c.end || *c.p != '{') return false;
+    c.p++;
+    return true;
+}
+
+static bool json_string(Cursor& c, Span* out) {
+    if (c.p >= c.end || *c.p != '"') return false;
+    c.p++;
+    out->p = c.p;
+    while (c.p < c.end && *c.p != '"') {
+        if (*c.p == '\\') return false;
+        c.p++;
+    }
+    if (c.p >= c.end) return false;
+    out->len = c.p - out->p;
+    c.p++;
+    return true;
+}
+
+// A flat object as one value span, braces included; parse it with its own Cursor
+static bool json_object(Cursor& c, Span* out) {
+    out->p = c.p;
+    c.p++;
+    while (c.p < c.end && *c.p != '}') {
+        if (*c.p == '{' || *c.p == '[') return false;
+        if (*c.p == '"') {
+            Span skipped;
+            if (!json_string(c, &skipped)) return false;
+        } else {
+            c.p++;
+        }
+    }
+    if (c.p >= c.end) return false;
+    c.p++;
+    out->len = c.p - out->p;
+    return true;
+}
+
+// Returns 1 for a member, 0 at the closing brace, -1 on malformed input.
+// With nested, an object value comes back whole (json_object).
+static int json_next_member(Cursor& c, Span* key, Span* value, bool first, bool nested = false) {
+    skip_space(c);
+    if (c.p >= c.end) return -1;
+    if (*c.p == '}') {
+        c.p++;
+        skip_space(c);
+        return c.p == c.end ? 0 : -1;
+    }
+    if (!first) {
+        if (*c.p != ',') return -1;
+        c.p++;
+        skip_space(c);
+    }
+
+    if (!json_string(c, key)) return -1;
+    skip_space(c);
+    if (c.p >= c.end || *c.p != ':') return -1;
+    c.p++;
+    skip_space(c);
+    if (c.p >= c.end) return -1;
+
+    if (*c.p == '"') return json_string(c, value) ? 1 : -1;
+    if (*c.p == '{' && nested) return json_object(c, value) ? 1 : -1;
+    if (*c.p == '{' || *c.p == '[') return -1;
+
+    value->p = c.p;
+    while (c.p < c.end && *c.p != ',' && *c.p != '}' && !is_space(*c.p)) c.p++;
+    value->len = c.p - value->p;
+    return value->len > 0 ? 1 : -1;
+}
+
+// {"state":"ON"|"OFF","brightness":0-255}
+static bool parse_light_json(Cursor c, uint8_t* level) {
+    if (!json_begin(c)) return false;
+
+    bool have_state = false, state_on = false, have_brightness = false;
+    uint8_t brightness = 0;
+    Span key, value;
+    int rc;
+    for (bool first = true; (rc = json_next_member(c, &key, &value, first)) == 1; first = false) {
+        if (equals_nocase(key, "state")) {
+            uint8_t on;
+            if (!parse_scalar(value, &on)) return false;
+            have_state = true;
+            state_on = on > 0;
+        } else if (equals_nocase(key, "brightness")) {
+            if (!parse_scalar(value, &brightness)) return false;
+            have_brightness = true;
+        }
+    }
+    if (rc < 0) return false;
+
+    if (have_state && !state_on) {
+        *level = 0;
+    } else if (have_brightness) {
+        *level = brightness;
+    } else if (have_state) {
+        *level = 255;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// PUBLIC PARSERS
+// ============================================================================
+bool mqtt_parse_level(const uint8_t* payload, size_t length, uint8_t* level) {
+    Cursor c = {payload, payload + length};
+    skip_space(c);
+    if (c.p < c.end && *c.p == '{') return parse_light_json(c, level);
+    return parse_scalar({payload, length}, level);
+}
+
+uint32_t mqtt_parse_batch(const uint8_t* payload, size_t length,
+                          const char* const* names, uint8_t count, uint8_t* values) {
+    Cursor c = {payload, payload + length};
+    if (!json_begin(c)) return 0;
+
+    uint32_t mask = 0;
+    uint8_t parsed[32];
+    if (count > 32) count = 32;
+
+    Span key, value;
+    int rc;
+    for (bool first = true; (rc = json_next_member(c, &key, &value, first)) == 1; first = false) {
+        for (uint8_t ch = 0; ch < count; ch++) {
+            if (!equals_nocase(key, names[ch])) continue;
+            if (!parse_scalar(value, &parsed[ch])) return 0;
+            mask |= 1u << ch;
+            break;
+        }
+    }
+    if (rc < 0) return 0;
+
+    // All or nothing: values are only touched for a valid command
+    for (uint8_t ch = 0; ch < count; ch++) {
+        if (mask & (1u << ch)) values[ch] = parsed[ch];
+    }
+    return mask;
+}
+
+// {"r":255,"g":0,"b":64,"w":255}
+static bool parse_rgbw(Span s, uint8_t* rgbw) {
+    static const char* const COMPONENTS[4] = {"r", "g", "b", "w"};
+    Cursor c = {s.p, s.p + s.len};
+    if (!json_begin(c)) return false;
+    uint8_t parsed[4] = {0, 0, 0, 0};
+    Span key, value;
+    int rc;
+    for (bool first = true; (rc = json_next_member(c, &key, &value, first)) == 1; first = false) {
+        for (uint8_t i = 0; i < 4; i++) {
+            if (equals_nocase(key, COMPONENTS[i]) && !parse_scalar(value, &parsed[i])) return false;
+        }
+    }
+    if (rc < 0) return false;
+    memcpy(rgbw, parsed, sizeof(parsed));
+    return true;
+}
+
+bool mqtt_parse_ha_light(const uint8_t* payload, size_t length, HaLightCommand* out) {
+    Cursor c = {payload, payload + length};
+    if (!json_begin(c)) return false;
+
+    HaLightCommand cmd = {};
+    Span key, value;
+    int rc;
+    for (bool first = true; (rc = json_next_member(c, &key, &value, first, true)) == 1; first = false) {
+        if (equals_nocase(key, "state")) {
+            uint8_t on;
+            if (!parse_scalar(value, &on)) return false;
+            cmd.on = on > 0;
+            cmd.fields |= HA_LIGHT_STATE;
+        } else if (equals_nocase(key, "brightness")) {
+            if (!parse_scalar(value, &cmd.brightness)) return false;
+            cmd.fields |= HA_LIGHT_BRIGHTNESS;
+        } else if (equals_nocase(key, "color")) {
+            if (!parse_rgbw(value, cmd.rgbw)) return false;
+            cmd.fields |= HA_LIGHT_COLOR;
+        } else if (equals_nocase(key, "effect")) {
+            cmd.effect = (const char*)value.p;
+            cmd.effect_length = value.len;
+            cmd.fields |= HA_LIGHT_EFFECT;
+        }
+    }
+    if (rc < 0 || cmd.fields == 0) return false;
+    *out = cmd;
+    return true;
+}
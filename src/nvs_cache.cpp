@@ -0,0 +1,194 @@
+/**
+ * Vaxthus_Master_V3 - Write-behind NVS cache
+ *
+ * See include/nvs_cache.h.
+ */
+
+#include "nvs_cache.h"
+
+#include <string.h>
+
+#include "hal.h"
+
+enum NvsCacheType : uint8_t {
+    NVS_CACHE_U8,
+    NVS_CACHE_U32
+};
+
+struct NvsCacheEntry {
+    const char* key;
+    uint32_t value;      // value in RAM
+    uint32_t committed;  // value in flash, valid when synced is set
+    NvsCacheType type;
+    bool synced;         // committed mirrors flash (false until read or written)
+    bool dirty;
+};
+
+static NvsCacheEntry entries[NVS_CACHE_MAX_ENTRIES];
+static uint8_t entry_count = 0;
+static bool any_dirty = false;
+static uint32_t first_dirty_ms = 0;
+static uint32_t last_change_ms = 0;
+static NvsCacheStats stats = {0, 0, 0};
+
+static NvsCacheEntry* find_entry(const char* key) {
+    for (uint8_t i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].key, key) == 0) return &entries[i];
+    }
+    return nullptr;
+}
+
+// read_flash = false creates the slot without touching flash (first put)
+static NvsCacheEntry* load_entry(const char* key, NvsCacheType type, uint32_t default_value, bool read_flash) {
+    NvsCacheEntry* entry = find_entry(key);
+    if (entry) return entry;
+
+    if (entry_count >= NVS_CACHE_MAX_ENTRIES) {
+        Serial.printf("[NVS] Cache full, %s is not cached\n", key);
+        return nullptr;
+    }
+
+    entry = &entries[entry_count++];
+    entry->key = key;
+    entry->type = type;
+    if (read_flash) {
+        entry->value = type == NVS_CACHE_U8 ? hal_nvs_get_u8(key, (uint8_t)default_value)
+                                            : hal_nvs_get_u32(key, default_value);
+    } else {
+        entry->value = default_value;
+    }
+    entry->committed = entry->value;
+    entry->synced = read_flash;
+    entry->dirty = false;
+    return entry;
+}
+
+static void write_value(const char* key, NvsCacheType type, uint32_t value) {
+    if (type == NVS_CACHE_U8) {
+        hal_nvs_put_u8(key, (uint8_t)value);
+    } else {
+        hal_nvs_put_u32(key, value);
+    }
+}
+
+static void put_value(const char* key, NvsCacheType type, uint32_t value) {
+    stats.writes_requested++;
+
+    NvsCacheEntry* entry = load_entry(key, type, value, false);
+    if (!entry) {
+        // Out of slots: fall back to a direct write rather than lose data
+        write_value(key, type, value);
+        stats.writes_committed++;
+        return;
+    }
+
+    entry->value = value;
+    entry->dirty = !entry->synced || entry->value != entry->committed;
+
+    uint32_t now = hal_millis();
+    if (!any_dirty) first_dirty_ms = now;
+    last_change_ms = now;
+    any_dirty = true;
+}
+
+// Copies every dirty value into batch; any_dirty drops until a put or nvs_cache_done()
+static bool take_dirty(NvsCacheBatch* batch) {
+    batch->count = 0;
+    if (!any_dirty) return false;
+    any_dirty = false;
+
+    for (uint8_t i = 0; i < entry_count; i++) {
+        const NvsCacheEntry& entry = entries[i];
+        if (!entry.dirty) continue;
+        batch->writes[batch->count].key = entry.key;
+        batch->writes[batch->count].value = entry.value;
+        batch->writes[batch->count].type = entry.type;
+        batch->count++;
+    }
+    return batch->count > 0;
+}
+
+uint8_t nvs_cache_get_u8(const char* key, uint8_t default_value) {
+    NvsCacheEntry* entry = load_entry(key, NVS_CACHE_U8, default_value, true);
+    return entry ? (uint8_t)entry->value : hal_nvs_get_u8(key, default_value);
+}
+
+void nvs_cache_put_u8(const char* key, uint8_t value) {
+    put_value(key, NVS_CACHE_U8, value);
+}
+
+uint32_t nvs_cache_get_u32(const char* key, uint32_t default_value) {
+    NvsCacheEntry* entry = load_entry(key, NVS_CACHE_U32, default_value, true);
+    return entry ? entry->value : hal_nvs_get_u32(key, default_value);
+}
+
+void nvs_cache_put_u32(const char* key, uint32_t value) {
+    put_value(key, NVS_CACHE_U32, value);
+}
+
+void nvs_cache_loop() {
+    NvsCacheBatch batch;
+    if (!nvs_cache_take(&batch)) return;
+    nvs_cache_write(batch);
+    nvs_cache_done(batch);
+}
+
+// Whichever comes first: NVS_CACHE_IDLE_MS of quiet or the max delay
+bool nvs_cache_commit_due(uint32_t* due_ms) {
+    if (!any_dirty) return false;
+    uint32_t idle = last_change_ms + NVS_CACHE_IDLE_MS;
+    uint32_t latest = first_dirty_ms + NVS_CACHE_MAX_DELAY_MS;
+    *due_ms = (int32_t)(idle - latest) < 0 ? idle : latest;
+    return true;
+}
+
+void nvs_cache_flush() {
+    NvsCacheBatch batch;
+    if (!take_dirty(&batch)) return;
+    nvs_cache_write(batch);
+    nvs_cache_done(batch);
+}
+
+bool nvs_cache_take(NvsCacheBatch* batch) {
+    batch->count = 0;
+    if (!any_dirty) return false;
+
+    uint32_t now = hal_millis();
+    if (now - last_change_ms < NVS_CACHE_IDLE_MS && now - first_dirty_ms < NVS_CACHE_MAX_DELAY_MS) return false;
+
+    return take_dirty(batch);
+}
+
+void nvs_cache_write(const NvsCacheBatch& batch) {
+    for (uint8_t i = 0; i < batch.count; i++) {
+        write_value(batch.writes[i].key, (NvsCacheType)batch.writes[i].type, batch.writes[i].value);
+    }
+}
+
+// committed follows what was written; a put since take() leaves the key dirty
+void nvs_cache_done(const NvsCacheBatch& batch) {
+    for (uint8_t i = 0; i < batch.count; i++) {
+        NvsCacheEntry* entry = find_entry(batch.writes[i].key);
+        entry->committed = batch.writes[i].value;
+        entry->synced = true;
+        entry->dirty = entry->value != entry->committed;
+        if (entry->dirty && !any_dirty) {
+            any_dirty = true;
+            first_dirty_ms = last_change_ms = hal_millis();
+        }
+    }
+    if (batch.count == 0) return;
+
+    stats.writes_committed += batch.count;
+    stats.commits++;
+    Serial.printf("[NVS] Committed %u key(s), %u of %u writes avoided\n",
+        batch.count, stats.writes_requested - stats.writes_committed, stats.writes_requested);
+}
+
+bool nvs_cache_dirty() {
+    return any_dirty;
+}
+
+NvsCacheStats nvs_cache_stats() {
+    return stats;
+}
@@ -0,0 +1,369 @@
+/**
+ * Vaxthus_Master_V3 - Light schedule engine
+ *
+ * See include/schedule.h. Breakpoints are collected as packed sort keys
+ * while parsing, sorted once, then split into one contiguous span per
+ * profile and channel.
+ */
+
+#include "schedule.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#include "mqtt_command.h"
+
+#define SECONDS_PER_DAY 86400
+
+struct Token {
+    const char* p;
+    size_t len;
+};
+
+static const char* const DAY_NAMES[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+// profile << 40 | channel << 32 | minute << 16 | level, STAGED_SOLAR marks
+// points with a solar time (ignored when sorting)
+#define STAGED_SOLAR (1ull << 63)
+#define STAGED_TIME  0x7FFFFFFFFFFF0000ull
+static uint64_t staged[SCHEDULE_MAX_POINTS];
+
+// ============================================================================
+// TOKENS
+// ============================================================================
+static bool next_token(const char*& p, const char* end, Token* t) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p >= end) return false;
+    t->p = p;
+    while (p < end && *p != ' ' && *p != '\t') p++;
+    t->len = p - t->p;
+    return true;
+}
+
+static bool token_is(Token t, const char* word) {
+    size_t n = strlen(word);
+    if (t.len != n) return false;
+    for (size_t i = 0; i < n; i++) {
+        char c = t.p[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != word[i]) return false;
+    }
+    return true;
+}
+
+// Unsigned decimal of 1-max_digits digits
+static bool parse_uint(Token t, size_t max_digits, int* out) {
+    if (t.len == 0 || t.len > max_digits) return false;
+    int v = 0;
+    for (size_t i = 0; i < t.len; i++) {
+        if (t.p[i] < '0' || t.p[i] > '9') return false;
+        v = v * 10 + (t.p[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+// Splits t at the first sep; false when sep is missing
+static bool split(Token t, char sep, Token* left, Token* right) {
+    const char* at = (const char*)memchr(t.p, sep, t.len);
+    if (!at) return false;
+    *left = {t.p, (size_t)(at - t.p)};
+    *right = {at + 1, t.len - (at - t.p) - 1};
+    return true;
+}
+
+// ============================================================================
+// PROFILE SELECTORS
+// ============================================================================
+static bool parse_day(Token t, int* day) {
+    for (int d = 0; d < 7; d++) {
+        if (token_is(t, DAY_NAMES[d])) {
+            *day = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_month(Token t, int* month) {
+    int m;
+    if (!parse_uint(t, 2, &m) || m < 1 || m > 12) return false;
+    *month = m - 1;
+    return true;
+}
+
+// "*", "a", "a-b" (wrapping) and comma lists of those, as a bitmask
+static bool parse_set(Token t, int size, bool (*item)(Token, int*), uint32_t* mask) {
+    if (t.len == 1 && t.p[0] == '*') {
+        *mask = (1u << size) - 1;
+        return true;
+    }
+    *mask = 0;
+    while (t.len > 0) {
+        Token part = t, rest = {t.p + t.len, 0};
+        if (split(t, ',', &part, &rest) && rest.len == 0) return false;
+
+        Token from = part, to = part;
+        split(part, '-', &from, &to);
+        int a, b;
+        if (!item(from, &a) || !item(to, &b)) return false;
+        for (int i = a;; i = (i + 1) % size) {
+            *mask |= 1u << i;
+            if (i == b) break;
+        }
+        t = rest;
+    }
+    return *mask != 0;
+}
+
+// ============================================================================
+// TIMES
+// ============================================================================
+enum TimeResult { TIME_BAD, TIME_OK, TIME_SKIP };
+
+// "HH:MM", or sunrise/sunset/noon with an optional +N/-N minute offset.
+// TIME_SKIP = valid, but the sun event does not happen (or is unknown) today.
+static TimeResult parse_time(Token t, const SolarDay* sun, int* minute, bool* solar) {
+    Token hours, minutes;
+    *solar = false;
+    if (split(t, ':', &hours, &minutes)) {
+        int h, m;
+        if (!parse_uint(hours, 2, &h) || !parse_uint(minutes, 2, &m) || h > 23 || m > 59) return TIME_BAD;
+        *minute = h * 60 + m;
+        return TIME_OK;
+    }
+
+    size_t name_len = 0;
+    while (name_len < t.len && t.p[name_len] != '+' && t.p[name_len] != '-') name_len++;
+    Token name = {t.p, name_len};
+    int offset = 0;
+    if (name_len < t.len) {
+        if (!parse_uint({t.p + name_len + 1, t.len - name_len - 1}, 3, &offset) || offset > 720) return TIME_BAD;
+        if (t.p[name_len] == '-') offset = -offset;
+    }
+
+    int base;
+    *solar = true;
+    if (token_is(name, "noon")) {
+        if (!sun) return TIME_SKIP;
+        base = sun->noon;
+    } else if (token_is(name, "sunrise") || token_is(name, "sunset")) {
+        if (!sun) return TIME_SKIP;
+        base = token_is(name, "sunrise") ? sun->sunrise : sun->sunset;
+        if (base == SOLAR_NONE) return TIME_SKIP;
+    } else {
+        return TIME_BAD;
+    }
+    *minute = ((base + offset) % 1440 + 1440) % 1440;
+    return TIME_OK;
+}
+
+// ============================================================================
+// COMPILE
+// ============================================================================
+static bool fail(ScheduleError* err, uint16_t line, const char* message, Token t = {nullptr, 0}) {
+    err->line = line;
+    if (t.p) {
+        snprintf(err->message, sizeof(err->message), "%s '%.*s'", message, (int)(t.len > 16 ? 16 : t.len), t.p);
+    } else {
+        snprintf(err->message, sizeof(err->message), "%s", message);
+    }
+    // The message ends up inside JSON replies
+    for (char* c = err->message; *c; c++) {
+        if (*c == '"' || *c == '\\' || (uint8_t)*c < 0x20) *c = '?';
+    }
+    return false;
+}
+
+// Adds one point per selected channel. Two fixed times that clash are an
+// error; a solar point gives way to whatever else is at that minute, since
+// whether they clash changes from day to day.
+static bool stage_point(uint32_t channels, uint8_t count, int profile, int minute, uint16_t level, bool solar,
+                        size_t* staged_count, ScheduleError* err, uint16_t line, Token where) {
+    for (uint8_t ch = 0; ch < count; ch++) {
+        if (!(channels & (1u << ch))) continue;
+        uint64_t key = (uint64_t)profile << 40 | (uint64_t)ch << 32 | (uint64_t)minute << 16;
+        size_t i = 0;
+        while (i < *staged_count && (staged[i] & STAGED_TIME) != key) i++;
+        if (i < *staged_count) {
+            if (solar) continue;
+            if (!(staged[i] & STAGED_SOLAR)) return fail(err, line, "duplicate time", where);
+            staged[i] = key | level;  // fixed point replaces the solar one
+            continue;
+        }
+        if (*staged_count >= SCHEDULE_MAX_POINTS) return fail(err, line, "too many points");
+        staged[(*staged_count)++] = key | level | (solar ? STAGED_SOLAR : 0);
+    }
+    return true;
+}
+
+bool schedule_compile(const char* text, size_t length, const char* const* names, uint8_t count,
+                      const SolarDay* sun, Schedule* out, ScheduleError* err) {
+    if (count > SCHEDULE_MAX_CHANNELS) count = SCHEDULE_MAX_CHANNELS;
+
+    memset(out, 0, sizeof(*out));
+    int profile = -1;  // opened implicitly by the first channel line
+    size_t staged_count = 0;
+
+    const char* p = text;
+    const char* end = text + length;
+    for (uint16_t line = 1; p < end; line++) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        const char* hash = (const char*)memchr(p, '#', eol - p);
+        const char* stop = hash ? hash : eol;
+        while (stop > p && (stop[-1] == '\r' || stop[-1] == ' ' || stop[-1] == '\t')) stop--;
+
+        const char* c = p;
+        p = eol + 1;
+        Token word;
+        if (!next_token(c, stop, &word)) continue;
+
+        if (token_is(word, "profile")) {
+            if (out->profile_count >= SCHEDULE_MAX_PROFILES) return fail(err, line, "too many profiles");
+            Token days = {"*", 1}, months = {"*", 1}, extra;
+            next_token(c, stop, &days);
+            next_token(c, stop, &months);
+            if (next_token(c, stop, &extra)) return fail(err, line, "unexpected", extra);
+
+            uint32_t day_mask, month_mask;
+            if (!parse_set(days, 7, parse_day, &day_mask)) return fail(err, line, "bad days", days);
+            if (!parse_set(months, 12, parse_month, &month_mask)) return fail(err, line, "bad months", months);
+            profile = out->profile_count++;
+            out->profiles[profile].days = day_mask;
+            out->profiles[profile].months = month_mask;
+            continue;
+        }
+
+        // Channel line: <name|all> HH:MM=level ...
+        uint32_t channels = 0;
+        if (token_is(word, "all")) {
+            channels = (1u << count) - 1;
+        } else {
+            for (uint8_t ch = 0; ch < count; ch++) {
+                if (token_is(word, names[ch])) channels = 1u << ch;
+            }
+            if (channels == 0) return fail(err, line, "unknown channel", word);
+        }
+        if (profile < 0) {
+            profile = out->profile_count++;
+            out->profiles[profile].days = 0x7F;
+            out->profiles[profile].months = 0xFFF;
+        }
+
+        Token point;
+        bool any = false;
+        while (next_token(c, stop, &point)) {
+            Token time, value;
+            uint8_t level;
+            if (!split(point, '=', &time, &value)) return fail(err, line, "bad point", point);
+            if (!mqtt_parse_level((const uint8_t*)value.p, value.len, &level)) {
+                return fail(err, line, "bad level", value);
+            }
+            any = true;
+
+            // sun=<level>: elevation curve, one point per table step while the sun is up
+            if (token_is(time, "sun")) {
+                out->solar = true;
+                if (!sun) continue;
+                for (int i = 0; i < SOLAR_TABLE_SIZE - 1; i++) {
+                    bool up = sun->intensity[i] > 0 || sun->intensity[i + 1] > 0 ||
+                              (i > 0 && sun->intensity[i - 1] > 0);
+                    if (!up) continue;
+                    uint16_t v = ((uint32_t)sun->intensity[i] * level * 257) / 65535;
+                    if (!stage_point(channels, count, profile, i * SOLAR_STEP_MINUTES, v, true,
+                                     &staged_count, err, line, time)) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+
+            int minute;
+            bool solar;
+            TimeResult r = parse_time(time, sun, &minute, &solar);
+            if (r == TIME_BAD) return fail(err, line, "bad point", point);
+            if (solar) out->solar = true;
+            if (r == TIME_SKIP) continue;
+            if (!stage_point(channels, count, profile, minute, level * 257, solar, &staged_count, err, line, time)) {
+                return false;
+            }
+        }
+        if (!any) return fail(err, line, "no points for", word);
+    }
+
+    // Sorted by profile, channel, minute: every span ends up contiguous
+    std::sort(staged, staged + staged_count,
+              [](uint64_t a, uint64_t b) { return (a & ~STAGED_SOLAR) < (b & ~STAGED_SOLAR); });
+    for (size_t i = 0; i < staged_count; i++) {
+        uint64_t key = staged[i] & ~STAGED_SOLAR;
+        ScheduleProfile& prof = out->profiles[(key >> 40) & 0xFF];
+        uint8_t ch = (key >> 32) & 0xFF;
+        if (prof.count[ch] == 0) prof.first[ch] = i;
+        prof.count[ch]++;
+        out->points[i] = {(uint16_t)(key >> 16), (uint16_t)key};
+    }
+    out->point_count = staged_count;
+
+    if (out->profile_count == 0) return fail(err, 0, "empty schedule");
+    err->line = 0;
+    err->message[0] = '\0';
+    return true;
+}
+
+// ============================================================================
+// EVALUATE
+// ============================================================================
+int schedule_find_profile(const Schedule& schedule, int wday, int month) {
+    for (int i = 0; i < schedule.profile_count; i++) {
+        const ScheduleProfile& p = schedule.profiles[i];
+        if ((p.days & (1u << wday)) && (p.months & (1u << month))) return i;
+    }
+    return -1;
+}
+
+uint16_t schedule_level(const Schedule& schedule, int profile, uint8_t channel, uint32_t second) {
+    if (profile < 0 || profile >= schedule.profile_count || channel >= SCHEDULE_MAX_CHANNELS) return 0;
+    const ScheduleProfile& p = schedule.profiles[profile];
+    uint16_t n = p.count[channel];
+    if (n == 0) return 0;
+    const SchedulePoint* points = &schedule.points[p.first[channel]];
+    if (n == 1) return points[0].level;
+
+    // First breakpoint after `second`
+    uint16_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (points[mid].minute * 60u <= second) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Neighbours, wrapping around midnight
+    int32_t t0, t1;
+    const SchedulePoint* a;
+    const SchedulePoint* b;
+    if (lo == 0) {
+        a = &points[n - 1];
+        b = &points[0];
+        t0 = a->minute * 60 - SECONDS_PER_DAY;
+        t1 = b->minute * 60;
+    } else if (lo == n) {
+        a = &points[n - 1];
+        b = &points[0];
+        t0 = a->minute * 60;
+        t1 = b->minute * 60 + SECONDS_PER_DAY;
+    } else {
+        a = &points[lo - 1];
+        b = &points[lo];
+        t0 = a->minute * 60;
+        t1 = b->minute * 60;
+    }
+
+    int32_t span = t1 - t0;
+    int32_t elapsed = (int32_t)second - t0;
+    return a->level + (int32_t)(((int64_t)(b->level - a->level) * elapsed) / span);
+}
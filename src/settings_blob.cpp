@@ -0,0 +1,63 @@
+/**
+ * Vaxthus_Master_V3 - Packed settings blob
+ *
+ * See include/settings_blob.h.
+ */
+
+#include "settings_blob.h"
+
+#include <string.h>
+
+static_assert(sizeof(SettingsHeader) == 8, "SettingsHeader layout is stored in flash");
+static_assert(sizeof(SettingsHeader) + sizeof(Settings) <= SETTINGS_BLOB_MAX, "Settings outgrew SETTINGS_BLOB_MAX");
+
+// Reflected CRC-32, polynomial 0xEDB88320 (zlib, Ethernet), a nibble at a time
+static const uint32_t CRC_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+uint32_t settings_crc(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+size_t settings_blob_size() {
+    return sizeof(SettingsHeader) + sizeof(Settings);
+}
+
+size_t settings_encode(const Settings& settings, uint8_t* blob, size_t size) {
+    if (size < settings_blob_size()) return 0;
+    SettingsHeader header = {SETTINGS_VERSION, 0, sizeof(Settings), 0};
+    memcpy(blob + sizeof(header), &settings, sizeof(settings));
+    header.crc = settings_crc(blob + sizeof(header), sizeof(settings));
+    memcpy(blob, &header, sizeof(header));
+    return settings_blob_size();
+}
+
+static void terminate(char* s, size_t size) {
+    s[size - 1] = '\0';
+}
+
+bool settings_decode(const uint8_t* blob, size_t length, Settings* settings, uint8_t* version) {
+    SettingsHeader header;
+    if (length < sizeof(header)) return false;
+    memcpy(&header, blob, sizeof(header));
+    if (header.version == 0 || header.length != length - sizeof(header)) return false;
+    if (settings_crc(blob + sizeof(header), header.length) != header.crc) return false;
+
+    // Older blob: its fields over the defaults. Newer: the part this version knows.
+    size_t known = header.length < sizeof(Settings) ? header.length : sizeof(Settings);
+    memcpy(settings, blob + sizeof(header), known);
+    terminate(settings->wifi_ssid, sizeof(settings->wifi_ssid));
+    terminate(settings->wifi_password, sizeof(settings->wifi_password));
+    terminate(settings->mqtt_server, sizeof(settings->mqtt_server));
+    terminate(settings->mqtt_user, sizeof(settings->mqtt_user));
+    terminate(settings->mqtt_password, sizeof(settings->mqtt_password));
+    if (version) *version = header.version;
+    return true;
+}
@@ -0,0 +1,70 @@
+/**
+ * Vaxthus_Master_V3 - Sun position
+ *
+ * See include/solar.h. Equations from the NOAA "General Solar Position
+ * Calculations" note; declination and equation of time are taken once for
+ * the day at local noon.
+ */
+
+#include "solar.h"
+
+#include <math.h>
+
+#define DEG (M_PI / 180.0)
+
+static int16_t wrap_minute(double minute) {
+    int m = (int)lround(minute) % 1440;
+    return m < 0 ? m + 1440 : m;
+}
+
+void solar_compute_day(int year, int yday, float latitude, float longitude, int utc_offset_minutes,
+                       SolarDay* out) {
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    double gamma = 2.0 * M_PI / (leap ? 366 : 365) * yday;
+
+    // Minutes, radians
+    double eqtime = 229.18 * (0.000075 + 0.001868 * cos(gamma) - 0.032077 * sin(gamma)
+                              - 0.014615 * cos(2 * gamma) - 0.040849 * sin(2 * gamma));
+    double decl = 0.006918 - 0.399912 * cos(gamma) + 0.070257 * sin(gamma) - 0.006758 * cos(2 * gamma)
+                  + 0.000907 * sin(2 * gamma) - 0.002697 * cos(3 * gamma) + 0.00148 * sin(3 * gamma);
+    double lat = latitude * DEG;
+
+    out->noon = wrap_minute(720 - 4 * longitude - eqtime + utc_offset_minutes);
+
+    // 90.833°: refraction and the sun's radius, so "sunrise" is the upper limb
+    double cos_ha = cos(90.833 * DEG) / (cos(lat) * cos(decl)) - tan(lat) * tan(decl);
+    if (cos_ha >= 1.0 || cos_ha <= -1.0) {
+        out->sunrise = SOLAR_NONE;
+        out->sunset = SOLAR_NONE;
+    } else {
+        double ha = acos(cos_ha) / DEG;
+        out->sunrise = wrap_minute(720 - 4 * (longitude + ha) - eqtime + utc_offset_minutes);
+        out->sunset = wrap_minute(720 - 4 * (longitude - ha) - eqtime + utc_offset_minutes);
+    }
+
+    double max_elevation = 90.0 - fabs(latitude - decl / DEG);
+    out->max_elevation = (int16_t)lround(max_elevation * 100);
+    double max_sin = sin(max_elevation * DEG);
+
+    for (int i = 0; i < SOLAR_TABLE_SIZE; i++) {
+        double utc = i * SOLAR_STEP_MINUTES - utc_offset_minutes;
+        double hour_angle = ((utc + eqtime + 4 * longitude) / 4.0 - 180.0) * DEG;
+        double cos_zenith = sin(lat) * sin(decl) + cos(lat) * cos(decl) * cos(hour_angle);
+        if (cos_zenith > 1.0) cos_zenith = 1.0;
+        if (cos_zenith < -1.0) cos_zenith = -1.0;
+        double elevation = 90.0 - acos(cos_zenith) / DEG;
+
+        out->elevation[i] = (int16_t)lround(elevation * 100);
+        double relative = (elevation > 0 && max_sin > 0) ? sin(elevation * DEG) / max_sin : 0.0;
+        out->intensity[i] = relative >= 1.0 ? 65535 : (uint16_t)lround(relative * 65535);
+    }
+}
+
+int16_t solar_elevation(const SolarDay& day, uint32_t second) {
+    uint32_t step = SOLAR_STEP_MINUTES * 60;
+    uint32_t i = (second / step) % (SOLAR_TABLE_SIZE - 1);
+    int32_t frac = second % step;
+    int32_t a = day.elevation[i];
+    int32_t b = day.elevation[i + 1];
+    return (int16_t)(a + (b - a) * frac / (int32_t)step);
+}
@@ -0,0 +1,183 @@
+/**
+ * Vaxthus_Master_V3 - Flash ring-buffer telemetry log
+ *
+ * See include/telemetry_log.h.
+ */
+
+#include "telemetry_log.h"
+
+#include <string.h>
+
+#include "hal.h"
+
+#define RECORDS_PER_PAGE    (TELEMETRY_PAGE_SIZE / TELEMETRY_RECORD_SIZE)
+#define RECORDS_PER_SECTOR  (TELEMETRY_SECTOR_SIZE / TELEMETRY_RECORD_SIZE)
+#define SEQ_ERASED          0xFFFFFFFFu
+
+static uint32_t capacity = 0;     // records in the ring, whole sectors
+static uint32_t head = 0;         // slot the next flushed record goes to
+static TelemetryRecord page[RECORDS_PER_PAGE];
+static uint8_t pending = 0;       // records in page[] not in flash yet, slots head.. onwards
+static uint32_t first_pending_ms = 0;
+static TelemetryStats stats = {0, 0, 0, 0, 0};
+
+static const char* const EVENT_NAMES[TELEMETRY_EVENT_COUNT] = {
+    "unknown", "boot", "levels", "mode", "heartbeat", "wifi_up", "wifi_down", "mqtt_up", "mqtt_down", "time_sync"};
+
+// ============================================================================
+// RECORDS
+// ============================================================================
+// CRC-16/CCITT-FALSE
+uint16_t telemetry_crc(const TelemetryRecord& record) {
+    const uint8_t* data = (const uint8_t*)&record;
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < offsetof(TelemetryRecord, crc); i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static bool record_valid(const TelemetryRecord& record) {
+    return record.seq != SEQ_ERASED && record.crc == telemetry_crc(record);
+}
+
+static bool record_erased(const TelemetryRecord& record) {
+    const uint8_t* data = (const uint8_t*)&record;
+    for (size_t i = 0; i < sizeof(record); i++) {
+        if (data[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+static bool read_record(uint32_t slot, TelemetryRecord& record) {
+    return hal_log_read(slot * TELEMETRY_RECORD_SIZE, &record, sizeof(record));
+}
+
+const char* telemetry_event_name(uint8_t event) {
+    return event < TELEMETRY_EVENT_COUNT ? EVENT_NAMES[event] : EVENT_NAMES[0];
+}
+
+// ============================================================================
+// RING
+// ============================================================================
+bool telemetry_begin() {
+    capacity = hal_log_size() / TELEMETRY_SECTOR_SIZE * RECORDS_PER_SECTOR;
+    pending = 0;
+    if (capacity < 2 * RECORDS_PER_SECTOR) {
+        capacity = 0;  // one sector could not rotate without losing everything
+        stats.capacity = 0;
+        Serial.println("[Telemetry] No telemetry partition, log disabled");
+        return false;
+    }
+    stats.capacity = capacity;
+
+    // Newest sector = highest sequence number in its first slot
+    uint32_t sectors = capacity / RECORDS_PER_SECTOR;
+    int32_t newest = -1;
+    uint32_t newest_seq = 0;
+    TelemetryRecord record;
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (!read_record(s * RECORDS_PER_SECTOR, record) || !record_valid(record)) continue;
+        if (newest < 0 || record.seq > newest_seq) {
+            newest = (int32_t)s;
+            newest_seq = record.seq;
+        }
+    }
+
+    if (newest < 0) {
+        head = 0;
+        stats.next_seq = 0;
+    } else {
+        // Head = first never-written slot; a full sector hands over to the next
+        uint32_t slot = (uint32_t)newest * RECORDS_PER_SECTOR;
+        uint32_t end = slot + RECORDS_PER_SECTOR;
+        for (; slot < end; slot++) {
+            if (!read_record(slot, record) || record_erased(record)) break;
+            if (record_valid(record) && record.seq > newest_seq) newest_seq = record.seq;
+        }
+        head = slot % capacity;
+        stats.next_seq = newest_seq + 1;
+    }
+
+    Serial.printf("[Telemetry] %u records capacity, head %u, next seq %u\n", capacity, head, stats.next_seq);
+    return true;
+}
+
+void telemetry_append(TelemetryRecord& record) {
+    record.seq = stats.next_seq++;
+    record.reserved = 0xFFFF;
+    record.crc = telemetry_crc(record);
+    stats.records++;
+    if (capacity == 0) return;
+
+    if (pending == 0) first_pending_ms = hal_millis();
+    page[pending++] = record;
+    if ((head + pending) % RECORDS_PER_PAGE == 0) telemetry_flush();
+}
+
+void telemetry_loop(uint32_t now_ms) {
+    if (pending > 0 && now_ms - first_pending_ms >= TELEMETRY_FLUSH_MS) telemetry_flush();
+}
+
+bool telemetry_flush_due(uint32_t* due_ms) {
+    if (pending == 0) return false;
+    *due_ms = first_pending_ms + TELEMETRY_FLUSH_MS;
+    return true;
+}
+
+// Writes never cross a page, so at most the sector being entered needs erasing
+void telemetry_flush() {
+    if (pending == 0) return;
+    if (head % RECORDS_PER_SECTOR == 0) {
+        hal_log_erase(head * TELEMETRY_RECORD_SIZE, TELEMETRY_SECTOR_SIZE);
+        stats.sector_erases++;
+    }
+    if (!hal_log_write(head * TELEMETRY_RECORD_SIZE, page, pending * TELEMETRY_RECORD_SIZE)) {
+        Serial.printf("[Telemetry] Flash write failed at slot %u\n", head);
+    }
+    stats.page_writes++;
+    head = (head + pending) % capacity;
+    pending = 0;
+}
+
+void telemetry_read(uint32_t from_seq, TelemetryVisitor visit, void* ctx) {
+    if (capacity > 0) {
+        // Oldest data: the head's own sector if it has not been erased for
+        // this lap yet (head on a sector boundary), else the sector after it
+        uint32_t start = head % RECORDS_PER_SECTOR == 0
+                             ? head
+                             : (head / RECORDS_PER_SECTOR + 1) * RECORDS_PER_SECTOR % capacity;
+        uint32_t remaining = (head + capacity - start) % capacity;
+        if (remaining == 0) remaining = capacity;
+
+        uint32_t slot = start;
+        TelemetryRecord chunk[RECORDS_PER_PAGE];
+        while (remaining > 0) {
+            // A whole sector older than from_seq is skipped on its last record
+            if (slot % RECORDS_PER_SECTOR == 0 && remaining >= RECORDS_PER_SECTOR) {
+                TelemetryRecord last;
+                if (read_record(slot + RECORDS_PER_SECTOR - 1, last) && record_valid(last) && last.seq < from_seq) {
+                    slot = (slot + RECORDS_PER_SECTOR) % capacity;
+                    remaining -= RECORDS_PER_SECTOR;
+                    continue;
+                }
+            }
+            uint32_t n = RECORDS_PER_PAGE - slot % RECORDS_PER_PAGE;
+            if (n > remaining) n = remaining;
+            if (!hal_log_read(slot * TELEMETRY_RECORD_SIZE, chunk, n * TELEMETRY_RECORD_SIZE)) return;
+            for (uint32_t i = 0; i < n; i++) {
+                if (record_valid(chunk[i]) && chunk[i].seq >= from_seq && !visit(chunk[i], ctx)) return;
+            }
+            slot = (slot + n) % capacity;
+            remaining -= n;
+        }
+    }
+    for (uint8_t i = 0; i < pending; i++) {
+        if (page[i].seq >= from_seq && !visit(page[i], ctx)) return;
+    }
+}
+
+TelemetryStats telemetry_stats() {
+    return stats;
+}
@@ -0,0 +1,143 @@
+/**
+ * Vaxthus_Master_V3 - Timer queue
+ *
+ * See include/timer_queue.h.
+ */
+
+#include "timer_queue.h"
+
+#include "hal.h"
+
+static Timer* heap[TIMERS_MAX];  // heap[0] is due first
+static uint8_t count = 0;
+static TimerStats stats = {0, 0};
+
+// ============================================================================
+// HEAP
+// ============================================================================
+static bool due_before(const Timer* a, const Timer* b) {
+    return (int32_t)(a->due - b->due) < 0;
+}
+
+static void place(uint8_t i, Timer* timer) {
+    heap[i] = timer;
+    timer->slot = (int8_t)i;
+}
+
+static void sift_up(uint8_t i) {
+    Timer* timer = heap[i];
+    while (i > 0) {
+        uint8_t parent = (i - 1) / 2;
+        if (!due_before(timer, heap[parent])) break;
+        place(i, heap[parent]);
+        i = parent;
+    }
+    place(i, timer);
+}
+
+static void sift_down(uint8_t i) {
+    Timer* timer = heap[i];
+    for (;;) {
+        uint8_t child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && due_before(heap[child + 1], heap[child])) child++;
+        if (!due_before(heap[child], timer)) break;
+        place(i, heap[child]);
+        i = child;
+    }
+    place(i, timer);
+}
+
+static void remove_at(uint8_t i) {
+    heap[i]->slot = -1;
+    Timer* last = heap[--count];
+    if (i == count) return;
+    place(i, last);
+    sift_down(i);
+    sift_up((uint8_t)last->slot);
+}
+
+// ============================================================================
+// TIMERS
+// ============================================================================
+bool timer_start(Timer& timer, uint32_t delay_ms) {
+    return timer_start_at(timer, hal_millis() + delay_ms);
+}
+
+bool timer_start_at(Timer& timer, uint32_t due) {
+    if (timer.slot >= 0) {
+        if (timer.due == due) return true;
+        timer.due = due;
+        sift_down((uint8_t)timer.slot);
+        sift_up((uint8_t)timer.slot);
+        return true;
+    }
+    if (count == TIMERS_MAX) {
+        Serial.printf("[Timer] Queue full, %s not started\n", timer.name);
+        return false;
+    }
+    timer.due = due;
+    place(count, &timer);
+    sift_up(count++);
+    return true;
+}
+
+void timer_stop(Timer& timer) {
+    if (timer.slot >= 0) remove_at((uint8_t)timer.slot);
+}
+
+bool timer_pending(const Timer& timer) {
+    return timer.slot >= 0;
+}
+
+void timers_run() {
+    uint32_t now = hal_millis();
+    // At most one firing per pending timer per call, so a callback that
+    // re-arms itself with delay 0 cannot keep loop() here
+    for (uint8_t budget = count; budget > 0 && count > 0; budget--) {
+        Timer& timer = *heap[0];
+        if ((int32_t)(now - timer.due) < 0) break;
+
+        uint32_t late = now - timer.due;
+        if (late > stats.late_max_ms) stats.late_max_ms = late;
+        if (timer.period_ms > 0) {
+            timer.due += timer.period_ms;
+            if ((int32_t)(now - timer.due) >= 0) timer.due = now + timer.period_ms;
+            sift_down(0);
+        } else {
+            remove_at(0);
+        }
+        stats.fired++;
+        if (timer.callback) timer.callback();
+    }
+}
+
+uint32_t timers_next() {
+    if (count == 0) return TIMER_NONE;
+    int32_t left = (int32_t)(heap[0]->due - hal_millis());
+    return left > 0 ? (uint32_t)left : 0;
+}
+
+uint8_t timers_pending() {
+    return count;
+}
+
+TimerStats timers_stats() {
+    return stats;
+}
+
+// ============================================================================
+// BACKOFF
+// ============================================================================
+uint32_t backoff_next(Backoff& backoff) {
+    uint32_t step = backoff.min_ms;
+    for (uint8_t i = 0; i < backoff.attempts && step < backoff.max_ms; i++) step *= 2;
+    if (step > backoff.max_ms) step = backoff.max_ms;
+    if (backoff.attempts < UINT8_MAX) backoff.attempts++;
+    uint32_t half = step / 2;
+    return step - half + (half > 0 ? hal_random() % (half + 1) : 0);
+}
+
+void backoff_reset(Backoff& backoff) {
+    backoff.attempts = 0;
+}
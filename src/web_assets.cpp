@@ -0,0 +1,289 @@
+// Generated by scripts/embed_web.py from web/ - do not edit by hand.
+
+#include "web_assets.h"
+
+// index.html: 5046 bytes, 1830 gzipped
+static const uint8_t web_index_html[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x58, 0xef, 0x6e, 0xdb, 0x36,
+    0x10, 0xff, 0xde, 0xa7, 0xb8, 0x66, 0x68, 0x25, 0x61, 0xb1, 0x6c, 0x27, 0xcd, 0x90, 0x39, 0x96,
+    0x8b, 0x36, 0xcd, 0xb0, 0x0d, 0xcd, 0xd2, 0xcd, 0xd9, 0x86, 0xa1, 0x28, 0x02, 0x5a, 0xa2, 0x2d,
+    0x36, 0x14, 0xa5, 0x91, 0x54, 0x1c, 0xaf, 0xcb, 0xc7, 0x7d, 0xdb, 0x3b, 0xec, 0x15, 0xf7, 0x08,
+    0x3b, 0x92, 0xb2, 0x25, 0xcb, 0x72, 0x5b, 0x60, 0x06, 0x8a, 0x48, 0x22, 0x79, 0x7f, 0x7e, 0x77,
+    0xf7, 0xbb, 0x63, 0xc7, 0x8f, 0x5f, 0x5d, 0x9d, 0x5f, 0xff, 0xf6, 0xe6, 0x02, 0x52, 0x9d, 0xf1,
+    0xc9, 0xa3, 0xf1, 0xfa, 0x0f, 0x25, 0xc9, 0xe4, 0x11, 0xe0, 0x6f, 0x9c, 0x51, 0x4d, 0x40, 0x90,
+    0x8c, 0x46, 0xde, 0x1d, 0xa3, 0xcb, 0x22, 0x97, 0xda, 0x83, 0x38, 0x17, 0x9a, 0x0a, 0x1d, 0x79,
+    0x4b, 0x96, 0xe8, 0x34, 0x4a, 0xe8, 0x1d, 0x8b, 0x69, 0xcf, 0xbe, 0x1c, 0x02, 0x13, 0x4c, 0x33,
+    0xc2, 0x7b, 0x2a, 0x26, 0x9c, 0x46, 0x43, 0xaf, 0x12, 0xa4, 0x99, 0xe6, 0x74, 0xf2, 0x0b, 0xb9,
+    0xd7, 0x69, 0xa9, 0xe0, 0x92, 0x28, 0x4d, 0x25, 0xfc, 0x72, 0x3c, 0xee, 0xbb, 0x05, 0xb7, 0x49,
+    0xe9, 0xd5, 0xfa, 0xd9, 0xfc, 0x66, 0x79, 0xb2, 0x82, 0x0f, 0x30, 0x47, 0x75, 0xbd, 0x39, 0xc9,
+    0x18, 0x5f, 0x8d, 0xe0, 0x85, 0x44, 0xe1, 0x67, 0x90, 0x11, 0xb9, 0x60, 0x62, 0x04, 0x47, 0x83,
+    0xe2, 0xfe, 0x0c, 0x66, 0x24, 0xbe, 0x5d, 0xc8, 0xbc, 0x14, 0xc9, 0x08, 0xbe, 0x18, 0x92, 0x21,
+    0x39, 0xa2, 0x67, 0x68, 0x25, 0xcf, 0x25, 0xbe, 0x53, 0x8a, 0x2f, 0x0f, 0x1b, 0xa1, 0xe9, 0x10,
+    0x45, 0xae, 0xd7, 0x9e, 0xd1, 0x38, 0x26, 0xc7, 0xcd, 0xe5, 0x30, 0x26, 0x32, 0xc1, 0x1d, 0xdb,
+    0x22, 0xbf, 0x3a, 0x1a, 0x1e, 0xa3, 0x94, 0x82, 0x24, 0x09, 0x13, 0x8b, 0x8d, 0xda, 0x5c, 0x26,
+    0x54, 0xf6, 0x24, 0x49, 0x58, 0xa9, 0x46, 0x30, 0xb4, 0x1f, 0xd7, 0x96, 0x99, 0x37, 0x18, 0x6c,
+    0x89, 0x56, 0x9c, 0x99, 0xfd, 0x06, 0x3e, 0xc2, 0x04, 0xfa, 0xff, 0xa1, 0xde, 0x7d, 0xb2, 0x6f,
+    0x37, 0x27, 0x33, 0xca, 0x71, 0x67, 0xc2, 0x54, 0xc1, 0x09, 0x22, 0x30, 0xe7, 0x14, 0xd5, 0xbc,
+    0x2f, 0x95, 0x66, 0xf3, 0x55, 0xaf, 0x8a, 0xc5, 0x08, 0x54, 0x41, 0x30, 0x08, 0x33, 0xaa, 0x97,
+    0x94, 0x8a, 0xb5, 0x19, 0xbd, 0x59, 0xae, 0x75, 0x9e, 0x8d, 0xe0, 0xc4, 0x98, 0x56, 0x0b, 0x67,
+    0xa2, 0x28, 0xf5, 0x5b, 0xbd, 0x2a, 0x68, 0x24, 0x89, 0x58, 0xd0, 0x77, 0xa8, 0xc0, 0xc6, 0xcf,
+    0xd8, 0x3d, 0x78, 0x72, 0x06, 0x29, 0x65, 0x8b, 0x14, 0xa5, 0x1e, 0xb5, 0x0e, 0x86, 0x4a, 0x13,
+    0x8d, 0x01, 0xac, 0xa2, 0xa2, 0xd8, 0x1f, 0x74, 0x04, 0x83, 0xf0, 0x6b, 0x9a, 0xd5, 0x80, 0x9f,
+    0x9e, 0x9e, 0x36, 0x8f, 0x90, 0x0e, 0xbc, 0x35, 0xbd, 0xd7, 0xbd, 0x84, 0xc6, 0xb9, 0x24, 0x9a,
+    0xe5, 0xe8, 0xbf, 0xc8, 0xc5, 0x56, 0x94, 0xc2, 0x99, 0x16, 0xf0, 0x61, 0xf3, 0x6a, 0xb3, 0xa1,
+    0x19, 0x91, 0xf9, 0xfc, 0xab, 0xd9, 0xf1, 0x49, 0xad, 0x73, 0x3e, 0x9f, 0xaf, 0xe3, 0x51, 0x09,
+    0xdb, 0x3a, 0xbb, 0x09, 0xdc, 0xf0, 0x08, 0x71, 0x3e, 0x7a, 0xd6, 0x11, 0x3d, 0xeb, 0x68, 0x5c,
+    0x4a, 0x65, 0xe4, 0x15, 0x39, 0x43, 0x58, 0xe5, 0xb6, 0x90, 0x86, 0xc7, 0xc3, 0x67, 0x5d, 0xa1,
+    0xde, 0x84, 0x88, 0x09, 0x8e, 0xf1, 0xed, 0xcd, 0x78, 0x1e, 0xdf, 0xd6, 0x32, 0xb6, 0xbd, 0x1b,
+    0xa5, 0xf9, 0x9d, 0x4d, 0x81, 0x96, 0x5f, 0xa7, 0xa7, 0x27, 0x27, 0x4d, 0x24, 0xbe, 0x20, 0xa5,
+    0xce, 0x5f, 0x1a, 0x34, 0x6a, 0xf9, 0x4d, 0xb4, 0xc6, 0xfd, 0xaa, 0x6a, 0xc6, 0x7d, 0x57, 0xb7,
+    0x63, 0x53, 0x36, 0x55, 0x41, 0xa5, 0xc3, 0xae, 0x92, 0xc3, 0xaf, 0x6e, 0xb9, 0x80, 0x98, 0x13,
+    0xa5, 0x22, 0xcf, 0x45, 0xd5, 0x9b, 0xfc, 0xca, 0xbe, 0x61, 0x23, 0xac, 0xc3, 0x82, 0x08, 0x60,
+    0x89, 0x29, 0xf0, 0x39, 0xf3, 0x26, 0xbd, 0x1e, 0x2a, 0xc1, 0x4f, 0x13, 0xf0, 0xeb, 0x25, 0xc5,
+    0x16, 0x82, 0xf0, 0xc6, 0x62, 0x00, 0x7f, 0xc2, 0xe5, 0x8f, 0xd7, 0xd7, 0xcd, 0xf3, 0xd9, 0xef,
+    0x5a, 0x37, 0xb6, 0x8c, 0xfb, 0xc5, 0xe4, 0x91, 0x53, 0x9d, 0xb0, 0xbb, 0xb5, 0x72, 0x53, 0x71,
+    0x5e, 0x5d, 0xf5, 0xe3, 0xf4, 0x68, 0xf2, 0xda, 0x64, 0x1f, 0x9c, 0x23, 0xe0, 0x32, 0xe7, 0x68,
+    0xf0, 0x51, 0x75, 0xcc, 0xae, 0x3f, 0xee, 0xf5, 0xe0, 0x4a, 0x50, 0x70, 0x05, 0x02, 0x05, 0xfe,
+    0xc3, 0x0a, 0x90, 0x2b, 0x84, 0x1d, 0xfa, 0x71, 0x4a, 0x84, 0xa0, 0x5c, 0x41, 0xaf, 0xd7, 0x10,
+    0x69, 0xb4, 0x59, 0xa3, 0xed, 0x11, 0x74, 0x74, 0xdc, 0xc7, 0x4f, 0x4d, 0xa1, 0xb3, 0x12, 0x0b,
+    0xc5, 0x19, 0x5d, 0x01, 0xee, 0xad, 0xed, 0x9b, 0x99, 0xe7, 0x5c, 0xc4, 0x9c, 0xc5, 0xb7, 0x91,
+    0x47, 0xef, 0x99, 0xbe, 0x24, 0xa2, 0x24, 0xdc, 0x0f, 0xbc, 0xc9, 0xbf, 0xff, 0xfc, 0xfd, 0x17,
+    0xfc, 0x44, 0x75, 0x29, 0x05, 0xe8, 0x1c, 0x5e, 0xe0, 0x51, 0xb8, 0xcc, 0x13, 0x3a, 0xee, 0x3b,
+    0x81, 0x15, 0xd0, 0x0d, 0x6d, 0xe3, 0x62, 0x32, 0x26, 0x90, 0x4a, 0x3a, 0x8f, 0xbc, 0xbe, 0xa2,
+    0x5a, 0x63, 0x5e, 0xa2, 0x41, 0xd3, 0xea, 0x69, 0xdc, 0x27, 0x4d, 0x98, 0x54, 0x2c, 0x59, 0xa1,
+    0x6b, 0x4f, 0x38, 0xd5, 0xb0, 0x71, 0x31, 0x82, 0xb7, 0xef, 0xce, 0x6a, 0x1f, 0xe6, 0xa5, 0x88,
+    0x4d, 0x35, 0xc1, 0xac, 0x64, 0x3c, 0x99, 0x3a, 0x57, 0x7d, 0xce, 0x94, 0x0e, 0x5a, 0xa5, 0x84,
+    0xa4, 0xa1, 0x34, 0xd4, 0x3c, 0x14, 0x41, 0x92, 0xc7, 0x65, 0x86, 0x28, 0x86, 0x0b, 0xaa, 0x2f,
+    0x38, 0x35, 0x8f, 0x2f, 0x57, 0xdf, 0x25, 0xfe, 0x06, 0xb1, 0x60, 0xbb, 0x16, 0x8c, 0xd4, 0x70,
+    0x9e, 0xcb, 0x0b, 0x12, 0xa7, 0x7e, 0x0c, 0xd1, 0xa4, 0xa5, 0xa1, 0xd6, 0x62, 0xa0, 0x6f, 0xc8,
+    0x8f, 0x25, 0x25, 0x9a, 0x56, 0x2a, 0x7c, 0x0f, 0x57, 0xdb, 0xa2, 0xcd, 0x0f, 0x3f, 0x87, 0x16,
+    0xfd, 0x1f, 0xb0, 0xf5, 0xe0, 0x71, 0xaf, 0x4d, 0x9d, 0x5e, 0xf7, 0x19, 0x86, 0xc0, 0xc8, 0x6f,
+    0xaf, 0x2f, 0x5f, 0xe3, 0x99, 0x83, 0x66, 0x8e, 0x35, 0xc9, 0x14, 0xa3, 0x5f, 0x65, 0xa3, 0xfb,
+    0xb3, 0xc9, 0xd6, 0x03, 0xf8, 0x12, 0xe2, 0xd0, 0x74, 0x3b, 0x7c, 0x38, 0xb8, 0xb9, 0xdb, 0x4a,
+    0x6f, 0x17, 0x43, 0xdc, 0xb2, 0xa3, 0xd8, 0xfc, 0x0e, 0xc6, 0x96, 0x52, 0xc1, 0x52, 0xaa, 0x67,
+    0x39, 0xd5, 0x83, 0x8c, 0x89, 0xc8, 0x1b, 0xe0, 0x5f, 0x72, 0xbf, 0x16, 0x8e, 0x8f, 0x46, 0xb6,
+    0x07, 0x28, 0xbc, 0xa4, 0x76, 0x75, 0x57, 0xb3, 0x37, 0x39, 0xe8, 0x76, 0xef, 0xf7, 0x92, 0xca,
+    0xd5, 0x94, 0x72, 0x1a, 0xeb, 0x5c, 0x62, 0x6c, 0xd0, 0x2e, 0x2f, 0x70, 0x4e, 0x5f, 0x23, 0xa3,
+    0xa2, 0xd3, 0x71, 0x68, 0x5d, 0x3c, 0xdb, 0x13, 0x8c, 0xaa, 0x64, 0xa2, 0x2e, 0x69, 0xd6, 0x81,
+    0xae, 0x60, 0xb8, 0x43, 0xa1, 0xa5, 0x99, 0x90, 0xc4, 0x31, 0x06, 0xee, 0xdc, 0xd0, 0xae, 0x55,
+    0x67, 0x09, 0x78, 0xef, 0x19, 0xac, 0x9a, 0xd4, 0x60, 0x81, 0x5b, 0xfd, 0xc0, 0x64, 0x09, 0x26,
+    0xbc, 0xad, 0x6d, 0xdf, 0x79, 0x7b, 0xb8, 0xde, 0x68, 0xe1, 0x08, 0x3a, 0xcd, 0x76, 0x01, 0x0f,
+    0x49, 0x51, 0x50, 0x91, 0x9c, 0xa7, 0x98, 0xda, 0x3e, 0x5a, 0xdf, 0xda, 0xfb, 0xd0, 0x7a, 0x6f,
+    0xd4, 0x88, 0x4d, 0xd5, 0x8c, 0x14, 0x2e, 0x4d, 0x9d, 0xde, 0xa0, 0xc9, 0xca, 0xbb, 0x05, 0x54,
+    0x5b, 0xe9, 0xc4, 0x1c, 0xba, 0x70, 0xb5, 0xcb, 0x68, 0x5f, 0xd1, 0x54, 0xa7, 0x30, 0x94, 0x9e,
+    0x4d, 0xa2, 0xed, 0x10, 0x59, 0x51, 0xad, 0xce, 0x42, 0x35, 0x96, 0x91, 0xa5, 0x03, 0xab, 0xf7,
+    0xb9, 0x67, 0xf2, 0xa1, 0x96, 0x12, 0x99, 0xf7, 0x36, 0x44, 0x5d, 0x86, 0x37, 0xc9, 0xa9, 0x65,
+    0xec, 0x5a, 0x47, 0xbd, 0xc5, 0x0b, 0x76, 0xe0, 0x0e, 0x75, 0x4a, 0x85, 0x2f, 0x0d, 0x50, 0x32,
+    0x7c, 0xaf, 0x72, 0xe1, 0x07, 0xfb, 0x36, 0x25, 0xdd, 0x45, 0x6f, 0x3b, 0x3e, 0xa7, 0x12, 0x6b,
+    0xdb, 0xd1, 0x22, 0x4d, 0x0c, 0x31, 0x1a, 0x4e, 0xcd, 0xb0, 0xd7, 0xc7, 0xa0, 0x4a, 0xc4, 0x97,
+    0x65, 0x25, 0xb7, 0x9d, 0x1f, 0x32, 0x24, 0xcb, 0xae, 0xa4, 0xb3, 0x53, 0xca, 0x1c, 0xfc, 0xc7,
+    0xf4, 0x0e, 0x61, 0x55, 0x01, 0x94, 0x45, 0x82, 0xc4, 0x31, 0xb5, 0x8d, 0xca, 0xef, 0x38, 0xf0,
+    0xd0, 0x0d, 0x4d, 0xbf, 0x0f, 0xaf, 0xb1, 0xf3, 0xc1, 0xad, 0xc8, 0x97, 0xa8, 0x18, 0x8f, 0x63,
+    0xe7, 0xec, 0x3b, 0xa1, 0x48, 0xea, 0x7c, 0x85, 0xc1, 0x16, 0x89, 0x02, 0xf4, 0x09, 0xe6, 0x8c,
+    0x72, 0xfb, 0x48, 0x1c, 0xc9, 0x2e, 0x68, 0xf2, 0xa8, 0x55, 0x3f, 0xe6, 0x3c, 0xc6, 0xf0, 0xc3,
+    0x43, 0x17, 0xef, 0x4a, 0x94, 0x44, 0xa5, 0x9f, 0xb4, 0xa1, 0xbf, 0x9a, 0xbd, 0xc7, 0x1a, 0x0b,
+    0x91, 0x88, 0xb0, 0x67, 0xfa, 0x56, 0xc6, 0x21, 0x24, 0x2d, 0x1f, 0xf6, 0x32, 0xb0, 0xed, 0xc1,
+    0xdb, 0x29, 0x64, 0x45, 0x84, 0x66, 0xe1, 0x06, 0xed, 0x12, 0x28, 0x1c, 0x51, 0x7e, 0xde, 0xfc,
+    0xcc, 0x0a, 0x18, 0x81, 0xf7, 0x8a, 0xa9, 0xcd, 0x7a, 0x8b, 0x31, 0x11, 0x97, 0xa9, 0xed, 0xe0,
+    0xe8, 0x59, 0x46, 0x15, 0x4e, 0x7f, 0x3a, 0xdd, 0xc2, 0x05, 0x51, 0xaa, 0x66, 0x3d, 0x4e, 0xc9,
+    0x1d, 0xee, 0x60, 0xda, 0x04, 0xb2, 0x8f, 0x37, 0x02, 0xc9, 0x62, 0xf5, 0x79, 0xb6, 0x57, 0x43,
+    0xc2, 0x67, 0x58, 0xff, 0xf4, 0x29, 0x58, 0x4f, 0x6f, 0x24, 0xa2, 0xe4, 0x99, 0x56, 0xee, 0xb0,
+    0x7e, 0xbe, 0x4b, 0x2d, 0xf5, 0x71, 0xb3, 0xd7, 0xd4, 0x07, 0x24, 0x2f, 0x33, 0xf0, 0x4d, 0x91,
+    0x34, 0x16, 0x9d, 0xee, 0x1b, 0x1c, 0x0f, 0x0c, 0x63, 0x99, 0x6d, 0x4f, 0x02, 0xcf, 0xa0, 0xd2,
+    0xeb, 0x79, 0x9f, 0x09, 0xbd, 0x1d, 0x5f, 0xba, 0x8c, 0x37, 0x0b, 0x5b, 0xd0, 0x7b, 0xe7, 0x1b,
+    0x9c, 0x3b, 0x80, 0x6f, 0x23, 0xff, 0x2a, 0x17, 0x9e, 0x86, 0x15, 0x11, 0xb7, 0x38, 0x1d, 0x57,
+    0x9c, 0x6c, 0x12, 0xb0, 0x54, 0xf8, 0xc0, 0x14, 0x24, 0x92, 0x2c, 0x70, 0xb2, 0x5c, 0x74, 0x52,
+    0xda, 0xa7, 0xda, 0xae, 0xad, 0x1a, 0x5c, 0x44, 0x08, 0x93, 0x20, 0xc0, 0xa4, 0x34, 0x55, 0xf8,
+    0xe9, 0x86, 0xb0, 0x8f, 0xcb, 0x3a, 0x4a, 0xcd, 0x68, 0xd8, 0xec, 0x27, 0x98, 0xfb, 0x77, 0xeb,
+    0x86, 0x0e, 0x8f, 0xa3, 0xa8, 0x92, 0x19, 0x6c, 0x51, 0xbb, 0xd1, 0xf0, 0x36, 0x7e, 0xd7, 0xd1,
+    0xd6, 0xf6, 0xe9, 0xdd, 0xc3, 0x9e, 0xbb, 0x52, 0x4c, 0xe1, 0xef, 0xa4, 0x76, 0x9a, 0x2f, 0xfb,
+    0x29, 0xaa, 0xaf, 0xdc, 0x5f, 0x53, 0x10, 0xb8, 0xa9, 0xec, 0xf3, 0xa2, 0xbf, 0x9e, 0x03, 0x83,
+    0xaa, 0xf5, 0x55, 0xe3, 0xf7, 0x26, 0x09, 0xcc, 0xfa, 0x8d, 0xe1, 0x2f, 0x13, 0x7f, 0x33, 0x92,
+    0xdb, 0xd0, 0x37, 0x67, 0x7f, 0xef, 0xe3, 0x6c, 0xbd, 0x4d, 0x69, 0x7b, 0xf8, 0xba, 0x1a, 0xcd,
+    0xff, 0x17, 0x57, 0x3b, 0x62, 0xda, 0x4b, 0x90, 0x6f, 0x4a, 0x95, 0x56, 0xc6, 0xa8, 0x33, 0x98,
+    0x13, 0xce, 0xed, 0xa5, 0xc4, 0x80, 0x56, 0xe4, 0x1c, 0xdd, 0x59, 0x98, 0x90, 0x9b, 0x04, 0x55,
+    0x1a, 0xc7, 0xb7, 0xcc, 0xa4, 0x28, 0xce, 0xaf, 0x98, 0xad, 0x09, 0xf8, 0x27, 0x83, 0xe3, 0xa0,
+    0x29, 0x2c, 0x77, 0xa9, 0x3c, 0x93, 0xf9, 0xd2, 0x64, 0x73, 0x4a, 0x14, 0x5e, 0x57, 0xe0, 0xc2,
+    0x10, 0xcb, 0x34, 0x2f, 0xb1, 0x16, 0xb7, 0x66, 0xd9, 0x8a, 0x70, 0x22, 0x10, 0x25, 0x6f, 0x4c,
+    0x2d, 0x66, 0xc9, 0xa8, 0xb6, 0xa9, 0xe9, 0x96, 0x3a, 0xba, 0xb4, 0x26, 0x52, 0xbf, 0x71, 0x06,
+    0xee, 0xc0, 0xb7, 0x47, 0xf0, 0xa6, 0x40, 0x9c, 0xf4, 0xa0, 0xd6, 0x82, 0xbd, 0xf7, 0x3b, 0x73,
+    0xe7, 0xc3, 0x94, 0xf3, 0x9b, 0x81, 0x39, 0x84, 0x93, 0xc1, 0x60, 0xd0, 0xaa, 0x82, 0x7d, 0xcd,
+    0xe8, 0x61, 0x9f, 0x99, 0x3f, 0x3b, 0x74, 0x77, 0xcc, 0xb4, 0xb6, 0x2c, 0x99, 0x48, 0xf2, 0x65,
+    0xd8, 0xc0, 0x28, 0xe8, 0xa8, 0xeb, 0x6d, 0x77, 0x77, 0x2b, 0xa9, 0xab, 0xd0, 0x1f, 0xf6, 0x60,
+    0x42, 0x97, 0xcd, 0x88, 0x98, 0xa9, 0xc0, 0x2e, 0xb5, 0x1b, 0xb1, 0xfb, 0x8a, 0x53, 0x1c, 0x76,
+    0x08, 0x45, 0xec, 0x18, 0x47, 0x6d, 0xbe, 0xb9, 0x46, 0xf7, 0xfd, 0xf4, 0xea, 0x87, 0xb0, 0x20,
+    0x52, 0x51, 0x1f, 0xab, 0x83, 0x68, 0x12, 0xec, 0x3b, 0x4f, 0xa5, 0xb4, 0xf3, 0xa2, 0x1b, 0x02,
+    0xbb, 0x39, 0xab, 0xb2, 0x0e, 0x1b, 0x41, 0x75, 0x0c, 0x53, 0x2d, 0x59, 0x4d, 0x5d, 0xc7, 0x45,
+    0x5a, 0x69, 0x18, 0x1c, 0x9e, 0xbf, 0xbe, 0x9a, 0x5e, 0xbc, 0x0a, 0x3e, 0x8a, 0xc9, 0x43, 0x77,
+    0x58, 0xaa, 0xb2, 0x5a, 0xb3, 0x69, 0xab, 0xb0, 0x3e, 0x59, 0x54, 0x6e, 0x83, 0x99, 0x29, 0xbb,
+    0x3d, 0xd9, 0xbd, 0x7b, 0x9d, 0x75, 0x47, 0x72, 0x93, 0x11, 0xdd, 0x83, 0x2c, 0xde, 0x3a, 0xaa,
+    0xab, 0x1f, 0x5e, 0x25, 0xed, 0x85, 0x1e, 0xaf, 0xc1, 0xf6, 0xbf, 0xe7, 0xfe, 0x03, 0xc2, 0x0e,
+    0xfa, 0xce, 0xb6, 0x13, 0x00, 0x00,
+};
+
+// settings.html: 8252 bytes, 2511 gzipped
+static const uint8_t web_settings_html[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xc5, 0x5a, 0xfd, 0x6e, 0x1b, 0xb9,
+    0x11, 0xff, 0x3f, 0x4f, 0x31, 0x4d, 0x71, 0x5d, 0x09, 0xd1, 0xb7, 0x63, 0xc3, 0x71, 0x24, 0x1d,
+    0x72, 0x71, 0x0e, 0x17, 0xc0, 0xb9, 0xb8, 0xb5, 0xaf, 0xd7, 0xe2, 0x10, 0x18, 0xd4, 0x2e, 0x65,
+    0xf1, 0xcc, 0x5d, 0x6e, 0x97, 0x5c, 0xdb, 0xba, 0x20, 0x2f, 0x55, 0xa0, 0x2f, 0x70, 0x4f, 0xd6,
+    0x19, 0x7e, 0x48, 0xbb, 0xd2, 0x2a, 0xb6, 0x72, 0x29, 0xea, 0x3f, 0xe2, 0x25, 0x39, 0x9c, 0xe1,
+    0x7c, 0xff, 0x48, 0x67, 0xfc, 0xa7, 0xd3, 0xf7, 0xaf, 0x2f, 0xff, 0x79, 0xfe, 0x06, 0x16, 0x26,
+    0x95, 0xd3, 0x27, 0xe3, 0xf0, 0x8b, 0xb3, 0x64, 0xfa, 0x04, 0xf0, 0x67, 0x9c, 0x72, 0xc3, 0x20,
+    0x63, 0x29, 0x9f, 0x44, 0xb7, 0x82, 0xdf, 0xe5, 0xaa, 0x30, 0x11, 0xc4, 0x2a, 0x33, 0x3c, 0x33,
+    0x93, 0xe8, 0x4e, 0x24, 0x66, 0x31, 0x49, 0xf8, 0xad, 0x88, 0x79, 0xd7, 0x0e, 0x3a, 0x20, 0x32,
+    0x61, 0x04, 0x93, 0x5d, 0x1d, 0x33, 0xc9, 0x27, 0xc3, 0xc8, 0x33, 0x32, 0xc2, 0x48, 0x3e, 0xbd,
+    0xe0, 0xc6, 0x88, 0xec, 0x5a, 0x43, 0x17, 0xfe, 0xce, 0xee, 0xcd, 0xa2, 0xd4, 0xf0, 0x8e, 0x69,
+    0xc3, 0x8b, 0x71, 0xdf, 0x11, 0x38, 0x62, 0x6d, 0x96, 0xe1, 0x9b, 0x7e, 0x66, 0x2a, 0x59, 0xc2,
+    0x47, 0x98, 0xa3, 0xd8, 0xee, 0x9c, 0xa5, 0x42, 0x2e, 0x4f, 0xe0, 0x55, 0x81, 0x42, 0x5e, 0x42,
+    0xca, 0x8a, 0x6b, 0x91, 0x9d, 0xc0, 0x68, 0x90, 0xdf, 0xbf, 0x84, 0x19, 0x8b, 0x6f, 0xae, 0x0b,
+    0x55, 0x66, 0xc9, 0x09, 0xfc, 0x79, 0xc8, 0x86, 0x6c, 0xc4, 0x5f, 0xe2, 0x69, 0xa5, 0x2a, 0x70,
+    0xcc, 0x39, 0x0e, 0x3e, 0xad, 0x98, 0x2e, 0x86, 0xc8, 0x32, 0xac, 0x3d, 0xe7, 0x71, 0xcc, 0x0e,
+    0xaa, 0xcb, 0xbd, 0x98, 0x15, 0x09, 0x52, 0xd4, 0x59, 0x1e, 0x8d, 0x86, 0x07, 0xc8, 0x25, 0x67,
+    0x49, 0x82, 0x6a, 0xac, 0xc4, 0xaa, 0x22, 0xe1, 0x45, 0xb7, 0x60, 0x89, 0x28, 0xf5, 0x09, 0x0c,
+    0xed, 0x64, 0x38, 0x19, 0x8d, 0x60, 0x50, 0x65, 0x2d, 0xd9, 0x8c, 0x4b, 0x64, 0x9d, 0x08, 0x9d,
+    0x4b, 0x86, 0xba, 0xcc, 0xa4, 0x8a, 0x6f, 0x36, 0x77, 0xc0, 0x21, 0x71, 0x59, 0xef, 0x12, 0x59,
+    0x5e, 0x9a, 0x5f, 0xcc, 0x32, 0xe7, 0x13, 0xc3, 0xef, 0xcd, 0x87, 0x4e, 0x75, 0x26, 0x67, 0x5a,
+    0xdf, 0xe1, 0x29, 0xea, 0xb3, 0x59, 0x99, 0xce, 0x78, 0x81, 0x73, 0x9a, 0x4b, 0x1e, 0x1b, 0xf8,
+    0xb8, 0x62, 0x46, 0x3f, 0xd6, 0x5f, 0x24, 0x6d, 0xf0, 0x4d, 0x45, 0xa3, 0x61, 0x45, 0xa3, 0x13,
+    0xc8, 0x54, 0xc6, 0xb7, 0xf4, 0xa3, 0x83, 0xd5, 0x38, 0xd5, 0x6c, 0x34, 0x98, 0x1f, 0x3c, 0x3f,
+    0x1a, 0x6c, 0x98, 0x7d, 0xa6, 0xee, 0xbb, 0x5a, 0xfc, 0x66, 0x25, 0x78, 0x6e, 0x38, 0xb5, 0xe6,
+    0xd2, 0xa8, 0x66, 0xbc, 0xe0, 0xf1, 0x0d, 0x92, 0x7d, 0x40, 0x5b, 0xf9, 0xc3, 0x3a, 0x7b, 0x2f,
+    0xb8, 0xb8, 0x5e, 0x98, 0x30, 0x5a, 0xef, 0x25, 0xbb, 0xb0, 0x82, 0xb3, 0xcf, 0x29, 0xba, 0xda,
+    0xeb, 0x36, 0xff, 0x7f, 0xf4, 0xae, 0x87, 0x72, 0xaa, 0x32, 0xa5, 0x73, 0x16, 0xf3, 0x26, 0x7b,
+    0xf4, 0x16, 0x22, 0x33, 0x95, 0x48, 0x3d, 0x3e, 0x3e, 0xf6, 0xdb, 0x91, 0x2f, 0xc7, 0x73, 0x1f,
+    0xd4, 0x6d, 0x90, 0x17, 0xbc, 0x42, 0xcd, 0x18, 0xab, 0x53, 0x8f, 0x88, 0x5a, 0xdd, 0xf2, 0x62,
+    0x2e, 0xd5, 0x5d, 0xf7, 0xfe, 0x04, 0x58, 0x69, 0x54, 0x75, 0xff, 0xac, 0x34, 0x46, 0x65, 0x1b,
+    0x16, 0xac, 0x29, 0x1a, 0x72, 0x25, 0xc8, 0x08, 0x79, 0x56, 0xb3, 0x5d, 0x6d, 0xfb, 0xda, 0xc8,
+    0x68, 0x42, 0x38, 0x68, 0xca, 0x19, 0x1b, 0xec, 0x71, 0x59, 0x68, 0x62, 0x99, 0x2b, 0xd4, 0x99,
+    0x17, 0x75, 0x26, 0x55, 0x2d, 0x8e, 0xd6, 0x09, 0xd6, 0x35, 0x2a, 0x0f, 0x91, 0x50, 0x75, 0x74,
+    0x83, 0x29, 0xd9, 0xce, 0x84, 0x1f, 0xf7, 0x7d, 0xc5, 0x19, 0xf7, 0x5d, 0xed, 0x1b, 0x53, 0xc9,
+    0xf1, 0xc5, 0x68, 0x31, 0x5c, 0x95, 0x2d, 0x5c, 0x1e, 0xfa, 0xd9, 0xb9, 0x2a, 0x52, 0x60, 0xb1,
+    0x11, 0x2a, 0x9b, 0x44, 0x7d, 0xcd, 0x6e, 0x79, 0x20, 0x8a, 0x00, 0x8b, 0xe6, 0x42, 0x25, 0x93,
+    0xe8, 0xfc, 0xfd, 0xc5, 0x65, 0xb4, 0x2e, 0x63, 0xe3, 0x44, 0xdc, 0x42, 0x2c, 0x31, 0x55, 0x27,
+    0x11, 0x55, 0x97, 0xca, 0x92, 0x13, 0x34, 0x9a, 0xfe, 0x2c, 0xbe, 0x17, 0x28, 0x64, 0xb4, 0xb1,
+    0x62, 0x2b, 0xc6, 0xf4, 0xe2, 0xe2, 0xed, 0xe9, 0xc9, 0xb8, 0xef, 0x06, 0x75, 0x02, 0x9b, 0x35,
+    0x60, 0xb3, 0x26, 0xa2, 0x2c, 0x88, 0x7c, 0xcd, 0xd6, 0x5a, 0x24, 0x11, 0x88, 0xc4, 0x7f, 0x35,
+    0xb2, 0x3d, 0xf7, 0xb5, 0xe3, 0x11, 0xac, 0x43, 0x99, 0x09, 0xec, 0xd7, 0x63, 0x2c, 0x64, 0x31,
+    0x5f, 0x28, 0x89, 0x3e, 0x9d, 0x44, 0xad, 0x32, 0x8b, 0x17, 0x2c, 0xbb, 0xe6, 0x49, 0xbb, 0xaa,
+    0x7e, 0x1f, 0xf5, 0x9f, 0x3e, 0xd9, 0xc7, 0x1c, 0xef, 0xfe, 0x7a, 0x79, 0xb9, 0xd3, 0x1c, 0xb5,
+    0x93, 0x85, 0x5a, 0x11, 0x4e, 0x96, 0xfe, 0xcb, 0x98, 0x2b, 0x9e, 0xb1, 0x99, 0xe4, 0xde, 0x00,
+    0xb5, 0x99, 0x29, 0xbc, 0xb1, 0x5f, 0xe0, 0x24, 0x34, 0xe9, 0xed, 0x6d, 0xce, 0x0b, 0x4c, 0x96,
+    0x3d, 0xad, 0x6e, 0x45, 0x69, 0xbb, 0xb3, 0x22, 0xdb, 0x4f, 0x34, 0xfb, 0x00, 0xfb, 0xea, 0x23,
+    0x84, 0xb8, 0x82, 0x5e, 0x13, 0xe3, 0x3a, 0xf2, 0x4a, 0x88, 0x1d, 0x36, 0x8a, 0xf8, 0x09, 0xe5,
+    0xd3, 0xbe, 0x2f, 0xd1, 0xa5, 0xd4, 0x35, 0x4d, 0xec, 0xf0, 0x6b, 0xc7, 0x92, 0x3b, 0x3e, 0x4e,
+    0x3e, 0x2a, 0x98, 0xf6, 0x8a, 0x03, 0xda, 0x9f, 0x71, 0x79, 0x85, 0xa5, 0x42, 0xc4, 0xba, 0xa2,
+    0xc8, 0xc6, 0xc2, 0x14, 0x5e, 0x49, 0xad, 0x20, 0x2f, 0x67, 0x52, 0xe8, 0x05, 0xe4, 0x58, 0x9f,
+    0x3c, 0x05, 0x68, 0xc3, 0x0c, 0x07, 0x47, 0x07, 0x2d, 0xc9, 0xaf, 0x59, 0xbc, 0x6c, 0x6f, 0x29,
+    0xf9, 0x05, 0x21, 0x7e, 0xa6, 0x62, 0x46, 0x45, 0xa4, 0x21, 0xcc, 0xf3, 0xb0, 0x95, 0x5a, 0x40,
+    0x44, 0x0e, 0x4c, 0xb0, 0x0a, 0x16, 0x30, 0x8e, 0x55, 0xc2, 0xa7, 0xba, 0xcc, 0x0a, 0xa1, 0xf9,
+    0xb8, 0x6f, 0x47, 0x9d, 0xf5, 0xac, 0xe6, 0x66, 0x63, 0x32, 0x53, 0xc4, 0xdf, 0x7e, 0x02, 0xcb,
+    0x92, 0x35, 0xe9, 0x24, 0xcc, 0x8a, 0x0c, 0xcc, 0x82, 0x83, 0x46, 0xf3, 0x25, 0xa5, 0xe4, 0xbd,
+    0x71, 0x3f, 0x6f, 0xb4, 0xf5, 0x19, 0x9e, 0xd5, 0x94, 0x09, 0xdf, 0x23, 0x56, 0x11, 0xdd, 0xe5,
+    0x93, 0x68, 0xd0, 0x1b, 0x0c, 0x06, 0x43, 0x2c, 0x8d, 0x02, 0xcb, 0x65, 0xf7, 0xc5, 0x00, 0xbf,
+    0xd8, 0xfd, 0x24, 0xa2, 0x0f, 0xe7, 0x28, 0xe9, 0x39, 0x3b, 0xef, 0xac, 0x46, 0xcd, 0xa7, 0x50,
+    0xd9, 0xf5, 0xd7, 0x38, 0xc6, 0xf0, 0x38, 0x9c, 0xc3, 0x7e, 0xf9, 0x83, 0x04, 0xe6, 0xfe, 0x24,
+    0xab, 0xe1, 0x1f, 0x72, 0xf3, 0xb9, 0xba, 0x23, 0x90, 0xfb, 0x90, 0x8f, 0x2f, 0xd1, 0x09, 0xaf,
+    0xcf, 0x7f, 0x42, 0xc9, 0x92, 0x6b, 0x60, 0x06, 0x8e, 0x07, 0xf0, 0xee, 0x87, 0xdf, 0xc8, 0x6b,
+    0x1d, 0xc0, 0xb6, 0xcc, 0x40, 0x12, 0x7c, 0xe9, 0x6a, 0xc9, 0x79, 0x8e, 0xbd, 0x5a, 0x48, 0x9c,
+    0x27, 0xcf, 0xc5, 0x0b, 0x91, 0x83, 0x9d, 0xd5, 0x70, 0xb7, 0x10, 0x58, 0xd9, 0x38, 0x16, 0x9b,
+    0x25, 0xa8, 0xd2, 0x90, 0x2d, 0x84, 0xae, 0x89, 0xb5, 0xfd, 0xb4, 0x94, 0x12, 0xd7, 0xe7, 0x73,
+    0xc0, 0x90, 0x52, 0x59, 0x0f, 0x48, 0x36, 0x8b, 0x63, 0xae, 0xb5, 0x6b, 0xc0, 0xb8, 0x09, 0xf4,
+    0x9d, 0x30, 0x14, 0x13, 0x96, 0xce, 0xf1, 0xa5, 0x16, 0x45, 0x4b, 0x78, 0x09, 0xc8, 0x10, 0x54,
+    0xe2, 0x1a, 0x85, 0x54, 0xac, 0x52, 0x3c, 0x30, 0xe1, 0x04, 0x10, 0x73, 0x10, 0x06, 0x92, 0x42,
+    0xe5, 0xba, 0xb7, 0x25, 0x95, 0xea, 0x2d, 0x11, 0xa7, 0xb8, 0x49, 0x83, 0x61, 0x37, 0x1c, 0xca,
+    0x1c, 0xf3, 0x8a, 0x9a, 0x36, 0xa4, 0x7a, 0x67, 0xe0, 0x7d, 0x36, 0xc9, 0x73, 0x32, 0xee, 0x15,
+    0xf5, 0x60, 0xe7, 0xb3, 0xca, 0x78, 0x0a, 0xd6, 0xf2, 0x40, 0x83, 0xaf, 0x91, 0xae, 0xa7, 0xef,
+    0xfe, 0xf1, 0x08, 0x2f, 0x92, 0x5a, 0xe4, 0x15, 0xeb, 0x2c, 0x0d, 0xf3, 0x42, 0xa5, 0xc1, 0x75,
+    0x88, 0x10, 0x20, 0xe1, 0xfa, 0xc6, 0x82, 0x30, 0xbc, 0xc5, 0x98, 0xee, 0x8f, 0xdc, 0x90, 0x0b,
+    0xf4, 0xab, 0xd7, 0x3f, 0x42, 0xeb, 0xcd, 0xb0, 0x77, 0x30, 0x6c, 0x3b, 0x67, 0xf8, 0xda, 0x83,
+    0xfb, 0x95, 0x44, 0xb4, 0x06, 0x9c, 0xc5, 0x0b, 0x50, 0xc8, 0xb7, 0xd8, 0x76, 0x26, 0x49, 0xb0,
+    0x19, 0x8c, 0x00, 0xd8, 0x00, 0xe2, 0xad, 0x82, 0xfc, 0x88, 0x69, 0x9d, 0x30, 0xbd, 0x98, 0x29,
+    0xba, 0xcb, 0x58, 0xc0, 0xe5, 0x38, 0x87, 0x3c, 0x07, 0xa4, 0x2a, 0xc9, 0x71, 0xa3, 0xde, 0x21,
+    0x60, 0xbc, 0xcd, 0x11, 0x75, 0x79, 0x36, 0x08, 0xa3, 0x53, 0xfc, 0x45, 0x4e, 0xdc, 0xe5, 0x93,
+    0xf3, 0x42, 0x19, 0x85, 0x80, 0x6a, 0x47, 0x16, 0xfa, 0x4b, 0x87, 0x73, 0x51, 0x92, 0xde, 0x5f,
+    0xe5, 0x9e, 0xde, 0x39, 0xa9, 0x36, 0x33, 0xdd, 0xd2, 0x68, 0xac, 0x72, 0x2a, 0x8b, 0x70, 0xcb,
+    0x64, 0x89, 0xfb, 0x31, 0xfe, 0xa2, 0xe9, 0xfb, 0xf9, 0x7c, 0xdc, 0x77, 0xf3, 0x0f, 0x6e, 0x40,
+    0x33, 0x64, 0x1c, 0x7d, 0xe1, 0x2d, 0xfc, 0xe8, 0x7d, 0x9a, 0xc5, 0x59, 0x34, 0xad, 0x3a, 0xa3,
+    0x79, 0x2b, 0x42, 0x46, 0xab, 0x5f, 0x73, 0xaf, 0xcd, 0x04, 0x7a, 0x57, 0xef, 0x53, 0x9f, 0x6c,
+    0x45, 0x0a, 0xe5, 0xe8, 0xe8, 0xe0, 0xc5, 0x8b, 0x17, 0x51, 0xc5, 0x74, 0xa5, 0x67, 0xb8, 0x36,
+    0xdd, 0x6a, 0xa6, 0x19, 0xb6, 0x54, 0xc3, 0x60, 0xdf, 0x53, 0x0c, 0xfd, 0x29, 0x0e, 0x87, 0xa3,
+    0xea, 0x19, 0x3c, 0xb7, 0xf5, 0x11, 0xc2, 0xc4, 0x1f, 0x4b, 0x28, 0x86, 0x77, 0x20, 0x38, 0xa3,
+    0xd4, 0x80, 0xb7, 0x88, 0xfa, 0xaf, 0x0b, 0x26, 0x1f, 0xce, 0xb0, 0x9f, 0x85, 0x59, 0x60, 0x46,
+    0xa1, 0x96, 0xd7, 0x98, 0x3d, 0x14, 0xb1, 0x74, 0x8f, 0x59, 0xc7, 0x35, 0xd6, 0xa7, 0x44, 0xa4,
+    0x29, 0x16, 0x27, 0xec, 0xe7, 0xb4, 0x9c, 0xb0, 0x25, 0x06, 0x3b, 0x26, 0x10, 0x06, 0xbb, 0x30,
+    0x1d, 0x5b, 0xb3, 0x2a, 0x19, 0x4a, 0x81, 0x8e, 0x45, 0x30, 0xe6, 0x54, 0xba, 0x70, 0x33, 0x22,
+    0xf8, 0x1e, 0x5e, 0xc1, 0x27, 0x54, 0xf7, 0xb6, 0x8b, 0xd8, 0xf9, 0xf9, 0xf7, 0xa7, 0x44, 0x65,
+    0x13, 0xd2, 0x67, 0x69, 0xa4, 0xe1, 0xf7, 0xff, 0xa4, 0x4a, 0xf6, 0xd3, 0xdf, 0xff, 0xdd, 0xb7,
+    0xa5, 0x9b, 0x0a, 0xac, 0xaf, 0xbf, 0x1d, 0x64, 0xc8, 0x74, 0x59, 0x50, 0xb1, 0x34, 0x10, 0xb3,
+    0x4c, 0xe5, 0x4b, 0x7f, 0x13, 0xdd, 0x99, 0x5d, 0x97, 0x4e, 0xb7, 0x56, 0xe0, 0x89, 0x1a, 0xb4,
+    0xbf, 0xa0, 0xdf, 0x0d, 0x37, 0x42, 0x0b, 0xeb, 0xec, 0xca, 0xa9, 0x52, 0x5c, 0x39, 0x0b, 0x7a,
+    0x9f, 0xae, 0xc7, 0x1b, 0x02, 0xc8, 0x8d, 0xb6, 0xb0, 0xe6, 0x73, 0xf4, 0xa1, 0xf7, 0xf2, 0x4e,
+    0xa7, 0xfb, 0x2b, 0xa4, 0x3b, 0x8f, 0x2e, 0x67, 0xa9, 0x40, 0x86, 0x17, 0x58, 0x80, 0xe1, 0x2f,
+    0xf0, 0x37, 0x3e, 0x53, 0x0a, 0xb3, 0xd1, 0xd1, 0xf8, 0xbb, 0x54, 0x9f, 0x2e, 0x53, 0x9e, 0xc3,
+    0x67, 0x42, 0x86, 0xc2, 0xe5, 0xc2, 0x7b, 0xb8, 0x1e, 0x22, 0x9b, 0xe1, 0xf1, 0x3e, 0x23, 0xcf,
+    0xe2, 0x3f, 0x08, 0xe1, 0x82, 0x83, 0x4e, 0x3c, 0xec, 0xc1, 0x2e, 0x86, 0x48, 0x6e, 0x70, 0x74,
+    0x32, 0x18, 0x4c, 0x06, 0xd8, 0x76, 0xe8, 0xf7, 0xe8, 0xf0, 0x10, 0x86, 0xc7, 0xe1, 0x6b, 0x34,
+    0xb2, 0x6b, 0x1e, 0x1b, 0xd5, 0xdd, 0x7f, 0x86, 0x6d, 0x15, 0x2b, 0xf2, 0xa0, 0x4b, 0x84, 0x58,
+    0xb5, 0x51, 0x40, 0xcc, 0x33, 0x13, 0x90, 0x16, 0x93, 0x32, 0x40, 0x2a, 0x84, 0x61, 0xda, 0x37,
+    0x61, 0x7f, 0x82, 0x3a, 0x27, 0xb7, 0x01, 0x2b, 0xe0, 0x9c, 0xba, 0x6a, 0xaa, 0xb2, 0xee, 0xbc,
+    0x10, 0xf0, 0xbc, 0xfb, 0x62, 0xc5, 0x80, 0x72, 0x18, 0x23, 0x09, 0xee, 0x38, 0xbf, 0x41, 0xef,
+    0xf7, 0x91, 0x06, 0xa3, 0xde, 0xef, 0xa8, 0x33, 0xbb, 0x14, 0x54, 0xc5, 0x53, 0x0c, 0xf2, 0x19,
+    0x16, 0x6f, 0x25, 0x59, 0x01, 0xad, 0x1a, 0x4c, 0xec, 0x1e, 0x90, 0xb6, 0x0e, 0x1d, 0x3e, 0x1b,
+    0x1e, 0xae, 0xb4, 0x6b, 0x57, 0x00, 0x61, 0x79, 0x4b, 0x04, 0x93, 0xe3, 0xc1, 0x37, 0xe1, 0x08,
+    0xae, 0xf1, 0x68, 0x9b, 0x29, 0x98, 0x3d, 0x92, 0xd6, 0xeb, 0x82, 0xad, 0x5b, 0x79, 0x9a, 0x9b,
+    0x25, 0x35, 0x71, 0x2c, 0x07, 0x46, 0x15, 0xae, 0xf7, 0x25, 0x7c, 0xce, 0x4a, 0xb9, 0x11, 0xdf,
+    0xe3, 0xd5, 0x13, 0x8d, 0xbd, 0x93, 0x7a, 0x67, 0x62, 0xb4, 0xe6, 0x5c, 0x4a, 0xdb, 0xd6, 0x27,
+    0xd1, 0x9c, 0x49, 0x2a, 0x6b, 0xe3, 0x7e, 0xa0, 0x9d, 0xee, 0x08, 0x2d, 0x37, 0x88, 0x28, 0x6f,
+    0xa5, 0xa0, 0x9d, 0xf6, 0x16, 0xee, 0x79, 0xb6, 0xda, 0x3e, 0xe6, 0xd6, 0x11, 0x53, 0x8d, 0xb9,
+    0x47, 0x70, 0xcb, 0x0b, 0x4e, 0x4f, 0x9e, 0x55, 0x86, 0xe7, 0x6e, 0x0a, 0x2e, 0x15, 0xfa, 0xa3,
+    0x81, 0x61, 0x5e, 0x53, 0xeb, 0x8a, 0xba, 0xab, 0xa4, 0xf7, 0xd2, 0x6a, 0x6c, 0xd6, 0xed, 0x41,
+    0xcf, 0x35, 0xb5, 0x3d, 0x5e, 0xaa, 0xa5, 0x2b, 0xc2, 0x7b, 0xe8, 0x3a, 0xe1, 0xc6, 0xf9, 0x74,
+    0xcc, 0x60, 0x51, 0xf0, 0xf9, 0x24, 0xea, 0x47, 0xd3, 0xef, 0x08, 0x70, 0xa1, 0xe1, 0x4f, 0x43,
+    0x97, 0x1f, 0xf7, 0x99, 0x93, 0xe0, 0x1f, 0x52, 0xe3, 0x42, 0xe4, 0x95, 0x1e, 0xd5, 0xef, 0x43,
+    0xb8, 0xa2, 0x61, 0x64, 0xa1, 0xec, 0x8c, 0x22, 0x14, 0x63, 0x15, 0xe1, 0x9e, 0x71, 0x95, 0x72,
+    0x56, 0xa0, 0xc7, 0x79, 0xf1, 0x12, 0x24, 0x27, 0xf3, 0xcd, 0x24, 0xcb, 0xac, 0x88, 0x1b, 0x42,
+    0x9c, 0x48, 0x90, 0xae, 0x98, 0xcd, 0x39, 0x62, 0xc3, 0x56, 0x84, 0xb1, 0x92, 0xcd, 0xc5, 0x75,
+    0xd4, 0xae, 0x05, 0x46, 0x0f, 0x49, 0xb3, 0x56, 0x01, 0x93, 0x29, 0x14, 0xbd, 0x5f, 0xb5, 0xca,
+    0x5a, 0xed, 0x26, 0x82, 0x84, 0x08, 0x3e, 0x6e, 0x55, 0xd8, 0x44, 0xc5, 0x88, 0x4b, 0x32, 0xd3,
+    0xc3, 0x62, 0xf4, 0x46, 0x72, 0xfa, 0xfc, 0x6e, 0xf9, 0x36, 0x69, 0xb9, 0x67, 0x8c, 0x76, 0xcf,
+    0x36, 0x6b, 0x2c, 0xcf, 0x49, 0x8f, 0x26, 0x5e, 0x3e, 0x7e, 0x7f, 0xed, 0x15, 0xa0, 0xdd, 0xb3,
+    0x21, 0x87, 0x55, 0x99, 0x38, 0x55, 0x97, 0xf6, 0xe5, 0xe8, 0xef, 0xf6, 0xd5, 0x83, 0x55, 0xe6,
+    0xf7, 0xe5, 0x66, 0x2f, 0xf1, 0x5b, 0xbc, 0x68, 0x76, 0x5f, 0x4e, 0xf6, 0xa6, 0xbe, 0xc5, 0x89,
+    0x66, 0xf7, 0xe5, 0xb4, 0x71, 0x55, 0x6e, 0x30, 0x5d, 0x9d, 0x62, 0x0f, 0xfe, 0x15, 0xb8, 0x5e,
+    0x67, 0xbb, 0x5e, 0xd8, 0x83, 0x5b, 0x0d, 0x57, 0x56, 0x55, 0xaf, 0x2e, 0xec, 0xc9, 0x6f, 0x05,
+    0xb6, 0x36, 0xf9, 0x85, 0x85, 0x3d, 0xf9, 0x05, 0xe4, 0xb4, 0xc9, 0xce, 0xcf, 0xef, 0xc1, 0x6d,
+    0x75, 0x51, 0xae, 0xb2, 0x0a, 0x93, 0xfb, 0xf0, 0x59, 0x5d, 0x73, 0x6b, 0x8c, 0xc2, 0xec, 0x3e,
+    0xfa, 0xad, 0x51, 0x44, 0x4d, 0xbd, 0xd5, 0xf4, 0x36, 0x2f, 0x2c, 0x20, 0xda, 0x00, 0x81, 0x0b,
+    0x22, 0xdd, 0x19, 0x26, 0x04, 0x3e, 0xda, 0xdb, 0xbb, 0xe9, 0x49, 0xa4, 0xe5, 0x58, 0x10, 0xae,
+    0xb1, 0x97, 0x9e, 0x1e, 0x11, 0xb7, 0x1b, 0x0a, 0x8b, 0x7d, 0x8e, 0xc6, 0xb5, 0x9e, 0xc0, 0x4e,
+    0x58, 0x98, 0x57, 0xc9, 0xaf, 0x8c, 0xfa, 0xf7, 0x0f, 0x97, 0xef, 0xce, 0x5a, 0xd1, 0x8c, 0x23,
+    0x2f, 0xce, 0xb3, 0x24, 0xea, 0xc0, 0xd3, 0x70, 0xc9, 0x21, 0xac, 0xf7, 0x14, 0x9e, 0x39, 0xde,
+    0xcf, 0xf0, 0xb3, 0x55, 0xc1, 0x79, 0x6b, 0x44, 0x86, 0x24, 0x8d, 0xc2, 0xe8, 0xe7, 0xe9, 0xc3,
+    0x88, 0xff, 0x70, 0xb0, 0xc6, 0x65, 0x74, 0xbe, 0xab, 0xaa, 0xc8, 0x28, 0x5c, 0x4e, 0x68, 0xd2,
+    0xe9, 0xf6, 0x0b, 0xad, 0x7d, 0xb0, 0x8b, 0xd3, 0xa7, 0x0d, 0x46, 0xf9, 0x54, 0x9b, 0xf9, 0x84,
+    0x14, 0x5b, 0x65, 0x7b, 0xd5, 0x7d, 0x3f, 0x53, 0xb8, 0xa9, 0x05, 0x37, 0x17, 0x6e, 0x43, 0x04,
+    0xbb, 0xcb, 0xf4, 0x8a, 0xf7, 0x2a, 0x04, 0x4c, 0xf5, 0x0c, 0xd8, 0x87, 0x5e, 0xe5, 0xb9, 0x14,
+    0x84, 0xc6, 0x09, 0xa6, 0x0b, 0x66, 0xb8, 0x5c, 0x76, 0x20, 0x23, 0x0c, 0x41, 0x08, 0x71, 0x7d,
+    0xda, 0x32, 0xb3, 0x8f, 0xec, 0x50, 0x6f, 0xee, 0x1b, 0xae, 0xdd, 0xd2, 0xa9, 0x03, 0x1f, 0xdd,
+    0x2b, 0xfc, 0x09, 0xb8, 0x67, 0xf8, 0x8e, 0xfd, 0x2b, 0xe2, 0xc9, 0xe3, 0x8f, 0xfc, 0xa9, 0xbd,
+    0x65, 0xd4, 0x07, 0x7b, 0xda, 0x83, 0x7d, 0xed, 0xf3, 0xbd, 0x6d, 0x03, 0x37, 0xb4, 0xad, 0xf9,
+    0x5f, 0xbb, 0x3f, 0xb6, 0xba, 0x66, 0x67, 0x98, 0x29, 0x35, 0x4c, 0x26, 0x13, 0x88, 0xd4, 0x4d,
+    0xb4, 0x33, 0xe0, 0xbe, 0x85, 0x88, 0xb0, 0x0f, 0x29, 0xef, 0x22, 0xc6, 0x61, 0x46, 0x8d, 0x83,
+    0x28, 0x00, 0xc8, 0x96, 0x6e, 0x77, 0xc2, 0x32, 0x3d, 0xf7, 0xf8, 0x45, 0xfb, 0xb9, 0x9b, 0x33,
+    0x72, 0x3c, 0x23, 0x60, 0xed, 0x36, 0x5a, 0x8c, 0x8d, 0xdb, 0x82, 0x1c, 0x5e, 0x14, 0xaa, 0xa1,
+    0xb3, 0x7c, 0x6a, 0x57, 0xff, 0x1c, 0x53, 0x0d, 0x82, 0x53, 0x44, 0xc7, 0x45, 0x99, 0xe1, 0x35,
+    0xcb, 0x62, 0x0f, 0xd2, 0x37, 0xbc, 0x45, 0xce, 0xd4, 0x3d, 0xb4, 0x32, 0x65, 0x16, 0xf4, 0x62,
+    0x42, 0x4f, 0x51, 0xa4, 0x50, 0x9b, 0x5e, 0xc1, 0x10, 0x8b, 0xaa, 0x3b, 0x0b, 0xed, 0x17, 0xaa,
+    0x2c, 0xb6, 0x23, 0x65, 0x0b, 0xb8, 0xed, 0x0a, 0x16, 0x91, 0x96, 0x58, 0x2a, 0xf9, 0xb7, 0xf6,
+    0xae, 0x74, 0x70, 0x84, 0x19, 0xf8, 0xbf, 0x0f, 0x1b, 0x75, 0x83, 0xde, 0x09, 0x89, 0x85, 0xe6,
+    0x0c, 0x81, 0x54, 0x09, 0x9b, 0x07, 0x2d, 0xbc, 0x33, 0xea, 0x1e, 0x97, 0x94, 0x2b, 0x8c, 0xb9,
+    0x19, 0x60, 0xa6, 0xbd, 0xf9, 0x67, 0xb3, 0x71, 0x3f, 0x20, 0x48, 0x44, 0xbb, 0xf6, 0x4f, 0x62,
+    0x78, 0xf1, 0xb2, 0xff, 0x49, 0xe0, 0xbf, 0xa1, 0x8b, 0x2a, 0x2a, 0x3c, 0x20, 0x00, 0x00,
+};
+
+const WebAsset WEB_ASSETS[] = {
+    {"/", "text/html", web_index_html, sizeof(web_index_html), "\"7fad02ea4096dd22\""},
+    {"/settings", "text/html", web_settings_html, sizeof(web_settings_html), "\"88b5a8dc23908a68\""},
+};
+const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
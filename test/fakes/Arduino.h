@@ -0,0 +1,129 @@
+/**
+ * Host stand-in for the Arduino core ([env:native] only).
+ *
+ * Provides just enough of String/Serial for main.cpp and ArduinoJson to
+ * build on a PC. Serial output can be muted so benchmarks measure the
+ * firmware logic rather than the terminal.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+class String {
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String(const char* s, unsigned int length) : s_(s ? std::string(s, length) : std::string()) {}
+    String(const String& other) = default;
+    String(String&& other) = default;
+    explicit String(char c) : s_(1, c) {}
+    String(int value, unsigned char base = DEC) { from_long(value, base); }
+    String(unsigned int value, unsigned char base = DEC) { from_ulong(value, base); }
+    String(long value, unsigned char base = DEC) { from_long(value, base); }
+    String(unsigned long value, unsigned char base = DEC) { from_ulong(value, base); }
+    explicit String(float value, unsigned int decimals = 2) { from_double(value, decimals); }
+    explicit String(double value, unsigned int decimals = 2) { from_double(value, decimals); }
+
+    String& operator=(const String& other) = default;
+    String& operator=(String&& other) = default;
+    String& operator=(const char* s) { s_ = s ? s : ""; return *this; }
+
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    bool reserve(unsigned int size) { s_.reserve(size); return true; }
+
+    bool concat(const String& s) { s_ += s.s_; return true; }
+    bool concat(const char* s) { if (s) s_ += s; return true; }
+    bool concat(const char* s, unsigned int n) { if (s) s_.append(s, n); return true; }
+    bool concat(char c) { s_ += c; return true; }
+
+    String& operator+=(const String& s) { concat(s); return *this; }
+    String& operator+=(const char* s) { concat(s); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool operator==(const String& o) const { return s_ == o.s_; }
+    bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+    bool operator!=(const String& o) const { return s_ != o.s_; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+
+    bool startsWith(const String& prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s_.size() >= suffix.s_.size() &&
+               s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(), suffix.s_) == 0;
+    }
+    int indexOf(char c) const { size_t p = s_.find(c); return p == std::string::npos ? -1 : (int)p; }
+    String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from).c_str()) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < s_.size() ? String(s_.substr(from, to - from).c_str()) : String();
+    }
+    long toInt() const { return atol(s_.c_str()); }
+    float toFloat() const { return (float)atof(s_.c_str()); }
+
+    friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+    friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+    friend String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+
+private:
+    void from_long(long value, unsigned char base) {
+        if (base == DEC) { s_ = std::to_string(value); return; }
+        from_ulong((unsigned long)value, base);
+    }
+    void from_ulong(unsigned long value, unsigned char base) {
+        char buf[33];
+        snprintf(buf, sizeof(buf), base == HEX ? "%lx" : "%lu", value);
+        s_ = buf;
+    }
+    void from_double(double value, unsigned int decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+        s_ = buf;
+    }
+
+    std::string s_;
+};
+
+// ArduinoJson's String adapter also recognises this helper type
+class StringSumHelper : public String {
+public:
+    using String::String;
+};
+
+class FakeSerial {
+public:
+    bool muted = false;
+
+    void begin(unsigned long baud) { (void)baud; }
+    size_t print(const String& s) { return write_str(s.c_str()); }
+    size_t print(const char* s) { return write_str(s); }
+    size_t println() { return write_str("\n"); }
+    size_t println(const String& s) { return write_str(s.c_str()) + write_str("\n"); }
+    size_t println(const char* s) { return write_str(s) + write_str("\n"); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        if (muted) return 0;
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n < 0 ? 0 : (size_t)n;
+    }
+
+private:
+    size_t write_str(const char* s) {
+        if (muted || !s) return 0;
+        return fputs(s, stdout) < 0 ? 0 : strlen(s);
+    }
+};
+
+inline FakeSerial Serial;
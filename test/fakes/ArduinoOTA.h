@@ -0,0 +1,41 @@
+/**
+ * Host stand-in for ArduinoOTA ([env:native] only). Everything is a no-op.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+typedef enum {
+    OTA_AUTH_ERROR,
+    OTA_BEGIN_ERROR,
+    OTA_CONNECT_ERROR,
+    OTA_RECEIVE_ERROR,
+    OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+public:
+    ArduinoOTAClass& setHostname(const char* name) { (void)name; return *this; }
+    ArduinoOTAClass& setPassword(const char* password) { (void)password; return *this; }
+    ArduinoOTAClass& setPort(uint16_t port) { (void)port; return *this; }
+    ArduinoOTAClass& onStart(std::function<void()> fn) { start_ = fn; return *this; }
+    ArduinoOTAClass& onEnd(std::function<void()> fn) { (void)fn; return *this; }
+    ArduinoOTAClass& onProgress(std::function<void(unsigned int, unsigned int)> fn) { (void)fn; return *this; }
+    ArduinoOTAClass& onError(std::function<void(ota_error_t)> fn) { (void)fn; return *this; }
+    void begin() {}
+    void handle() {}
+    int getCommand() { return U_FLASH; }
+
+    // Fake control: simulate an incoming update
+    void fake_start() { if (start_) start_(); }
+
+private:
+    std::function<void()> start_;
+};
+
+inline ArduinoOTAClass ArduinoOTA;
@@ -0,0 +1,397 @@
+/**
+ * Host stand-in for ESPAsyncWebServer ([env:native] only).
+ *
+ * Handlers are matched like the real server (registration order, filters,
+ * exact path or path + "/..."). fake_request() runs a request to the end;
+ * fake_open() + fake_pump() hand a chunked body out one window at a time,
+ * so tests can interleave slow clients with loop() without sockets.
+ * A body in args["plain"] is delivered through the body callback.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+class AsyncWebServerRequest;
+class AsyncEventSourceClient;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                           size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<size_t(uint8_t* buffer, size_t max_len, size_t index)> AwsResponseFiller;
+typedef std::function<void(AsyncEventSourceClient* client)> ArEventHandlerFunction;
+
+// ============================================================================
+// RESPONSES
+// ============================================================================
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse(int code, const char* content_type) : code_(code), content_type_(content_type) {}
+    virtual ~AsyncWebServerResponse() {}
+
+    bool addHeader(const char* name, const char* value, bool replace = true) {
+        if (!replace && headers_.count(name)) return false;
+        headers_[name] = value;
+        return true;
+    }
+
+    // Fake controls: next piece of the body, empty when finished
+    virtual std::string fake_next(size_t window) {
+        std::string out = body_.substr(sent_, window);
+        sent_ += out.size();
+        return out;
+    }
+
+    int code_;
+    std::string content_type_;
+    std::string body_;
+    size_t sent_ = 0;
+    std::map<std::string, std::string> headers_;
+};
+
+class AsyncChunkedResponse : public AsyncWebServerResponse {
+public:
+    AsyncChunkedResponse(const char* content_type, AwsResponseFiller filler)
+        : AsyncWebServerResponse(200, content_type), filler_(filler) {}
+
+    std::string fake_next(size_t window) override {
+        if (done_) return std::string();
+        std::vector<uint8_t> buf(window);
+        size_t len;
+        while ((len = filler_(buf.data(), window, sent_)) == RESPONSE_TRY_AGAIN) {
+        }
+        if (len == 0) {
+            done_ = true;
+            return std::string();
+        }
+        sent_ += len;
+        return std::string((const char*)buf.data(), len);
+    }
+
+private:
+    AwsResponseFiller filler_;
+    bool done_ = false;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse {
+public:
+    explicit AsyncResponseStream(const char* content_type) : AsyncWebServerResponse(200, content_type) {}
+    size_t write(const uint8_t* data, size_t len) {
+        body_.append((const char*)data, len);
+        return len;
+    }
+    size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+};
+
+// ============================================================================
+// REQUEST
+// ============================================================================
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String& name, const String& value) : name_(name), value_(value) {}
+    const String& name() const { return name_; }
+    const String& value() const { return value_; }
+
+private:
+    String name_;
+    String value_;
+};
+
+class AsyncWebServerRequest {
+public:
+    AsyncWebServerRequest(WebRequestMethod method, const std::string& url,
+                          const std::map<std::string, std::string>& args,
+                          const std::map<std::string, std::string>& headers)
+        : method_(method), url_(url.c_str()) {
+        for (auto& arg : args) {
+            if (arg.first == "plain") {
+                body_ = arg.second;
+            } else {
+                args_[arg.first] = arg.second.c_str();
+            }
+        }
+        for (auto& header : headers) {
+            headers_.emplace(header.first, AsyncWebHeader(header.first.c_str(), header.second.c_str()));
+        }
+    }
+    ~AsyncWebServerRequest() {
+        if (disconnect_) disconnect_();
+        delete response_;
+        free(_tempObject);
+    }
+
+    WebRequestMethodComposite method() const { return method_; }
+    const String& url() const { return url_; }
+    size_t contentLength() const { return body_.size(); }
+
+    bool hasArg(const char* name) const { return args_.count(name) != 0; }
+    const String& arg(const char* name) const {
+        static const String empty;
+        auto it = args_.find(name);
+        return it == args_.end() ? empty : it->second;
+    }
+    bool hasHeader(const char* name) const { return headers_.count(name) != 0; }
+    const AsyncWebHeader* getHeader(const char* name) const {
+        auto it = headers_.find(name);
+        return it == headers_.end() ? nullptr : &it->second;
+    }
+
+    AsyncWebServerResponse* beginResponse(int code, const char* content_type = "", const char* content = "") {
+        AsyncWebServerResponse* response = new AsyncWebServerResponse(code, content_type);
+        response->body_ = content;
+        return response;
+    }
+    AsyncWebServerResponse* beginResponse(int code, const char* content_type, const String& content) {
+        return beginResponse(code, content_type, content.c_str());
+    }
+    AsyncWebServerResponse* beginResponse(int code, const char* content_type, const uint8_t* content, size_t len) {
+        AsyncWebServerResponse* response = new AsyncWebServerResponse(code, content_type);
+        response->body_.assign((const char*)content, len);
+        return response;
+    }
+    AsyncWebServerResponse* beginChunkedResponse(const char* content_type, AwsResponseFiller filler) {
+        return new AsyncChunkedResponse(content_type, filler);
+    }
+    AsyncResponseStream* beginResponseStream(const char* content_type) {
+        return new AsyncResponseStream(content_type);
+    }
+
+    void send(AsyncWebServerResponse* response) {
+        delete response_;
+        response_ = response;
+    }
+    void send(int code, const char* content_type = "", const char* content = "") {
+        send(beginResponse(code, content_type, content));
+    }
+    void send(int code, const char* content_type, const String& content) {
+        send(beginResponse(code, content_type, content));
+    }
+
+    void onDisconnect(std::function<void()> fn) { disconnect_ = fn; }
+
+    void* _tempObject = nullptr;  // freed with free(), like the real request
+
+    // Fake controls
+    std::string body_;
+    AsyncWebServerResponse* response_ = nullptr;
+    AsyncEventSourceClient* event_client_ = nullptr;
+
+private:
+    WebRequestMethod method_;
+    String url_;
+    std::map<std::string, String> args_;
+    std::map<std::string, AsyncWebHeader> headers_;
+    std::function<void()> disconnect_;
+};
+
+// ============================================================================
+// HANDLERS
+// ============================================================================
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    AsyncWebHandler& setFilter(ArRequestFilterFunction fn) {
+        filter_ = fn;
+        return *this;
+    }
+    bool filter(AsyncWebServerRequest* request) { return !filter_ || filter_(request); }
+    virtual bool canHandle(AsyncWebServerRequest* request) = 0;
+    virtual void handleRequest(AsyncWebServerRequest* request) = 0;
+
+protected:
+    static bool url_matches(const std::string& uri, const String& url) {
+        std::string u = url.c_str();
+        return u == uri || u.compare(0, uri.size() + 1, uri + "/") == 0;
+    }
+
+private:
+    ArRequestFilterFunction filter_;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+    AsyncCallbackWebHandler(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction on_request,
+                            ArBodyHandlerFunction on_body)
+        : uri_(uri), method_(method), on_request_(on_request), on_body_(on_body) {}
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        return (request->method() & method_) && url_matches(uri_, request->url());
+    }
+    void handleRequest(AsyncWebServerRequest* request) override {
+        if (on_body_ && !request->body_.empty()) {
+            on_body_(request, (uint8_t*)&request->body_[0], request->body_.size(), 0, request->body_.size());
+        }
+        if (on_request_) on_request_(request);
+    }
+
+private:
+    std::string uri_;
+    WebRequestMethodComposite method_;
+    ArRequestHandlerFunction on_request_;
+    ArBodyHandlerFunction on_body_;
+};
+
+// ============================================================================
+// SERVER-SENT EVENTS
+// ============================================================================
+class AsyncEventSourceClient {
+public:
+    void send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        (void)id;
+        (void)reconnect;
+        if (!connected_) return;
+        if (event) sent.append("event: ").append(event).append("\n");
+        sent.append("data: ").append(message).append("\n\n");
+    }
+    void close() { connected_ = false; }
+    bool connected() const { return connected_; }
+
+    // Fake controls
+    std::string sent;
+
+private:
+    bool connected_ = true;
+};
+
+class AsyncEventSource : public AsyncWebHandler {
+public:
+    explicit AsyncEventSource(const char* url) : url_(url) {}
+
+    void onConnect(ArEventHandlerFunction fn) { connect_ = fn; }
+    void send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        for (auto& client : clients_) client->send(message, event, id, reconnect);
+    }
+    size_t count() const {
+        size_t n = 0;
+        for (auto& client : clients_) n += client->connected();
+        return n;
+    }
+    void close() {
+        for (auto& client : clients_) client->close();
+    }
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        return request->method() == HTTP_GET && request->url() == url_.c_str();
+    }
+    void handleRequest(AsyncWebServerRequest* request) override {
+        // Dropped clients leave the list when the next one arrives
+        for (size_t i = clients_.size(); i-- > 0;) {
+            if (!clients_[i]->connected()) clients_.erase(clients_.begin() + i);
+        }
+        clients_.emplace_back(new AsyncEventSourceClient());
+        request->event_client_ = clients_.back().get();
+        if (connect_) connect_(request->event_client_);
+    }
+
+private:
+    std::string url_;
+    ArEventHandlerFunction connect_;
+    std::vector<std::unique_ptr<AsyncEventSourceClient>> clients_;
+};
+
+// ============================================================================
+// SERVER
+// ============================================================================
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) { (void)port; }
+    ~AsyncWebServer() {
+        for (auto* handler : owned_) delete handler;
+    }
+
+    void begin() {}
+
+    AsyncWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction on_request,
+                        ArUploadHandlerFunction on_upload = nullptr, ArBodyHandlerFunction on_body = nullptr) {
+        (void)on_upload;
+        AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler(uri, method, on_request, on_body);
+        owned_.push_back(handler);
+        handlers_.push_back(handler);
+        return *handler;
+    }
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler) {
+        handlers_.push_back(handler);
+        return *handler;
+    }
+    void onNotFound(ArRequestHandlerFunction fn) { not_found_ = fn; }
+
+    // Fake controls
+    int last_code = 0;
+    String last_body;
+    std::map<std::string, std::string> response_headers;
+    AsyncEventSourceClient* last_event_client = nullptr;
+
+    // Runs the handler; the response is still to be sent. Delete the
+    // request to close the connection.
+    AsyncWebServerRequest* fake_open(WebRequestMethod method, const char* uri,
+                                     const std::map<std::string, std::string>& args = {},
+                                     const std::map<std::string, std::string>& headers = {}) {
+        AsyncWebServerRequest* request = new AsyncWebServerRequest(method, uri, args, headers);
+        for (auto* handler : handlers_) {
+            if (!handler->filter(request) || !handler->canHandle(request)) continue;
+            handler->handleRequest(request);
+            return request;
+        }
+        if (not_found_) {
+            not_found_(request);
+        } else {
+            request->send(404);
+        }
+        return request;
+    }
+
+    // Sends up to window bytes of the response body; false once it is complete
+    static bool fake_pump(AsyncWebServerRequest* request, std::string& body, size_t window) {
+        if (!request->response_) return false;
+        std::string piece = request->response_->fake_next(window);
+        body += piece;
+        return !piece.empty();
+    }
+
+    // One whole request/response. False when no handler took it (404).
+    bool fake_request(WebRequestMethod method, const char* uri,
+                      const std::map<std::string, std::string>& args = {},
+                      const std::map<std::string, std::string>& headers = {}) {
+        AsyncWebServerRequest* request = fake_open(method, uri, args, headers);
+        std::string body;
+        while (fake_pump(request, body, 1436)) {  // one TCP segment at a time
+        }
+        last_event_client = request->event_client_;
+        last_code = request->response_ ? request->response_->code_ : (last_event_client ? 200 : 0);
+        last_body = String();
+        last_body.concat(body.data(), (unsigned int)body.size());
+        response_headers = request->response_ ? request->response_->headers_ : std::map<std::string, std::string>();
+        bool found = last_code != 404;
+        delete request;
+        return found;
+    }
+
+private:
+    std::vector<AsyncWebHandler*> handlers_;
+    std::vector<AsyncWebHandler*> owned_;
+    ArRequestHandlerFunction not_found_;
+};
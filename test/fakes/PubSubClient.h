@@ -0,0 +1,55 @@
+/**
+ * Host stand-in for PubSubClient ([env:native] only).
+ *
+ * Records publish traffic instead of talking to a broker so benchmarks can
+ * count messages and bytes per operation.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+class PubSubClient {
+public:
+    explicit PubSubClient(WiFiClient& client) { (void)client; }
+
+    // Fake controls
+    bool fake_connected = false;
+    bool fake_connect_result = true;
+    uint32_t publish_count = 0;
+    uint32_t publish_bytes = 0;
+    uint32_t subscribe_count = 0;
+    String last_topic;
+    String last_payload;
+
+    PubSubClient& setServer(const char* domain, uint16_t port) { (void)domain; (void)port; return *this; }
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE) { callback_ = callback; return *this; }
+    bool setBufferSize(uint16_t size) { (void)size; return true; }
+
+    bool connect(const char* id) { (void)id; fake_connected = fake_connect_result; return fake_connected; }
+    bool connect(const char* id, const char* user, const char* pass) { (void)user; (void)pass; return connect(id); }
+    void disconnect() { fake_connected = false; }
+    bool connected() { return fake_connected; }
+    int state() { return fake_connected ? 0 : -2; }
+    bool loop() { return fake_connected; }
+
+    bool publish(const char* topic, const char* payload, bool retained = false) {
+        (void)retained;
+        if (!fake_connected) return false;
+        publish_count++;
+        publish_bytes += strlen(topic) + strlen(payload);
+        last_topic = topic;
+        last_payload = payload;
+        return true;
+    }
+    bool subscribe(const char* topic) { (void)topic; subscribe_count++; return fake_connected; }
+
+    void fake_reset_counters() { publish_count = 0; publish_bytes = 0; subscribe_count = 0; }
+
+private:
+    std::function<void(char*, uint8_t*, unsigned int)> callback_;
+};
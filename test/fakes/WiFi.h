@@ -0,0 +1,16 @@
+/**
+ * Host stand-in for the ESP32 WiFi library ([env:native] only).
+ *
+ * main.cpp reaches the radio through hal.h; only the client type that
+ * PubSubClient needs is provided here.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class WiFiClient {
+public:
+    bool connected() { return false; }
+    void stop() {}
+};
@@ -0,0 +1,558 @@
+/**
+ * Vaxthus_Master_V3 - Loop hot-path benchmarks
+ *
+ * Host build only:  pio test -e native -f test_bench_loop -v
+ *
+ * Times the functions loop() and its handlers spend their life in, and
+ * counts the side effects (MQTT publishes, NVS writes) per call. /status
+ * is timed cached, re-rendered and revalidated. A Home Assistant scene is
+ * timed as one combined-light command against one command per channel,
+ * discovery as prebuilt payloads against building them. Paths
+ * that cross the light task queue are timed end to end. Figures
+ * are host CPU time: compare them between commits, they are not ESP32
+ * cycle counts. A command arriving mid sun fade must not wait for the
+ * fade. setup() runs with power save on, the last test checks
+ * what that holds and reports.
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <vector>
+
+#include "hal.h"
+#include "telemetry_log.h"
+#include <ArduinoJson.h>
+#include <PubSubClient.h>
+#include <ESPAsyncWebServer.h>
+
+extern AsyncWebServer server;
+extern PubSubClient mqtt;
+
+void setup();
+void loop();
+void update_sun_simulation();
+void light_control_step(bool periodic = true);
+void process_light_state();
+void events_loop();
+void mqtt_callback(char* topic, byte* payload, unsigned int length);
+void set_light(uint8_t channel, uint8_t value);
+uint32_t light_idle_ms();
+void status_step();
+extern uint32_t status_version;
+extern uint32_t status_renders;
+extern uint8_t light_levels[];
+extern bool autoMode;
+void init_ha_discovery();
+void publish_ha_discovery();
+struct HaDiscovery {
+    char topic[80];
+    const char* payload;
+};
+extern HaDiscovery ha_discovery[];
+
+#define BENCH_ITERATIONS 20000
+
+struct BenchResult {
+    double ns_per_call;
+    double publishes_per_call;
+    double nvs_writes_per_call;
+};
+
+template <typename F>
+static BenchResult bench(uint32_t iterations, F fn) {
+    mqtt.fake_reset_counters();
+    uint32_t nvs_before = hal_fake_nvs_writes();
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) fn(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    BenchResult r;
+    r.ns_per_call = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    r.publishes_per_call = (double)mqtt.publish_count / iterations;
+    r.nvs_writes_per_call = (double)(hal_fake_nvs_writes() - nvs_before) / iterations;
+    return r;
+}
+
+static void report(const char* name, const BenchResult& r) {
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%-24s %10.1f ns/call  %5.2f publish/call  %5.2f nvs-write/call",
+             name, r.ns_per_call, r.publishes_per_call, r.nvs_writes_per_call);
+    TEST_MESSAGE(msg);
+}
+
+void setUp() {
+    mqtt.fake_connected = true;
+}
+
+void tearDown() {
+}
+
+void test_bench_update_sun_simulation() {
+    BenchResult r = bench(BENCH_ITERATIONS, [](uint32_t i) {
+        uint32_t minute_of_day = (i * 7) % 1440;  // sweep night, ramps and day
+        hal_fake_set_local_time(minute_of_day / 60, minute_of_day % 60);
+        hal_fake_advance_millis(60001);
+        update_sun_simulation();
+        process_light_state();
+    });
+    report("update_sun_simulation", r);
+    TEST_ASSERT_TRUE(r.ns_per_call > 0);
+}
+
+void test_bench_mqtt_callback() {
+    char topic[] = "bastun/vaxtljus/white/set";
+    BenchResult r = bench(BENCH_ITERATIONS, [&](uint32_t i) {
+        char payload[4];
+        int len = snprintf(payload, sizeof(payload), "%u", (unsigned)(i % 256));
+        mqtt_callback(topic, (byte*)payload, len);
+        light_control_step();  // command → PWM on the light side
+        process_light_state();  // publish + persist on the network side
+    });
+    report("mqtt_callback", r);
+    TEST_ASSERT_TRUE(r.ns_per_call > 0);
+}
+
+void test_bench_index_page() {
+    size_t bytes = 0;
+    BenchResult r = bench(BENCH_ITERATIONS, [&](uint32_t) {
+        server.fake_request(HTTP_GET, "/");
+        bytes += server.last_body.length();
+    });
+    report("GET /", r);
+    TEST_ASSERT_TRUE(bytes > 0);
+}
+
+void test_bench_index_page_revalidate() {
+    server.fake_request(HTTP_GET, "/");
+    std::map<std::string, std::string> headers = {{"If-None-Match", server.response_headers["ETag"]}};
+    int not_modified = 0;
+    BenchResult r = bench(BENCH_ITERATIONS, [&](uint32_t) {
+        server.fake_request(HTTP_GET, "/", {}, headers);
+        if (server.last_code == 304) not_modified++;
+    });
+    report("GET / (If-None-Match)", r);
+    TEST_ASSERT_EQUAL(BENCH_ITERATIONS, not_modified);
+}
+
+void test_bench_status_handler() {
+    int ok = 0;
+    BenchResult r = bench(BENCH_ITERATIONS, [&](uint32_t) {
+        server.fake_request(HTTP_GET, "/status");
+        if (server.last_code == 200) ok++;
+    });
+    report("GET /status", r);
+    TEST_ASSERT_EQUAL(BENCH_ITERATIONS, ok);
+}
+
+// Every request after a state change: the old per-request cost
+void test_bench_status_render() {
+    int ok = 0;
+    BenchResult r = bench(BENCH_ITERATIONS, [&](uint32_t) {
+        status_version++;
+        server.fake_request(HTTP_GET, "/status");
+        if (server.last_code == 200) ok++;
+    });
+    report("GET /status (re-render)", r);
+    TEST_ASSERT_EQUAL(BENCH_ITERATIONS, ok);
+}
+
+void test_bench_status_revalidate() {
+    server.fake_request(HTTP_GET, "/status");
+    std::map<std::string, std::string> headers = {{"If-None-Match", server.response_headers["ETag"]}};
+    int not_modified = 0;
+    BenchResult r = bench(BENCH_ITERATIONS, [&](uint32_t) {
+        server.fake_request(HTTP_GET, "/status", {}, headers);
+        if (server.last_code == 304) not_modified++;
+    });
+    report("GET /status (If-None-Match)", r);
+    TEST_ASSERT_EQUAL(BENCH_ITERATIONS, not_modified);
+    TEST_ASSERT_EQUAL_UINT32(0, server.last_body.length());
+}
+
+// A light change reaches the next poll: new ETag, new body
+void test_status_follows_state() {
+    server.fake_request(HTTP_GET, "/status");
+    std::map<std::string, std::string> headers = {{"If-None-Match", server.response_headers["ETag"]}};
+    uint32_t renders = status_renders;
+
+    set_light(1, 123);
+    light_control_step();
+    process_light_state();
+    status_step();
+    server.fake_request(HTTP_GET, "/status", {}, headers);
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+    TEST_ASSERT_TRUE(server.response_headers["ETag"] != headers["If-None-Match"]);
+    JsonDocument doc;
+    deserializeJson(doc, server.last_body.c_str());
+    TEST_ASSERT_EQUAL_INT(123, doc["red"].as<int>());
+    TEST_ASSERT_EQUAL_UINT32(renders + 1, status_renders);
+
+    // And the new tag holds until something moves again - counters and
+    // signal strength are /metrics' business, however long the poll waits
+    headers["If-None-Match"] = server.response_headers["ETag"];
+    status_step();
+    server.fake_request(HTTP_GET, "/status", {}, headers);
+    TEST_ASSERT_EQUAL_INT(304, server.last_code);
+    hal_fake_set_wifi(hal_wifi_connected(), hal_wifi_rssi() - 7);
+    hal_fake_advance_millis(30000);
+    status_step();
+    server.fake_request(HTTP_GET, "/status", {}, headers);
+    TEST_ASSERT_EQUAL_INT(304, server.last_code);
+    TEST_ASSERT_EQUAL_UINT32(renders + 1, status_renders);
+}
+
+void test_bench_events_push() {
+    AsyncEventSourceClient* subscribers[4];
+    for (auto& client : subscribers) {
+        server.fake_request(HTTP_GET, "/events");
+        client = server.last_event_client;
+        TEST_ASSERT_NOT_NULL(client);
+    }
+    char topic[] = "bastun/vaxtljus/red/set";
+    BenchResult r = bench(BENCH_ITERATIONS, [&](uint32_t i) {
+        char payload[4];
+        int len = snprintf(payload, sizeof(payload), "%u", (unsigned)(i % 256));
+        mqtt_callback(topic, (byte*)payload, len);
+        light_control_step();
+        process_light_state();
+        events_loop();  // one delta to 4 subscribers
+        for (auto* client : subscribers) client->sent.clear();
+    });
+    report("events push (4 clients)", r);
+    for (auto* client : subscribers) {
+        TEST_ASSERT_TRUE(client->connected());
+        client->close();
+    }
+}
+
+// Load generator: slow readers hold streamed downloads open (one 536-byte
+// segment per client per loop() pass) while a fast client polls /status.
+// The old blocking server spent each whole transfer inside loop().
+void test_bench_concurrent_clients() {
+    for (int i = 0; i < 2000; i++) {
+        TelemetryRecord record = {};
+        record.event = TELEMETRY_HEARTBEAT;
+        telemetry_append(record);
+    }
+    const int slow_clients = 8;
+    std::vector<AsyncWebServerRequest*> slow;
+    std::vector<std::string> bodies(slow_clients);
+    slow.push_back(server.fake_open(HTTP_GET, "/simulate", {{"date", "2026-06-21"}, {"days", "7"}, {"step", "60"}}));
+    for (int i = 1; i < slow_clients; i++) slow.push_back(server.fake_open(HTTP_GET, "/telemetry.csv"));
+
+    std::vector<double> loop_ns, status_ns;
+    int open = slow_clients;
+    while (open > 0) {
+        auto start = std::chrono::steady_clock::now();
+        loop();
+        auto mid = std::chrono::steady_clock::now();
+        server.fake_request(HTTP_GET, "/status");
+        auto end = std::chrono::steady_clock::now();
+        TEST_ASSERT_EQUAL_INT(200, server.last_code);
+        loop_ns.push_back(std::chrono::duration<double, std::nano>(mid - start).count());
+        status_ns.push_back(std::chrono::duration<double, std::nano>(end - mid).count());
+
+        open = 0;
+        for (int i = 0; i < slow_clients; i++) open += AsyncWebServer::fake_pump(slow[i], bodies[i], 536);
+    }
+    for (auto* request : slow) delete request;
+
+    std::sort(loop_ns.begin(), loop_ns.end());
+    std::sort(status_ns.begin(), status_ns.end());
+    size_t bytes = 0;
+    for (auto& body : bodies) bytes += body.size();
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%d streams, %zu KB over %zu loop() passes", slow_clients, bytes / 1024,
+             loop_ns.size());
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "loop() under load          p50 %8.1f ns  p99 %8.1f ns  max %8.1f ns",
+             loop_ns[loop_ns.size() / 2], loop_ns[loop_ns.size() * 99 / 100], loop_ns.back());
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "GET /status under load     p50 %8.1f ns  p99 %8.1f ns  max %8.1f ns",
+             status_ns[status_ns.size() / 2], status_ns[status_ns.size() * 99 / 100], status_ns.back());
+    TEST_MESSAGE(msg);
+
+    // Every stream completed and matches what a single fast client gets
+    TEST_ASSERT_EQUAL_INT(7 * 1440 + 1, std::count(bodies[0].begin(), bodies[0].end(), '\n'));
+    server.fake_request(HTTP_GET, "/telemetry.csv");
+    for (int i = 1; i < slow_clients; i++) TEST_ASSERT_TRUE(bodies[i] == server.last_body.c_str());
+}
+
+// ============================================================================
+// HOME ASSISTANT
+// ============================================================================
+static void mqtt_message(const char* topic, const char* payload) {
+    char topic_buf[64];
+    snprintf(topic_buf, sizeof(topic_buf), "%s", topic);
+    mqtt_callback(topic_buf, (byte*)payload, strlen(payload));
+    light_control_step();
+    process_light_state();
+}
+
+// The same scene: three template lights, or the combined light once
+void test_bench_ha_scene() {
+    BenchResult per_channel = bench(BENCH_ITERATIONS, [](uint32_t i) {
+        mqtt_message("bastun/vaxtljus/white/set", (i & 1) ? "200" : "100");
+        mqtt_message("bastun/vaxtljus/red/set", (i & 1) ? "128" : "100");
+        mqtt_message("bastun/vaxtljus/uv/set", (i & 1) ? "60" : "40");
+    });
+    report("HA scene, 3 lights", per_channel);
+    uint8_t uv = light_levels[2];
+    BenchResult combined = bench(BENCH_ITERATIONS, [](uint32_t i) {
+        mqtt_message("bastun/vaxtljus/light/set", (i & 1)
+            ? "{\"state\":\"ON\",\"brightness\":200,\"color\":{\"r\":163,\"g\":0,\"b\":0,\"w\":255}}"
+            : "{\"state\":\"ON\",\"brightness\":100,\"color\":{\"r\":255,\"g\":0,\"b\":0,\"w\":255}}");
+    });
+    report("HA scene, combined light", combined);
+    TEST_ASSERT_TRUE(combined.publishes_per_call * 3 <= per_channel.publishes_per_call + 0.01);
+
+    // Last iteration was odd: white 200, red 163·200/255; UV is not part of the combined light
+    TEST_ASSERT_EQUAL_UINT8(200, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT8(128, light_levels[1]);
+    TEST_ASSERT_EQUAL_UINT8(uv, light_levels[2]);
+    TEST_ASSERT_FALSE(autoMode);
+}
+
+void test_ha_light_state_and_effects() {
+    mqtt_message("bastun/vaxtljus/light/set", "{\"state\":\"ON\",\"brightness\":255,\"color\":{\"r\":0,\"w\":255}}");
+    mqtt_message("bastun/vaxtljus/uv/set", "255");
+    TEST_ASSERT_EQUAL_UINT8(255, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, light_levels[1]);
+    TEST_ASSERT_EQUAL_UINT8(204, light_levels[2]);  // the UV limiter applies: 80 % of white
+
+    // UV keeps its own entity: it is in no colour component
+    JsonDocument state;
+    TEST_ASSERT_FALSE(deserializeJson(state, mqtt.last_payload.c_str()));
+    TEST_ASSERT_EQUAL_STRING("ON", state["state"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("rgbw", state["color_mode"].as<const char*>());
+    TEST_ASSERT_EQUAL_UINT8(255, state["brightness"].as<uint8_t>());
+    TEST_ASSERT_EQUAL_UINT8(255, state["color"]["w"].as<uint8_t>());
+    TEST_ASSERT_EQUAL_UINT8(0, state["color"]["b"].as<uint8_t>());
+    TEST_ASSERT_EQUAL_STRING("Manual", state["effect"].as<const char*>());
+    TEST_ASSERT_EQUAL_UINT8(204, state["uv"].as<uint8_t>());  // the per-channel lights' keys stay
+
+    // Brightness alone keeps the colour; OFF and back ON restores it
+    mqtt_message("bastun/vaxtljus/light/set", "{\"brightness\":51}");
+    TEST_ASSERT_EQUAL_UINT8(51, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT8(41, light_levels[2]);  // still limited by white
+    mqtt_message("bastun/vaxtljus/light/set", "{\"state\":\"OFF\"}");
+    TEST_ASSERT_EQUAL_UINT8(0, light_levels[0]);
+    mqtt_message("bastun/vaxtljus/light/set", "{\"state\":\"ON\"}");
+    TEST_ASSERT_EQUAL_UINT8(51, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, light_levels[1]);
+
+    // The base colour is read from the levels when the command arrives, so a
+    // change made on a per-channel topic is kept
+    mqtt_message("bastun/vaxtljus/red/set", "51");
+    mqtt_message("bastun/vaxtljus/light/set", "{\"brightness\":102}");
+    TEST_ASSERT_EQUAL_UINT8(102, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT8(102, light_levels[1]);
+
+    mqtt_message("bastun/vaxtljus/light/set", "{\"state\":\"ON\",\"effect\":\"Sun simulation\"}");
+    TEST_ASSERT_TRUE(autoMode);
+    TEST_ASSERT_FALSE(deserializeJson(state, mqtt.last_payload.c_str()));
+    TEST_ASSERT_EQUAL_STRING("Sun simulation", state["effect"].as<const char*>());
+    uint8_t white = light_levels[0], red = light_levels[1];
+    mqtt_message("bastun/vaxtljus/light/set", "{\"effect\":\"Manual\"}");
+    TEST_ASSERT_FALSE(autoMode);
+    TEST_ASSERT_EQUAL_UINT8(white, light_levels[0]);  // the sun's levels, held
+    TEST_ASSERT_EQUAL_UINT8(red, light_levels[1]);
+    mqtt_message("bastun/vaxtljus/light/set", "{\"effect\":\"Disco\"}");
+    TEST_ASSERT_FALSE(autoMode);
+
+    // OFF wins over an effect; Manual alone keeps an off light off
+    mqtt_message("bastun/vaxtljus/light/set", "{\"brightness\":102}");
+    mqtt_message("bastun/vaxtljus/light/set", "{\"state\":\"OFF\",\"effect\":\"Sun simulation\"}");
+    TEST_ASSERT_EQUAL_UINT8(0, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, light_levels[1]);
+    TEST_ASSERT_FALSE(autoMode);
+    mqtt_message("bastun/vaxtljus/light/set", "{\"effect\":\"Manual\"}");
+    TEST_ASSERT_EQUAL_UINT8(0, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, light_levels[1]);
+    TEST_ASSERT_FALSE(deserializeJson(state, mqtt.last_payload.c_str()));
+    TEST_ASSERT_EQUAL_STRING("OFF", state["state"].as<const char*>());
+}
+
+// Payloads are built once at boot; HA coming online gets them again as they are
+void test_bench_ha_discovery() {
+    BenchResult build = bench(BENCH_ITERATIONS / 10, [](uint32_t) { init_ha_discovery(); });
+    report("HA discovery, build", build);
+    BenchResult publish = bench(BENCH_ITERATIONS / 10, [](uint32_t) { publish_ha_discovery(); });
+    report("HA discovery, publish", publish);
+    TEST_ASSERT_TRUE(publish.ns_per_call < build.ns_per_call);
+
+    server.fake_request(HTTP_GET, "/status");
+    JsonDocument status;
+    TEST_ASSERT_FALSE(deserializeJson(status, server.last_body.c_str()));
+    JsonDocument light;
+    TEST_ASSERT_FALSE(deserializeJson(light, ha_discovery[0].payload));
+    TEST_ASSERT_EQUAL_STRING("homeassistant/light/vaxthus_light/config", ha_discovery[0].topic);
+    TEST_ASSERT_EQUAL_STRING("json", light["schema"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("bastun/vaxtljus/light/set", light["command_topic"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING(status["firmware"].as<const char*>(), light["device"]["sw_version"].as<const char*>());
+    JsonDocument white;
+    TEST_ASSERT_FALSE(deserializeJson(white, ha_discovery[1].payload));
+    TEST_ASSERT_EQUAL_STRING("{{ value_json.white }}", white["brightness_template"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("{% if value_json.white | int > 0 %}on{% else %}off{% endif %}",
+                             white["state_template"].as<const char*>());
+
+    mqtt.fake_reset_counters();
+    char topic[] = "homeassistant/status";
+    char online[] = "online";
+    mqtt_callback(topic, (byte*)online, strlen(online));
+    TEST_ASSERT_EQUAL_UINT32(5 + 1, mqtt.publish_count);  // 2 + one per channel, then the state
+    mqtt_callback(topic, (byte*)"offline", 7);
+    TEST_ASSERT_EQUAL_UINT32(5 + 1, mqtt.publish_count);
+}
+
+// ============================================================================
+// FADES
+// ============================================================================
+// The LEDC driver blocks a write on a channel mid-fade (the fake skips the
+// clock past it and counts a stall): a command arriving during a sun fade
+// is held, and goes out on the first tick after the fade
+void test_command_during_sun_fade() {
+    hal_fake_set_local_time(8, 0);
+    server.fake_request(HTTP_GET, "/exitManual");
+    for (int i = 0; i < 200; i++) {
+        hal_fake_advance_millis(10);
+        loop();
+    }
+    hal_fake_set_local_time(8, 30);  // sunrise: a new, higher target on the next sun step
+    uint32_t start = hal_millis();
+    uint32_t duty = hal_fake_pwm_duty(0);
+    while (hal_fake_pwm_duty(0) == duty && hal_millis() - start < 11000) {
+        hal_fake_advance_millis(10);
+        loop();
+    }
+    TEST_ASSERT_EQUAL_UINT32(1000, hal_fake_pwm_fade_ms(0));
+    uint32_t sun_duty = hal_fake_pwm_duty(0);
+    uint32_t fade_start = hal_millis();
+    uint32_t stalls = hal_fake_pwm_stalls();
+
+    hal_fake_advance_millis(300);
+    set_light(0, 255);
+    loop();
+    TEST_ASSERT_TRUE(hal_millis() - fade_start < 1000);          // nothing waited for the fade
+    TEST_ASSERT_EQUAL_UINT8(255, light_levels[0]);
+    TEST_ASSERT_EQUAL_UINT32(sun_duty, hal_fake_pwm_duty(0));   // held
+    while (hal_fake_pwm_duty(0) == sun_duty && hal_millis() - fade_start < 2000) {
+        hal_fake_advance_millis(10);
+        loop();
+    }
+    TEST_ASSERT_UINT_WITHIN(10, fade_start + 1001, hal_millis());
+    TEST_ASSERT_EQUAL_UINT32(300, hal_fake_pwm_fade_ms(0));
+    TEST_ASSERT_EQUAL_UINT32(stalls, hal_fake_pwm_stalls());
+    TEST_ASSERT_FALSE(autoMode);
+}
+
+// ============================================================================
+// POWER SAVE
+// ============================================================================
+static int awake_holds() {
+    return hal_fake_power_holds(true);
+}
+
+void test_power_save_holds() {
+    loop();  // station up: AP off, modem sleep on
+    TEST_ASSERT_FALSE(hal_fake_ap_running());
+    TEST_ASSERT_TRUE(hal_fake_wifi_sleep());
+
+    // Night, all outputs off: nothing keeps the chip awake, loop() holds
+    // the full clock only while it runs
+    hal_fake_set_local_time(2, 0);
+    server.fake_request(HTTP_GET, "/exitManual");
+    loop();  // sun fade down, each output's held until its last manual fade ends
+    for (int i = 0; i < 4 && awake_holds(); i++) {
+        hal_fake_advance_millis(light_idle_ms());
+        loop();
+    }
+    TEST_ASSERT_EQUAL_INT(0, awake_holds());
+    TEST_ASSERT_EQUAL_INT(0, hal_fake_power_holds(false));
+
+    // Mid duty freezes in light sleep: held while lit and while fading out
+    set_light(0, 128);
+    loop();
+    TEST_ASSERT_EQUAL_INT(1, awake_holds());
+    set_light(0, 0);
+    loop();
+    TEST_ASSERT_EQUAL_INT(1, awake_holds());
+    TEST_ASSERT_TRUE(light_idle_ms() < 300);  // the light task wakes when the fade ends
+    hal_fake_advance_millis(light_idle_ms());
+    loop();  // the held 0 fades out now
+    TEST_ASSERT_EQUAL_INT(1, awake_holds());
+    hal_fake_advance_millis(light_idle_ms());
+    loop();
+    TEST_ASSERT_EQUAL_INT(0, awake_holds());
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_stalls());
+
+    // Fully on is as steady as off
+    set_light(0, 255);
+    for (int i = 0; i < 40; i++) loop();
+    TEST_ASSERT_EQUAL_INT(0, awake_holds());
+    set_light(0, 0);
+    TEST_ASSERT_EQUAL_INT(0, hal_fake_power_holds(false));
+}
+
+void test_power_report() {
+    server.fake_request(HTTP_GET, "/exitManual");
+    uint32_t start = hal_millis();
+    while (hal_millis() - start < 121000) loop();  // at least one whole report window
+
+    server.fake_request(HTTP_GET, "/status");
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, server.last_body.c_str()));
+    TEST_ASSERT_EQUAL_STRING("light_sleep", doc["power_mode"].as<const char*>());
+
+    // loop() polls every 10 ms for the inline light step on this build
+    server.fake_request(HTTP_GET, "/metrics");
+    const char* body = server.last_body.c_str();
+    TEST_ASSERT_NOT_NULL(strstr(body, "vaxthus_power_mode 2"));
+    double window = atof(strstr(body, "\nvaxthus_power_window_seconds ") + 30);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 60.0f, window);
+    uint32_t wakes = atol(strstr(body, "vaxthus_wakes{task=\"loop\"} ") + 27) * 60 / window;
+    TEST_ASSERT_UINT_WITHIN(600, 6000, wakes);
+    TEST_ASSERT_TRUE(atol(strstr(body, "vaxthus_wakes{task=\"light_task\"} ") + 33) > 0);
+    uint32_t duty = atol(strstr(body, "vaxthus_cpu_duty_permille{task=\"loop\"} ") + 39);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "power window: loop %u wakes/min, %.1f%% busy (host time on the fake clock)",
+             (unsigned)wakes, duty / 10.0);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    hal_fake_reset();
+    Serial.muted = true;
+    hal_nvs_put_string("SSID", "greenhouse");
+    hal_nvs_put_bool("POWERSAVE", true);
+    setup();
+    hal_fake_set_wifi(true, -58);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_update_sun_simulation);
+    RUN_TEST(test_bench_mqtt_callback);
+    RUN_TEST(test_bench_index_page);
+    RUN_TEST(test_bench_index_page_revalidate);
+    RUN_TEST(test_bench_status_handler);
+    RUN_TEST(test_bench_status_render);
+    RUN_TEST(test_bench_status_revalidate);
+    RUN_TEST(test_status_follows_state);
+    RUN_TEST(test_bench_events_push);
+    RUN_TEST(test_bench_concurrent_clients);
+    RUN_TEST(test_bench_ha_scene);
+    RUN_TEST(test_ha_light_state_and_effects);
+    RUN_TEST(test_bench_ha_discovery);
+    RUN_TEST(test_command_during_sun_fade);
+    RUN_TEST(test_power_save_holds);
+    RUN_TEST(test_power_report);
+    return UNITY_END();
+}
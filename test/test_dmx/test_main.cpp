@@ -0,0 +1,429 @@
+/**
+ * Vaxthus_Master_V3 - Art-Net / sACN receiver tests
+ *
+ * Host build only:  pio test -e native -f test_dmx -v
+ *
+ * Packet parsing and rejects for both protocols, sequence and address
+ * mapping, a fuzz pass over truncated and corrupted packets, then the
+ * firmware receiving ArtDmx from a loopback UDP sender: frames on the
+ * outputs without a fade, out of order packets dropped, a stream starting
+ * mid sun fade, and the schedule back after the stream goes quiet.
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dmx_packet.h"
+#include "hal.h"
+
+void setup();
+void loop();
+extern bool dmx_active;
+extern std::atomic<uint32_t> dmx_frames;
+extern std::atomic<uint32_t> dmx_rejected;
+
+#define CH_WHITE 0
+#define CH_RED   1
+#define CH_UV    2
+#define DUTY_MAX 4095
+
+// ArtDmx with `slots` values
+static size_t artdmx(uint8_t* p, uint16_t universe, uint8_t sequence, const uint8_t* data, uint16_t slots) {
+    memcpy(p, "Art-Net", 8);
+    p[8] = 0x00;  // OpDmx, little endian
+    p[9] = 0x50;
+    p[10] = 0;
+    p[11] = 14;
+    p[12] = sequence;
+    p[13] = 0;
+    p[14] = universe & 0xFF;
+    p[15] = universe >> 8;
+    p[16] = slots >> 8;
+    p[17] = slots & 0xFF;
+    memcpy(p + 18, data, slots);
+    return 18 + slots;
+}
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    put16(p, v >> 16);
+    put16(p + 2, v & 0xFFFF);
+}
+
+// E1.31 data packet with `slots` values
+static size_t sacn(uint8_t* p, uint16_t universe, uint8_t sequence, const uint8_t* data, uint16_t slots,
+                   uint8_t options = 0) {
+    size_t length = 126 + slots;
+    memset(p, 0, length);
+    const uint8_t preamble[16] = {0x00, 0x10, 0x00, 0x00, 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+    memcpy(p, preamble, sizeof(preamble));
+    put16(p + 16, 0x7000 | (length - 16));
+    put32(p + 18, 4);
+    put16(p + 38, 0x7000 | (length - 38));
+    put32(p + 40, 2);
+    memcpy(p + 44, "desk", 5);
+    p[108] = 100;
+    p[111] = sequence;
+    p[112] = options;
+    put16(p + 113, universe);
+    put16(p + 115, 0x7000 | (length - 115));
+    p[117] = 0x02;
+    p[118] = 0xA1;
+    put16(p + 119, 0);
+    put16(p + 121, 1);
+    put16(p + 123, slots + 1);
+    p[125] = 0;
+    memcpy(p + 126, data, slots);
+    return length;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// PARSER
+// ============================================================================
+void test_artnet_parse() {
+    uint8_t packet[DMX_PACKET_MAX];
+    uint8_t data[512];
+    for (int i = 0; i < 512; i++) data[i] = (uint8_t)i;
+    size_t length = artdmx(packet, 0x1234, 7, data, 512);
+
+    DmxPacket p;
+    TEST_ASSERT_TRUE(dmx_parse(DMX_ARTNET, packet, length, &p));
+    TEST_ASSERT_EQUAL_UINT16(512, p.slots);
+    TEST_ASSERT_EQUAL_UINT16(0x1234, p.universe);
+    TEST_ASSERT_EQUAL_UINT8(7, p.sequence);
+    TEST_ASSERT_TRUE(p.data == packet + 18);  // in place, not copied
+    TEST_ASSERT_EQUAL_UINT8(100, p.data[100]);
+    TEST_ASSERT_FALSE(p.terminated);
+
+    // Not an sACN packet, and not a DMX packet for the wrong protocol version
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length, &p));
+    TEST_ASSERT_FALSE(dmx_parse(DMX_OFF, packet, length, &p));
+    packet[11] = 13;
+    TEST_ASSERT_FALSE(dmx_parse(DMX_ARTNET, packet, length, &p));
+}
+
+void test_artnet_rejects() {
+    uint8_t packet[DMX_PACKET_MAX];
+    uint8_t data[16] = {};
+    DmxPacket p;
+
+    size_t length = artdmx(packet, 0, 0, data, 16);
+    TEST_ASSERT_FALSE(dmx_parse(DMX_ARTNET, packet, length - 1, &p));  // length field past the end
+    packet[9] = 0x20;                                                  // OpPoll
+    TEST_ASSERT_FALSE(dmx_parse(DMX_ARTNET, packet, length, &p));
+
+    length = artdmx(packet, 0, 0, data, 16);
+    packet[7] = 'x';  // ID without its NUL
+    TEST_ASSERT_FALSE(dmx_parse(DMX_ARTNET, packet, length, &p));
+
+    length = artdmx(packet, 0, 0, data, 1);  // the spec's minimum is 2
+    TEST_ASSERT_FALSE(dmx_parse(DMX_ARTNET, packet, length, &p));
+    length = artdmx(packet, 0, 0, data, 2);
+    TEST_ASSERT_TRUE(dmx_parse(DMX_ARTNET, packet, length, &p));
+    packet[16] = 0x02;  // 512 + 2 slots
+    packet[17] = 0x02;
+    TEST_ASSERT_FALSE(dmx_parse(DMX_ARTNET, packet, sizeof(packet), &p));
+}
+
+void test_sacn_parse() {
+    uint8_t packet[DMX_PACKET_MAX];
+    uint8_t data[512];
+    for (int i = 0; i < 512; i++) data[i] = (uint8_t)(255 - i);
+    size_t length = sacn(packet, 63999, 200, data, 512);
+    TEST_ASSERT_EQUAL(DMX_PACKET_MAX, length);
+
+    DmxPacket p;
+    TEST_ASSERT_TRUE(dmx_parse(DMX_SACN, packet, length, &p));
+    TEST_ASSERT_EQUAL_UINT16(512, p.slots);
+    TEST_ASSERT_EQUAL_UINT16(63999, p.universe);
+    TEST_ASSERT_EQUAL_UINT8(200, p.sequence);
+    TEST_ASSERT_EQUAL_UINT8(100, p.priority);
+    TEST_ASSERT_TRUE(p.data == packet + 126);
+    TEST_ASSERT_EQUAL_UINT8(255, p.data[0]);
+    TEST_ASSERT_FALSE(dmx_parse(DMX_ARTNET, packet, length, &p));
+
+    length = sacn(packet, 1, 0, data, 3, 0x40);
+    TEST_ASSERT_TRUE(dmx_parse(DMX_SACN, packet, length, &p));
+    TEST_ASSERT_TRUE(p.terminated);
+    TEST_ASSERT_EQUAL_UINT16(3, p.slots);
+}
+
+void test_sacn_rejects() {
+    uint8_t packet[DMX_PACKET_MAX];
+    uint8_t data[8] = {};
+    DmxPacket p;
+    size_t length;
+
+    length = sacn(packet, 1, 0, data, 8, 0x80);  // preview data
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length, &p));
+    length = sacn(packet, 0, 0, data, 8);  // universe 0 is reserved
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length, &p));
+    length = sacn(packet, 64000, 0, data, 8);
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length, &p));
+
+    length = sacn(packet, 1, 0, data, 8);
+    packet[125] = 0xCC;  // RDM start code
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length, &p));
+    length = sacn(packet, 1, 0, data, 8);
+    put32(packet + 40, 1);  // synchronization packet
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length, &p));
+    length = sacn(packet, 1, 0, data, 8);
+    put32(packet + 18, 8);  // extended (discovery)
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length, &p));
+    length = sacn(packet, 1, 0, data, 8);
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, length - 1, &p));  // property count past the end
+    TEST_ASSERT_FALSE(dmx_parse(DMX_SACN, packet, 125, &p));
+}
+
+void test_sequence() {
+    TEST_ASSERT_TRUE(dmx_sequence_ok(DMX_SACN, 10, 11));
+    TEST_ASSERT_TRUE(dmx_sequence_ok(DMX_SACN, 255, 0));   // wraps
+    TEST_ASSERT_FALSE(dmx_sequence_ok(DMX_SACN, 10, 10));  // duplicate
+    TEST_ASSERT_FALSE(dmx_sequence_ok(DMX_SACN, 10, 0));   // 10 behind: late
+    TEST_ASSERT_FALSE(dmx_sequence_ok(DMX_SACN, 5, 242));  // 19 behind across the wrap
+    TEST_ASSERT_TRUE(dmx_sequence_ok(DMX_SACN, 30, 10));   // 20 behind: a new stream
+    TEST_ASSERT_TRUE(dmx_sequence_ok(DMX_ARTNET, 10, 0));  // Art-Net 0 = not sequenced
+    TEST_ASSERT_TRUE(dmx_sequence_ok(DMX_ARTNET, 0, 7));
+    TEST_ASSERT_FALSE(dmx_sequence_ok(DMX_ARTNET, 10, 9));
+}
+
+void test_map() {
+    uint8_t packet[DMX_PACKET_MAX];
+    uint8_t data[512];
+    for (int i = 0; i < 512; i++) data[i] = (uint8_t)(i + 1);  // slot n holds n
+    DmxPacket p;
+    uint8_t values[3] = {};
+
+    dmx_parse(DMX_ARTNET, packet, artdmx(packet, 0, 0, data, 512), &p);
+    TEST_ASSERT_EQUAL_UINT32(0x7, dmx_map(p, 1, 3, values));
+    TEST_ASSERT_EQUAL_UINT8(1, values[0]);
+    TEST_ASSERT_EQUAL_UINT8(3, values[2]);
+    TEST_ASSERT_EQUAL_UINT32(0x3, dmx_map(p, 511, 3, values));  // last two slots
+    TEST_ASSERT_EQUAL_UINT8(255, values[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, dmx_map(p, 0, 3, values));
+
+    // A short packet only reaches the channels it has slots for
+    dmx_parse(DMX_ARTNET, packet, artdmx(packet, 0, 0, data, 20), &p);
+    TEST_ASSERT_EQUAL_UINT32(0x3, dmx_map(p, 19, 3, values));
+    TEST_ASSERT_EQUAL_UINT8(20, values[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, dmx_map(p, 21, 3, values));
+}
+
+// Truncations and random byte flips of valid packets, each parsed from a
+// buffer of exactly its length (run under ASan to catch over-reads)
+void test_fuzz() {
+    uint8_t valid[2][DMX_PACKET_MAX];
+    size_t valid_length[2];
+    uint8_t data[512];
+    for (int i = 0; i < 512; i++) data[i] = (uint8_t)i;
+    valid_length[0] = artdmx(valid[0], 3, 1, data, 512);
+    valid_length[1] = sacn(valid[1], 3, 1, data, 512);
+    const DmxProtocol protocols[2] = {DMX_ARTNET, DMX_SACN};
+
+    srand(21);
+    uint32_t accepted = 0;
+    for (int i = 0; i < 20000; i++) {
+        int which = i & 1;
+        size_t length = (i % 4 < 2) ? (size_t)rand() % (valid_length[which] + 1) : valid_length[which];
+        uint8_t* buffer = (uint8_t*)malloc(length ? length : 1);
+        memcpy(buffer, valid[which], length);
+        for (int flips = rand() % 4; flips > 0 && length > 0; flips--) buffer[rand() % length] = (uint8_t)rand();
+
+        DmxPacket p;
+        if (dmx_parse(protocols[which], buffer, length, &p)) {
+            accepted++;
+            TEST_ASSERT_TRUE(p.slots >= 1 && p.slots <= DMX_SLOTS);
+            TEST_ASSERT_TRUE(p.data + p.slots <= buffer + length);
+            uint8_t values[3];
+            dmx_map(p, 512, 3, values);
+        }
+        free(buffer);
+    }
+    TEST_ASSERT_TRUE(accepted > 0);
+}
+
+// ============================================================================
+// FIRMWARE
+// ============================================================================
+// Loopback sender to the firmware's Art-Net socket
+static int sender = -1;
+
+static void send_artdmx(uint8_t sequence, uint8_t white, uint8_t red, uint8_t uv, uint16_t universe = 5) {
+    uint8_t data[16] = {};
+    data[9] = white;  // DMXADDRESS 10
+    data[10] = red;
+    data[11] = uv;
+    uint8_t packet[DMX_PACKET_MAX];
+    size_t length = artdmx(packet, universe, sequence, data, sizeof(data));
+
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(ARTNET_PORT);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL((int)length, (int)sendto(sender, packet, length, 0, (sockaddr*)&to, sizeof(to)));
+}
+
+void test_firmware_applies_frames() {
+    uint32_t frames = dmx_frames;
+    send_artdmx(1, 255, 0, 0);
+    loop();
+    TEST_ASSERT_EQUAL_UINT32(frames + 1, dmx_frames);
+    TEST_ASSERT_TRUE(dmx_active);
+    TEST_ASSERT_EQUAL_UINT32(DUTY_MAX, hal_fake_pwm_duty(CH_WHITE));
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_duty(CH_RED));
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_fade_ms(CH_WHITE));  // straight on, no fade
+
+    send_artdmx(2, 0, 255, 0);
+    loop();
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_duty(CH_WHITE));
+    TEST_ASSERT_EQUAL_UINT32(DUTY_MAX, hal_fake_pwm_duty(CH_RED));
+
+    // Another universe is ignored, a late packet is dropped
+    uint32_t rejected = dmx_rejected;
+    send_artdmx(3, 255, 255, 0, 6);
+    loop();
+    send_artdmx(1, 255, 255, 0);
+    loop();
+    TEST_ASSERT_EQUAL_UINT32(rejected + 1, dmx_rejected);
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_duty(CH_WHITE));
+    TEST_ASSERT_EQUAL_UINT32(frames + 2, dmx_frames);
+}
+
+// Quiet for DMX_TIMEOUT_MS: the night schedule (everything off) takes over
+void test_firmware_timeout_releases() {
+    send_artdmx(10, 0, 255, 0);
+    loop();
+    TEST_ASSERT_EQUAL_UINT32(DUTY_MAX, hal_fake_pwm_duty(CH_RED));
+
+    uint32_t start = hal_millis();
+    while (hal_millis() - start < 2000) loop();
+    TEST_ASSERT_TRUE(dmx_active);
+    TEST_ASSERT_EQUAL_UINT32(DUTY_MAX, hal_fake_pwm_duty(CH_RED));  // the schedule waits
+    while (hal_millis() - start < 3000) loop();
+    TEST_ASSERT_FALSE(dmx_active);
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_duty(CH_RED));
+}
+
+// A stream starting mid sun fade: the ESP32 cannot stop the fade and the
+// driver would block on it, so the frame is held (the light step does not
+// wait) and reaches the outputs on the first step after the fade
+void test_firmware_starts_during_sun_fade() {
+    hal_fake_set_local_time(8, 0);  // sunrise ramp
+    uint32_t start = hal_millis();
+    while (hal_fake_pwm_duty(CH_WHITE) == 0 && hal_millis() - start < 11000) loop();
+    TEST_ASSERT_EQUAL_UINT32(1000, hal_fake_pwm_fade_ms(CH_WHITE));
+    uint32_t sun_duty = hal_fake_pwm_duty(CH_WHITE);
+    uint32_t fade_start = hal_millis();
+    uint32_t stalls = hal_fake_pwm_stalls();
+
+    send_artdmx(20, 0, 255, 0);
+    loop();
+    TEST_ASSERT_TRUE(dmx_active);
+    TEST_ASSERT_TRUE(hal_millis() - fade_start < 100);  // nothing waited for the fade
+    TEST_ASSERT_EQUAL_UINT32(sun_duty, hal_fake_pwm_duty(CH_WHITE));
+    while (hal_fake_pwm_duty(CH_WHITE) != 0 && hal_millis() - fade_start < 2000) loop();
+    TEST_ASSERT_UINT_WITHIN(20, fade_start + 1001, hal_millis());
+    TEST_ASSERT_EQUAL_UINT32(DUTY_MAX, hal_fake_pwm_duty(CH_RED));
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_fade_ms(CH_RED));  // straight on, no fade
+    TEST_ASSERT_EQUAL_UINT32(stalls, hal_fake_pwm_stalls());
+
+    // Back to the night schedule, and its fade over, for the benchmarks
+    hal_fake_set_local_time(1, 0);
+    start = hal_millis();
+    while (hal_millis() - start < 4000) loop();
+    TEST_ASSERT_FALSE(dmx_active);
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_pwm_duty(CH_RED));
+}
+
+// ============================================================================
+// MICROBENCHMARK
+// ============================================================================
+void test_bench_parse() {
+    uint8_t packet[DMX_PACKET_MAX];
+    uint8_t data[512] = {};
+    size_t length = sacn(packet, 1, 0, data, 512);
+    const uint32_t iterations = 1000000;
+    uint32_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        packet[111] = (uint8_t)i;
+        DmxPacket p;
+        uint8_t values[3];
+        if (dmx_parse(DMX_SACN, packet, length, &p)) sum += dmx_map(p, 1, 3, values) + p.sequence;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "dmx_parse + dmx_map (sACN, 512 slots)  %8.1f ns/packet", ns / iterations);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(sum > 0);
+}
+
+// sendto() to the outputs written, through the socket, the seqlock and
+// the light step - everything but the scheduler switch on the ESP32
+void test_bench_loopback_latency() {
+    const int packets = 2000;
+    double total_ns = 0, max_ns = 0;
+    for (int i = 0; i < packets; i++) {
+        uint8_t level = (i & 1) ? 255 : 0;
+        auto start = std::chrono::steady_clock::now();
+        send_artdmx((uint8_t)(i % 255 + 1), level, 0, 0);
+        do loop();
+        while (hal_fake_pwm_duty(CH_WHITE) != (level ? DUTY_MAX : 0u));
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        total_ns += ns;
+        if (ns > max_ns) max_ns = ns;
+    }
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "UDP loopback → PWM   avg %8.1f µs  max %8.1f µs", total_ns / packets / 1000,
+             max_ns / 1000);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(total_ns / packets < 1e6);  // well under a millisecond on any host
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    hal_fake_reset();
+    Serial.muted = true;
+    hal_nvs_put_u8("DMXPROTO", DMX_ARTNET);
+    hal_nvs_put_u32("DMXUNIVERSE", 5);
+    hal_nvs_put_u32("DMXADDRESS", 10);
+    hal_fake_set_local_time(1, 0);
+    setup();
+    sender = socket(AF_INET, SOCK_DGRAM, 0);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_artnet_parse);
+    RUN_TEST(test_artnet_rejects);
+    RUN_TEST(test_sacn_parse);
+    RUN_TEST(test_sacn_rejects);
+    RUN_TEST(test_sequence);
+    RUN_TEST(test_map);
+    RUN_TEST(test_fuzz);
+    RUN_TEST(test_firmware_applies_frames);
+    RUN_TEST(test_firmware_timeout_releases);
+    RUN_TEST(test_firmware_starts_during_sun_fade);
+    RUN_TEST(test_bench_parse);
+    RUN_TEST(test_bench_loopback_latency);
+    close(sender);
+    return UNITY_END();
+}
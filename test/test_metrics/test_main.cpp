@@ -0,0 +1,206 @@
+/**
+ * Vaxthus_Master_V3 - Runtime metrics tests
+ *
+ * Host build only:  pio test -e native -f test_metrics -v
+ *
+ * Histogram bucketing, the Prometheus text format, and a /metrics scrape
+ * after a few real loop() iterations.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+
+#include "hal.h"
+#include "metrics.h"
+#include <PubSubClient.h>
+#include <ESPAsyncWebServer.h>
+
+extern AsyncWebServer server;
+extern PubSubClient mqtt;
+
+void setup();
+void loop();
+void set_light(uint8_t channel, uint8_t value);
+
+static std::string text;
+
+static void append(const char* data, size_t len, void* ctx) {
+    ((std::string*)ctx)->append(data, len);
+}
+
+static const MetricsOutput out = {append, &text};
+
+// Integer value of the first line starting with prefix, -1 if missing
+static long value_of(const std::string& body, const char* prefix) {
+    size_t at = 0;
+    while ((at = body.find(prefix, at)) != std::string::npos) {
+        if (at == 0 || body[at - 1] == '\n') return atol(body.c_str() + at + strlen(prefix));
+        at++;
+    }
+    return -1;
+}
+
+void setUp() {
+    text.clear();
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// HISTOGRAM
+// ============================================================================
+void test_buckets_are_powers_of_two() {
+    Histogram h = {"x", {}, 0, 0, 0};
+    uint32_t samples[] = {0, 1, 2, 3, 4, 5, 1000, 1024, 1025, 524288, 524289, 4000000000u};
+    for (uint32_t us : samples) histogram_observe(h, us);
+
+    TEST_ASSERT_EQUAL_UINT32(2, h.buckets[0]);   // 0, 1
+    TEST_ASSERT_EQUAL_UINT32(1, h.buckets[1]);   // 2
+    TEST_ASSERT_EQUAL_UINT32(2, h.buckets[2]);   // 3, 4
+    TEST_ASSERT_EQUAL_UINT32(1, h.buckets[3]);   // 5
+    TEST_ASSERT_EQUAL_UINT32(2, h.buckets[10]);  // 1000, 1024
+    TEST_ASSERT_EQUAL_UINT32(1, h.buckets[11]);  // 1025
+    TEST_ASSERT_EQUAL_UINT32(1, h.buckets[19]);  // 524288
+    TEST_ASSERT_EQUAL_UINT32(2, h.buckets[METRICS_BUCKETS]);  // +Inf
+    TEST_ASSERT_EQUAL_UINT32(12, h.count);
+    TEST_ASSERT_EQUAL_UINT32(4000000000u, h.max_us);
+}
+
+void test_histogram_text_format() {
+    Histogram h = {"mqtt", {}, 0, 0, 0};
+    histogram_observe(h, 3);
+    histogram_observe(h, 700);
+    metrics_header(out, "t_seconds", "histogram", "Test");
+    metrics_histogram(out, "t_seconds", "section", h);
+
+    size_t head = text.find("# HELP t_seconds Test\n# TYPE t_seconds histogram\n"
+                            "t_seconds_bucket{section=\"mqtt\",le=\"0.000001\"} 0\n"
+                            "t_seconds_bucket{section=\"mqtt\",le=\"0.000002\"} 0\n"
+                            "t_seconds_bucket{section=\"mqtt\",le=\"0.000004\"} 1\n");
+    TEST_ASSERT_EQUAL_INT(0, head);
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, text.find("t_seconds_bucket{section=\"mqtt\",le=\"0.000512\"} 1\n"
+                                                       "t_seconds_bucket{section=\"mqtt\",le=\"0.001024\"} 2\n"));
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, text.find("t_seconds_bucket{section=\"mqtt\",le=\"+Inf\"} 2\n"
+                                                       "t_seconds_sum{section=\"mqtt\"} 0.000703\n"
+                                                       "t_seconds_count{section=\"mqtt\"} 2\n"));
+}
+
+void test_values() {
+    metrics_value(out, "a_total", nullptr, nullptr, 42);
+    metrics_value(out, "rssi", nullptr, nullptr, -61);
+    metrics_seconds(out, "b_seconds", "section", "http", 2500001);
+    metrics_float(out, "elevation_degrees", nullptr, nullptr, -3.5);
+    TEST_ASSERT_EQUAL_STRING("a_total 42\nrssi -61\nb_seconds{section=\"http\"} 2.500001\nelevation_degrees -3.50\n",
+                             text.c_str());
+}
+
+// ============================================================================
+// /metrics
+// ============================================================================
+void test_scrape() {
+    mqtt.fake_connected = true;
+    for (int i = 0; i < 50; i++) loop();
+    set_light(0, 10);
+    loop();
+    hal_fake_set_heap(150000, 90000);
+
+    TEST_ASSERT_TRUE(server.fake_request(HTTP_GET, "/metrics"));
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+    std::string body = server.last_body.c_str();
+
+    // Every histogram: cumulative buckets never go down, +Inf equals _count
+    const char* sections[] = {"ota", "http", "connectivity", "mqtt", "light_state", "sun_update"};
+    for (const char* section : sections) {
+        std::string prefix = std::string("vaxthus_section_duration_seconds_bucket{section=\"") + section + "\",le=\"";
+        long previous = 0;
+        size_t at = 0;
+        int buckets = 0;
+        while ((at = body.find(prefix, at)) != std::string::npos) {
+            long v = atol(body.c_str() + body.find("} ", at) + 2);
+            TEST_ASSERT_TRUE(v >= previous);
+            previous = v;
+            buckets++;
+            at++;
+        }
+        TEST_ASSERT_EQUAL_INT(METRICS_BUCKETS + 1, buckets);
+        std::string count = std::string("vaxthus_section_duration_seconds_count{section=\"") + section + "\"} ";
+        TEST_ASSERT_EQUAL_INT(previous, value_of(body, count.c_str()));
+    }
+    TEST_ASSERT_TRUE(value_of(body, "vaxthus_loop_duration_seconds_count ") >= 51);
+    TEST_ASSERT_TRUE(value_of(body, "vaxthus_section_duration_seconds_count{section=\"sun_update\"} ") >= 1);
+
+    TEST_ASSERT_EQUAL_INT(150000, value_of(body, "vaxthus_heap_free_bytes "));
+    TEST_ASSERT_EQUAL_INT(90000, value_of(body, "vaxthus_heap_largest_free_block_bytes "));
+    TEST_ASSERT_TRUE(value_of(body, "vaxthus_mqtt_publishes_total ") >= 1);
+    TEST_ASSERT_EQUAL_INT(1, value_of(body, "vaxthus_mqtt_connected "));
+
+    // Prometheus line format: "# ..." or "<name>[{...}] <number>"
+    size_t start = 0;
+    while (start < body.size()) {
+        size_t end = body.find('\n', start);
+        TEST_ASSERT_NOT_EQUAL(std::string::npos, end);
+        std::string line = body.substr(start, end - start);
+        if (line[0] != '#') {
+            size_t space = line.rfind(' ');
+            TEST_ASSERT_NOT_EQUAL(std::string::npos, space);
+            char* rest;
+            strtod(line.c_str() + space + 1, &rest);
+            TEST_ASSERT_EQUAL_INT('\0', *rest);
+        }
+        start = end + 1;
+    }
+}
+
+// A handler that cannot get the network lock answers 503 and is counted
+void test_busy_lock_answers_503() {
+    hal_fake_net_busy(true);
+    server.fake_request(HTTP_GET, "/status");
+    hal_fake_net_busy(false);
+    TEST_ASSERT_EQUAL_INT(503, server.last_code);
+    TEST_ASSERT_EQUAL_STRING("1", server.response_headers["Retry-After"].c_str());
+
+    server.fake_request(HTTP_GET, "/metrics");
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+    TEST_ASSERT_EQUAL_INT(1, value_of(server.last_body.c_str(), "vaxthus_http_busy_total "));
+}
+
+// ============================================================================
+// MICROBENCHMARK
+// ============================================================================
+void test_bench_lap() {
+    Histogram h = {"bench", {}, 0, 0, 0};
+    const uint32_t iterations = 1000000;
+    uint32_t t = hal_cycle_count();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) t = metrics_lap(h, t);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "metrics_lap                  %8.1f ns/call (host clock read included)",
+             ns / iterations);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(iterations, h.count);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    hal_fake_reset();
+    Serial.muted = true;
+    hal_fake_set_local_time(12, 0);
+    setup();
+    hal_fake_set_wifi(true, -58);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_buckets_are_powers_of_two);
+    RUN_TEST(test_histogram_text_format);
+    RUN_TEST(test_values);
+    RUN_TEST(test_scrape);
+    RUN_TEST(test_busy_lock_answers_503);
+    RUN_TEST(test_bench_lap);
+    return UNITY_END();
+}
@@ -0,0 +1,311 @@
+/**
+ * Vaxthus_Master_V3 - MQTT command parser tests, fuzz and microbenchmarks
+ *
+ * Host build only:  pio test -e native -f test_mqtt_parser -v
+ *
+ * Levels, batch objects and the HA JSON-schema light command. The fuzz
+ * pass feeds random and mutated payloads through the parsers in
+ * exact-size heap buffers, so any read past `length` shows up under
+ * AddressSanitizer (add -fsanitize=address to build_flags to check).
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <string.h>
+#include <vector>
+
+#include "mqtt_command.h"
+
+#define FUZZ_ITERATIONS  200000
+#define BENCH_ITERATIONS 200000
+
+static const char* const NAMES[] = {"white", "red", "uv"};
+
+static bool level(const char* payload, uint8_t* out) {
+    return mqtt_parse_level((const uint8_t*)payload, strlen(payload), out);
+}
+
+static uint32_t batch(const char* payload, uint8_t* values) {
+    return mqtt_parse_batch((const uint8_t*)payload, strlen(payload), NAMES, 3, values);
+}
+
+static bool ha_light(const char* payload, HaLightCommand* cmd) {
+    return mqtt_parse_ha_light((const uint8_t*)payload, strlen(payload), cmd);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// LEVELS
+// ============================================================================
+void test_level_raw() {
+    uint8_t v = 99;
+    TEST_ASSERT_TRUE(level("0", &v));
+    TEST_ASSERT_EQUAL_UINT8(0, v);
+    TEST_ASSERT_TRUE(level("128", &v));
+    TEST_ASSERT_EQUAL_UINT8(128, v);
+    TEST_ASSERT_TRUE(level(" 255\n", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+    TEST_ASSERT_TRUE(level("300", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+    TEST_ASSERT_TRUE(level("99999999999", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+    TEST_ASSERT_TRUE(level("-5", &v));
+    TEST_ASSERT_EQUAL_UINT8(0, v);
+    TEST_ASSERT_TRUE(level("127.6", &v));
+    TEST_ASSERT_EQUAL_UINT8(128, v);
+}
+
+void test_level_percent() {
+    uint8_t v = 0;
+    TEST_ASSERT_TRUE(level("100%", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+    TEST_ASSERT_TRUE(level("50%", &v));
+    TEST_ASSERT_EQUAL_UINT8(128, v);
+    TEST_ASSERT_TRUE(level("12.5%", &v));
+    TEST_ASSERT_EQUAL_UINT8(32, v);
+    TEST_ASSERT_TRUE(level("0%", &v));
+    TEST_ASSERT_EQUAL_UINT8(0, v);
+    TEST_ASSERT_TRUE(level("150%", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+}
+
+void test_level_on_off() {
+    uint8_t v = 7;
+    TEST_ASSERT_TRUE(level("ON", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+    TEST_ASSERT_TRUE(level("off", &v));
+    TEST_ASSERT_EQUAL_UINT8(0, v);
+    TEST_ASSERT_TRUE(level("True", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+}
+
+void test_level_json() {
+    uint8_t v = 0;
+    TEST_ASSERT_TRUE(level("{\"state\":\"ON\",\"brightness\":80}", &v));
+    TEST_ASSERT_EQUAL_UINT8(80, v);
+    TEST_ASSERT_TRUE(level("{\"state\":\"OFF\",\"brightness\":80}", &v));
+    TEST_ASSERT_EQUAL_UINT8(0, v);
+    TEST_ASSERT_TRUE(level(" { \"state\" : \"ON\" } ", &v));
+    TEST_ASSERT_EQUAL_UINT8(255, v);
+    TEST_ASSERT_TRUE(level("{\"brightness\":\"40%\",\"transition\":2}", &v));
+    TEST_ASSERT_EQUAL_UINT8(102, v);
+}
+
+void test_level_rejects_garbage() {
+    uint8_t v = 42;
+    const char* bad[] = {"", " ", "abc", "12abc", "%", "-", "1.2.3", "ONN", "{", "{}", "{\"state\":}",
+                         "{\"brightness\":{\"x\":1}}", "{\"state\":\"ON\"} x", "{\"st\\\"ate\":\"ON\"}"};
+    for (const char* payload : bad) {
+        TEST_ASSERT_FALSE_MESSAGE(level(payload, &v), payload);
+    }
+    TEST_ASSERT_EQUAL_UINT8(42, v);
+}
+
+// ============================================================================
+// BATCH
+// ============================================================================
+void test_batch() {
+    uint8_t values[3] = {1, 2, 3};
+    TEST_ASSERT_EQUAL_UINT32(0x7, batch("{\"white\":200,\"red\":\"50%\",\"uv\":\"OFF\"}", values));
+    TEST_ASSERT_EQUAL_UINT8(200, values[0]);
+    TEST_ASSERT_EQUAL_UINT8(128, values[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, values[2]);
+
+    uint8_t partial[3] = {1, 2, 3};
+    TEST_ASSERT_EQUAL_UINT32(0x4, batch("{\"uv\": 10, \"fan\": 3}", partial));
+    TEST_ASSERT_EQUAL_UINT8(1, partial[0]);
+    TEST_ASSERT_EQUAL_UINT8(10, partial[2]);
+}
+
+void test_batch_is_all_or_nothing() {
+    uint8_t values[3] = {1, 2, 3};
+    TEST_ASSERT_EQUAL_UINT32(0, batch("{\"white\":200,\"red\":\"lots\"}", values));
+    TEST_ASSERT_EQUAL_UINT32(0, batch("{\"white\":200,", values));
+    TEST_ASSERT_EQUAL_UINT32(0, batch("{}", values));
+    TEST_ASSERT_EQUAL_UINT32(0, batch("200", values));
+    TEST_ASSERT_EQUAL_UINT8(1, values[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, values[1]);
+}
+
+// ============================================================================
+// HA JSON-SCHEMA LIGHT
+// ============================================================================
+void test_ha_light() {
+    HaLightCommand cmd;
+    TEST_ASSERT_TRUE(ha_light("{\"state\":\"ON\",\"brightness\":200,\"color\":{\"r\":255,\"g\":0,\"b\":64,"
+                              "\"w\":255},\"transition\":2,\"effect\":\"Manual\"}", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(HA_LIGHT_STATE | HA_LIGHT_BRIGHTNESS | HA_LIGHT_COLOR | HA_LIGHT_EFFECT, cmd.fields);
+    TEST_ASSERT_TRUE(cmd.on);
+    TEST_ASSERT_EQUAL_UINT8(200, cmd.brightness);
+    TEST_ASSERT_EQUAL_UINT8(255, cmd.rgbw[0]);
+    TEST_ASSERT_EQUAL_UINT8(64, cmd.rgbw[2]);
+    TEST_ASSERT_EQUAL_UINT8(255, cmd.rgbw[3]);
+    TEST_ASSERT_EQUAL(6, cmd.effect_length);
+    TEST_ASSERT_EQUAL(0, memcmp(cmd.effect, "Manual", 6));
+
+    TEST_ASSERT_TRUE(ha_light(" {\"state\":\"OFF\"} ", &cmd));
+    TEST_ASSERT_EQUAL_UINT8(HA_LIGHT_STATE, cmd.fields);
+    TEST_ASSERT_FALSE(cmd.on);
+
+    TEST_ASSERT_TRUE(ha_light("{\"color\":{\"w\":10}}", &cmd));  // missing components are 0
+    TEST_ASSERT_EQUAL_UINT8(HA_LIGHT_COLOR, cmd.fields);
+    TEST_ASSERT_EQUAL_UINT8(0, cmd.rgbw[0]);
+    TEST_ASSERT_EQUAL_UINT8(10, cmd.rgbw[3]);
+}
+
+void test_ha_light_rejects() {
+    HaLightCommand cmd;
+    cmd.brightness = 42;
+    const char* bad[] = {"", "ON", "{}", "{\"transition\":2}", "{\"brightness\":\"lots\"}",
+                         "{\"color\":{\"r\":{\"x\":1}}}", "{\"color\":[255,0,0]}", "{\"color\":{\"r\":255}",
+                         "{\"color\":{\"r\":\"x\"}}", "{\"state\":\"ON\"} x", "{\"state\":\"ON\",}"};
+    for (const char* payload : bad) {
+        TEST_ASSERT_FALSE_MESSAGE(ha_light(payload, &cmd), payload);
+    }
+    TEST_ASSERT_EQUAL_UINT8(42, cmd.brightness);
+
+    // The nesting is for this command only
+    uint8_t values[3];
+    TEST_ASSERT_EQUAL_UINT32(0, batch("{\"white\":1,\"color\":{\"r\":1}}", values));
+}
+
+// ============================================================================
+// TOPICS
+// ============================================================================
+void test_route_find() {
+    static const char* topics[] = {"bastun/vaxtljus/white/set", "bastun/vaxtljus/red/set", "bastun/vaxtljus/set"};
+    MqttRoute routes[3];
+    for (int i = 0; i < 3; i++) {
+        routes[i] = {mqtt_topic_hash(topics[i], strlen(topics[i])), topics[i], (int8_t)(i == 2 ? MQTT_ROUTE_BATCH : i)};
+    }
+    TEST_ASSERT_EQUAL_PTR(&routes[1], mqtt_route_find(routes, 3, "bastun/vaxtljus/red/set"));
+    TEST_ASSERT_EQUAL_PTR(&routes[2], mqtt_route_find(routes, 3, "bastun/vaxtljus/set"));
+    TEST_ASSERT_NULL(mqtt_route_find(routes, 3, "bastun/vaxtljus/uv/set"));
+    TEST_ASSERT_NULL(mqtt_route_find(routes, 3, "x/bastun/vaxtljus/red/set"));
+}
+
+// ============================================================================
+// FUZZ
+// ============================================================================
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+void test_fuzz_parsers() {
+    static const char* seeds[] = {"{\"white\":200,\"red\":\"50%\",\"uv\":\"OFF\"}",
+                                  "{\"state\":\"ON\",\"brightness\":128}", "12.5%", "ON", "255",
+                                  "{\"state\":\"ON\",\"color\":{\"r\":255,\"w\":9},\"effect\":\"Manual\"}"};
+    static const char alphabet[] = "{}[]\":,.%-+ 0123456789onfONFwhiteruvbgs\\\n";
+
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < FUZZ_ITERATIONS; i++) {
+        std::vector<uint8_t> buf;
+        if (i & 1) {
+            // Mutate a valid seed
+            const char* seed = seeds[rng() % 6];
+            buf.assign(seed, seed + strlen(seed));
+            for (uint32_t m = rng() % 4; m > 0 && !buf.empty(); m--) {
+                size_t at = rng() % buf.size();
+                switch (rng() % 3) {
+                    case 0: buf[at] = alphabet[rng() % (sizeof(alphabet) - 1)]; break;
+                    case 1: buf.erase(buf.begin() + at); break;
+                    default: buf.resize(at); break;
+                }
+            }
+        } else {
+            buf.resize(rng() % 48);
+            for (auto& c : buf) c = (rng() & 3) ? alphabet[rng() % (sizeof(alphabet) - 1)] : (uint8_t)rng();
+        }
+
+        // Exact-size copy: no slack bytes past the end for a bad read to hit
+        uint8_t* payload = new uint8_t[buf.size() ? buf.size() : 1];
+        if (!buf.empty()) memcpy(payload, buf.data(), buf.size());
+
+        uint8_t v = 0;
+        if (mqtt_parse_level(payload, buf.size(), &v)) accepted++;
+        uint8_t values[3] = {0, 0, 0};
+        uint32_t mask = mqtt_parse_batch(payload, buf.size(), NAMES, 3, values);
+        TEST_ASSERT_EQUAL_UINT32(0, mask & ~0x7u);
+        HaLightCommand cmd;
+        if (mqtt_parse_ha_light(payload, buf.size(), &cmd) && (cmd.fields & HA_LIGHT_EFFECT)) {
+            TEST_ASSERT_TRUE((const uint8_t*)cmd.effect + cmd.effect_length <= payload + buf.size());
+        }
+        delete[] payload;
+    }
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%u of %u fuzz payloads accepted as levels", accepted, FUZZ_ITERATIONS);
+    TEST_MESSAGE(msg);
+}
+
+// ============================================================================
+// MICROBENCHMARKS
+// ============================================================================
+template <typename F>
+static void bench(const char* name, F fn) {
+    volatile uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) sink = sink + fn(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%-24s %8.1f ns/call",
+             name, std::chrono::duration<double, std::nano>(elapsed).count() / BENCH_ITERATIONS);
+    TEST_MESSAGE(msg);
+}
+
+void test_bench_parsers() {
+    static const char* topics[] = {"bastun/vaxtljus/white/set", "bastun/vaxtljus/red/set",
+                                   "bastun/vaxtljus/uv/set", "bastun/vaxtljus/set"};
+    MqttRoute routes[4];
+    for (int i = 0; i < 4; i++) {
+        routes[i] = {mqtt_topic_hash(topics[i], strlen(topics[i])), topics[i], (int8_t)(i == 3 ? MQTT_ROUTE_BATCH : i)};
+    }
+
+    bench("route_find", [&](uint32_t i) { return (uint32_t)(mqtt_route_find(routes, 4, topics[i & 3]) != nullptr); });
+    bench("parse_level raw", [](uint32_t) { uint8_t v; level("200", &v); return (uint32_t)v; });
+    bench("parse_level percent", [](uint32_t) { uint8_t v; level("12.5%", &v); return (uint32_t)v; });
+    bench("parse_level json", [](uint32_t) {
+        uint8_t v;
+        level("{\"state\":\"ON\",\"brightness\":128}", &v);
+        return (uint32_t)v;
+    });
+    bench("parse_batch", [](uint32_t) {
+        uint8_t values[3];
+        return batch("{\"white\":200,\"red\":\"50%\",\"uv\":\"OFF\"}", values);
+    });
+    bench("parse_ha_light", [](uint32_t) {
+        HaLightCommand cmd;
+        ha_light("{\"state\":\"ON\",\"brightness\":200,\"color\":{\"r\":255,\"g\":0,\"b\":64,\"w\":255}}", &cmd);
+        return (uint32_t)cmd.brightness;
+    });
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_level_raw);
+    RUN_TEST(test_level_percent);
+    RUN_TEST(test_level_on_off);
+    RUN_TEST(test_level_json);
+    RUN_TEST(test_level_rejects_garbage);
+    RUN_TEST(test_batch);
+    RUN_TEST(test_batch_is_all_or_nothing);
+    RUN_TEST(test_ha_light);
+    RUN_TEST(test_ha_light_rejects);
+    RUN_TEST(test_route_find);
+    RUN_TEST(test_fuzz_parsers);
+    RUN_TEST(test_bench_parsers);
+    return UNITY_END();
+}
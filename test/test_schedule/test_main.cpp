@@ -0,0 +1,251 @@
+/**
+ * Vaxthus_Master_V3 - Schedule engine and sun position tests, microbenchmarks
+ *
+ * Host build only:  pio test -e native -f test_schedule -v
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <string.h>
+#include <string>
+
+#include "schedule.h"
+#include "solar.h"
+
+#define BENCH_ITERATIONS 200000
+
+static const char* const NAMES[] = {"white", "red", "uv"};
+
+static Schedule schedule;
+static ScheduleError err;
+
+static bool compile(const char* text, const SolarDay* sun = nullptr) {
+    return schedule_compile(text, strlen(text), NAMES, 3, sun, &schedule, &err);
+}
+
+static uint32_t at(int hour, int minute) {
+    return (hour * 60 + minute) * 60;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// COMPILE
+// ============================================================================
+void test_compile_default_curve() {
+    TEST_ASSERT_TRUE_MESSAGE(compile("all 06:00=0 10:00=255 18:00=255 22:00=0\n"), err.message);
+    TEST_ASSERT_EQUAL_UINT8(1, schedule.profile_count);
+    TEST_ASSERT_EQUAL_UINT16(12, schedule.point_count);
+    TEST_ASSERT_FALSE(schedule.solar);
+
+    int p = schedule_find_profile(schedule, 3, 5);
+    TEST_ASSERT_EQUAL_INT(0, p);
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, p, 0, at(3, 0)));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, p, 0, at(6, 0)));
+    TEST_ASSERT_EQUAL_UINT16(32767, schedule_level(schedule, p, 0, at(8, 0)));
+    TEST_ASSERT_EQUAL_UINT16(65535, schedule_level(schedule, p, 1, at(12, 0)));
+    TEST_ASSERT_EQUAL_UINT16(65535, schedule_level(schedule, p, 2, at(18, 0)));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, p, 2, at(23, 59)));
+}
+
+void test_points_are_sorted_and_interleaved_lines_merge() {
+    TEST_ASSERT_TRUE_MESSAGE(compile("red 20:00=100 08:00=100\n"
+                                     "white 12:00=50%\n"
+                                     "red 06:00=0   # dawn\r\n"
+                                     "red 22:00=0\n"),
+                             err.message);
+    TEST_ASSERT_EQUAL_UINT16(32896, schedule_level(schedule, 0, 0, at(3, 0)));  // single point = constant
+    TEST_ASSERT_EQUAL_UINT16(100 * 257 / 2, schedule_level(schedule, 0, 1, at(7, 0)));
+    TEST_ASSERT_EQUAL_UINT16(100 * 257, schedule_level(schedule, 0, 1, at(14, 0)));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, 0, 2, at(12, 0)));  // not listed = off
+}
+
+void test_interpolates_across_midnight() {
+    TEST_ASSERT_TRUE_MESSAGE(compile("white 22:00=200 02:00=0"), err.message);
+    TEST_ASSERT_EQUAL_UINT16(100 * 257, schedule_level(schedule, 0, 0, at(0, 0)));
+    TEST_ASSERT_EQUAL_UINT16(150 * 257, schedule_level(schedule, 0, 0, at(23, 0)));
+    TEST_ASSERT_EQUAL_UINT16(50 * 257, schedule_level(schedule, 0, 0, at(1, 0)));
+    TEST_ASSERT_EQUAL_UINT16(100 * 257, schedule_level(schedule, 0, 0, at(12, 0)));
+}
+
+void test_profiles_by_weekday_and_month() {
+    TEST_ASSERT_TRUE_MESSAGE(compile("profile sat,sun\n"
+                                     "all 09:00=255\n"
+                                     "profile mon-fri 11-2   # winter weekdays\n"
+                                     "all 07:00=128\n"
+                                     "profile\n"
+                                     "all 07:00=64\n"),
+                             err.message);
+    TEST_ASSERT_EQUAL_UINT8(3, schedule.profile_count);
+    TEST_ASSERT_EQUAL_INT(0, schedule_find_profile(schedule, 0, 6));   // Sunday, July
+    TEST_ASSERT_EQUAL_INT(0, schedule_find_profile(schedule, 6, 0));   // Saturday, January
+    TEST_ASSERT_EQUAL_INT(1, schedule_find_profile(schedule, 1, 11));  // Monday, December
+    TEST_ASSERT_EQUAL_INT(1, schedule_find_profile(schedule, 5, 1));   // Friday, February
+    TEST_ASSERT_EQUAL_INT(2, schedule_find_profile(schedule, 3, 2));   // Wednesday, March
+
+    TEST_ASSERT_TRUE(compile("profile mon\nall 07:00=1"));
+    TEST_ASSERT_EQUAL_INT(-1, schedule_find_profile(schedule, 2, 0));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, -1, 0, at(12, 0)));
+}
+
+void test_rejects_bad_schedules() {
+    const char* bad[] = {"", "# only a comment\n", "fan 06:00=1", "white", "white 6=1", "white 24:00=1",
+                         "white 06:60=1", "white 06:00=lots", "white 06:00=1 06:00=2", "all 06:00=1\nred 06:00=3",
+                         "profile xyz\nall 06:00=1", "profile mon 13\nall 06:00=1", "profile mon, 1\nall 06:00=1",
+                         "profile * * extra"};
+    for (const char* text : bad) {
+        TEST_ASSERT_FALSE_MESSAGE(compile(text), text);
+    }
+
+    TEST_ASSERT_FALSE(compile("white 06:00=0\nred 07:00=1 0x:00=2\n"));
+    TEST_ASSERT_EQUAL_UINT16(2, err.line);
+
+    TEST_ASSERT_FALSE(compile("wh\"ite 06:00=0"));
+    TEST_ASSERT_NULL(strchr(err.message, '"'));
+}
+
+void test_capacity_limits() {
+    std::string text;
+    for (int p = 0; p <= SCHEDULE_MAX_PROFILES; p++) text += "profile\nwhite 06:00=1\n";
+    TEST_ASSERT_FALSE(compile(text.c_str()));
+
+    text.clear();
+    char point[16];
+    for (int m = 0; m < SCHEDULE_MAX_POINTS / 3 + 1; m++) {
+        snprintf(point, sizeof(point), " %02d:%02d=%d", m / 60, m % 60, m & 0xFF);
+        text += point;
+    }
+    TEST_ASSERT_FALSE(compile(("all" + text).c_str()));
+    TEST_ASSERT_TRUE(compile(("white" + text).c_str()));
+}
+
+// ============================================================================
+// SUN
+// ============================================================================
+// Stockholm and Kiruna, 2026-06-21 (CEST) and 2026-12-21 (CET)
+#define MIDSUMMER 171
+#define MIDWINTER 354
+
+static void check_minute(int expected, int actual) {
+    TEST_ASSERT_INT_WITHIN(3, expected, actual);
+}
+
+void test_solar_stockholm() {
+    SolarDay day;
+    solar_compute_day(2026, MIDSUMMER, 59.33f, 18.07f, 120, &day);
+    check_minute(3 * 60 + 31, day.sunrise);
+    check_minute(22 * 60 + 8, day.sunset);
+    check_minute(12 * 60 + 49, day.noon);
+    TEST_ASSERT_INT_WITHIN(20, 5411, day.max_elevation);
+    TEST_ASSERT_LESS_THAN(0, solar_elevation(day, 0));
+    TEST_ASSERT_INT_WITHIN(30, 5411, solar_elevation(day, (12 * 60 + 49) * 60));
+
+    solar_compute_day(2026, MIDWINTER, 59.33f, 18.07f, 60, &day);
+    check_minute(8 * 60 + 44, day.sunrise);
+    check_minute(14 * 60 + 48, day.sunset);
+}
+
+void test_solar_polar() {
+    SolarDay day;
+    solar_compute_day(2026, MIDSUMMER, 67.85f, 20.22f, 120, &day);
+    TEST_ASSERT_EQUAL_INT(SOLAR_NONE, day.sunrise);
+    TEST_ASSERT_GREATER_THAN(0, day.elevation[0]);  // midnight sun
+
+    solar_compute_day(2026, MIDWINTER, 67.85f, 20.22f, 60, &day);
+    TEST_ASSERT_EQUAL_INT(SOLAR_NONE, day.sunset);
+    for (int i = 0; i < SOLAR_TABLE_SIZE; i++) TEST_ASSERT_EQUAL_UINT16(0, day.intensity[i]);
+}
+
+void test_solar_schedule_points() {
+    SolarDay day;
+    solar_compute_day(2026, MIDWINTER, 59.33f, 18.07f, 60, &day);
+    char text[160];
+    snprintf(text, sizeof(text),
+             "white sunrise-30=0 sunrise+60=255 sunset-60=255 sunset=0\n"
+             "red sunrise+0=10 %02d:%02d=100   # fixed point wins a clash\n"
+             "uv sun=200",
+             day.sunrise / 60, day.sunrise % 60);
+    TEST_ASSERT_TRUE_MESSAGE(compile(text, &day), err.message);
+    TEST_ASSERT_TRUE(schedule.solar);
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, 0, 0, (day.sunrise - 30) * 60));
+    TEST_ASSERT_EQUAL_UINT16(65535, schedule_level(schedule, 0, 0, (day.sunrise + 60) * 60));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, 0, 0, day.sunset * 60));
+    TEST_ASSERT_EQUAL_UINT16(100 * 257, schedule_level(schedule, 0, 1, 0));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, 0, 2, 3 * 3600));
+    TEST_ASSERT_UINT_WITHIN(600, 200 * 257, schedule_level(schedule, 0, 2, day.noon * 60));
+
+    // Unknown date or polar night: solar points drop out, the rest stays valid
+    TEST_ASSERT_TRUE(compile("white sunrise=0 12:00=50\nuv sun=255"));
+    TEST_ASSERT_TRUE(schedule.solar);
+    TEST_ASSERT_EQUAL_UINT16(50 * 257, schedule_level(schedule, 0, 0, 3 * 3600));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule_level(schedule, 0, 2, 12 * 3600));
+
+    TEST_ASSERT_FALSE(compile("white sunrose=0", &day));
+    TEST_ASSERT_FALSE(compile("white sunrise+1000=0", &day));
+    TEST_ASSERT_FALSE(compile("white sunrise+x=0", &day));
+}
+
+// ============================================================================
+// MICROBENCHMARKS
+// ============================================================================
+template <typename F>
+static void bench(const char* name, uint32_t iterations, F fn) {
+    volatile uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) sink = sink + fn(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%-28s %8.1f ns/call",
+             name, std::chrono::duration<double, std::nano>(elapsed).count() / iterations);
+    TEST_MESSAGE(msg);
+}
+
+void test_bench_schedule() {
+    // Per-tick cost must not grow with the schedule: 4 points vs 128 per channel
+    TEST_ASSERT_TRUE(compile("all 06:00=0 10:00=255 18:00=255 22:00=0"));
+    bench("level, 4 points/channel", BENCH_ITERATIONS, [](uint32_t i) {
+        return (uint32_t)schedule_level(schedule, 0, i % 3, (i * 7919) % 86400);
+    });
+
+    std::string text;
+    char point[16];
+    for (int m = 0; m < 128; m++) {
+        snprintf(point, sizeof(point), " %02d:%02d=%d", (m * 11) / 60, (m * 11) % 60, (m * 37) & 0xFF);
+        text += point;
+    }
+    std::string big = "all" + text;
+    TEST_ASSERT_TRUE_MESSAGE(compile(big.c_str()), err.message);
+    bench("level, 128 points/channel", BENCH_ITERATIONS, [](uint32_t i) {
+        return (uint32_t)schedule_level(schedule, 0, i % 3, (i * 7919) % 86400);
+    });
+    bench("solar_compute_day", BENCH_ITERATIONS / 1000, [](uint32_t i) {
+        SolarDay day;
+        solar_compute_day(2026, i % 365, 59.33f, 18.07f, 60, &day);
+        return (uint32_t)day.sunrise;
+    });
+    bench("compile, 384 points", BENCH_ITERATIONS / 1000, [&](uint32_t) {
+        return (uint32_t)schedule_compile(big.c_str(), big.size(), NAMES, 3, nullptr, &schedule, &err);
+    });
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_compile_default_curve);
+    RUN_TEST(test_points_are_sorted_and_interleaved_lines_merge);
+    RUN_TEST(test_interpolates_across_midnight);
+    RUN_TEST(test_profiles_by_weekday_and_month);
+    RUN_TEST(test_rejects_bad_schedules);
+    RUN_TEST(test_capacity_limits);
+    RUN_TEST(test_solar_stockholm);
+    RUN_TEST(test_solar_polar);
+    RUN_TEST(test_solar_schedule_points);
+    RUN_TEST(test_bench_schedule);
+    return UNITY_END();
+}
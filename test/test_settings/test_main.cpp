@@ -0,0 +1,272 @@
+/**
+ * Vaxthus_Master_V3 - Settings blob tests
+ *
+ * Host build only:  pio test -e native -f test_settings -v
+ *
+ * Encode/decode round trip, rejects (CRC, length, version), blobs from an
+ * older and a newer layout, then the firmware: migration from the old
+ * key-per-setting layout, a single NVS read on the next boot, and a save
+ * that replaces the blob in one write.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <string.h>
+
+#include "hal.h"
+#include "settings_blob.h"
+
+void load_settings();
+void save_settings();
+extern String mqtt_server;
+extern String wifi_ssid;
+extern uint16_t mqtt_port;
+extern bool power_save;
+extern float dli_target;
+extern uint16_t light_ppfd[];
+extern const char* settings_source;
+extern uint32_t settings_load_us;
+
+static Settings sample() {
+    Settings s;
+    memset(&s, 0, sizeof(s));
+    strcpy(s.wifi_ssid, "greenhouse");
+    strcpy(s.mqtt_server, "broker.local");
+    s.mqtt_port = 8883;
+    s.flags = SETTINGS_MQTT_ENABLED | SETTINGS_POWER_SAVE;
+    s.dmx_protocol = 2;
+    s.dmx_universe = 7;
+    s.dmx_address = 100;
+    s.latitude = 63.83f;
+    s.longitude = 20.26f;
+    s.dli_target = 17.5f;
+    s.ppfd[0] = 250;
+    s.ppfd[1] = 150;
+    return s;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// BLOB
+// ============================================================================
+void test_crc_check_value() {
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, settings_crc((const uint8_t*)"123456789", 9));
+}
+
+void test_round_trip() {
+    Settings in = sample();
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t length = settings_encode(in, blob, sizeof(blob));
+    TEST_ASSERT_EQUAL(settings_blob_size(), length);
+
+    Settings out;
+    uint8_t version = 0;
+    TEST_ASSERT_TRUE(settings_decode(blob, length, &out, &version));
+    TEST_ASSERT_EQUAL_UINT8(SETTINGS_VERSION, version);
+    TEST_ASSERT_EQUAL(0, memcmp(&in, &out, sizeof(in)));
+    TEST_ASSERT_EQUAL(0, settings_encode(in, blob, settings_blob_size() - 1));
+}
+
+void test_rejects() {
+    Settings in = sample();
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t length = settings_encode(in, blob, sizeof(blob));
+    Settings out = {};
+    uint8_t version;
+
+    TEST_ASSERT_FALSE(settings_decode(blob, length - 1, &out, &version));  // torn
+    TEST_ASSERT_FALSE(settings_decode(blob, 4, &out, &version));
+    blob[40] ^= 0x10;  // one bit
+    TEST_ASSERT_FALSE(settings_decode(blob, length, &out, &version));
+    blob[40] ^= 0x10;
+    blob[0] = 0;  // version 0 is the old keys, never a blob
+    TEST_ASSERT_FALSE(settings_decode(blob, length, &out, &version));
+    TEST_ASSERT_EQUAL_STRING("", out.wifi_ssid);  // untouched on failure
+
+    uint8_t erased[SETTINGS_BLOB_MAX];
+    memset(erased, 0xFF, sizeof(erased));
+    TEST_ASSERT_FALSE(settings_decode(erased, settings_blob_size(), &out, &version));
+}
+
+// Blob written by a firmware whose Settings ended before ppfd: ppfd keeps the default
+void test_older_blob_keeps_defaults() {
+    Settings in = sample();
+    size_t old_length = offsetof(Settings, ppfd);
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    SettingsHeader header = {1, 0, (uint16_t)old_length, settings_crc((const uint8_t*)&in, old_length)};
+    memcpy(blob, &header, sizeof(header));
+    memcpy(blob + sizeof(header), &in, old_length);
+
+    Settings out = {};
+    out.ppfd[0] = 999;
+    TEST_ASSERT_TRUE(settings_decode(blob, sizeof(header) + old_length, &out, nullptr));
+    TEST_ASSERT_EQUAL_STRING("broker.local", out.mqtt_server);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 17.5f, out.dli_target);
+    TEST_ASSERT_EQUAL_UINT16(999, out.ppfd[0]);
+}
+
+// Blob from a newer firmware with fields appended: read what is known
+void test_newer_blob_reads_known_part() {
+    Settings in = sample();
+    uint8_t body[sizeof(Settings) + 16];
+    memcpy(body, &in, sizeof(in));
+    memset(body + sizeof(in), 0xAB, 16);
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    SettingsHeader header = {SETTINGS_VERSION + 1, 0, sizeof(body), settings_crc(body, sizeof(body))};
+    memcpy(blob, &header, sizeof(header));
+    memcpy(blob + sizeof(header), body, sizeof(body));
+
+    Settings out;
+    uint8_t version;
+    TEST_ASSERT_TRUE(settings_decode(blob, sizeof(header) + sizeof(body), &out, &version));
+    TEST_ASSERT_EQUAL_UINT8(SETTINGS_VERSION + 1, version);
+    TEST_ASSERT_EQUAL(0, memcmp(&in, &out, sizeof(in)));
+}
+
+void test_strings_terminated() {
+    Settings in = sample();
+    memset(in.wifi_ssid, 'x', sizeof(in.wifi_ssid));  // no NUL
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t length = settings_encode(in, blob, sizeof(blob));
+    Settings out;
+    TEST_ASSERT_TRUE(settings_decode(blob, length, &out, nullptr));
+    TEST_ASSERT_EQUAL(sizeof(out.wifi_ssid) - 1, strlen(out.wifi_ssid));
+}
+
+// ============================================================================
+// FIRMWARE
+// ============================================================================
+// First boot on the blob firmware: the old keys become the blob
+void test_migrates_old_keys() {
+    hal_fake_reset();
+    hal_nvs_put_string("SSID", "greenhouse");
+    hal_nvs_put_string("MQTTSERVER", "broker.local");
+    hal_nvs_put_u32("MQTTPORT", 1884);
+    hal_nvs_put_bool("POWERSAVE", true);
+    hal_nvs_put_string("DLITARGET", "12.5");
+    hal_nvs_put_u32("PPFD_red", 180);
+
+    load_settings();
+    TEST_ASSERT_EQUAL_STRING("migrated", settings_source);
+    TEST_ASSERT_EQUAL_STRING("broker.local", mqtt_server.c_str());  // no longer forced to the default
+    TEST_ASSERT_EQUAL_UINT16(1884, mqtt_port);
+    TEST_ASSERT_TRUE(power_save);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 12.5f, dli_target);
+    TEST_ASSERT_EQUAL_UINT16(180, light_ppfd[1]);
+    TEST_ASSERT_EQUAL_UINT16(250, light_ppfd[0]);  // default from the channel table
+
+    // The next boot reads the blob: one NVS read for all settings
+    mqtt_server = "";
+    uint32_t reads = hal_fake_nvs_reads();
+    load_settings();
+    TEST_ASSERT_EQUAL_STRING("blob", settings_source);
+    TEST_ASSERT_EQUAL_STRING("broker.local", mqtt_server.c_str());
+    TEST_ASSERT_EQUAL_STRING("greenhouse", wifi_ssid.c_str());
+    TEST_ASSERT_EQUAL_UINT32(reads + 1, hal_fake_nvs_reads());
+}
+
+void test_save_is_one_write() {
+    load_settings();
+    mqtt_server = "mqtt.example.org";
+    dli_target = 20.0f;
+    uint32_t writes = hal_fake_nvs_writes();
+    save_settings();
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, hal_fake_nvs_writes());
+
+    mqtt_server = "";
+    dli_target = 0;
+    load_settings();
+    TEST_ASSERT_EQUAL_STRING("blob", settings_source);
+    TEST_ASSERT_EQUAL_STRING("mqtt.example.org", mqtt_server.c_str());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, dli_target);
+}
+
+// A corrupt blob falls back to the old keys (the last pre-blob settings) and is rewritten
+void test_corrupt_blob_rebuilt() {
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t length = hal_nvs_get_blob("SETTINGS", blob, sizeof(blob));
+    TEST_ASSERT_TRUE(length > 0);
+    blob[length - 1] ^= 0xFF;
+    hal_nvs_put_blob("SETTINGS", blob, length);
+
+    load_settings();
+    TEST_ASSERT_EQUAL_STRING("rebuilt", settings_source);
+    TEST_ASSERT_EQUAL_STRING("broker.local", mqtt_server.c_str());
+    load_settings();
+    TEST_ASSERT_EQUAL_STRING("blob", settings_source);
+}
+
+void test_fresh_device_defaults() {
+    hal_fake_reset();
+    load_settings();
+    TEST_ASSERT_EQUAL_STRING("migrated", settings_source);
+    TEST_ASSERT_EQUAL_STRING("mqtt.revolt-energy.org", mqtt_server.c_str());
+    TEST_ASSERT_EQUAL_UINT16(1883, mqtt_port);
+    TEST_ASSERT_FALSE(power_save);
+}
+
+// ============================================================================
+// MICROBENCHMARK
+// ============================================================================
+// The two load paths side by side. Host time is only a rough guide; on the
+// ESP32 each NVS lookup searches the flash pages, so the read count matters.
+void settings_from_keys(Settings* s);
+
+void test_bench_load() {
+    const int iterations = 20000;
+    hal_fake_reset();
+    hal_nvs_put_string("SSID", "greenhouse");
+    load_settings();  // writes the blob
+
+    Settings s;
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    uint32_t reads = hal_fake_nvs_reads();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        size_t length = hal_nvs_get_blob("SETTINGS", blob, sizeof(blob));
+        TEST_ASSERT_TRUE(settings_decode(blob, length, &s, nullptr));
+    }
+    double blob_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    uint32_t blob_reads = hal_fake_nvs_reads() - reads;
+
+    reads = hal_fake_nvs_reads();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) settings_from_keys(&s);
+    double keys_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    uint32_t key_reads = hal_fake_nvs_reads() - reads;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "blob + CRC  %8.1f ns/load  %2u NVS reads", blob_ns / iterations,
+             (unsigned)(blob_reads / iterations));
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "old keys    %8.1f ns/load  %2u NVS reads", keys_ns / iterations,
+             (unsigned)(key_reads / iterations));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(iterations, blob_reads);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    hal_fake_reset();
+    Serial.muted = true;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_check_value);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_rejects);
+    RUN_TEST(test_older_blob_keeps_defaults);
+    RUN_TEST(test_newer_blob_reads_known_part);
+    RUN_TEST(test_strings_terminated);
+    RUN_TEST(test_migrates_old_keys);
+    RUN_TEST(test_save_is_one_write);
+    RUN_TEST(test_corrupt_blob_rebuilt);
+    RUN_TEST(test_fresh_device_defaults);
+    RUN_TEST(test_bench_load);
+    return UNITY_END();
+}
@@ -0,0 +1,428 @@
+/**
+ * Vaxthus_Master_V3 - Accelerated-time simulation tests
+ *
+ * Host build only:  pio test -e native -f test_simulation -v
+ *
+ * Runs the real light engine over days and seasons on the virtual clock
+ * (see simulation.h) and checks what the outputs would have done.
+ * SIM_TRACE=<file> also writes the default day as CSV, for plotting.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <string.h>
+#include <stdlib.h>
+
+#include "hal.h"
+#include "pwm_curve.h"
+#include "simulation.h"
+#include <ESPAsyncWebServer.h>
+
+extern AsyncWebServer server;
+extern uint32_t status_version;
+
+void setup();
+void loop();
+
+#define CH_WHITE 0
+#define CH_RED   1
+#define CH_UV    2
+
+#define DEFAULT_DAY "all 06:00=0 10:00=255 18:00=255 22:00=0"
+
+// Whole trace in memory (host only)
+struct Trace {
+    uint32_t count;
+    uint32_t t[65536];
+    uint8_t levels[65536][3];
+    bool auto_mode[65536];
+    uint32_t dli[65536];
+};
+
+static Trace trace;
+static ScheduleError err;
+
+static bool record(const SimSample& s, void* ctx) {
+    Trace& tr = *(Trace*)ctx;
+    if (tr.count >= 65536) return false;
+    tr.t[tr.count] = s.t;
+    memcpy(tr.levels[tr.count], s.levels, 3);
+    tr.auto_mode[tr.count] = s.auto_mode;
+    tr.dli[tr.count] = s.dli;
+    tr.count++;
+    return true;
+}
+
+static SimOptions options(uint16_t days, uint32_t step, int month = 6, int day = 21) {
+    SimOptions opt = {};
+    opt.year = 2026;
+    opt.month = month;
+    opt.day = day;
+    opt.days = days;
+    opt.step = step;
+    opt.latitude = 59.33f;
+    opt.longitude = 18.07f;
+    opt.utc_offset_minutes = 120;
+    return opt;
+}
+
+static bool run(const char* text, const SimOptions& opt) {
+    trace.count = 0;
+    return light_simulate(text, strlen(text), opt, record, &trace, &err);
+}
+
+// Row at a time of day on the first simulated day (step must divide it)
+static uint32_t row(const SimOptions& opt, int hour, int minute, int second = 0) {
+    return ((hour * 60 + minute) * 60 + second) / opt.step;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// ENGINE
+// ============================================================================
+void test_default_day() {
+    SimOptions opt = options(1, 10);
+    TEST_ASSERT_TRUE_MESSAGE(run(DEFAULT_DAY, opt), err.message);
+    TEST_ASSERT_EQUAL_UINT32(8640, trace.count);
+
+    TEST_ASSERT_EQUAL_UINT8(0, trace.levels[row(opt, 3, 0)][CH_WHITE]);
+    TEST_ASSERT_EQUAL_UINT8(127, trace.levels[row(opt, 8, 0)][CH_WHITE]);
+    TEST_ASSERT_EQUAL_UINT8(255, trace.levels[row(opt, 12, 0)][CH_RED]);
+    TEST_ASSERT_EQUAL_UINT8(0, trace.levels[row(opt, 23, 0)][CH_RED]);
+    // UV limiter: 80% of white
+    TEST_ASSERT_EQUAL_UINT8(204, trace.levels[row(opt, 12, 0)][CH_UV]);
+}
+
+void test_uv_limiter_holds_all_week() {
+    SimOptions opt = options(7, 10);
+    TEST_ASSERT_TRUE_MESSAGE(run("white 06:00=0 08:00=100 20:00=100 21:00=0\n"
+                                 "uv 05:00=0 07:00=255 22:00=255 23:00=0", opt), err.message);
+    TEST_ASSERT_EQUAL_UINT32(7 * 8640, trace.count);
+    for (uint32_t i = 0; i < trace.count; i++) {
+        TEST_ASSERT_TRUE(trace.levels[i][CH_UV] * 100 <= trace.levels[i][CH_WHITE] * 80 + 100);
+    }
+    TEST_ASSERT_EQUAL_UINT8(80, trace.levels[row(opt, 12, 0)][CH_UV]);
+}
+
+void test_manual_override_expires() {
+    SimOptions opt = options(1, 10);
+    SimEvent events[] = {{12 * 3600, CH_WHITE, 10}};
+    opt.events = events;
+    opt.event_count = 1;
+    TEST_ASSERT_TRUE_MESSAGE(run(DEFAULT_DAY, opt), err.message);
+
+    TEST_ASSERT_TRUE(trace.auto_mode[row(opt, 11, 59, 50)]);
+    TEST_ASSERT_FALSE(trace.auto_mode[row(opt, 12, 0)]);
+    TEST_ASSERT_EQUAL_UINT8(10, trace.levels[row(opt, 12, 0)][CH_WHITE]);
+    TEST_ASSERT_EQUAL_UINT8(8, trace.levels[row(opt, 12, 0)][CH_UV]);  // limiter follows
+    TEST_ASSERT_EQUAL_UINT8(10, trace.levels[row(opt, 12, 40)][CH_WHITE]);
+    TEST_ASSERT_FALSE(trace.auto_mode[row(opt, 12, 40)]);
+
+    // 40 minutes, then back to the schedule on the next update
+    TEST_ASSERT_TRUE(trace.auto_mode[row(opt, 12, 40, 10)]);
+    TEST_ASSERT_EQUAL_UINT8(255, trace.levels[row(opt, 12, 40, 10)][CH_WHITE]);
+}
+
+void test_exit_manual_event() {
+    SimOptions opt = options(1, 60);
+    SimEvent events[] = {{12 * 3600, CH_RED, 0}, {12 * 3600 + 300, -1, 0}};
+    opt.events = events;
+    opt.event_count = 2;
+    TEST_ASSERT_TRUE_MESSAGE(run(DEFAULT_DAY, opt), err.message);
+    TEST_ASSERT_EQUAL_UINT8(0, trace.levels[row(opt, 12, 4)][CH_RED]);
+    TEST_ASSERT_EQUAL_UINT8(255, trace.levels[row(opt, 12, 5)][CH_RED]);
+    TEST_ASSERT_TRUE(trace.auto_mode[row(opt, 12, 5)]);
+}
+
+void test_profiles_follow_the_calendar() {
+    // 2026-06-21 is a Sunday
+    SimOptions opt = options(2, 600);
+    TEST_ASSERT_TRUE_MESSAGE(run("profile sun\nall 00:00=50\nprofile *\nall 00:00=200", opt), err.message);
+    TEST_ASSERT_EQUAL_UINT8(50, trace.levels[0][CH_RED]);
+    TEST_ASSERT_EQUAL_UINT8(200, trace.levels[86400 / 600][CH_RED]);
+}
+
+void test_season_follows_the_sun() {
+    // A year of sunrise/sunset-driven light in Stockholm, one sample per 10 min
+    SimOptions opt = options(365, 600, 1, 1);
+    TEST_ASSERT_TRUE_MESSAGE(run("white sunrise=0 sunrise+30=255 sunset-30=255 sunset=0", opt), err.message);
+    TEST_ASSERT_EQUAL_UINT32(365 * 144, trace.count);
+
+    uint32_t lit[365] = {};
+    for (uint32_t i = 0; i < trace.count; i++) {
+        if (trace.levels[i][CH_WHITE] > 0) lit[trace.t[i] / 86400]++;
+    }
+    // 10-minute rows lit: ~18 h at midsummer, ~6 h at midwinter
+    TEST_ASSERT_INT_WITHIN(6, 18 * 6, lit[171]);
+    TEST_ASSERT_INT_WITHIN(6, 6 * 6, lit[354]);
+    TEST_ASSERT_TRUE(lit[79] > lit[354] && lit[79] < lit[171]);  // equinox in between
+}
+
+void test_rejects_bad_input() {
+    TEST_ASSERT_FALSE(run("white 25:00=0", options(1, 60)));
+    TEST_ASSERT_EQUAL_UINT16(1, err.line);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.count);
+    TEST_ASSERT_FALSE(run(DEFAULT_DAY, options(0, 60)));
+    TEST_ASSERT_FALSE(run(DEFAULT_DAY, options(1, 0)));
+}
+
+void test_live_engine_untouched() {
+    uint32_t writes[3];
+    for (int ch = 0; ch < 3; ch++) writes[ch] = hal_fake_pwm_duty(ch);
+    SimOptions opt = options(1, 10);
+    SimEvent events[] = {{3600, CH_WHITE, 255}};
+    opt.events = events;
+    opt.event_count = 1;
+    TEST_ASSERT_TRUE(run(DEFAULT_DAY, opt));
+    for (int ch = 0; ch < 3; ch++) TEST_ASSERT_EQUAL_UINT32(writes[ch], hal_fake_pwm_duty(ch));
+}
+
+// ============================================================================
+// DAILY LIGHT INTEGRAL
+// ============================================================================
+// Default calibration: white 250, red 150 µmol/m²/s at full output, UV not PAR
+void test_dli_integrates_and_resets_at_midnight() {
+    SimOptions opt = options(2, 10);
+    TEST_ASSERT_TRUE_MESSAGE(run("white 00:00=255 23:59=255", opt), err.message);
+    // Full white from the first step: 250 µmol/m²/s for all but the last 10 s of the day
+    TEST_ASSERT_INT_WITHIN(250 * 20, 250 * 86390, trace.dli[8639]);
+    TEST_ASSERT_INT_WITHIN(250 * 20, 0, trace.dli[8640]);
+    TEST_ASSERT_INT_WITHIN(250 * 20, 250 * 86390, trace.dli[2 * 8640 - 1]);
+}
+
+void test_dli_target_scales_the_curve() {
+    SimOptions opt = options(1, 10);
+    TEST_ASSERT_TRUE_MESSAGE(run(DEFAULT_DAY, opt), err.message);
+    uint32_t full = trace.dli[trace.count - 1];
+    uint8_t full_noon = trace.levels[row(opt, 12, 0)][CH_WHITE];
+    TEST_ASSERT_TRUE(full > 400 * 8 * 3600 && full < 400 * 12 * 3600);  // 8 h at full + two 4 h ramps
+
+    opt.dli_target = full / 2 / 1e6f;
+    TEST_ASSERT_TRUE_MESSAGE(run(DEFAULT_DAY, opt), err.message);
+    TEST_ASSERT_INT_WITHIN(full / 100, full / 2, trace.dli[trace.count - 1]);
+    // Same photoperiod, dimmer: half the photons at noon is ~3/4 of the perceptual level
+    TEST_ASSERT_TRUE(trace.levels[row(opt, 6, 30)][CH_WHITE] > 0);
+    TEST_ASSERT_TRUE(trace.levels[row(opt, 12, 0)][CH_WHITE] < full_noon);
+    TEST_ASSERT_INT_WITHIN(12, 193, trace.levels[row(opt, 12, 0)][CH_WHITE]);
+    TEST_ASSERT_TRUE(trace.levels[row(opt, 21, 30)][CH_WHITE] > 0);
+}
+
+void test_dli_target_reached_stops_early() {
+    SimOptions opt = options(1, 10);
+    SimEvent events[] = {{6 * 3600, CH_WHITE, 255}, {6 * 3600, CH_RED, 255}};
+    opt.events = events;
+    opt.event_count = 2;
+    opt.dli_target = 0.5f;  // reached within the 40 min manual override (0.96 mol)
+    TEST_ASSERT_TRUE_MESSAGE(run(DEFAULT_DAY, opt), err.message);
+
+    TEST_ASSERT_EQUAL_UINT8(255, trace.levels[row(opt, 6, 30)][CH_WHITE]);  // manual is never dimmed
+    TEST_ASSERT_TRUE(trace.auto_mode[row(opt, 12, 0)]);
+    TEST_ASSERT_EQUAL_UINT8(0, trace.levels[row(opt, 12, 0)][CH_WHITE]);
+    TEST_ASSERT_EQUAL_UINT8(0, trace.levels[row(opt, 12, 0)][CH_UV]);
+    TEST_ASSERT_EQUAL_UINT32(trace.dli[row(opt, 6, 41)], trace.dli[trace.count - 1]);
+}
+
+void test_curve_inverse() {
+    constexpr PwmCurve<12, true> curve;
+    for (uint32_t level = 0; level <= 0xFFFF; level += 7) {
+        uint32_t duty = curve.at(level);
+        uint16_t back = curve.level_for(duty);
+        TEST_ASSERT_EQUAL_UINT32(duty, curve.at(back));
+        TEST_ASSERT_TRUE(back <= level);
+    }
+    TEST_ASSERT_EQUAL_UINT32(curve.MAX_DUTY, curve.at(curve.level_for(curve.MAX_DUTY)));
+}
+
+// Live engine: integrated on the light side, saved through the NVS cache
+void test_dli_live_status_and_persistence() {
+    hal_fake_set_local_time(12, 0);
+    for (int i = 0; i < 1100; i++) loop();  // > 10 s: a sun step at full output
+    hal_fake_advance_millis(15 * 60 * 1000);
+    for (int i = 0; i < 1100; i++) loop();
+
+    // Steady output: the dose grows, the light state snapshot does not
+    uint32_t version = status_version;
+    for (int i = 0; i < 3300; i++) loop();  // three more sun steps
+    TEST_ASSERT_EQUAL_UINT32(version, status_version);
+
+    hal_fake_advance_millis(40000);          // NVS write-behind
+    loop();
+
+    uint32_t saved = hal_nvs_get_u32("DLI0", 0);
+    TEST_ASSERT_TRUE(saved > 250 * 900);
+    TEST_ASSERT_EQUAL_UINT32(126 * 1000 + 171, hal_nvs_get_u32("DLIDAY", 0));
+
+    server.fake_request(HTTP_GET, "/status");
+    TEST_ASSERT_NOT_NULL(strstr(server.last_body.c_str(), "\"dli\":"));
+    TEST_ASSERT_NOT_NULL(strstr(server.last_body.c_str(), "\"dli_percent\":100"));
+}
+
+// ============================================================================
+// HTTP
+// ============================================================================
+void test_http_csv() {
+    server.fake_request(HTTP_GET, "/simulate", {{"date", "2026-06-21"}, {"step", "3600"}});
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+    const char* body = server.last_body.c_str();
+    TEST_ASSERT_EQUAL_INT(0, strncmp(body, "time,white,red,uv,auto\n2026-06-21 00:00:00,0,0,0,1\n", 51));
+    TEST_ASSERT_NOT_NULL(strstr(body, "2026-06-21 12:00:00,255,255,204,1\n"));
+    int lines = 0;
+    for (const char* c = body; *c; c++) lines += *c == '\n';
+    TEST_ASSERT_EQUAL_INT(25, lines);
+}
+
+void test_http_json_candidate() {
+    server.fake_request(HTTP_POST, "/simulate",
+                        {{"plain", "red 00:00=10 12:00=200"}, {"date", "2026-06-21"}, {"step", "21600"},
+                         {"format", "json"}});
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+    TEST_ASSERT_EQUAL_STRING("{\"start\":\"2026-06-21\",\"step\":21600,"
+                             "\"columns\":[\"t\",\"white\",\"red\",\"uv\",\"auto\"],"
+                             "\"rows\":[[0,0,10,0,1],[21600,0,105,0,1],[43200,0,200,0,1],[64800,0,105,0,1]]}",
+                             server.last_body.c_str());
+
+    server.fake_request(HTTP_POST, "/simulate", {{"plain", "red 00:00=10\nblue 12:00=1"}, {"date", "2026-06-21"}});
+    TEST_ASSERT_EQUAL_INT(400, server.last_code);
+    TEST_ASSERT_EQUAL_STRING("{\"status\":\"error\",\"line\":2,\"error\":\"unknown channel 'blue'\"}",
+                             server.last_body.c_str());
+
+    server.fake_request(HTTP_GET, "/simulate", {{"date", "2026-06-21"}, {"days", "30"}, {"step", "10"}});
+    TEST_ASSERT_EQUAL_INT(400, server.last_code);
+    server.fake_request(HTTP_GET, "/simulate", {{"date", "2026-06-21"}, {"days", "30000"}, {"step", "2000000"}});
+    TEST_ASSERT_EQUAL_INT(400, server.last_code);  // days is checked before days * 86400 could overflow
+    TEST_ASSERT_NOT_NULL(strstr(server.last_body.c_str(), "days 1-400"));
+}
+
+// Rows are produced as the client reads; one preview streams at a time
+void test_http_stream_one_at_a_time() {
+    std::map<std::string, std::string> args = {{"date", "2026-06-21"}, {"days", "7"}, {"step", "60"}};
+    server.fake_request(HTTP_GET, "/simulate", args);
+    std::string whole = server.last_body.c_str();
+
+    AsyncWebServerRequest* slow = server.fake_open(HTTP_GET, "/simulate", args);
+    std::string body;
+    for (int i = 0; i < 10; i++) AsyncWebServer::fake_pump(slow, body, 100);
+    server.fake_request(HTTP_GET, "/simulate", args);
+    TEST_ASSERT_EQUAL_INT(503, server.last_code);
+    for (int i = 0; i < 20; i++) loop();
+    while (AsyncWebServer::fake_pump(slow, body, 100)) {
+    }
+    TEST_ASSERT_TRUE(body == whole);
+    delete slow;
+
+    // A client that disconnects half way frees the slot too
+    slow = server.fake_open(HTTP_GET, "/simulate", args);
+    AsyncWebServer::fake_pump(slow, body, 100);
+    delete slow;
+    server.fake_request(HTTP_GET, "/simulate", args);
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+}
+
+void test_http_changes_only() {
+    server.fake_request(HTTP_POST, "/simulate",
+                        {{"plain", "all 00:00=0 12:00=0 12:01=255 13:00=255 13:01=0"}, {"date", "2026-06-21"},
+                         {"step", "60"}, {"changes", "1"}});
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+    TEST_ASSERT_EQUAL_STRING("time,white,red,uv,auto\n"
+                             "2026-06-21 00:00:00,0,0,0,1\n"
+                             "2026-06-21 12:01:00,255,255,204,1\n"
+                             "2026-06-21 13:01:00,0,0,0,1\n",
+                             server.last_body.c_str());
+}
+
+// ============================================================================
+// THROUGHPUT
+// ============================================================================
+static bool count_only(const SimSample& s, void* ctx) {
+    *(uint32_t*)ctx += s.levels[0];
+    return true;
+}
+
+// Schedule variants × one day at the live 10 s interval
+void test_bench_sweep() {
+    const int variants = 1000;
+    char text[128];
+    uint32_t sum = 0;
+    SimOptions opt = options(1, 10);
+    auto start = std::chrono::steady_clock::now();
+    for (int v = 0; v < variants; v++) {
+        snprintf(text, sizeof(text), "all 0%d:%02d=0 10:00=%d 18:00=%d 2%d:00=0", 4 + v % 5, v % 60, 100 + v % 156,
+                 100 + v % 156, v % 4);
+        TEST_ASSERT_TRUE_MESSAGE(light_simulate(text, strlen(text), opt, count_only, &sum, &err), err.message);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%d schedule variants x 1 day @ 10 s: %.1f ms total, %.3f ms/day", variants, ms,
+             ms / variants);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(sum > 0);
+}
+
+void test_bench_year() {
+    uint32_t sum = 0;
+    SimOptions opt = options(365, 10, 1, 1);
+    const char* text = "white sunrise-30=0 sunrise+60=255 sunset-60=255 sunset+30=0\nuv sun=60%";
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE_MESSAGE(light_simulate(text, strlen(text), opt, count_only, &sum, &err), err.message);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "solar schedule, 365 days @ 10 s: %.1f ms (daily recompile included)", ms);
+    TEST_MESSAGE(msg);
+}
+
+// SIM_TRACE=day.csv: the default day at 1-minute steps, for plotting
+static bool write_csv(const SimSample& s, void* ctx) {
+    char line[64];
+    int len = format_sim_row(line, sizeof(line), s, false);
+    fwrite(line, 1, len, (FILE*)ctx);
+    return true;
+}
+
+static void write_trace() {
+    const char* path = getenv("SIM_TRACE");
+    if (!path) return;
+    FILE* f = fopen(path, "w");
+    if (!f) return;
+    fputs("time,white,red,uv,auto\n", f);
+    light_simulate(DEFAULT_DAY, strlen(DEFAULT_DAY), options(1, 60), write_csv, f, &err);
+    fclose(f);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    hal_fake_reset();
+    Serial.muted = true;
+    hal_fake_set_local_time(12, 0);
+    setup();
+    write_trace();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_default_day);
+    RUN_TEST(test_uv_limiter_holds_all_week);
+    RUN_TEST(test_manual_override_expires);
+    RUN_TEST(test_exit_manual_event);
+    RUN_TEST(test_profiles_follow_the_calendar);
+    RUN_TEST(test_season_follows_the_sun);
+    RUN_TEST(test_rejects_bad_input);
+    RUN_TEST(test_live_engine_untouched);
+    RUN_TEST(test_dli_integrates_and_resets_at_midnight);
+    RUN_TEST(test_dli_target_scales_the_curve);
+    RUN_TEST(test_dli_target_reached_stops_early);
+    RUN_TEST(test_curve_inverse);
+    RUN_TEST(test_http_csv);
+    RUN_TEST(test_http_json_candidate);
+    RUN_TEST(test_http_changes_only);
+    RUN_TEST(test_http_stream_one_at_a_time);
+    RUN_TEST(test_dli_live_status_and_persistence);
+    RUN_TEST(test_bench_sweep);
+    RUN_TEST(test_bench_year);
+    return UNITY_END();
+}
@@ -0,0 +1,273 @@
+/**
+ * Vaxthus_Master_V3 - Telemetry log tests
+ *
+ * Host build only:  pio test -e native -f test_telemetry -v
+ *
+ * The ring on the fake NOR flash (hal_native.cpp): page batching, even
+ * sector wear over many laps, recovery after a reboot or a torn write,
+ * and the streamed /telemetry.csv export.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <stdlib.h>
+
+#include "hal.h"
+#include "telemetry_log.h"
+#include <PubSubClient.h>
+#include <ESPAsyncWebServer.h>
+
+extern AsyncWebServer server;
+extern PubSubClient mqtt;
+
+void setup();
+void loop();
+void set_light(uint8_t channel, uint8_t value);
+
+#define RECORDS_PER_SECTOR (TELEMETRY_SECTOR_SIZE / TELEMETRY_RECORD_SIZE)
+
+static std::vector<TelemetryRecord> seen;
+
+static bool collect(const TelemetryRecord& record, void* ctx) {
+    (void)ctx;
+    seen.push_back(record);
+    return true;
+}
+
+static std::vector<TelemetryRecord> read_all(uint32_t from_seq = 0) {
+    seen.clear();
+    telemetry_read(from_seq, collect, nullptr);
+    return seen;
+}
+
+static void append(uint8_t event, uint8_t level) {
+    TelemetryRecord record;
+    memset(&record, 0, sizeof(record));
+    record.time = 1750000000;
+    record.event = event;
+    record.channel_count = 1;
+    record.levels[0] = level;
+    telemetry_append(record);
+}
+
+// Fresh, erased partition of the given number of sectors
+static void fresh_log(uint32_t sectors) {
+    hal_fake_log_resize(sectors * TELEMETRY_SECTOR_SIZE);
+    telemetry_begin();
+}
+
+static void assert_consecutive(const std::vector<TelemetryRecord>& records, uint32_t last_seq) {
+    TEST_ASSERT_TRUE(records.size() > 0);
+    for (size_t i = 1; i < records.size(); i++) TEST_ASSERT_EQUAL_UINT32(records[i - 1].seq + 1, records[i].seq);
+    TEST_ASSERT_EQUAL_UINT32(last_seq, records.back().seq);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// RING
+// ============================================================================
+void test_records_batch_into_pages() {
+    fresh_log(4);
+    TelemetryStats before = telemetry_stats();
+    for (int i = 0; i < 7; i++) append(TELEMETRY_LEVELS, i);
+    TEST_ASSERT_EQUAL_UINT32(before.page_writes, telemetry_stats().page_writes);
+    TEST_ASSERT_EQUAL_INT(7, read_all().size());  // still in RAM, readable anyway
+
+    append(TELEMETRY_LEVELS, 7);  // page full
+    TEST_ASSERT_EQUAL_UINT32(before.page_writes + 1, telemetry_stats().page_writes);
+    TEST_ASSERT_EQUAL_UINT32(1, hal_fake_log_erases(0));
+
+    TelemetryRecord first;
+    hal_log_read(0, &first, sizeof(first));
+    TEST_ASSERT_EQUAL_UINT32(0, first.seq);
+    TEST_ASSERT_EQUAL_UINT16(telemetry_crc(first), first.crc);
+}
+
+void test_partial_page_flush_then_fill() {
+    fresh_log(4);
+    for (int i = 0; i < 3; i++) append(TELEMETRY_LEVELS, i);
+    telemetry_loop(hal_millis() + TELEMETRY_FLUSH_MS);  // timed flush of 3
+    for (int i = 3; i < 8; i++) append(TELEMETRY_LEVELS, i);  // rest of the same page
+
+    telemetry_begin();  // reboot: everything must come from flash
+    std::vector<TelemetryRecord> records = read_all();
+    TEST_ASSERT_EQUAL_INT(8, records.size());
+    assert_consecutive(records, 7);
+    TEST_ASSERT_EQUAL_UINT8(5, records[5].levels[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, hal_fake_log_erases(0));
+}
+
+void test_wraps_with_even_wear() {
+    fresh_log(4);
+    const uint32_t total = 20 * RECORDS_PER_SECTOR + 37;  // five laps and a bit
+    for (uint32_t i = 0; i < total; i++) append(TELEMETRY_LEVELS, (uint8_t)i);
+
+    uint32_t least = UINT32_MAX, most = 0;
+    for (uint32_t s = 0; s < 4; s++) {
+        least = hal_fake_log_erases(s) < least ? hal_fake_log_erases(s) : least;
+        most = hal_fake_log_erases(s) > most ? hal_fake_log_erases(s) : most;
+    }
+    TEST_ASSERT_TRUE(most - least <= 1);
+    TEST_ASSERT_EQUAL_UINT32(6, most);
+
+    // Three full sectors plus the head sector's records survive
+    std::vector<TelemetryRecord> records = read_all();
+    assert_consecutive(records, total - 1);
+    TEST_ASSERT_EQUAL_INT(3 * RECORDS_PER_SECTOR + 37, records.size());
+
+    telemetry_begin();
+    TEST_ASSERT_EQUAL_UINT32(total - 5, telemetry_stats().next_seq);  // 5 unflushed records lost
+    append(TELEMETRY_BOOT, 0);
+    assert_consecutive(read_all(), total - 5);
+}
+
+void test_reboot_on_sector_boundary() {
+    fresh_log(4);
+    for (uint32_t i = 0; i < 4 * RECORDS_PER_SECTOR; i++) append(TELEMETRY_LEVELS, 0);  // exactly one lap
+
+    telemetry_begin();
+    TEST_ASSERT_EQUAL_UINT32(4 * RECORDS_PER_SECTOR, telemetry_stats().next_seq);
+    std::vector<TelemetryRecord> records = read_all();
+    TEST_ASSERT_EQUAL_INT(4 * RECORDS_PER_SECTOR, records.size());
+    assert_consecutive(records, 4 * RECORDS_PER_SECTOR - 1);
+
+    for (int i = 0; i < 8; i++) append(TELEMETRY_LEVELS, 0);  // sector 0 erased again
+    TEST_ASSERT_EQUAL_UINT32(2, hal_fake_log_erases(0));
+    records = read_all();
+    TEST_ASSERT_EQUAL_UINT32(RECORDS_PER_SECTOR, records.front().seq);
+    assert_consecutive(records, 4 * RECORDS_PER_SECTOR + 7);
+}
+
+void test_torn_record_is_skipped() {
+    fresh_log(4);
+    for (int i = 0; i < 16; i++) append(TELEMETRY_LEVELS, i);
+
+    // Power cut halfway through programming record 13: its tail never landed
+    uint8_t zeros[8] = {};
+    hal_log_write(12 * TELEMETRY_RECORD_SIZE, zeros, sizeof(zeros));
+    telemetry_begin();
+
+    std::vector<TelemetryRecord> records = read_all();
+    TEST_ASSERT_EQUAL_INT(15, records.size());
+    TEST_ASSERT_EQUAL_UINT32(11, records[11].seq);
+    TEST_ASSERT_EQUAL_UINT32(13, records[12].seq);
+    TEST_ASSERT_EQUAL_UINT32(16, telemetry_stats().next_seq);
+}
+
+void test_read_from_seq() {
+    fresh_log(4);
+    for (uint32_t i = 0; i < 3 * RECORDS_PER_SECTOR + 10; i++) append(TELEMETRY_LEVELS, 0);
+    std::vector<TelemetryRecord> records = read_all(2 * RECORDS_PER_SECTOR + 5);
+    TEST_ASSERT_EQUAL_INT(RECORDS_PER_SECTOR + 5, records.size());
+    TEST_ASSERT_EQUAL_UINT32(2 * RECORDS_PER_SECTOR + 5, records.front().seq);
+}
+
+void test_no_partition() {
+    hal_fake_log_resize(0);
+    TEST_ASSERT_FALSE(telemetry_begin());
+    append(TELEMETRY_BOOT, 0);
+    TEST_ASSERT_EQUAL_INT(0, read_all().size());
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry_stats().capacity);
+}
+
+// ============================================================================
+// /telemetry.csv
+// ============================================================================
+static std::string csv_line(const std::string& body, int n) {
+    size_t start = 0;
+    while (n-- > 0) start = body.find('\n', start) + 1;
+    return body.substr(start, body.find('\n', start) - start);
+}
+
+static std::string csv_field(const std::string& line, int n) {
+    size_t start = 0;
+    while (n-- > 0) start = line.find(',', start) + 1;
+    return line.substr(start, line.find(',', start) - start);
+}
+
+void test_csv_export() {
+    fresh_log(16);
+    hal_fake_set_wifi(true, -58);
+    for (int i = 0; i < 5; i++) loop();  // boot, time_sync
+    set_light(1, 40);
+    for (int i = 0; i < 5; i++) loop();  // mode -> manual
+
+    TEST_ASSERT_TRUE(server.fake_request(HTTP_GET, "/telemetry.csv"));
+    TEST_ASSERT_EQUAL_INT(200, server.last_code);
+    std::string body = server.last_body.c_str();
+    TEST_ASSERT_EQUAL_STRING("seq,time,event,mode,wifi,mqtt,rssi,white,red,uv", csv_line(body, 0).c_str());
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, body.find(",2026-06-21T10:00:00Z,time_sync,auto,1,0,-58,"));
+    TEST_ASSERT_EQUAL_STRING("boot", csv_field(csv_line(body, 1), 2).c_str());
+    std::string last = csv_line(body, 3);
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, last.find(",mode,manual,1,0,-58,"));
+    TEST_ASSERT_EQUAL_STRING("40", csv_field(last, 8).c_str());
+    TEST_ASSERT_EQUAL_STRING("", csv_line(body, 4).c_str());
+
+    TEST_ASSERT_TRUE(server.fake_request(HTTP_GET, "/telemetry.csv", {{"last", "1"}}));
+    body = server.last_body.c_str();
+    TEST_ASSERT_EQUAL_STRING(last.c_str(), csv_line(body, 1).c_str());
+    TEST_ASSERT_EQUAL_STRING("", csv_line(body, 2).c_str());
+
+    TEST_ASSERT_TRUE(server.fake_request(HTTP_GET, "/telemetry.csv", {{"since", "1900000000"}}));
+    TEST_ASSERT_EQUAL_STRING("", csv_line(server.last_body.c_str(), 1).c_str());
+}
+
+void test_wifi_drop_is_logged() {
+    hal_fake_set_wifi(false, 0);
+    loop();
+    hal_fake_set_wifi(true, -70);
+    loop();
+    TEST_ASSERT_TRUE(server.fake_request(HTTP_GET, "/telemetry.csv", {{"last", "2"}}));
+    std::string body = server.last_body.c_str();
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, csv_line(body, 1).find(",wifi_down,manual,0,0,,"));
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, csv_line(body, 2).find(",wifi_up,manual,1,0,-70,"));
+}
+
+// ============================================================================
+// MICROBENCHMARK
+// ============================================================================
+void test_bench_export() {
+    fresh_log(256);  // 1 MB, the size of the real partition
+    uint32_t capacity = telemetry_stats().capacity;
+    for (uint32_t i = 0; i < capacity; i++) append(TELEMETRY_HEARTBEAT, (uint8_t)i);
+
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(server.fake_request(HTTP_GET, "/telemetry.csv"));
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "full export %u rows, %u KB   %8.1f ms", (unsigned)capacity,
+             (unsigned)(server.last_body.length() / 1024), ms);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(server.last_body.length() > capacity * 40);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    hal_fake_reset();
+    Serial.muted = true;
+    setup();
+    hal_fake_set_local_time(12, 0);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_records_batch_into_pages);
+    RUN_TEST(test_partial_page_flush_then_fill);
+    RUN_TEST(test_wraps_with_even_wear);
+    RUN_TEST(test_reboot_on_sector_boundary);
+    RUN_TEST(test_torn_record_is_skipped);
+    RUN_TEST(test_read_from_seq);
+    RUN_TEST(test_no_partition);
+    RUN_TEST(test_csv_export);
+    RUN_TEST(test_wifi_drop_is_logged);
+    RUN_TEST(test_bench_export);
+    return UNITY_END();
+}
@@ -0,0 +1,388 @@
+/**
+ * Vaxthus_Master_V3 - Timer queue tests
+ *
+ * Host build only:  pio test -e native -f test_timers -v
+ *
+ * The min-heap on the fake clock: firing order, re-arming, periodic
+ * timers on their grid, millis() wrap-around, jittered backoff, and the
+ * firmware: the NVS commit landing on its deadline through loop(), WiFi
+ * fast connect from the cached link, and WiFi / MQTT retries backing off.
+ */
+
+#include <unity.h>
+#include <PubSubClient.h>
+#include <chrono>
+#include <string>
+#include <stdlib.h>
+
+#include "hal.h"
+#include "nvs_cache.h"
+#include "timer_queue.h"
+
+void setup();
+void loop();
+void set_light(uint8_t channel, uint8_t value);
+void init_wifi();
+extern Timer nvs_timer;
+extern String wifi_ssid;
+extern bool mqtt_enabled;
+extern PubSubClient mqtt;
+extern uint32_t mqtt_connects;
+extern uint32_t mqtt_connect_failures;
+extern bool wifi_fast_connecting;
+struct ReconnectStats {
+    const char* link;
+    bool down;
+    uint32_t down_since;
+    uint32_t count;
+    uint32_t last_ms;
+    uint32_t max_ms;
+    uint64_t total_ms;
+};
+extern ReconnectStats wifi_reconnect;
+extern ReconnectStats mqtt_reconnect;
+
+#define LOOP_SLACK_MS 100  // a loop() pass may sleep up to LOOP_POLL_SAVE_MS past a deadline
+
+static std::string fired;
+
+static void fire_a() { fired += 'a'; }
+static void fire_b() { fired += 'b'; }
+static void fire_c() { fired += 'c'; }
+static void fire_d() { fired += 'd'; }
+
+static Timer a = TIMER_INIT("a", fire_a, 0);
+static Timer b = TIMER_INIT("b", fire_b, 0);
+static Timer c = TIMER_INIT("c", fire_c, 0);
+static Timer d = TIMER_INIT("d", fire_d, 0);
+
+// Runs the queue once per ms for `ms` ms
+static void run_for(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        hal_fake_advance_millis(1);
+        timers_run();
+    }
+}
+
+void setUp() {
+    fired.clear();
+}
+
+void tearDown() {
+    timer_stop(a);
+    timer_stop(b);
+    timer_stop(c);
+    timer_stop(d);
+    a.period_ms = b.period_ms = c.period_ms = d.period_ms = 0;
+}
+
+// ============================================================================
+// QUEUE
+// ============================================================================
+void test_fires_in_due_order() {
+    timer_start(c, 30);
+    timer_start(a, 10);
+    timer_start(d, 40);
+    timer_start(b, 20);
+    TEST_ASSERT_EQUAL_UINT8(4, timers_pending());
+    TEST_ASSERT_EQUAL_UINT32(10, timers_next());
+
+    run_for(9);
+    TEST_ASSERT_EQUAL_STRING("", fired.c_str());
+    run_for(1);
+    TEST_ASSERT_EQUAL_STRING("a", fired.c_str());
+    run_for(30);
+    TEST_ASSERT_EQUAL_STRING("abcd", fired.c_str());
+    TEST_ASSERT_FALSE(timer_pending(a));
+    TEST_ASSERT_EQUAL_UINT32(TIMER_NONE, timers_next());
+}
+
+void test_rearm_moves_and_stop_removes() {
+    timer_start(a, 10);
+    timer_start(b, 20);
+    timer_start(c, 30);
+    timer_start(a, 25);  // later: b now goes first
+    timer_stop(c);
+    TEST_ASSERT_EQUAL_UINT8(2, timers_pending());
+
+    run_for(30);
+    TEST_ASSERT_EQUAL_STRING("ba", fired.c_str());
+
+    // All due on the same pass: one timers_run() fires them all
+    timer_start(a, 5);
+    timer_start(b, 5);
+    timer_start(c, 5);
+    hal_fake_advance_millis(100);
+    timers_run();
+    TEST_ASSERT_EQUAL_UINT32(5, fired.size());
+    TEST_ASSERT_EQUAL_UINT8(0, timers_pending());
+}
+
+void test_periodic_keeps_its_grid() {
+    a.period_ms = 100;
+    timer_start(a, 100);
+    uint32_t start = hal_millis();
+
+    // Late by 30 ms: the next firing is still on the 100 ms grid
+    hal_fake_advance_millis(130);
+    timers_run();
+    TEST_ASSERT_EQUAL_UINT32(start + 200, a.due);
+
+    // A whole period behind: missed firings are skipped, not replayed
+    hal_fake_advance_millis(450);
+    timers_run();
+    TEST_ASSERT_EQUAL_STRING("aa", fired.c_str());
+    TEST_ASSERT_EQUAL_UINT32(hal_millis() + 100, a.due);
+    TEST_ASSERT_TRUE(timers_stats().late_max_ms >= 380);
+}
+
+static void rearm_self() {
+    fired += 'r';
+    timer_start(d, 0);
+}
+
+void test_self_rearm_runs_once_per_call() {
+    d.callback = rearm_self;
+    timer_start(d, 0);
+    timers_run();
+    timers_run();
+    TEST_ASSERT_EQUAL_STRING("rr", fired.c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, timers_next());
+    d.callback = fire_d;
+}
+
+void test_wraps_around_millis() {
+    hal_fake_advance_millis(UINT32_MAX - hal_millis() - 15);  // 16 ms before the wrap
+    timer_start(b, 40);  // due after the wrap
+    timer_start(a, 10);  // due before it
+    TEST_ASSERT_EQUAL_UINT32(10, timers_next());
+    run_for(50);
+    TEST_ASSERT_EQUAL_STRING("ab", fired.c_str());
+    TEST_ASSERT_TRUE(hal_millis() < 100);
+}
+
+void test_queue_full() {
+    static Timer many[TIMERS_MAX + 1];
+    for (int i = 0; i <= TIMERS_MAX; i++) many[i] = TIMER_INIT("many", nullptr, 0);
+    // Latest first, so every insert sifts up to the root
+    for (int i = 0; i < TIMERS_MAX; i++) TEST_ASSERT_TRUE(timer_start(many[i], 100 - i));
+    TEST_ASSERT_FALSE(timer_start(many[TIMERS_MAX], 1));
+    TEST_ASSERT_FALSE(timer_pending(many[TIMERS_MAX]));
+
+    // Still a valid heap: they come out in due order, one per ms
+    for (int i = TIMERS_MAX - 1; i >= 0; i--) {
+        hal_fake_advance_millis(timers_next());
+        timers_run();
+        TEST_ASSERT_FALSE(timer_pending(many[i]));
+        if (i > 0) TEST_ASSERT_TRUE(timer_pending(many[i - 1]));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, timers_pending());
+}
+
+// ============================================================================
+// BACKOFF
+// ============================================================================
+void test_backoff_doubles_to_the_cap() {
+    Backoff backoff = BACKOFF_INIT(1000, 8000);
+    const uint32_t steps[] = {1000, 2000, 4000, 8000, 8000, 8000};
+    for (uint32_t step : steps) {
+        uint32_t wait = backoff_next(backoff);
+        TEST_ASSERT_UINT_WITHIN(step / 4, step * 3 / 4, wait);  // upper half of the step
+    }
+    backoff_reset(backoff);
+    TEST_ASSERT_UINT_WITHIN(250, 750, backoff_next(backoff));
+
+    Backoff forever = BACKOFF_INIT(5000, 300000);  // attempts saturate, the wait stays capped
+    for (int i = 0; i < 1000; i++) TEST_ASSERT_TRUE(backoff_next(forever) <= 300000);
+}
+
+// Devices that lost the same AP at the same moment spread their retries
+void test_backoff_spreads_retries() {
+    uint32_t lowest = UINT32_MAX, highest = 0;
+    for (int device = 0; device < 50; device++) {
+        Backoff backoff = BACKOFF_INIT(10000, 120000);
+        backoff_next(backoff);
+        backoff_next(backoff);
+        uint32_t wait = backoff_next(backoff);  // third retry: 20-40 s
+        if (wait < lowest) lowest = wait;
+        if (wait > highest) highest = wait;
+    }
+    TEST_ASSERT_TRUE(lowest >= 20000 && highest <= 40000);
+    TEST_ASSERT_TRUE(highest - lowest > 10000);
+}
+
+// ============================================================================
+// FIRMWARE
+// ============================================================================
+// Split commit: a put while the batch is written (net lock released) stays
+// dirty and goes out with the next commit
+void test_nvs_put_during_split_commit() {
+    nvs_cache_put_u32("SPLIT", 1);
+    hal_fake_advance_millis(NVS_CACHE_IDLE_MS);
+    NvsCacheBatch batch;
+    TEST_ASSERT_TRUE(nvs_cache_take(&batch));
+    TEST_ASSERT_EQUAL_UINT8(1, batch.count);
+
+    nvs_cache_put_u32("SPLIT", 2);
+    nvs_cache_write(batch);
+    nvs_cache_done(batch);
+    TEST_ASSERT_EQUAL_UINT32(1, hal_nvs_get_u32("SPLIT", 0));
+    TEST_ASSERT_TRUE(nvs_cache_dirty());
+    TEST_ASSERT_FALSE(nvs_cache_take(&batch));  // the idle time starts over
+
+    hal_fake_advance_millis(NVS_CACHE_IDLE_MS);
+    nvs_cache_loop();
+    TEST_ASSERT_EQUAL_UINT32(2, hal_nvs_get_u32("SPLIT", 0));
+    TEST_ASSERT_FALSE(nvs_cache_dirty());
+}
+
+// A light change is committed to NVS when its idle deadline comes up,
+// not a pass earlier or later
+void test_nvs_commit_on_its_deadline() {
+    setup();
+    for (int i = 0; i < 10; i++) loop();
+    set_light(0, 77);
+    loop();  // command applied, state saved to the cache
+    TEST_ASSERT_TRUE(timer_pending(nvs_timer));
+    uint32_t due = nvs_timer.due;
+    uint32_t writes = hal_fake_nvs_writes();
+
+    while ((int32_t)(due - hal_millis()) > 0) {
+        TEST_ASSERT_EQUAL_UINT32(writes, hal_fake_nvs_writes());
+        loop();
+    }
+    loop();
+    TEST_ASSERT_TRUE(hal_fake_nvs_writes() > writes);
+    TEST_ASSERT_EQUAL_UINT8(77, hal_nvs_get_u8("LIGHTWHITE", 0));
+    TEST_ASSERT_FALSE(timer_pending(nvs_timer));
+}
+
+// The first connect scans and caches the link; the next boot joins from it
+void test_wifi_fast_connect_from_cache() {
+    wifi_ssid = "greenhouse";
+    init_wifi();
+    TEST_ASSERT_EQUAL_UINT32(1, hal_fake_wifi_begins(false));
+    TEST_ASSERT_EQUAL_UINT32(0, hal_fake_wifi_begins(true));
+    hal_fake_set_wifi(true, -55);
+    loop();
+    uint8_t cache[64];
+    TEST_ASSERT_TRUE(hal_nvs_get_blob("WIFICACHE", cache, sizeof(cache)) > 0);
+
+    // Back on the same AP with the same lease: timed, and no flash write
+    uint32_t writes = hal_fake_nvs_writes();
+    hal_fake_set_wifi(false, 0);
+    loop();
+    hal_fake_advance_millis(1500);
+    hal_fake_set_wifi(true, -55);
+    loop();
+    TEST_ASSERT_EQUAL_UINT32(writes, hal_fake_nvs_writes());
+    TEST_ASSERT_EQUAL_UINT32(1, wifi_reconnect.count);
+    TEST_ASSERT_UINT_WITHIN(50, 1500, wifi_reconnect.last_ms);
+
+    hal_fake_set_wifi(false, 0);
+    loop();
+    init_wifi();  // "reboot"
+    TEST_ASSERT_EQUAL_UINT32(1, hal_fake_wifi_begins(true));
+    TEST_ASSERT_TRUE(wifi_fast_connecting);
+}
+
+// A cached AP that does not answer costs one retry, then a scan with DHCP.
+// After that the station retries with growing, jittered waits.
+void test_wifi_fallback_and_backoff() {
+    uint32_t scans = hal_fake_wifi_begins(false);
+    uint32_t start = hal_millis();
+    while (hal_fake_wifi_begins(false) == scans) loop();
+    TEST_ASSERT_UINT_WITHIN(2500, 7500, hal_millis() - start);  // 5-10 s
+    TEST_ASSERT_FALSE(wifi_fast_connecting);
+
+    uint32_t last = hal_millis(), previous_wait = 0;
+    for (int retry = 0; retry < 4; retry++) {
+        uint32_t reconnects = hal_fake_wifi_reconnects();
+        while (hal_fake_wifi_reconnects() == reconnects) loop();
+        uint32_t wait = hal_millis() - last;
+        last = hal_millis();
+        TEST_ASSERT_TRUE(wait > previous_wait / 2);  // each step doubles; the jitter takes at most half
+        TEST_ASSERT_TRUE(wait >= 10000 && wait <= 120000 + LOOP_SLACK_MS);
+        previous_wait = wait;
+    }
+    TEST_ASSERT_TRUE(previous_wait >= 60000);  // fifth wait: 60-120 s (capped)
+
+    hal_fake_set_wifi(true, -55);
+    loop();
+    TEST_ASSERT_EQUAL_UINT32(2, wifi_reconnect.count);
+}
+
+// A lost broker gets one immediate try, then waits 2.5-5 s, 5-10 s, 10-20 s...
+void test_mqtt_backoff() {
+    mqtt_enabled = true;
+    while (mqtt_connects == 0) loop();
+    mqtt.fake_connect_result = false;
+    mqtt.fake_connected = false;
+    uint32_t lost = hal_millis();
+
+    uint32_t attempt_at[4];
+    for (int i = 0; i < 4; i++) {
+        uint32_t failures = mqtt_connect_failures;
+        while (mqtt_connect_failures == failures) loop();
+        attempt_at[i] = hal_millis();
+    }
+    TEST_ASSERT_UINT_WITHIN(LOOP_SLACK_MS, lost, attempt_at[0]);
+    TEST_ASSERT_UINT_WITHIN(1250 + LOOP_SLACK_MS, 3750, attempt_at[1] - attempt_at[0]);
+    TEST_ASSERT_UINT_WITHIN(2500 + LOOP_SLACK_MS, 7500, attempt_at[2] - attempt_at[1]);
+    TEST_ASSERT_UINT_WITHIN(5000 + LOOP_SLACK_MS, 15000, attempt_at[3] - attempt_at[2]);
+
+    mqtt.fake_connect_result = true;
+    uint32_t connects = mqtt_connects;
+    while (mqtt_connects == connects) loop();
+    TEST_ASSERT_EQUAL_UINT32(1, mqtt_reconnect.count);
+    TEST_ASSERT_UINT_WITHIN(LOOP_SLACK_MS, hal_millis() - lost, mqtt_reconnect.last_ms);
+}
+
+// ============================================================================
+// MICROBENCHMARK
+// ============================================================================
+void test_bench_run() {
+    static Timer bench[TIMERS_MAX / 2];
+    const uint8_t n = sizeof(bench) / sizeof(bench[0]);
+    for (uint8_t i = 0; i < n; i++) {
+        bench[i] = TIMER_INIT("bench", nullptr, 10u + i);
+        timer_start(bench[i], 10 + i);
+    }
+    const uint32_t passes = 200000;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < passes; i++) {
+        hal_fake_advance_millis(1);
+        timers_run();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "timers_run() %u pending   %8.1f ns/pass", (unsigned)timers_pending(), ns / passes);
+    TEST_MESSAGE(msg);
+    for (uint8_t i = 0; i < n; i++) timer_stop(bench[i]);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    hal_fake_reset();
+    Serial.muted = true;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_fires_in_due_order);
+    RUN_TEST(test_rearm_moves_and_stop_removes);
+    RUN_TEST(test_periodic_keeps_its_grid);
+    RUN_TEST(test_self_rearm_runs_once_per_call);
+    RUN_TEST(test_wraps_around_millis);
+    RUN_TEST(test_queue_full);
+    RUN_TEST(test_backoff_doubles_to_the_cap);
+    RUN_TEST(test_backoff_spreads_retries);
+    RUN_TEST(test_bench_run);
+    RUN_TEST(test_nvs_put_during_split_commit);
+    // Last: setup() leaves the firmware's timers pending
+    RUN_TEST(test_nvs_commit_on_its_deadline);
+    RUN_TEST(test_wifi_fast_connect_from_cache);
+    RUN_TEST(test_wifi_fallback_and_backoff);
+    RUN_TEST(test_mqtt_backoff);
+    return UNITY_END();
+}